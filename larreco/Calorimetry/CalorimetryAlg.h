@@ -90,6 +90,11 @@ namespace calo{
 
     double LifetimeCorrection(double time, double T0=0) const;
 
+    /// True if the dEdx_* methods only read constant data and can be called from several threads at once.
+    /// The lifetime of CaloLifeTimeForm 1 is read through the ElectronLifetimeService for each call instead.
+    bool IsReentrant() const
+    { return !fDoLifeTimeCorrection || fLifeTimeForm == 0; }
+
   private:
 
     art::ServiceHandle<geo::Geometry const> geom;
@@ -9,10 +9,14 @@
 //  of the 3D reconstructed tracks
 ////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <string>
 #include <optional>
 #include <cmath>
 #include <limits> // std::numeric_limits<>
+#include <numeric> // std::iota()
+#include <stack>
+#include <utility>
 
 #include "larreco/Calorimetry/CalorimetryAlg.h"
 #include "larcoreobj/SimpleTypesAndConstants/PhysicalConstants.h"
@@ -37,8 +41,6 @@
 
 // ROOT includes
 #include <TMath.h>
-#include <TGraph.h>
-#include <TF1.h>
 #include <TVector3.h>
 
 // Framework includes
@@ -53,6 +55,8 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "cetlib/pow.h" // cet::sum_of_squares()
 
+#include "tbb/parallel_for.h"
+
 
 ///calorimetry
 namespace calo {
@@ -80,6 +84,11 @@ namespace calo {
    *     are excluded from the calorimetry. The value is specified as absolute
    *     _z_ coordinate in world reference frame, in centimeters.
    *     The legacy value of this cut was hard coded to `-100.0` cm.
+   * * **ParallelTracks** (boolean, default: `false`): compute the calorimetry
+   *     of the tracks of the event in parallel (TBB); the output is the same,
+   *     in the same order, as in the serial computation. Not allowed with the
+   *     database electron lifetime (`CaloAlg.CaloLifeTimeForm: 1`), which is
+   *     not read in a thread-safe way.
    *
    *
    */
@@ -96,7 +105,7 @@ namespace calo {
     bool BeginsOnBoundary(art::Ptr<recob::Track> lar_track);
     bool EndsOnBoundary(art::Ptr<recob::Track> lar_track);
 
-    void GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> trkx, std::vector<double> trky, std::vector<double> trkz, std::vector<double> trkw, std::vector<double> trkx0, double *xyz3d, double &pitch, double TickT0);
+    void GetPitch(art::Ptr<recob::Hit> const& hit, std::vector<double> const& trkx, std::vector<double> const& trky, std::vector<double> const& trkz, std::vector<double> const& trkw, std::vector<double> const& trkx0, std::vector<size_t> const& trkwOrder, double *xyz3d, double &pitch, double TickT0) const;
 
     std::string fTrackModuleLabel;
     std::string fSpacePointModuleLabel;
@@ -105,25 +114,66 @@ namespace calo {
     bool fSCE;
     bool fFlipTrack_dQdx; //flip track direction if significant rise of dQ/dx at the track start
     std::optional<double> fNotOnTrackZcut; ///< Exclude trajectory points with _z_ lower than this [cm]
+    bool fParallelTracks; ///< Compute the calorimetry of the tracks of an event in parallel
     CalorimetryAlg caloAlg;
 
-    int fnsps;
-    std::vector<int>    fwire;
-    std::vector<double> ftime;
-    std::vector<double> fstime;
-    std::vector<double> fetime;
-    std::vector<double> fMIPs;
-    std::vector<double> fdQdx;
-    std::vector<double> fdEdx;
-    std::vector<double> fResRng;
-    std::vector<float> fpitch;
-    std::vector<TVector3> fXYZ;
-    std::vector<size_t> fHitIndex;
-
   }; // class Calorimetry
 
 }
 
+namespace {
+
+  // Least squares fit of v(s) with a polynomial of degree 1 or 2, as TGraph::Fit("pol1"/"pol2") does,
+  // giving the value and the slope at s = 0. Returns false, leaving them unchanged, if the points do not
+  // constrain the polynomial. Unlike a ROOT fit it does not use the global list of functions, so it can
+  // run for several tracks at the same time.
+  bool FitPolynomial(std::vector<double> const& s, std::vector<double> const& v, unsigned int degree,
+                     double& value, double& slope)
+  {
+    unsigned int const n = degree + 1;
+
+    // normal equations, with the right hand side in the last column;
+    // s is scaled to [-1, 1] for a better conditioned system
+    double scale = 0;
+    for (auto const si : s) scale = std::max(scale, std::abs(si));
+    if (scale == 0) return false;
+    double a[3][4] = {};
+    for (size_t i = 0; i < s.size(); ++i){
+      double const t = s[i]/scale;
+      double const powers[3] = {1., t, t*t};
+      for (unsigned int r = 0; r < n; ++r){
+        for (unsigned int c = 0; c < n; ++c) a[r][c] += powers[r]*powers[c];
+        a[r][n] += powers[r]*v[i];
+      }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (unsigned int col = 0; col < n; ++col){
+      unsigned int pivot = col;
+      for (unsigned int r = col+1; r < n; ++r)
+        if (std::abs(a[r][col]) > std::abs(a[pivot][col])) pivot = r;
+      if (a[pivot][col] == 0) return false;
+      std::swap(a[col], a[pivot]);
+      for (unsigned int r = col+1; r < n; ++r){
+        double const f = a[r][col]/a[col][col];
+        for (unsigned int c = col; c <= n; ++c) a[r][c] -= f*a[col][c];
+      }
+    }
+    double p[3] = {};
+    for (int r = n-1; r >= 0; --r){
+      p[r] = a[r][n];
+      for (unsigned int c = r+1; c < n; ++c) p[r] -= a[r][c]*p[c];
+      p[r] /= a[r][r];
+    }
+    if (!std::isfinite(p[0]) || !std::isfinite(p[1])) return false;
+
+    value = p[0];
+    slope = p[1]/scale;
+    return true;
+  }
+
+} // local namespace
+
 //-------------------------------------------------
 calo::Calorimetry::Calorimetry(fhicl::ParameterSet const& pset)
   : EDProducer{pset},
@@ -133,12 +183,19 @@ calo::Calorimetry::Calorimetry(fhicl::ParameterSet const& pset)
     fUseArea(pset.get< bool >("UseArea") ),
     fSCE(pset.get< bool >("CorrectSCE")),
     fFlipTrack_dQdx(pset.get< bool >("FlipTrack_dQdx",true)),
+    fParallelTracks(pset.get< bool >("ParallelTracks",false)),
     caloAlg(pset.get< fhicl::ParameterSet >("CaloAlg"))
 {
 
   if (pset.has_key("NotOnTrackZcut"))
     fNotOnTrackZcut = pset.get<double>("NotOnTrackZcut");
 
+  if (fParallelTracks && !caloAlg.IsReentrant()) {
+    throw cet::exception("Calorimetry")
+      << "ParallelTracks can not be used with the electron lifetime correction of CaloLifeTimeForm "
+      << pset.get<fhicl::ParameterSet>("CaloAlg").get<int>("CaloLifeTimeForm") << ", which is not thread-safe";
+  }
+
   produces< std::vector<anab::Calorimetry>              >();
   produces< art::Assns<recob::Track, anab::Calorimetry> >();
 }
@@ -174,7 +231,39 @@ void calo::Calorimetry::produce(art::Event& evt)
   art::FindManyP<recob::Hit, recob::TrackHitMeta> fmthm(trackListHandle, evt, fTrackModuleLabel); //this has more information about hit-track association, only available in PMA for now
   art::FindManyP<anab::T0>          fmt0(trackListHandle, evt, fT0ModuleLabel);
 
-  for(size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter){
+  //resolve the space points of the hits of all the tracks at once, into a flat
+  //table indexed by the position of the hit in the concatenated track hits
+  std::vector<size_t> hitOffset(tracklist.size()+1, 0);
+  std::vector< art::Ptr<recob::Hit> > evtHits;
+  for (size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter){
+    auto const& trkHits = fmht.at(trkIter);
+    evtHits.insert(evtHits.end(), trkHits.begin(), trkHits.end());
+    hitOffset[trkIter+1] = evtHits.size();
+  }
+  std::vector<size_t> sptBegin(evtHits.size()+1, 0);
+  std::vector<recob::SpacePoint const*> hitSpts;
+  if (!evtHits.empty()){
+    art::FindManyP<recob::SpacePoint> fmspts(evtHits, evt, fSpacePointModuleLabel);
+    for (size_t evtHit = 0; evtHit < evtHits.size(); ++evtHit){
+      for (auto const& spt : fmspts.at(evtHit)) hitSpts.push_back(spt.get());
+      sptBegin[evtHit+1] = hitSpts.size();
+    }
+  }
+
+  //(hit key, association entry) of the hit metadata of each track, sorted by hit key
+  std::vector<size_t> metaOffset(tracklist.size()+1, 0);
+  std::vector< std::pair<size_t, size_t> > hitMetaIndex;
+  if (fmthm.isValid()){
+    for (size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter){
+      auto const& vhit = fmthm.at(trkIter);
+      for (size_t ii = 0; ii<vhit.size(); ++ii) hitMetaIndex.emplace_back(vhit[ii].key(), ii);
+      std::sort(hitMetaIndex.begin() + metaOffset[trkIter], hitMetaIndex.end());
+      metaOffset[trkIter+1] = hitMetaIndex.size();
+    }
+  }
+  auto const byHitKey = [](std::pair<size_t, size_t> const& a, std::pair<size_t, size_t> const& b){ return a.first < b.first; };
+
+  auto trackCalorimetry = [&](size_t trkIter, std::vector<anab::Calorimetry>& calos){
 
     decltype(auto) larEnd = tracklist[trkIter]->Trajectory().End();
 
@@ -188,7 +277,7 @@ void calo::Calorimetry::produce(art::Event& evt)
     unsigned int wire    = 0;   //hit wire number
     unsigned int plane   = 0;  //hit plane number
 
-    std::vector< art::Ptr<recob::Hit> > allHits = fmht.at(trkIter);
+    std::vector< art::Ptr<recob::Hit> > const& allHits = fmht.at(trkIter);
     double T0 =0;
     double TickT0 =0;
     if ( fmt0.isValid() ) {
@@ -199,7 +288,6 @@ void calo::Calorimetry::produce(art::Event& evt)
 
     std::vector< std::vector<unsigned int> > hits(nplanes);
 
-    art::FindManyP<recob::SpacePoint> fmspts(allHits, evt, fSpacePointModuleLabel);
     for (size_t ah = 0; ah< allHits.size(); ++ah){
       hits[allHits[ah]->WireID().Plane].push_back(ah);
     }
@@ -208,17 +296,17 @@ void calo::Calorimetry::produce(art::Event& evt)
 
       geo::PlaneID planeID;//(cstat,tpc,ipl);
 
-      fwire.clear();
-      ftime.clear();
-      fstime.clear();
-      fetime.clear();
-      fMIPs.clear();
-      fdQdx.clear();
-      fdEdx.clear();
-      fpitch.clear();
-      fResRng.clear();
-      fXYZ.clear();
-      fHitIndex.clear();
+      std::vector<int>    fwire;
+      std::vector<double> ftime;
+      std::vector<double> fstime;
+      std::vector<double> fetime;
+      std::vector<double> fMIPs;
+      std::vector<double> fdQdx;
+      std::vector<double> fdEdx;
+      std::vector<double> fResRng;
+      std::vector<float> fpitch;
+      std::vector<TVector3> fXYZ;
+      std::vector<size_t> fHitIndex;
 
       float Kin_En = 0.;
       float Trk_Length = 0.;
@@ -233,16 +321,15 @@ void calo::Calorimetry::produce(art::Event& evt)
         if (hits[ipl].size() == 1){
           mf::LogWarning("Calorimetry") << "Only one hit in plane "<<ipl<<" associated with track id "<<trkIter;
         }
-	calorimetrycol->push_back(anab::Calorimetry(util::kBogusD,
-						    vdEdx,
-						    vdQdx,
-						    vresRange,
-						    deadwire,
-						    util::kBogusD,
-						    fpitch,
-						    recob::tracking::convertCollToPoint(vXYZ),
-						    planeID));
-	util::CreateAssn(*this, evt, *calorimetrycol, tracklist[trkIter], *assn);
+	calos.push_back(anab::Calorimetry(util::kBogusD,
+					  vdEdx,
+					  vdQdx,
+					  vresRange,
+					  deadwire,
+					  util::kBogusD,
+					  fpitch,
+					  recob::tracking::convertCollToPoint(vXYZ),
+					  planeID));
         continue;
       }
 
@@ -260,7 +347,7 @@ void calo::Calorimetry::produce(art::Event& evt)
       // temp array holding distance betweeen space points
       std::vector<double> spdelta;
       //int nht = 0; //number of hits
-      fnsps = 0; //number of space points
+      int fnsps = 0; //number of space points
       std::vector<double> ChargeBeg;
       std::stack<double> ChargeEnd;
 
@@ -307,24 +394,28 @@ void calo::Calorimetry::produce(art::Event& evt)
       std::vector<double> trkx0;
       for (size_t i = 0; i<hits[ipl].size(); ++i){
 	//Get space points associated with the hit
-	std::vector< art::Ptr<recob::SpacePoint> > sptv = fmspts.at(hits[ipl][i]);
-	for (size_t j = 0; j < sptv.size(); ++j){
+	size_t const evtHit = hitOffset[trkIter] + hits[ipl][i];
+	for (size_t j = sptBegin[evtHit]; j < sptBegin[evtHit+1]; ++j){
 
 	  double t = allHits[hits[ipl][i]]->PeakTime() - TickT0; // Want T0 here? Otherwise ticks to x is wrong?
 	  double x = detprop->ConvertTicksToX(t, allHits[hits[ipl][i]]->WireID().Plane, allHits[hits[ipl][i]]->WireID().TPC, allHits[hits[ipl][i]]->WireID().Cryostat);
 	  double w = allHits[hits[ipl][i]]->WireID().Wire;
 	  if (TickT0){
-	    trkx.push_back(sptv[j]->XYZ()[0]-detprop->ConvertTicksToX(TickT0, allHits[hits[ipl][i]]->WireID().Plane, allHits[hits[ipl][i]]->WireID().TPC, allHits[hits[ipl][i]]->WireID().Cryostat));
+	    trkx.push_back(hitSpts[j]->XYZ()[0]-detprop->ConvertTicksToX(TickT0, allHits[hits[ipl][i]]->WireID().Plane, allHits[hits[ipl][i]]->WireID().TPC, allHits[hits[ipl][i]]->WireID().Cryostat));
 	  }
 	  else{
-	    trkx.push_back(sptv[j]->XYZ()[0]);
+	    trkx.push_back(hitSpts[j]->XYZ()[0]);
 	  }
-	  trky.push_back(sptv[j]->XYZ()[1]);
-	  trkz.push_back(sptv[j]->XYZ()[2]);
+	  trky.push_back(hitSpts[j]->XYZ()[1]);
+	  trkz.push_back(hitSpts[j]->XYZ()[2]);
 	  trkw.push_back(w);
 	  trkx0.push_back(x);
 	}
       }
+      //space points sorted by wire, for the nearest point search in GetPitch
+      std::vector<size_t> trkwOrder(trkw.size());
+      std::iota(trkwOrder.begin(), trkwOrder.end(), 0);
+      std::sort(trkwOrder.begin(), trkwOrder.end(), [&trkw](size_t a, size_t b){ return trkw[a] < trkw[b]; });
       for (size_t ihit = 0; ihit < hits[ipl].size(); ++ihit){//loop over all hits on each wire plane
 
 	//std::cout<<ihit<<std::endl;
@@ -353,55 +444,57 @@ void calo::Calorimetry::produce(art::Event& evt)
 	double pitch;
         bool fBadhit = false;
         if (fmthm.isValid()){
-          auto vhit = fmthm.at(trkIter);
-          auto vmeta = fmthm.data(trkIter);
-          for (size_t ii = 0; ii<vhit.size(); ++ii){
-            if (vhit[ii].key() == allHits[hits[ipl][ihit]].key()){
-              if (vmeta[ii]->Index() == std::numeric_limits<int>::max()){
-                fBadhit = true;
-                continue;
-              }
-              if (vmeta[ii]->Index()>=tracklist[trkIter]->NumberTrajectoryPoints()){
-                throw cet::exception("Calorimetry_module.cc") << "Requested track trajectory index "<<vmeta[ii]->Index()<<" exceeds the total number of trajectory points "<<tracklist[trkIter]->NumberTrajectoryPoints()<<" for track index "<<trkIter<<". Something is wrong with the track reconstruction. Please contact tjyang@fnal.gov";
-              }
-              if (!tracklist[trkIter]->HasValidPoint(vmeta[ii]->Index())){
-                fBadhit = true;
-                continue;
-              }
-
-             //Correct location for SCE
-              geo::Point_t const loc
-                = tracklist[trkIter]->LocationAtPoint(vmeta[ii]->Index());
-              geo::Vector_t locOffsets = {0., 0., 0.,};
-              if(sce->EnableCalSpatialSCE()&&fSCE) locOffsets = sce->GetCalPosOffsets(loc,vhit[ii]->WireID().TPC);
-              xyz3d[0] = loc.X() - locOffsets.X();
-              xyz3d[1] = loc.Y() + locOffsets.Y();
-              xyz3d[2] = loc.Z() + locOffsets.Z();
-
-              double angleToVert = geom->WireAngleToVertical(vhit[ii]->View(), vhit[ii]->WireID().TPC, vhit[ii]->WireID().Cryostat) - 0.5*::util::pi<>();
-              const geo::Vector_t& dir = tracklist[trkIter]->DirectionAtPoint(vmeta[ii]->Index());
-              double cosgamma = std::abs(std::sin(angleToVert)*dir.Y() + std::cos(angleToVert)*dir.Z());
-              if (cosgamma){
-                pitch = geom->WirePitch(vhit[ii]->View())/cosgamma;
-
-              }
-              else{
-                pitch = 0;
-              }
-
-              //Correct pitch for SCE
-              geo::Vector_t dirOffsets = {0., 0., 0.};
-              if(sce->EnableCalSpatialSCE()&&fSCE) dirOffsets = sce->GetCalPosOffsets(geo::Point_t{loc.X() + pitch*dir.X(), loc.Y() + pitch*dir.Y(), loc.Z() + pitch*dir.Z()},vhit[ii]->WireID().TPC);
-              const TVector3& dir_corr = {pitch*dir.X() - dirOffsets.X() + locOffsets.X(), pitch*dir.Y() + dirOffsets.Y() - locOffsets.Y(), pitch*dir.Z() + dirOffsets.Z() - locOffsets.Z()};
-
-               pitch = dir_corr.Mag();
-
-              break;
+          auto const& vhit = fmthm.at(trkIter);
+          auto const& vmeta = fmthm.data(trkIter);
+          //association entries of this hit, in their original order
+          auto const entries = std::equal_range(hitMetaIndex.begin() + metaOffset[trkIter], hitMetaIndex.begin() + metaOffset[trkIter+1],
+                                                std::make_pair(allHits[hits[ipl][ihit]].key(), size_t(0)), byHitKey);
+          for (auto entry = entries.first; entry != entries.second; ++entry){
+            size_t const ii = entry->second;
+            if (vmeta[ii]->Index() == std::numeric_limits<int>::max()){
+              fBadhit = true;
+              continue;
             }
+            if (vmeta[ii]->Index()>=tracklist[trkIter]->NumberTrajectoryPoints()){
+              throw cet::exception("Calorimetry_module.cc") << "Requested track trajectory index "<<vmeta[ii]->Index()<<" exceeds the total number of trajectory points "<<tracklist[trkIter]->NumberTrajectoryPoints()<<" for track index "<<trkIter<<". Something is wrong with the track reconstruction. Please contact tjyang@fnal.gov";
+            }
+            if (!tracklist[trkIter]->HasValidPoint(vmeta[ii]->Index())){
+              fBadhit = true;
+              continue;
+            }
+
+           //Correct location for SCE
+            geo::Point_t const loc
+              = tracklist[trkIter]->LocationAtPoint(vmeta[ii]->Index());
+            geo::Vector_t locOffsets = {0., 0., 0.,};
+            if(sce->EnableCalSpatialSCE()&&fSCE) locOffsets = sce->GetCalPosOffsets(loc,vhit[ii]->WireID().TPC);
+            xyz3d[0] = loc.X() - locOffsets.X();
+            xyz3d[1] = loc.Y() + locOffsets.Y();
+            xyz3d[2] = loc.Z() + locOffsets.Z();
+
+            double angleToVert = geom->WireAngleToVertical(vhit[ii]->View(), vhit[ii]->WireID().TPC, vhit[ii]->WireID().Cryostat) - 0.5*::util::pi<>();
+            const geo::Vector_t& dir = tracklist[trkIter]->DirectionAtPoint(vmeta[ii]->Index());
+            double cosgamma = std::abs(std::sin(angleToVert)*dir.Y() + std::cos(angleToVert)*dir.Z());
+            if (cosgamma){
+              pitch = geom->WirePitch(vhit[ii]->View())/cosgamma;
+
+            }
+            else{
+              pitch = 0;
+            }
+
+            //Correct pitch for SCE
+            geo::Vector_t dirOffsets = {0., 0., 0.};
+            if(sce->EnableCalSpatialSCE()&&fSCE) dirOffsets = sce->GetCalPosOffsets(geo::Point_t{loc.X() + pitch*dir.X(), loc.Y() + pitch*dir.Y(), loc.Z() + pitch*dir.Z()},vhit[ii]->WireID().TPC);
+            const TVector3& dir_corr = {pitch*dir.X() - dirOffsets.X() + locOffsets.X(), pitch*dir.Y() + dirOffsets.Y() - locOffsets.Y(), pitch*dir.Z() + dirOffsets.Z() - locOffsets.Z()};
+
+             pitch = dir_corr.Mag();
+
+            break;
           }
         }
         else
-          GetPitch(allHits[hits[ipl][ihit]], trkx, trky, trkz, trkw, trkx0, xyz3d, pitch, TickT0);
+          GetPitch(allHits[hits[ipl][ihit]], trkx, trky, trkz, trkw, trkx0, trkwOrder, xyz3d, pitch, TickT0);
 
         if (fBadhit) continue;
 	if (fNotOnTrackZcut && (xyz3d[2] < fNotOnTrackZcut.value())) continue; //hit not on track
@@ -459,16 +552,15 @@ void calo::Calorimetry::produce(art::Event& evt)
         deadwire.clear();
         fpitch.clear();
 	//std::cout << "Adding the aforementioned positions..." << std::endl;
-	calorimetrycol->push_back(anab::Calorimetry(util::kBogusD,
-						    vdEdx,
-						    vdQdx,
-						    vresRange,
-						    deadwire,
-						    util::kBogusD,
-						    fpitch,
-						    recob::tracking::convertCollToPoint(vXYZ),
-						    planeID));
-	util::CreateAssn(*this, evt, *calorimetrycol, tracklist[trkIter], *assn);
+	calos.push_back(anab::Calorimetry(util::kBogusD,
+					  vdEdx,
+					  vdQdx,
+					  vresRange,
+					  deadwire,
+					  util::kBogusD,
+					  fpitch,
+					  recob::tracking::convertCollToPoint(vXYZ),
+					  planeID));
 	continue;
       }
       for (int isp = 0; isp<fnsps; ++isp){
@@ -599,13 +691,13 @@ void calo::Calorimetry::produce(art::Event& evt)
 	    channel = allHits[hits[ipl][ihit]]->Channel();
 	    if (channelStatus.IsBad(channel)) continue;
 	    // grab the space points associated with this hit
-	    std::vector< art::Ptr<recob::SpacePoint> > sppv = fmspts.at(hits[ipl][ihit]);
-	    if(sppv.size() < 1) continue;
+	    size_t const evtHit = hitOffset[trkIter] + hits[ipl][ihit];
+	    if (sptBegin[evtHit] == sptBegin[evtHit+1]) continue;
 	    // only use the first space point in the collection, really each hit should
 	    // only map to 1 space point
-	    const recob::Track::Point_t xyz{sppv[0]->XYZ()[0],
-				   sppv[0]->XYZ()[1],
-				   sppv[0]->XYZ()[2]};
+	    const recob::Track::Point_t xyz{hitSpts[sptBegin[evtHit]]->XYZ()[0],
+				   hitSpts[sptBegin[evtHit]]->XYZ()[1],
+				   hitSpts[sptBegin[evtHit]]->XYZ()[2]};
 	    double dis1 = (larEnd - xyz).Mag2();
 	    if (dis1) dis1 = std::sqrt(dis1);
 	    if (dis1 < mindis){
@@ -629,20 +721,37 @@ void calo::Calorimetry::produce(art::Event& evt)
 	}
       }
       //std::cout << "Adding at the end but still same fXYZ" << std::endl;
-      calorimetrycol->push_back(anab::Calorimetry(Kin_En,
-						  vdEdx,
-						  vdQdx,
-						  vresRange,
-						  deadwire,
-						  Trk_Length,
-						  fpitch,
-						  recob::tracking::convertCollToPoint(vXYZ),
-						  fHitIndex,
-						  planeID));
-      util::CreateAssn(*this, evt, *calorimetrycol, tracklist[trkIter], *assn);
+      calos.push_back(anab::Calorimetry(Kin_En,
+					vdEdx,
+					vdQdx,
+					vresRange,
+					deadwire,
+					Trk_Length,
+					fpitch,
+					recob::tracking::convertCollToPoint(vXYZ),
+					fHitIndex,
+					planeID));
 
     }//end looping over planes
-  }//end looping over tracks
+  };
+
+  std::vector< std::vector<anab::Calorimetry> > trackCalos(tracklist.size());
+  if (fParallelTracks) {
+    tbb::parallel_for(static_cast<size_t>(0), tracklist.size(),
+                      [&](size_t trkIter){ trackCalorimetry(trkIter, trackCalos[trkIter]); });
+  }
+  else {
+    for(size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter) trackCalorimetry(trkIter, trackCalos[trkIter]);
+  }
+
+  //store in the order of the tracks and planes, whichever order they were computed in
+  for(size_t trkIter = 0; trkIter < tracklist.size(); ++trkIter){
+    for (auto& calo : trackCalos[trkIter]){
+      calorimetrycol->push_back(std::move(calo));
+      util::CreateAssn(*this, evt, *calorimetrycol, tracklist[trkIter], *assn);
+    }
+  }
+
 
   evt.put(std::move(calorimetrycol));
   evt.put(std::move(assn));
@@ -650,7 +759,7 @@ void calo::Calorimetry::produce(art::Event& evt)
   return;
 }
 
-void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> trkx, std::vector<double> trky, std::vector<double> trkz, std::vector<double> trkw, std::vector<double> trkx0, double *xyz3d, double &pitch, double TickT0){
+void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> const& hit, std::vector<double> const& trkx, std::vector<double> const& trky, std::vector<double> const& trkz, std::vector<double> const& trkw, std::vector<double> const& trkx0, std::vector<size_t> const& trkwOrder, double *xyz3d, double &pitch, double TickT0) const{
   //Get 3d coordinates and track pitch for each hit
   //Find 5 nearest space points and determine xyz and curvature->track pitch
 
@@ -661,10 +770,10 @@ void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> t
   auto const* dp = lar::providerFrom<detinfo::DetectorPropertiesService>();
   auto const* sce = lar::providerFrom<spacecharge::SpaceChargeService>();
 
-  //save distance to each spacepoint sorted by distance
-  std::map<double,size_t> sptmap;
-  //save the sign of distance
-  std::map<size_t, int> sptsignmap;
+  //save distance to the (up to) 5 nearest spacepoints sorted by distance;
+  //as in a map keyed by distance, the first spacepoint at a given distance is kept
+  constexpr size_t maxNearest = 5;
+  std::vector< std::pair<double,size_t> > sptmap;
 
   double wire_pitch = geom->WirePitch(0);
 
@@ -672,13 +781,40 @@ void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> t
   double x0 = dp->ConvertTicksToX(t0, hit->WireID().Plane, hit->WireID().TPC, hit->WireID().Cryostat);
   double w0 = hit->WireID().Wire;
 
-  for (size_t i = 0; i<trkx.size(); ++i){
+  auto distanceTo = [&](size_t i){
     double distance = cet::sum_of_squares((trkw[i]-w0)*wire_pitch, trkx0[i]-x0);
     if (distance>0) distance = sqrt(distance);
-    //std::cout << "Dis " << distance << ", sqaured " << distance*distance << " = " << wire_pitch*wire_pitch <<"("<<trkw[i]<<"-"<<w0<<")^2 + ("<<trkx0[i]<<"-"<<x0<<")^2"<<std::endl;
-    sptmap.insert(std::pair<double,size_t>(distance,i));
-    if (w0-trkw[i]>0) sptsignmap.insert(std::pair<size_t,int>(i,1));
-    else sptsignmap.insert(std::pair<size_t,int>(i,-1));
+    return distance;
+  };
+  //lower bound of the distance of the spacepoints on the wire of spacepoint i
+  auto wireDistanceTo = [&](size_t i){
+    double distance = cet::sum_of_squares((trkw[i]-w0)*wire_pitch, 0.);
+    if (distance>0) distance = sqrt(distance);
+    return distance;
+  };
+  auto insertNearest = [&](size_t i){
+    double const distance = distanceTo(i);
+    auto isp = std::lower_bound(sptmap.begin(), sptmap.end(), distance,
+                                [](std::pair<double,size_t> const& sp, double d){ return sp.first < d; });
+    if (isp != sptmap.end() && isp->first == distance){
+      isp->second = std::min(isp->second, i);
+      return;
+    }
+    if (isp == sptmap.end() && sptmap.size() == maxNearest) return;
+    sptmap.emplace(isp, distance, i);
+    if (sptmap.size() > maxNearest) sptmap.pop_back();
+  };
+  //the spacepoints are sorted by wire: walk away from the wire of the hit on both
+  //sides, until the wire distance alone is larger than the farthest point kept
+  auto const firstAfter = std::lower_bound(trkwOrder.begin(), trkwOrder.end(), w0,
+                                           [&trkw](size_t i, double w){ return trkw[i] < w; });
+  for (auto isp = firstAfter; isp != trkwOrder.end(); ++isp){
+    if (sptmap.size() == maxNearest && wireDistanceTo(*isp) > sptmap.back().first) break;
+    insertNearest(*isp);
+  }
+  for (auto isp = std::make_reverse_iterator(firstAfter); isp != trkwOrder.rend(); ++isp){
+    if (sptmap.size() == maxNearest && wireDistanceTo(*isp) > sptmap.back().first) break;
+    insertNearest(*isp);
   }
 
   //x,y,z vs distance
@@ -698,7 +834,7 @@ void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> t
     xyz[1] = trky[isp->second];
     xyz[2] = trkz[isp->second];
 
-    double distancesign = sptsignmap[isp->second];
+    double distancesign = (w0-trkw[isp->second]>0)? 1: -1;
     //std::cout<<np<<" "<<xyz[0]<<" "<<xyz[1]<<" "<<xyz[2]<<" "<<(*isp).first<<std::endl;
     if (np==0&&isp->first>30){//hit not on track
       xyz3d[0] = std::numeric_limits<double>::lowest();
@@ -723,67 +859,19 @@ void calo::Calorimetry::GetPitch(art::Ptr<recob::Hit> hit, std::vector<double> t
   //std::cout<<"np="<<np<<std::endl;
   if (np>=2){//at least two points
     //std::cout << "At least 2 points.."<<std::endl;
-    TGraph *xs = new TGraph(np,&vs[0],&vx[0]);
-    //for (int i = 0; i<np; i++) std::cout<<i<<" "<<vs[i]<<" "<<vx[i]<<" "<<vy[i]<<" "<<vz[i]<<std::endl;
-    try{
-      if (np>2){
-	xs->Fit("pol2","Q");
-      }
-      else{
-	xs->Fit("pol1","Q");
-      }
-      TF1 *pol = 0;
-      if (np>2) pol = (TF1*) xs->GetFunction("pol2");
-      else pol = (TF1*) xs->GetFunction("pol1");
-      xyz3d[0] = pol->Eval(0);
-      kx = pol->GetParameter(1);
-      //std::cout<<"X fit "<<xyz3d[0]<<" "<<kx<<std::endl;
-    }
-    catch(...){
+    unsigned int const degree = (np>2)? 2: 1;
+    if (!FitPolynomial(vs, vx, degree, xyz3d[0], kx)){
       mf::LogWarning("Calorimetry::GetPitch") <<"Fitter failed";
       xyz3d[0] = vx[0];
     }
-    delete xs;
-    TGraph *ys = new TGraph(np,&vs[0],&vy[0]);
-    try{
-      if (np>2){
-	ys->Fit("pol2","Q");
-      }
-      else{
-	ys->Fit("pol1","Q");
-      }
-      TF1 *pol = 0;
-      if (np>2) pol = (TF1*) ys->GetFunction("pol2");
-      else pol = (TF1*) ys->GetFunction("pol1");
-      xyz3d[1] = pol->Eval(0);
-      ky = pol->GetParameter(1);
-      //std::cout<<"Y fit "<<xyz3d[1]<<" "<<ky<<std::endl;
-    }
-    catch(...){
+    if (!FitPolynomial(vs, vy, degree, xyz3d[1], ky)){
       mf::LogWarning("Calorimetry::GetPitch") <<"Fitter failed";
       xyz3d[1] = vy[0];
     }
-    delete ys;
-    TGraph *zs = new TGraph(np,&vs[0],&vz[0]);
-    try{
-      if (np>2){
-	zs->Fit("pol2","Q");
-      }
-      else{
-	zs->Fit("pol1","Q");
-      }
-      TF1 *pol = 0;
-      if (np>2) pol = (TF1*) zs->GetFunction("pol2");
-      else pol = (TF1*) zs->GetFunction("pol1");
-      xyz3d[2] = pol->Eval(0);
-      kz = pol->GetParameter(1);
-      //std::cout<<"Z fit "<<xyz3d[2]<<" "<<kz<<std::endl;
-    }
-    catch(...){
+    if (!FitPolynomial(vs, vz, degree, xyz3d[2], kz)){
       mf::LogWarning("Calorimetry::GetPitch") <<"Fitter failed";
       xyz3d[2] = vz[0];
     }
-    delete zs;
   }
   else if (np){
     xyz3d[0] = vx[0];
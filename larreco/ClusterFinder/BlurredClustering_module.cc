@@ -20,6 +20,7 @@
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "art/Framework/Core/EDProducer.h"
+#include "cetlib/cpu_timer.h"
 
 // LArSoft includes
 #include "larcore/Geometry/Geometry.h"
@@ -161,12 +162,20 @@ void cluster::BlurredClustering::produce(art::Event &evt)
 
       // Convert hit map to TH2 histogram and blur it
       auto const image = fBlurredClusteringAlg.ConvertRecobHitsToVector(hits);
+      cet::cpu_timer blurTimer;
+      blurTimer.start();
       auto const blurred = fBlurredClusteringAlg.GaussianBlur(image);
+      blurTimer.stop();
 
        // Find clusters in histogram
       std::vector<std::vector<int>> allClusterBins; // Vector of clusters (clusters are vectors of hits)
+      cet::cpu_timer findTimer;
+      findTimer.start();
       int numClusters = fBlurredClusteringAlg.FindClusters(blurred, allClusterBins);
+      findTimer.stop();
       mf::LogVerbatim("Blurred Clustering") << "Found " << numClusters << " clusters" << std::endl;
+      mf::LogVerbatim("Blurred Clustering") << "Plane " << plane.first << " TPC " << plane.second << ": blurring took " << blurTimer.accumulated_real_time()
+                                            << " s, clustering took " << findTimer.accumulated_real_time() << " s" << std::endl;
 
       // Create output clusters from the vector of clusters made in FindClusters
       std::vector<art::PtrVector<recob::Hit>> planeClusters;
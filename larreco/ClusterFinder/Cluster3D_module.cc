@@ -517,6 +517,14 @@ namespace lar_cluster3d {
     float m_clusterMergeTime;      ///< Keeps track of the time to merge clusters
     float m_pathFindingTime;       ///< Keeps track of the path finding time
     float m_finishTime;            ///< Keeps track of time to run output module
+    float m_hit3DWallTime;         ///< Wall clock time of the 3D hit building stage
+    float m_hit3DCPUTime;          ///< CPU time of the 3D hit building stage
+    float m_clusteringWallTime;    ///< Wall clock time of the clustering stage
+    float m_clusteringCPUTime;     ///< CPU time of the clustering stage
+    float m_clusterMergeWallTime;  ///< Wall clock time of the cluster merging stage
+    float m_clusterMergeCPUTime;   ///< CPU time of the cluster merging stage
+    float m_pathFindingWallTime;   ///< Wall clock time of the path finding stage
+    float m_pathFindingCPUTime;    ///< CPU time of the path finding stage
     std::string m_pathInstance;    ///< Special instance for path points
     std::string m_vertexInstance;  ///< Special instance name for vertex points
     std::string m_extremeInstance; ///< Instance name for the extreme points
@@ -642,6 +650,10 @@ namespace lar_cluster3d {
     // Set up for monitoring the timing... at some point this should be removed in favor of
     // external profilers
     cet::cpu_timer theClockTotal;
+    cet::cpu_timer theClockHit3D;
+    cet::cpu_timer theClockClustering;
+    cet::cpu_timer theClockMerge;
+    cet::cpu_timer theClockPathFinding;
     cet::cpu_timer theClockFinish;
 
     if (m_enableMonitoring) theClockTotal.start();
@@ -655,18 +667,38 @@ namespace lar_cluster3d {
     std::unique_ptr<reco::HitPairList> hitPairList(
       new reco::HitPairList); // Potentially lots of hits, use heap instead of stack
 
+    // The wall and CPU times of each stage tell how much the tools running in parallel gain
+    if (m_enableMonitoring) theClockHit3D.start();
+
     // Call the algorithm that builds 3D hits and stores the hit collection
     m_hit3DBuilderAlg->Hit3DBuilder(evt, *hitPairList, clusterHitToArtPtrMap);
 
+    if (m_enableMonitoring) {
+      theClockHit3D.stop();
+      theClockClustering.start();
+    }
+
     // Call the main workhorse algorithm for building the local version of candidate 3D clusters
     m_clusterAlg->Cluster3DHits(*hitPairList, clusterParametersList);
 
+    if (m_enableMonitoring) {
+      theClockClustering.stop();
+      theClockMerge.start();
+    }
+
     // Try merging clusters
     m_clusterMergeAlg->ModifyClusters(clusterParametersList);
 
+    if (m_enableMonitoring) {
+      theClockMerge.stop();
+      theClockPathFinding.start();
+    }
+
     // Run the path finding
     m_clusterPathAlg->ModifyClusters(clusterParametersList);
 
+    if (m_enableMonitoring) theClockPathFinding.stop();
+
     if (m_enableMonitoring) theClockFinish.start();
 
     // Get the art ouput object
@@ -696,6 +728,14 @@ namespace lar_cluster3d {
       m_clusterMergeTime = m_clusterMergeAlg->getTimeToExecute();
       m_pathFindingTime = m_clusterPathAlg->getTimeToExecute();
       m_finishTime = theClockFinish.accumulated_real_time();
+      m_hit3DWallTime = theClockHit3D.accumulated_real_time();
+      m_hit3DCPUTime = theClockHit3D.accumulated_cpu_time();
+      m_clusteringWallTime = theClockClustering.accumulated_real_time();
+      m_clusteringCPUTime = theClockClustering.accumulated_cpu_time();
+      m_clusterMergeWallTime = theClockMerge.accumulated_real_time();
+      m_clusterMergeCPUTime = theClockMerge.accumulated_cpu_time();
+      m_pathFindingWallTime = theClockPathFinding.accumulated_real_time();
+      m_pathFindingCPUTime = theClockPathFinding.accumulated_cpu_time();
       m_hits = static_cast<int>(clusterHitToArtPtrMap.size());
       m_hits3D = static_cast<int>(hitPairList->size());
       m_pRecoTree->Fill();
@@ -707,6 +747,11 @@ namespace lar_cluster3d {
                                 << ", merge: " << m_clusterMergeTime
                                 << ", path: " << m_pathFindingTime << ", finish: " << m_finishTime
                                 << std::endl;
+      mf::LogDebug("Cluster3D") << "*** Cluster3D stage wall/cpu times, hit3D: " << m_hit3DWallTime
+                                << "/" << m_hit3DCPUTime << ", clustering: " << m_clusteringWallTime
+                                << "/" << m_clusteringCPUTime << ", merge: " << m_clusterMergeWallTime
+                                << "/" << m_clusterMergeCPUTime << ", path: " << m_pathFindingWallTime
+                                << "/" << m_pathFindingCPUTime << std::endl;
     }
 
     // Will we ever get here? ;-)
@@ -732,6 +777,14 @@ namespace lar_cluster3d {
     m_pRecoTree->Branch("clusterMergeTime", &m_clusterMergeTime, "time/F");
     m_pRecoTree->Branch("pathfindingtime", &m_pathFindingTime, "time/F");
     m_pRecoTree->Branch("finishTime", &m_finishTime, "time/F");
+    m_pRecoTree->Branch("hit3DWallTime", &m_hit3DWallTime, "time/F");
+    m_pRecoTree->Branch("hit3DCPUTime", &m_hit3DCPUTime, "time/F");
+    m_pRecoTree->Branch("clusteringWallTime", &m_clusteringWallTime, "time/F");
+    m_pRecoTree->Branch("clusteringCPUTime", &m_clusteringCPUTime, "time/F");
+    m_pRecoTree->Branch("clusterMergeWallTime", &m_clusterMergeWallTime, "time/F");
+    m_pRecoTree->Branch("clusterMergeCPUTime", &m_clusterMergeCPUTime, "time/F");
+    m_pRecoTree->Branch("pathFindingWallTime", &m_pathFindingWallTime, "time/F");
+    m_pRecoTree->Branch("pathFindingCPUTime", &m_pathFindingCPUTime, "time/F");
 
     m_clusterPathAlg->initializeHistograms(*tfs.get());
 
@@ -752,8 +805,17 @@ namespace lar_cluster3d {
     m_makeHitsTime = 0.f;
     m_buildNeighborhoodTime = 0.f;
     m_dbscanTime = 0.f;
+    m_clusterMergeTime = 0.f;
     m_pathFindingTime = 0.f;
     m_finishTime = 0.f;
+    m_hit3DWallTime = 0.f;
+    m_hit3DCPUTime = 0.f;
+    m_clusteringWallTime = 0.f;
+    m_clusteringCPUTime = 0.f;
+    m_clusterMergeWallTime = 0.f;
+    m_clusterMergeCPUTime = 0.f;
+    m_pathFindingWallTime = 0.f;
+    m_pathFindingCPUTime = 0.f;
   }
 
   //------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,535 @@
+/*!
+ * Title:   BatchGausFitter Class
+ *
+ * Description:
+ * Levenberg-Marquardt fitter for many multi-Gaussian pulse trains at once.
+ * See BatchGausFitter.h for details.
+ *
+ * All working arrays are laid out as [element][lane] so that the innermost
+ * loops run over the kLanes pulse trains of a chunk and can be vectorized.
+*/
+
+#include "BatchGausFitter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace {
+
+  constexpr std::size_t kLanes = hit::BatchGausFitter::kLanes;
+
+  using LaneArray = std::array<float, kLanes>;
+
+  /// exp(x) for x <= 0 to float precision, written without branches so that
+  /// the lane loops calling it vectorize
+  inline float negExp(float x)
+  {
+    constexpr float log2e = 1.44269504f;
+    constexpr float ln2hi = 0.693145752f;
+    constexpr float ln2lo = 1.42860677e-6f;
+
+    x = std::max(x, -87.f);
+
+    // round to nearest (x is never positive so truncation after the shift works)
+    int   const n  = static_cast<int>(x * log2e - 0.5f);
+    float const fn = static_cast<float>(n);
+    float const r  = (x - fn * ln2hi) - fn * ln2lo;
+
+    float poly = 1.f / 720.f;
+    poly = poly * r + 1.f / 120.f;
+    poly = poly * r + 1.f / 24.f;
+    poly = poly * r + 1.f / 6.f;
+    poly = poly * r + 0.5f;
+    poly = poly * r + 1.f;
+    poly = poly * r + 1.f;
+
+    std::int32_t const bits = (n + 127) << 23;
+    float              scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return poly * scale;
+  }
+
+  /// Working arrays for one chunk of lanes, all with [element][lane] layout
+  struct LaneWorkspace {
+    LaneWorkspace(std::size_t nGaus, std::size_t nFree, std::size_t nTicks)
+      : nGaus(nGaus), nPars(3 * nGaus + 1), nFree(nFree), nTicks(nTicks)
+      , params(nPars * kLanes, 0.), trial(nPars * kLanes, 0.)
+      , low(nPars * kLanes, 0.), high(nPars * kLanes, 0.)
+      , data(nTicks * kLanes, 0.), mask(nTicks * kLanes, 0.)
+      , deriv(nFree * kLanes, 0.), alpha(nFree * nFree * kLanes, 0.), beta(nFree * kLanes, 0.)
+      , chol(nFree * nFree * kLanes, 0.), step(nFree * kLanes, 0.)
+      {}
+
+    std::size_t const  nGaus;
+    std::size_t const  nPars;
+    std::size_t const  nFree;
+    std::size_t const  nTicks;
+
+    std::vector<float> params;
+    std::vector<float> trial;
+    std::vector<float> low;
+    std::vector<float> high;
+    std::vector<float> data;
+    std::vector<float> mask;    ///< 1 for ticks belonging to the lane's pulse train, 0 for padding
+    std::vector<float> deriv;
+    std::vector<float> alpha;   ///< normal matrix J^T J (lower triangle)
+    std::vector<float> beta;    ///< J^T r
+    std::vector<float> chol;    ///< Cholesky factor of the damped normal matrix
+    std::vector<float> step;
+  };
+
+  /// Evaluates the model in all lanes at tick center x, filling the derivatives if requested
+  template <bool WithDerivatives>
+  inline void evaluateModel(LaneWorkspace& ws, const float* par, float x, float* value)
+  {
+    const float* baseline = par + 3 * ws.nGaus * kLanes;
+
+    for(std::size_t lane = 0; lane < kLanes; lane++) value[lane] = baseline[lane];
+
+    for(std::size_t gaus = 0; gaus < ws.nGaus; gaus++)
+    {
+      const float* amp   = par + (3 * gaus    ) * kLanes;
+      const float* mean  = par + (3 * gaus + 1) * kLanes;
+      const float* sigma = par + (3 * gaus + 2) * kLanes;
+      float*       dAmp  = ws.deriv.data() + (3 * gaus    ) * kLanes;
+      float*       dMean = ws.deriv.data() + (3 * gaus + 1) * kLanes;
+      float*       dSig  = ws.deriv.data() + (3 * gaus + 2) * kLanes;
+
+      for(std::size_t lane = 0; lane < kLanes; lane++)
+      {
+        float const invSigma = 1.f / sigma[lane];
+        float const z        = (x - mean[lane]) * invSigma;
+        float const expZ     = negExp(-0.5f * z * z);
+        float const ampExpZ  = amp[lane] * expZ;
+
+        value[lane] += ampExpZ;
+
+        if (WithDerivatives)
+        {
+          dAmp[lane]  = expZ;
+          dMean[lane] = ampExpZ * z * invSigma;
+          dSig[lane]  = dMean[lane] * z;
+        }
+      }
+    }
+
+    if (WithDerivatives && ws.nFree > 3 * ws.nGaus)
+    {
+      float* dBase = ws.deriv.data() + 3 * ws.nGaus * kLanes;
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) dBase[lane] = 1.f;
+    }
+  }
+
+  /// Computes chi2 for the parameters par in all lanes
+  void computeChi2(LaneWorkspace& ws, const float* par, LaneArray& chi2)
+  {
+    LaneArray value;
+
+    chi2.fill(0.);
+
+    for(std::size_t tick = 0; tick < ws.nTicks; tick++)
+    {
+      const float* data = ws.data.data() + tick * kLanes;
+      const float* mask = ws.mask.data() + tick * kLanes;
+
+      evaluateModel<false>(ws, par, float(tick) + 0.5f, value.data());
+
+      for(std::size_t lane = 0; lane < kLanes; lane++)
+      {
+        float const resid = mask[lane] * (data[lane] - value[lane]);
+
+        chi2[lane] += resid * resid;
+      }
+    }
+  }
+
+  /// Computes chi2 and the normal equations (alpha, beta) at the current parameters
+  void computeNormalEquations(LaneWorkspace& ws, LaneArray& chi2)
+  {
+    LaneArray value;
+    LaneArray resid;
+
+    chi2.fill(0.);
+    std::fill(ws.alpha.begin(), ws.alpha.end(), 0.);
+    std::fill(ws.beta.begin(),  ws.beta.end(),  0.);
+
+    for(std::size_t tick = 0; tick < ws.nTicks; tick++)
+    {
+      const float* data = ws.data.data() + tick * kLanes;
+      const float* mask = ws.mask.data() + tick * kLanes;
+
+      evaluateModel<true>(ws, ws.params.data(), float(tick) + 0.5f, value.data());
+
+      for(std::size_t lane = 0; lane < kLanes; lane++)
+      {
+        resid[lane]  = mask[lane] * (data[lane] - value[lane]);
+        chi2[lane]  += resid[lane] * resid[lane];
+      }
+
+      for(std::size_t row = 0; row < ws.nFree; row++)
+      {
+        float*       dRow = ws.deriv.data() + row * kLanes;
+        float*       beta = ws.beta.data()  + row * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++)
+        {
+          dRow[lane] *= mask[lane];
+          beta[lane] += dRow[lane] * resid[lane];
+        }
+
+        for(std::size_t col = 0; col <= row; col++)
+        {
+          const float* dCol  = ws.deriv.data() + col * kLanes;
+          float*       alpha = ws.alpha.data() + (row * ws.nFree + col) * kLanes;
+
+          for(std::size_t lane = 0; lane < kLanes; lane++) alpha[lane] += dRow[lane] * dCol[lane];
+        }
+      }
+    }
+  }
+
+  /// Cholesky factorization of alpha with the diagonal scaled by (1 + lambda)
+  void choleskyDecompose(LaneWorkspace& ws, const LaneArray& lambda, LaneArray& good)
+  {
+    std::size_t const n = ws.nFree;
+    LaneArray         sum;
+    LaneArray         invDiag;
+
+    good.fill(1.);
+
+    for(std::size_t col = 0; col < n; col++)
+    {
+      const float* aDiag = ws.alpha.data() + (col * n + col) * kLanes;
+      float*       cDiag = ws.chol.data()  + (col * n + col) * kLanes;
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) sum[lane] = aDiag[lane] * (1.f + lambda[lane]);
+
+      for(std::size_t k = 0; k < col; k++)
+      {
+        const float* c = ws.chol.data() + (col * n + k) * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) sum[lane] -= c[lane] * c[lane];
+      }
+
+      for(std::size_t lane = 0; lane < kLanes; lane++)
+      {
+        good[lane]    = sum[lane] > 0.f ? good[lane] : 0.f;
+        cDiag[lane]   = std::sqrt(std::max(sum[lane], std::numeric_limits<float>::min()));
+        invDiag[lane] = 1.f / cDiag[lane];
+      }
+
+      for(std::size_t row = col + 1; row < n; row++)
+      {
+        const float* a = ws.alpha.data() + (row * n + col) * kLanes;
+        float*       c = ws.chol.data()  + (row * n + col) * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) sum[lane] = a[lane];
+
+        for(std::size_t k = 0; k < col; k++)
+        {
+          const float* cRow = ws.chol.data() + (row * n + k) * kLanes;
+          const float* cCol = ws.chol.data() + (col * n + k) * kLanes;
+
+          for(std::size_t lane = 0; lane < kLanes; lane++) sum[lane] -= cRow[lane] * cCol[lane];
+        }
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) c[lane] = sum[lane] * invDiag[lane];
+      }
+    }
+  }
+
+  /// Solves (L L^T) step = beta using the Cholesky factor
+  void choleskySolve(LaneWorkspace& ws)
+  {
+    std::size_t const n = ws.nFree;
+
+    // forward substitution, L y = beta
+    for(std::size_t row = 0; row < n; row++)
+    {
+      float*       y     = ws.step.data() + row * kLanes;
+      const float* beta  = ws.beta.data() + row * kLanes;
+      const float* cDiag = ws.chol.data() + (row * n + row) * kLanes;
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) y[lane] = beta[lane];
+
+      for(std::size_t k = 0; k < row; k++)
+      {
+        const float* c  = ws.chol.data() + (row * n + k) * kLanes;
+        const float* yk = ws.step.data() + k * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) y[lane] -= c[lane] * yk[lane];
+      }
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) y[lane] /= cDiag[lane];
+    }
+
+    // back substitution, L^T step = y
+    for(std::size_t row = n; row-- > 0; )
+    {
+      float*       x     = ws.step.data() + row * kLanes;
+      const float* cDiag = ws.chol.data() + (row * n + row) * kLanes;
+
+      for(std::size_t k = row + 1; k < n; k++)
+      {
+        const float* c  = ws.chol.data() + (k * n + row) * kLanes;
+        const float* xk = ws.step.data() + k * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) x[lane] -= c[lane] * xk[lane];
+      }
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) x[lane] /= cDiag[lane];
+    }
+  }
+
+  /// Diagonal of (L L^T)^-1, i.e. the unnormalized parameter variances
+  void choleskyInverseDiagonal(LaneWorkspace& ws, std::vector<float>& variance)
+  {
+    std::size_t const  n = ws.nFree;
+    std::vector<float> inverse(n * kLanes);
+
+    variance.assign(n * kLanes, 0.);
+
+    // one column of L^-1 at a time
+    for(std::size_t col = 0; col < n; col++)
+    {
+      const float* cDiag = ws.chol.data() + (col * n + col) * kLanes;
+      float*       invCol = inverse.data() + col * kLanes;
+
+      for(std::size_t lane = 0; lane < kLanes; lane++) invCol[lane] = 1.f / cDiag[lane];
+
+      for(std::size_t row = col + 1; row < n; row++)
+      {
+        float*       invRow = inverse.data() + row * kLanes;
+        const float* cRow   = ws.chol.data() + (row * n + row) * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) invRow[lane] = 0.f;
+
+        for(std::size_t k = col; k < row; k++)
+        {
+          const float* c    = ws.chol.data() + (row * n + k) * kLanes;
+          const float* invK = inverse.data() + k * kLanes;
+
+          for(std::size_t lane = 0; lane < kLanes; lane++) invRow[lane] -= c[lane] * invK[lane];
+        }
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) invRow[lane] /= cRow[lane];
+      }
+
+      // (L L^T)^-1 = L^-T L^-1, so the diagonal is the sum of squares of the columns of L^-1
+      float* var = variance.data() + col * kLanes;
+
+      for(std::size_t row = col; row < n; row++)
+      {
+        const float* invRow = inverse.data() + row * kLanes;
+
+        for(std::size_t lane = 0; lane < kLanes; lane++) var[lane] += invRow[lane] * invRow[lane];
+      }
+    }
+  }
+
+} // namespace
+
+
+void hit::BatchGausFitter::Fit(std::vector<Problem> const& problems, std::vector<Solution>& solutions) const
+{
+    solutions.clear();
+    solutions.resize(problems.size());
+
+    // Group the problems by the shape of their parameter space
+    std::map<std::pair<std::size_t,bool>, std::vector<std::size_t>> groupMap;
+
+    for(std::size_t idx = 0; idx < problems.size(); idx++)
+    {
+        const Problem& problem = problems[idx];
+
+        if (problem.NGaussians() == 0 || !problem.signal || problem.nTicks == 0) continue;
+
+        groupMap[std::make_pair(problem.NGaussians(), problem.floatBaseline)].push_back(idx);
+    }
+
+    for(auto& group : groupMap)
+    {
+        std::vector<std::size_t>& indices = group.second;
+
+        // Similar lengths in a chunk keep the amount of padding low
+        std::stable_sort(indices.begin(), indices.end(),
+                         [&problems](std::size_t left, std::size_t right){return problems[left].nTicks < problems[right].nTicks;});
+
+        for(std::size_t first = 0; first < indices.size(); first += kLanes)
+            FitLanes(problems, indices.data() + first, std::min(kLanes, indices.size() - first), solutions);
+    }
+
+    return;
+}
+
+void hit::BatchGausFitter::FitLanes(std::vector<Problem> const& problems,
+                                    std::size_t const*          laneProblems,
+                                    std::size_t                 nLanes,
+                                    std::vector<Solution>&      solutions) const
+{
+    const Problem&    firstProblem = problems[laneProblems[0]];
+    std::size_t const nGaus        = firstProblem.NGaussians();
+    std::size_t const nFree        = 3 * nGaus + (firstProblem.floatBaseline ? 1 : 0);
+    std::size_t       nTicks       = 0;
+
+    for(std::size_t lane = 0; lane < nLanes; lane++) nTicks = std::max(nTicks, problems[laneProblems[lane]].nTicks);
+
+    LaneWorkspace ws(nGaus, nFree, nTicks);
+
+    // Transpose the inputs into the lanes; unused lanes get a harmless flat model
+    for(std::size_t lane = 0; lane < kLanes; lane++)
+    {
+        for(std::size_t gaus = 0; gaus < nGaus; gaus++)
+        {
+            ws.params[(3 * gaus + 2) * kLanes + lane] = 1.;
+            ws.low[   (3 * gaus + 2) * kLanes + lane] = 1.;
+            ws.high[  (3 * gaus + 2) * kLanes + lane] = 1.;
+        }
+
+        if (lane >= nLanes) continue;
+
+        const Problem& problem = problems[laneProblems[lane]];
+
+        for(std::size_t par = 0; par < ws.nPars; par++)
+        {
+            float const lowLimit  = par < problem.lowLimits.size()  ? problem.lowLimits[par]  : problem.params[par];
+            float const highLimit = par < problem.highLimits.size() ? problem.highLimits[par] : problem.params[par];
+
+            ws.params[par * kLanes + lane] = problem.params[par];
+            ws.low[   par * kLanes + lane] = std::min(lowLimit, highLimit);
+            ws.high[  par * kLanes + lane] = std::max(lowLimit, highLimit);
+        }
+
+        for(std::size_t tick = 0; tick < problem.nTicks; tick++)
+        {
+            ws.data[tick * kLanes + lane] = problem.signal[tick];
+            ws.mask[tick * kLanes + lane] = 1.;
+        }
+    }
+
+    LaneArray    chi2;
+    LaneArray    trialChi2;
+    LaneArray    lambda;
+    LaneArray    good;
+    LaneArray    accepted;
+    std::array<bool,kLanes>         active;
+    std::array<unsigned int,kLanes> iterations;
+
+    lambda.fill(fConfig.startLambda);
+    iterations.fill(0);
+
+    for(std::size_t lane = 0; lane < kLanes; lane++) active[lane] = lane < nLanes;
+
+    computeNormalEquations(ws, chi2);
+
+    for(unsigned int iter = 0; iter < fConfig.maxIterations; iter++)
+    {
+        if (std::none_of(active.begin(), active.end(), [](bool isActive){return isActive;})) break;
+
+        choleskyDecompose(ws, lambda, good);
+        choleskySolve(ws);
+
+        // Take the step, respecting the parameter limits
+        for(std::size_t par = 0; par < ws.nPars; par++)
+        {
+            const float* param = ws.params.data() + par * kLanes;
+            const float* low   = ws.low.data()    + par * kLanes;
+            const float* high  = ws.high.data()   + par * kLanes;
+            float*       trial = ws.trial.data()  + par * kLanes;
+
+            if (par < nFree)
+            {
+                const float* step = ws.step.data() + par * kLanes;
+
+                for(std::size_t lane = 0; lane < kLanes; lane++)
+                    trial[lane] = std::min(std::max(param[lane] + step[lane], low[lane]), high[lane]);
+            }
+            else
+            {
+                for(std::size_t lane = 0; lane < kLanes; lane++) trial[lane] = param[lane];
+            }
+        }
+
+        computeChi2(ws, ws.trial.data(), trialChi2);
+
+        bool anyAccepted(false);
+
+        for(std::size_t lane = 0; lane < kLanes; lane++)
+        {
+            accepted[lane] = 0.;
+
+            if (!active[lane]) continue;
+
+            iterations[lane]++;
+
+            if (good[lane] > 0.f && trialChi2[lane] < chi2[lane])
+            {
+                accepted[lane]  = 1.;
+                anyAccepted     = true;
+                lambda[lane]   *= 0.1f;
+
+                if (chi2[lane] - trialChi2[lane] < fConfig.chi2Tolerance) active[lane] = false;
+            }
+            else
+            {
+                lambda[lane] *= 10.f;
+
+                // No downhill step left, we are sitting in the minimum
+                if (lambda[lane] > fConfig.maxLambda) active[lane] = false;
+            }
+        }
+
+        if (!anyAccepted) continue;
+
+        for(std::size_t par = 0; par < nFree; par++)
+        {
+            float*       param = ws.params.data() + par * kLanes;
+            const float* trial = ws.trial.data()  + par * kLanes;
+
+            for(std::size_t lane = 0; lane < kLanes; lane++)
+                param[lane] = accepted[lane] > 0.f ? trial[lane] : param[lane];
+        }
+
+        computeNormalEquations(ws, chi2);
+    }
+
+    // Parameter errors from the undamped normal matrix at the minimum
+    std::vector<float> variance;
+
+    lambda.fill(0.);
+    choleskyDecompose(ws, lambda, good);
+    choleskyInverseDiagonal(ws, variance);
+
+    for(std::size_t lane = 0; lane < nLanes; lane++)
+    {
+        const Problem& problem  = problems[laneProblems[lane]];
+        Solution&      solution = solutions[laneProblems[lane]];
+
+        solution.params.resize(ws.nPars);
+        solution.errors.assign(ws.nPars, 0.);
+        solution.chi2       = chi2[lane];
+        solution.NDF        = int(problem.nTicks) - int(nFree);
+        solution.iterations = iterations[lane];
+        solution.valid      = std::isfinite(solution.chi2) && solution.NDF > 0;
+
+        float const errorNorm = solution.NDF > 0 ? solution.chi2 / float(solution.NDF) : 0.;
+
+        for(std::size_t par = 0; par < ws.nPars; par++)
+        {
+            solution.params[par] = ws.params[par * kLanes + lane];
+            solution.valid       = solution.valid && std::isfinite(solution.params[par]);
+
+            if (par < nFree && good[lane] > 0.f) solution.errors[par] = std::sqrt(variance[par * kLanes + lane] * errorNorm);
+        }
+    }
+
+    return;
+}
@@ -0,0 +1,91 @@
+#ifndef BATCHGAUSFITTER_H
+#define BATCHGAUSFITTER_H
+
+/*!
+ * Title:   BatchGausFitter Class
+ *
+ * Description:
+ * Levenberg-Marquardt least squares fitter for many multi-Gaussian pulse
+ * trains at once. Pulse trains with the same number of Gaussians are packed
+ * into structure-of-arrays "lanes" so that the model, the analytic Jacobian,
+ * the normal equations and their Cholesky solution are all evaluated for
+ * kLanes pulse trains in lock-step with plain, vectorizable loops.
+ *
+ * The fit model is the one of BaselinedGausFitCache (PeakFitterGaussian):
+ *
+ *     f(x) = sum_k A_k exp(-0.5 ((x - m_k) / s_k)^2) + baseline
+ *
+ * evaluated at the tick centers x = tick + 0.5, with unit weights and box
+ * limits on every parameter. Parameter errors are taken from the inverse of
+ * the normal matrix, normalized by chi2/NDF as ROOT does for "W" fits.
+ *
+ * The fitter holds no mutable state and can be called concurrently.
+ *
+ * Input:  Vector of pulse trains with starting parameters and limits
+ * Output: Fitted parameters, errors, chi2 and NDF for each pulse train
+*/
+
+#include <cstddef>
+#include <vector>
+
+namespace hit{
+
+  class BatchGausFitter {
+
+  public:
+
+    /// Number of pulse trains fitted in lock-step
+    static constexpr std::size_t kLanes = 8;
+
+    struct Config {
+      unsigned int maxIterations = 100;    ///< maximum number of LM steps per pulse train
+      float        chi2Tolerance = 1.e-3;  ///< converged when an accepted step improves chi2 by less
+      float        startLambda   = 1.e-3;  ///< initial Marquardt damping parameter
+      float        maxLambda     = 1.e10;  ///< damping at which no better point can be found
+    };
+
+    /// A single pulse train to fit
+    ///
+    /// Parameters are stored as (amplitude, mean, sigma) for each Gaussian
+    /// followed by the baseline, i.e. 3 * nGaus + 1 values.
+    struct Problem {
+      const float*       signal        = nullptr; ///< first tick of the pulse train
+      std::size_t        nTicks        = 0;       ///< number of ticks to fit
+      bool               floatBaseline = false;   ///< if false the baseline is held fixed
+      std::vector<float> params;                  ///< starting values
+      std::vector<float> lowLimits;               ///< lower limit of each parameter
+      std::vector<float> highLimits;              ///< upper limit of each parameter
+
+      std::size_t NGaussians() const { return params.size() / 3; }
+    };
+
+    /// Result of the fit of one pulse train (same parameter layout as Problem)
+    struct Solution {
+      std::vector<float> params;
+      std::vector<float> errors;
+      float              chi2       = 0.;
+      int                NDF        = 0;
+      unsigned int       iterations = 0;
+      bool               valid      = false;      ///< false if the fit did not produce finite results
+    };
+
+    BatchGausFitter() = default;
+    explicit BatchGausFitter(Config const& config): fConfig(config) {}
+
+    /// Fits all problems; solutions are returned in the same order
+    void Fit(std::vector<Problem> const& problems, std::vector<Solution>& solutions) const;
+
+  private:
+
+    void FitLanes(std::vector<Problem> const& problems,
+                  std::size_t const*          laneProblems,
+                  std::size_t                 nLanes,
+                  std::vector<Solution>&      solutions) const;
+
+    Config fConfig;
+
+  };
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 // C/C++ standard library
 #include <atomic>
 #include <algorithm> // std::accumulate()
+#include <chrono>
 #include <string>
 #include <memory> // std::unique_ptr()
 #include <utility> // std::move()
@@ -39,6 +40,7 @@
 #include "fhiclcpp/ParameterSet.h"
 #include "art/Utilities/make_tool.h"
 #include "art/Utilities/Globals.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 // LArSoft Includes
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
@@ -56,7 +58,6 @@
 #include "TMath.h"
 
 #include "tbb/tbb.h"
-#include "tbb/concurrent_vector.h"
 
 namespace hit{
 class GausHitFinder : public art::SharedProducer {
@@ -69,6 +70,7 @@ public:
 
     void produce(art::Event& evt, art::ProcessingFrame const&) override;
     void beginJob(art::ProcessingFrame const&) override;
+    void endJob(art::ProcessingFrame const&) override;
 
 private:
     std::vector<double> FillOutHitParameterVector(const std::vector<double>& input);
@@ -92,10 +94,11 @@ private:
     const std::vector<float>  fPulseRatioCuts;
 
     std::atomic <size_t>      fEventCount{0};
+    std::atomic <long long>   fMergeTimeNs{0};           ///< total time spent merging the per wire hit buffers
 
     //only Standard and Morphological implementation is threadsafe. 
     std::vector<std::unique_ptr<reco_tool::ICandidateHitFinder>> fHitFinderToolVec;  ///< For finding candidate hits
-    // only Marqdt implementation is threadsafe. 
+    // only Marqdt and GaussBatch implementations are threadsafe. 
     std::unique_ptr<reco_tool::IPeakFitter>                      fPeakFitterTool;    ///< Perform fit to candidate peaks
     //HitFilterAlg implementation is threadsafe. 
     std::unique_ptr<HitFilterAlg>                                fHitFilterAlg;      ///< algorithm used to filter out noise hits
@@ -206,6 +209,16 @@ void GausHitFinder::beginJob(art::ProcessingFrame const&)
     }
 }
 
+//-------------------------------------------------
+//-------------------------------------------------
+void GausHitFinder::endJob(art::ProcessingFrame const&)
+{
+    size_t const nEvents = fEventCount.load();
+
+    mf::LogInfo("GausHitFinder") << "Merging per wire hit buffers took " << 1.e-6 * fMergeTimeNs.load() << " ms in total for "
+                                 << nEvents << " events (" << (nEvents ? 1.e-6 * fMergeTimeNs.load() / nEvents : 0.) << " ms per event)";
+}
+
 //  This algorithm uses the fact that deconvolved signals are very smooth
 //  and looks for hits as areas between local minima that have signal above
 //  threshold.
@@ -239,15 +252,16 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
 
     if( fFilterHits ) filteredHitCol = &hcol;
 
-    //store in a thread safe way
+    //store in a thread safe way: each wire only writes to its own buffer,
+    //the buffers are merged in wire order after the parallel loop so the
+    //output does not depend on the number of threads
     struct hitstruct
     {
       recob::Hit hit_tbb;
       art::Ptr<recob::Wire> wire_tbb;
     };
 
-    tbb::concurrent_vector<hitstruct> hitstruct_vec;
-    tbb::concurrent_vector<hitstruct> filthitstruct_vec;
+    using hitstructvec = std::vector<hitstruct>;
 
 //    if (fAllHitsInstanceName != "") filteredHitCol = &hcol;
 
@@ -257,6 +271,8 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
     art::Handle< std::vector<recob::Wire> > wireVecHandle;
     evt.getByLabel(fCalDataModuleLabel,wireVecHandle);
 
+    std::vector<hitstructvec> hitstruct_vec(wireVecHandle->size());
+    std::vector<hitstructvec> filthitstruct_vec(wireVecHandle->size());
 
 
     //#################################################
@@ -290,6 +306,10 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
         // ####################################
         art::Ptr<recob::Wire>   wire(wireVecHandle, wireIter);
 
+        // The output buffers for this wire
+        hitstructvec& wireHitstructVec     = hitstruct_vec[wireIter];
+        hitstructvec& wireFiltHitstructVec = filthitstruct_vec[wireIter];
+
         // --- Setting Channel Number and Signal type ---
 
 	raw::ChannelID_t channel = wire->Channel();
@@ -310,21 +330,52 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
         // ### Set up to loop over ROI's for this wire   ###
         // #################################################
         const recob::Wire::RegionsOfInterest_t& signalROI = wire->SignalROI();
+        const auto&                             rangeVec  = signalROI.get_ranges();
 
-        for(const auto& range : signalROI.get_ranges())
-        {
-            // ROI start time
-            raw::TDCtick_t roiFirstBinTick = range.begin_index();
+        // ###########################################################
+        // ### Scan the waveforms and find candidate peaks + merge ###
+        // ###########################################################
 
-            // ###########################################################
-            // ### Scan the waveform and find candidate peaks + merge  ###
-            // ###########################################################
+        std::vector<reco_tool::ICandidateHitFinder::MergeHitCandidateVec> mergedCandidateHitVecs(rangeVec.size());
 
-            reco_tool::ICandidateHitFinder::HitCandidateVec      hitCandidateVec;
-            reco_tool::ICandidateHitFinder::MergeHitCandidateVec mergedCandidateHitVec;
+        reco_tool::IPeakFitter::PeakFitInputVec peakFitInputVec;
+
+        for(size_t rangeIdx = 0; rangeIdx < rangeVec.size(); rangeIdx++)
+        {
+            const auto& range = rangeVec[rangeIdx];
+
+            reco_tool::ICandidateHitFinder::HitCandidateVec hitCandidateVec;
 
             fHitFinderToolVec.at(plane)->findHitCandidates(range, 0, channel, count, hitCandidateVec);
-            fHitFinderToolVec.at(plane)->MergeHitCandidates(range, hitCandidateVec, mergedCandidateHitVec);
+            fHitFinderToolVec.at(plane)->MergeHitCandidates(range, hitCandidateVec, mergedCandidateHitVecs[rangeIdx]);
+
+            // Queue the pulses to fit, with the same selection as in the loop below
+            for(const auto& mergedCands : mergedCandidateHitVecs[rangeIdx])
+            {
+                if (int(mergedCands.back().stopTick) - int(mergedCands.front().startTick) < 5) continue;
+
+                if (mergedCands.size() <= fMaxMultiHit) peakFitInputVec.push_back({&range.data(), &mergedCands});
+            }
+        }
+
+        // ##################################################################
+        // ### Fit all pulses on this wire at once, fitter tools which    ###
+        // ### can batch the pulse trains will do so                      ###
+        // ##################################################################
+        reco_tool::IPeakFitter::PeakFitOutputVec peakFitOutputVec;
+
+        fPeakFitterTool->findBatchPeakParameters(peakFitInputVec, peakFitOutputVec);
+
+        size_t peakFitIdx(0);
+
+        for(size_t rangeIdx = 0; rangeIdx < rangeVec.size(); rangeIdx++)
+        {
+            const auto& range = rangeVec[rangeIdx];
+
+            // ROI start time
+            raw::TDCtick_t roiFirstBinTick = range.begin_index();
+
+            reco_tool::ICandidateHitFinder::MergeHitCandidateVec& mergedCandidateHitVec = mergedCandidateHitVecs[rangeIdx];
 
             // #######################################################
             // ### Lets loop over the pulses we found on this wire ###
@@ -348,7 +399,7 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
                 int nGausForFit = mergedCands.size();
 
                 // ##################################################
-                // ### Calling the function for fitting Gaussians ###
+                // ### Recover the result of fitting Gaussians    ###
                 // ##################################################
                 double                                chi2PerNDF(0.);
                 int                                   NDF(1);
@@ -362,7 +413,11 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
                 // #######################################################
                 if (mergedCands.size() <= fMaxMultiHit)
                 {
-                    fPeakFitterTool->findPeakParameters(range.data(), mergedCands, peakParamsVec, chi2PerNDF, NDF);
+                    reco_tool::IPeakFitter::PeakFitOutput_t& peakFitOutput = peakFitOutputVec.at(peakFitIdx++);
+
+                    peakParamsVec = std::move(peakFitOutput.peakParams);
+                    chi2PerNDF    = peakFitOutput.chi2PerNDF;
+                    NDF           = peakFitOutput.NDF;
 
                     // If the chi2 is infinite then there is a real problem so we bail
                     if (!(chi2PerNDF < std::numeric_limits<double>::infinity()))
@@ -487,11 +542,8 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
 
                     if (filteredHitCol) filteredHitVec.push_back(hitcreator.copy());
 
-                    const recob::Hit hit(hitcreator.move());
-
                     // This loop will store ALL hits
-		    hitstruct tmp{std::move(hit),wire};
-		    hitstruct_vec.push_back(std::move(tmp));
+                    wireHitstructVec.push_back(hitstruct{hitcreator.move(),wire});
 
                     numHits++;
                 } // <---End loop over gaussians
@@ -531,10 +583,9 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
                     }
 
                     // Copy the hits we want to keep to the filtered hit collection
-                    for(const auto& filteredHit : filteredHitVec)
+                    for(auto& filteredHit : filteredHitVec)
 		      if (!fHitFilterAlg || fHitFilterAlg->IsGoodHit(filteredHit)){
-			hitstruct tmp{std::move(filteredHit),wire};
-			filthitstruct_vec.push_back(std::move(tmp));
+			wireFiltHitstructVec.push_back(hitstruct{std::move(filteredHit),wire});
 		      }
 
 		    if (fFillHists) fChi2->Fill(chi2PerNDF);
@@ -546,13 +597,26 @@ void GausHitFinder::produce(art::Event& evt, art::ProcessingFrame const&)
      }//<---End looping over all the wires
     );//end tbb parallel for
 
-    for(size_t i=0; i<hitstruct_vec.size(); i++){
-      allHitCol.emplace_back(hitstruct_vec[i].hit_tbb, hitstruct_vec[i].wire_tbb);
-    }
+    // Merge the per wire buffers in wire order, moving each hit once
+    auto mergeStart = std::chrono::steady_clock::now();
 
-    for(size_t j=0; j<filthitstruct_vec.size(); j++){
-      filteredHitCol->emplace_back(filthitstruct_vec[j].hit_tbb, filthitstruct_vec[j].wire_tbb);
-    }
+    auto mergeHits = [](std::vector<hitstructvec>& hitstructVecs, recob::HitCollectionCreator& hitCol)
+    {
+      size_t nHits(0);
+
+      for(const auto& wireHits : hitstructVecs) nHits += wireHits.size();
+
+      hitCol.reserve(nHits);
+
+      for(auto& wireHits : hitstructVecs)
+        for(auto& hitStruct : wireHits) hitCol.emplace_back(std::move(hitStruct.hit_tbb), hitStruct.wire_tbb);
+    };
+
+    mergeHits(hitstruct_vec, allHitCol);
+
+    if (filteredHitCol) mergeHits(filthitstruct_vec, *filteredHitCol);
+
+    fMergeTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mergeStart).count();
 
     //==================================================================================================
     // End of the event -- move the hit collection and the associations into the event
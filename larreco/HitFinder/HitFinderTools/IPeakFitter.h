@@ -35,6 +35,24 @@ namespace reco_tool
         };
 
         using PeakParamsVec = std::vector<PeakFitParams_t>;
+
+        // Define structures for fitting several pulse trains in one call
+        struct PeakFitInput_t
+        {
+            const std::vector<float>*                   signal;       ///< waveform the candidates refer to
+            const ICandidateHitFinder::HitCandidateVec* candidates;   ///< candidate peaks of one pulse train
+        };
+
+        struct PeakFitOutput_t
+        {
+            PeakParamsVec peakParams;
+            double        chi2PerNDF = 0.;
+            int           NDF        = 1;
+        };
+
+        using PeakFitInputVec  = std::vector<PeakFitInput_t>;
+        using PeakFitOutputVec = std::vector<PeakFitOutput_t>;
+
         virtual ~IPeakFitter() = default;
         // Get parameters for input candidate peaks
         virtual void findPeakParameters(const std::vector<float>&,
@@ -42,6 +60,23 @@ namespace reco_tool
                                         PeakParamsVec&,
                                         double&,
                                         int&) const = 0;
+
+        // Get parameters for a batch of pulse trains, output is in input order.
+        // Tools which can fit several pulse trains at once should override this,
+        // by default each pulse train is fit on its own.
+        virtual void findBatchPeakParameters(const PeakFitInputVec& inputVec,
+                                             PeakFitOutputVec&      outputVec) const
+        {
+            outputVec.clear();
+            outputVec.resize(inputVec.size());
+
+            for(size_t idx = 0; idx < inputVec.size(); idx++)
+            {
+                PeakFitOutput_t& output = outputVec[idx];
+
+                findPeakParameters(*inputVec[idx].signal, *inputVec[idx].candidates, output.peakParams, output.chi2PerNDF, output.NDF);
+            }
+        }
     };
 }
 
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////
+/// \file   PeakFitterGaussBatch.cc
+///
+/// \brief  Multi-Gaussian peak fitter which fits many pulse trains at once
+///
+/// This implements the same fit as PeakFitterGaussian (Gaussians plus an
+/// optionally floating baseline, parameter limits, unit weights) but without
+/// ROOT objects: pulse trains are handed to hit::BatchGausFitter which runs a
+/// Levenberg-Marquardt minimization with analytic derivatives on batches of
+/// pulse trains of the same multiplicity. The tool has no mutable state so it
+/// can be used from the GausHitFinder parallel loop over wires.
+///
+////////////////////////////////////////////////////////////////////////
+
+#include "larreco/HitFinder/HitFinderTools/IPeakFitter.h"
+#include "larreco/HitFinder/BatchGausFitter.h"
+
+#include "art/Utilities/ToolMacros.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace reco_tool
+{
+
+class PeakFitterGaussBatch : IPeakFitter
+{
+public:
+    explicit PeakFitterGaussBatch(const fhicl::ParameterSet& pset);
+
+    void findPeakParameters(const std::vector<float>&,
+                            const ICandidateHitFinder::HitCandidateVec&,
+                            PeakParamsVec&,
+                            double&,
+                            int&) const override;
+
+    void findBatchPeakParameters(const PeakFitInputVec&,
+                                 PeakFitOutputVec&) const override;
+
+private:
+    // Translate the candidate peaks into the fit problem
+    void setupProblem(const PeakFitInput_t&, hit::BatchGausFitter::Problem&) const;
+
+    // Member variables from the fhicl file
+    const double                   fMinWidth;          ///< minimum initial width for gaussian fit
+    const double                   fMaxWidthMult;      ///< multiplier for max width for gaussian fit
+    const double                   fPeakRange;         ///< set range limits for peak center
+    const double                   fAmpRange;          ///< set range limit for peak amplitude
+    const bool                     fFloatBaseline;     ///< Allow baseline to "float" away from zero
+
+    const hit::BatchGausFitter     fFitter;            ///< The fitter doing the actual work
+};
+
+//----------------------------------------------------------------------
+// Constructor.
+PeakFitterGaussBatch::PeakFitterGaussBatch(const fhicl::ParameterSet& pset):
+    fMinWidth(pset.get<double>("MinWidth",         0.5)),
+    fMaxWidthMult (pset.get<double>("MaxWidthMult",     3.)),
+    fPeakRange(pset.get<double>("PeakRangeFact",    2.)),
+    fAmpRange(pset.get<double>("PeakAmpRange",     2.)),
+    fFloatBaseline(pset.get< bool >("FloatBaseline",    false)),
+    fFitter([&pset]{
+        hit::BatchGausFitter::Config config;
+        config.maxIterations = pset.get<unsigned int>("MaxIterations", 100);
+        config.chi2Tolerance = pset.get<float       >("Chi2Tolerance", 1.e-3);
+        return hit::BatchGausFitter(config);
+    }())
+{
+    return;
+}
+
+// --------------------------------------------------------------------------------------------
+void PeakFitterGaussBatch::setupProblem(const PeakFitInput_t&          input,
+                                        hit::BatchGausFitter::Problem& problem) const
+{
+    // As for PeakFitterGaussian the reference time for the input hit candidates
+    // is the first tick of the input waveform
+    const ICandidateHitFinder::HitCandidateVec& hitCandidateVec = *input.candidates;
+
+    int startTime = hitCandidateVec.front().startTick;
+    int endTime   = hitCandidateVec.back().stopTick;
+    int roiSize   = endTime - startTime;
+
+    problem.signal        = input.signal->data() + startTime;
+    problem.nTicks        = std::max(roiSize, 0);
+    problem.floatBaseline = fFloatBaseline;
+
+    problem.params.clear();
+    problem.lowLimits.clear();
+    problem.highLimits.clear();
+
+    float baseline = fFloatBaseline ? (*input.signal)[startTime] : 0.;
+
+    for(auto const& candidateHit : hitCandidateVec)
+    {
+        double const peakMean   = candidateHit.hitCenter - float(startTime);
+        double const peakWidth  = candidateHit.hitSigma;
+        double const amplitude  = candidateHit.hitHeight - baseline;
+        double const meanLowLim = std::max(peakMean - fPeakRange * peakWidth,              0.);
+        double const meanHiLim  = std::min(peakMean + fPeakRange * peakWidth, double(roiSize));
+
+        problem.params.insert(    problem.params.end(),     {float(amplitude),       float(peakMean),   float(peakWidth)});
+        problem.lowLimits.insert( problem.lowLimits.end(),  {float(0.1 * amplitude), float(meanLowLim), float(std::max(fMinWidth, 0.1 * peakWidth))});
+        problem.highLimits.insert(problem.highLimits.end(), {float(fAmpRange * amplitude), float(meanHiLim), float(fMaxWidthMult * peakWidth)});
+    }
+
+    // The baseline is always the last parameter
+    problem.params.push_back(baseline);
+    problem.lowLimits.push_back( fFloatBaseline ? baseline - 12. : baseline);
+    problem.highLimits.push_back(fFloatBaseline ? baseline + 12. : baseline);
+
+    return;
+}
+
+// --------------------------------------------------------------------------------------------
+void PeakFitterGaussBatch::findPeakParameters(const std::vector<float>&                   roiSignalVec,
+                                              const ICandidateHitFinder::HitCandidateVec& hitCandidateVec,
+                                              PeakParamsVec&                              peakParamsVec,
+                                              double&                                     chi2PerNDF,
+                                              int&                                        NDF) const
+{
+    if (hitCandidateVec.empty()) return;
+
+    PeakFitOutputVec outputVec;
+
+    findBatchPeakParameters(PeakFitInputVec{{&roiSignalVec, &hitCandidateVec}}, outputVec);
+
+    PeakFitOutput_t& output = outputVec.front();
+
+    chi2PerNDF = output.chi2PerNDF;
+
+    if (output.chi2PerNDF < std::numeric_limits<double>::infinity()) NDF = output.NDF;
+
+    for(const auto& peakParams : output.peakParams) peakParamsVec.emplace_back(peakParams);
+
+    return;
+}
+
+// --------------------------------------------------------------------------------------------
+void PeakFitterGaussBatch::findBatchPeakParameters(const PeakFitInputVec& inputVec,
+                                                   PeakFitOutputVec&      outputVec) const
+{
+    std::vector<hit::BatchGausFitter::Problem>  problemVec(inputVec.size());
+    std::vector<hit::BatchGausFitter::Solution> solutionVec;
+
+    for(size_t idx = 0; idx < inputVec.size(); idx++)
+    {
+        if (inputVec[idx].candidates->empty()) continue;
+
+        setupProblem(inputVec[idx], problemVec[idx]);
+    }
+
+    fFitter.Fit(problemVec, solutionVec);
+
+    outputVec.clear();
+    outputVec.resize(inputVec.size());
+
+    for(size_t idx = 0; idx < inputVec.size(); idx++)
+    {
+        const hit::BatchGausFitter::Solution& solution = solutionVec[idx];
+        PeakFitOutput_t&                      output   = outputVec[idx];
+
+        // in case of a fit failure, set the chi-square to infinity
+        output.chi2PerNDF = std::numeric_limits<double>::infinity();
+
+        if (!solution.valid) continue;
+
+        int const startTime = inputVec[idx].candidates->front().startTick;
+
+        output.chi2PerNDF = solution.chi2 / solution.NDF;
+        output.NDF        = solution.NDF;
+
+        for(size_t parIdx = 0; parIdx + 1 < solution.params.size(); parIdx += 3)
+        {
+            PeakFitParams_t peakParams;
+
+            peakParams.peakAmplitude      = solution.params[parIdx];
+            peakParams.peakAmplitudeError = solution.errors[parIdx];
+            peakParams.peakCenter         = solution.params[parIdx + 1] + float(startTime);
+            peakParams.peakCenterError    = solution.errors[parIdx + 1];
+            peakParams.peakSigma          = solution.params[parIdx + 2];
+            peakParams.peakSigmaError     = solution.errors[parIdx + 2];
+
+            output.peakParams.emplace_back(peakParams);
+        }
+    }
+
+    return;
+}
+
+DEFINE_ART_CLASS_TOOL(PeakFitterGaussBatch)
+}
@@ -3,9 +3,11 @@
 #include "larreco/QuadVtx/HeatMap.h"
 
 // C/C++ standard libraries
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <random>
+#include <tuple>
 
 // framework libraries
 #include "fhiclcpp/ParameterSet.h"
@@ -29,6 +31,9 @@
 #include "TMatrixD.h"
 #include "TVectorD.h"
 
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+
 namespace quad
 {
 
@@ -181,17 +186,69 @@ inline bool CloseAngles(float ma, float mb)
   return cet::square(dot) > (1+cet::square(ma))*(1+cet::square(mb))*cet::square(cosCrit);
 }
 
+// ---------------------------------------------------------------------------
+// Map bin of the crossing of line a with each of the n lines b[0], b[stride],
+// ..., or -1 if the crossing is within one of the two lines or off the map.
+// The same bins as HeatMap::ZToBin() and XToBin(), but written without
+// branches so that the compiler can vectorize the loop
+inline void CrossingBins(const Line2D& a, const Line2D* __restrict__ b,
+                         int n, int stride, const HeatMap& hm,
+                         int* __restrict__ bins)
+{
+  const double dz = hm.maxz-hm.minz;
+  const double dx = hm.maxx-hm.minx;
+  const double Nz = hm.Nz;
+  const double Nx = hm.Nx;
+
+  for(int k = 0; k < n; ++k){
+    const Line2D& bk = b[k*stride];
+
+    // x = mA * z + cA = mB * z + cB
+    const float z = (bk.c-a.c)/(a.m-bk.m);
+    const float x = a.m*z+a.c;
+
+    // No solutions within a line
+    const bool outside = ((z < a.minz) | (z > a.maxz)) & ((z < bk.minz) | (z > bk.maxz));
+
+    const double fz = (z-hm.minz)/dz*Nz;
+    const double fx = (x-hm.minx)/dx*Nx;
+
+    const bool inMap = outside & (fz >= 0) & (fz < Nz) & (fx >= 0) & (fx < Nx);
+
+    // only convert in-range values, parallel lines give infinities
+    const int iz = int(inMap ? fz : 0.);
+    const int ix = int(inMap ? fx : 0.);
+
+    bins[k] = inMap ? iz*hm.Nx + ix : -1;
+  }
+}
+
 // ---------------------------------------------------------------------------
 void MapFromLines(const std::vector<Line2D>& lines, HeatMap& hm)
 {
   // This maximum is driven by runtime
   constexpr size_t kMaxPts = 10*1000*1000;
 
+  // Lines combined by each parallel task, and crossings binned per call of
+  // the vectorized kernel
+  constexpr unsigned int kChunkSize = 256;
+  constexpr int kBatchSize = 256;
+
+  const unsigned int nA = lines.empty() ? 0 : lines.size()-1;
+
+  // The window of lines at a large enough angle to line i only moves
+  // forward. Remember where it was at the start of each chunk so that the
+  // chunks can be filled independently.
+  std::vector<std::pair<unsigned int, unsigned int>> chunkWindows;
+  chunkWindows.reserve(nA/kChunkSize+1);
+
   unsigned int j0 = 0;
   unsigned int jmax = 0;
 
   long npts = 0;
-  for(unsigned int i = 0; i+1 < lines.size(); ++i){
+  for(unsigned int i = 0; i < nA; ++i){
+    if(i % kChunkSize == 0) chunkWindows.emplace_back(j0, jmax);
+
     const Line2D a = lines[i];
 
     j0 = std::max(j0, i+1);
@@ -209,45 +266,63 @@ void MapFromLines(const std::vector<Line2D>& lines, HeatMap& hm)
 
   mf::LogInfo() << npts << " cf " << product << " ie " << double(npts)/product << std::endl;
 
-  j0 = 0;
-  jmax = 0;
+  // Each thread fills its own map, they are summed at the end. The entries
+  // are integers, so the sum does not depend on the order.
+  tbb::enumerable_thread_specific<std::vector<float>> partialMaps([&hm](){return std::vector<float>(hm.map.size(), 0);});
 
-  for(unsigned int i = 0; i+1 < lines.size(); ++i){
-    const Line2D a = lines[i];
+  tbb::parallel_for(size_t(0), chunkWindows.size(), [&](size_t chunk){
+    std::vector<float>& map = partialMaps.local();
 
-    j0 = std::max(j0, i+1);
-    while(j0 < lines.size() && CloseAngles(a.m, lines[j0].m)) ++j0;
-    jmax = std::max(jmax, j0);
-    while(jmax < lines.size() && !CloseAngles(a.m, lines[jmax].m)) ++jmax;
+    unsigned int j0 = chunkWindows[chunk].first;
+    unsigned int jmax = chunkWindows[chunk].second;
 
-    for(unsigned int j = j0; j < jmax; j += stride){
-      const Line2D& b = lines[j];
+    int bins[kBatchSize];
 
-      // x = mA * z + cA = mB * z + cB
-      const float z = (b.c-a.c)/(a.m-b.m);
-      const float x = a.m*z+a.c;
+    const unsigned int iEnd = std::min(nA, unsigned((chunk+1)*kChunkSize));
+    for(unsigned int i = chunk*kChunkSize; i < iEnd; ++i){
+      const Line2D a = lines[i];
 
-      // No solutions within a line
-      if((z < a.minz || z > a.maxz) && (z < b.minz || z > b.maxz)){
-        const int iz = hm.ZToBin(z);
-        const int ix = hm.XToBin(x);
-        if(iz >= 0 && iz < hm.Nz && ix >= 0 && ix < hm.Nx){
-          hm.map[iz*hm.Nx + ix] += stride;
+      j0 = std::max(j0, i+1);
+      while(j0 < lines.size() && CloseAngles(a.m, lines[j0].m)) ++j0;
+      jmax = std::max(jmax, j0);
+      while(jmax < lines.size() && !CloseAngles(a.m, lines[jmax].m)) ++jmax;
+
+      for(unsigned int j = j0; j < jmax; j += kBatchSize*stride){
+        const int n = std::min<long>(kBatchSize, (jmax-j+stride-1)/stride);
+
+        CrossingBins(a, &lines[j], n, stride, hm, bins);
+
+        for(int k = 0; k < n; ++k){
+          if(bins[k] >= 0) map[bins[k]] += stride;
         }
       }
     } // end for i
-  }
+  });
+
+  partialMaps.combine_each([&hm](const std::vector<float>& map){
+      for(unsigned int i = 0; i < map.size(); ++i) hm.map[i] += map[i];
+    });
 }
 
 // ---------------------------------------------------------------------------
 // Assumes that all three maps have the same vertical stride
+//
+// Finds the same peak as scanning every (z, u, x) bin: the highest sum of
+// the three views, and of those the first one in z, u, x order. Blocks of
+// kBlockZ x kBlockZ z and u bins are visited from the largest upper bound on
+// their score down, and within them blocks of kBlockX x bins, skipping any
+// whose bound is below the best score found so far.
 TVector3 FindPeak3D(const std::vector<HeatMap>& hs,
                     const std::vector<TVector3>& dirs) noexcept
 {
   assert(hs.size() == 3);
   assert(dirs.size() == 3);
 
+  constexpr int kBlockZ = 8;
+  constexpr int kBlockX = 16;
+
   const int Nx = hs[0].Nx;
+  const int nBlockX = (Nx+kBlockX-1)/kBlockX;
 
   TMatrixD M(2, 2);
   M(0, 0) = dirs[0].Y();
@@ -260,58 +335,125 @@ TVector3 FindPeak3D(const std::vector<HeatMap>& hs,
 
   M.Invert();
 
-  float bestscore = -1;
-  TVector3 bestr;
-
-  // Accumulate some statistics up front that will enable us to optimize
+  // r.Dot(d0) = z && r.Dot(d1) = u, the v coordinate and map bin that go
+  // with them
+  auto solve = [&](double z, double u, double& y){
+    y = M(0, 0)*z + M(0, 1)*u;
+    const double r1 = M(1, 0)*z + M(1, 1)*u;
+    const float v = y*dirs[2].Y() + r1*dirs[2].Z();
+    return v;
+  };
+
+  // Accumulate some statistics up front that will enable us to optimize:
+  // the maximum of each column and of each block of kBlockX bins in it
   std::vector<float> colMax[3];
+  std::vector<float> blockMax[3];
   for(int view = 0; view < 3; ++view){
     colMax[view].resize(hs[view].Nz);
+    blockMax[view].resize(hs[view].Nz*nBlockX);
     for(int iz = 0; iz < hs[view].Nz; ++iz){
-      colMax[view][iz] = *std::max_element(&hs[view].map[Nx*iz],
-                                           &hs[view].map[Nx*(iz+1)]);
+      const float* col = &hs[view].map[Nx*iz];
+      for(int bx = 0; bx < nBlockX; ++bx){
+        blockMax[view][iz*nBlockX+bx] = *std::max_element(col+bx*kBlockX, col+std::min(Nx, (bx+1)*kBlockX));
+      }
+      colMax[view][iz] = *std::max_element(&blockMax[view][iz*nBlockX], &blockMax[view][(iz+1)*nBlockX]);
     }
   }
 
-  for(int iz = 0; iz < hs[0].Nz; ++iz){
-    const float z = hs[0].ZBinCenter(iz);
-    const float bonus = 1; // works badly... exp((hs[0].maxz-z)/1000.);
-
-    for(int iu = 0; iu < hs[1].Nz; ++iu){
-      const float u = hs[1].ZBinCenter(iu);
-      // r.Dot(d0) = z && r.Dot(d1) = u
-      TVectorD p(2);
-      p(0) = z;
-      p(1) = u;
-      const TVectorD r = M*p;
-      const float v = r[0]*dirs[2].Y() + r[1]*dirs[2].Z();
-      const int iv = hs[2].ZToBin(v);
-      if(iv < 0 || iv >= hs[2].Nz) continue;
-      const double y = r(0);
-
-      // Even if the maxes were all at the same x we couldn't beat the record
-      if(colMax[0][iz] + colMax[1][iu] + colMax[2][iv] < bestscore) continue;
-
-      // Attempt to micro-optimize the dx loop below
-      const float* __restrict__ h0 = &hs[0].map[Nx*iz];
-      const float* __restrict__ h1 = &hs[1].map[Nx*iu];
-      const float* __restrict__ h2 = &hs[2].map[Nx*iv];
-
-      int bestix = -1;
-      for(int ix = 1; ix < Nx-1; ++ix){
-        const float score = bonus * (h0[ix] + h1[ix] + h2[ix]);
-
-        if(score > bestscore){
-          bestscore = score;
-          bestix = ix;
-        }
-      } // end for dx
+  auto rangeMax = [](const std::vector<float>& v, int lo, int hi){
+    return *std::max_element(v.begin()+lo, v.begin()+hi);
+  };
 
-      if(bestix != -1){
-        bestr = TVector3(hs[0].XBinCenter(bestix), y, z);
+  // Upper bound on the score of each block of z and u columns
+  struct ZUBlock
+  {
+    float bound;
+    int iz0, iu0;
+    bool operator<(const ZUBlock& b) const {return std::tie(b.bound, iz0, iu0) < std::tie(bound, b.iz0, b.iu0);}
+  };
+
+  std::vector<ZUBlock> blocks;
+  for(int iz0 = 0; iz0 < hs[0].Nz; iz0 += kBlockZ){
+    const int iz1 = std::min(hs[0].Nz, iz0+kBlockZ);
+    const float zMax = rangeMax(colMax[0], iz0, iz1);
+
+    for(int iu0 = 0; iu0 < hs[1].Nz; iu0 += kBlockZ){
+      const int iu1 = std::min(hs[1].Nz, iu0+kBlockZ);
+
+      // v is linear in z and u, so the corners bound it
+      double y;
+      float vmin = +1e30, vmax = -1e30;
+      for(int iz: {iz0, iz1-1}){
+        for(int iu: {iu0, iu1-1}){
+          const float v = solve(hs[0].ZBinCenter(iz), hs[1].ZBinCenter(iu), y);
+          vmin = std::min(vmin, v);
+          vmax = std::max(vmax, v);
+        }
       }
-    } // end for u
-  } // end for z
+      // one bin of slack for the rounding of v
+      const int iv0 = std::max(0, hs[2].ZToBin(vmin)-1);
+      const int iv1 = std::min(hs[2].Nz, hs[2].ZToBin(vmax)+2);
+      if(iv0 >= iv1) continue;
+
+      blocks.push_back({zMax + rangeMax(colMax[1], iu0, iu1) + rangeMax(colMax[2], iv0, iv1), iz0, iu0});
+    }
+  }
+
+  std::sort(blocks.begin(), blocks.end());
+
+  float bestscore = -1;
+  std::tuple<int, int, int> bestbin(hs[0].Nz, hs[1].Nz, Nx);
+  TVector3 bestr;
+
+  for(const ZUBlock& block: blocks){
+    // Even if the maxes were all at the same x we couldn't beat the record
+    if(block.bound < bestscore) break;
+
+    for(int iz = block.iz0; iz < std::min(hs[0].Nz, block.iz0+kBlockZ); ++iz){
+      const float z = hs[0].ZBinCenter(iz);
+      const float bonus = 1; // works badly... exp((hs[0].maxz-z)/1000.);
+
+      for(int iu = block.iu0; iu < std::min(hs[1].Nz, block.iu0+kBlockZ); ++iu){
+        const float u = hs[1].ZBinCenter(iu);
+        double y;
+        const float v = solve(z, u, y);
+        const int iv = hs[2].ZToBin(v);
+        if(iv < 0 || iv >= hs[2].Nz) continue;
+
+        if(colMax[0][iz] + colMax[1][iu] + colMax[2][iv] < bestscore) continue;
+
+        // Attempt to micro-optimize the dx loop below
+        const float* __restrict__ h0 = &hs[0].map[Nx*iz];
+        const float* __restrict__ h1 = &hs[1].map[Nx*iu];
+        const float* __restrict__ h2 = &hs[2].map[Nx*iv];
+
+        const float* b0 = &blockMax[0][nBlockX*iz];
+        const float* b1 = &blockMax[1][nBlockX*iu];
+        const float* b2 = &blockMax[2][nBlockX*iv];
+
+        int bestix = -1;
+        for(int bx = 0; bx < nBlockX; ++bx){
+          if(b0[bx] + b1[bx] + b2[bx] < bestscore) continue;
+
+          for(int ix = std::max(1, bx*kBlockX); ix < std::min(Nx-1, (bx+1)*kBlockX); ++ix){
+            const float score = bonus * (h0[ix] + h1[ix] + h2[ix]);
+
+            // Ties go to the bin an exhaustive scan would meet first
+            if(score > bestscore ||
+               (score == bestscore && std::make_tuple(iz, iu, ix) < bestbin)){
+              bestscore = score;
+              bestbin = std::make_tuple(iz, iu, ix);
+              bestix = ix;
+            }
+          } // end for ix
+        } // end for bx
+
+        if(bestix != -1){
+          bestr = TVector3(hs[0].XBinCenter(bestix), y, z);
+        }
+      } // end for u
+    } // end for z
+  } // end for blocks
 
   return bestr;
 }
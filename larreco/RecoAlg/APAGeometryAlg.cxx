@@ -238,6 +238,67 @@ namespace apa{
   }
 
 
+  //----------------------------------------------------------
+  void APAGeometryAlg::InitChannelSegments()
+  {
+
+    fChannelSegments.assign(fGeom->Nchannels(), std::vector<APAChannelSegment>());
+
+    for( uint32_t chan = 0; chan < fGeom->Nchannels(); chan++ ){
+      geo::View_t view = fGeom->View(chan);
+      if( view != geo::kU && view != geo::kV ) continue;
+
+      std::vector<geo::WireID> wids = fGeom->ChannelToWire(chan);
+      fChannelSegments[chan].reserve(wids.size());
+      for(size_t w = 0; w < wids.size(); w++){
+	APAChannelSegment seg{ wids[w], 0, 0, true };
+	try{ this->SegmentZChannelRange(chan, wids[w], seg.zMinChan, seg.zMaxChan); }
+	catch(cet::exception const&){ seg.hasZRange = false; }
+	fChannelSegments[chan].push_back(seg);
+      }
+    }
+
+  }
+
+
+  //----------------------------------------------------------
+  const std::vector<APAChannelSegment>& APAGeometryAlg::ChannelSegments( uint32_t chan ) const
+  {
+
+    if( chan >= fChannelSegments.size() ) throw cet::exception("APAGeometryAlg")
+					    << "No wire segments for channel " << chan
+					    << ", call InitChannelSegments() first.\n";
+    return fChannelSegments[chan];
+
+  }
+
+
+  //----------------------------------------------------------
+  void APAGeometryAlg::SegmentZChannelRange( uint32_t chan,
+					     geo::WireID const& wid,
+					     uint32_t & zMinChan,
+                                             uint32_t & zMaxChan ) const
+  {
+
+    double xyzStart[3] = {0.};  double xyzEnd[3] = {0.};
+    fGeom->WireEndPoints(wid.Cryostat, wid.TPC, wid.Plane, wid.Wire, xyzStart, xyzEnd);
+    unsigned int side(wid.TPC%2), cryo(wid.Cryostat);
+
+    // get appropriate x and y with tpc center
+    TVector3 tpcCenter(0,0,0);
+    unsigned int apa = this->ChannelToAPA(chan);
+    unsigned int tpc = 2*apa + side - cryo*fGeom->NTPC(); // apa number does not reset per cryo
+    tpcCenter = fGeom->Cryostat(cryo).TPC(tpc).LocalToWorld(tpcCenter);
+
+    // get channel range
+    TVector3 Min(tpcCenter); Min[2] = xyzStart[2];
+    TVector3 Max(tpcCenter); Max[2] = xyzEnd[2];
+    zMinChan = fGeom->NearestChannel( Min, 2, tpc, cryo );
+    zMaxChan = fGeom->NearestChannel( Max, 2, tpc, cryo );
+
+  }
+
+
   //----------------------------------------------------------
   std::vector<geo::WireID> APAGeometryAlg::ChanSegsPerSide(uint32_t chan, unsigned int side) const {
 
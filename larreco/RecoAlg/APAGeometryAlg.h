@@ -27,6 +27,15 @@ namespace apa{
     kUnknown
   } APAView_t;
 
+  // a wire segment of an induction channel, with the collection
+  // channels nearest to its two ends in z
+  struct APAChannelSegment {
+    geo::WireID  wid;
+    uint32_t     zMinChan;
+    uint32_t     zMaxChan;
+    bool         hasZRange;  ///< false if the geometry could not give the collection channels
+  };
+
 
   //---------------------------------------------------------------
   class APAGeometryAlg {
@@ -79,6 +88,15 @@ namespace apa{
     unsigned int         ChannelsInAPAView( APAView_t apaview ) const;
     unsigned int         ChannelsPerAPA() const { return fChannelsPerAPA; };
 
+    void                 InitChannelSegments();        ///< Fill the wire segment table of all induction channels
+    const std::vector<APAChannelSegment>& ChannelSegments( uint32_t chan ) const;
+                                                       ///< Wire segments of an induction channel, needs InitChannelSegments()
+    void                 SegmentZChannelRange( uint32_t chan,
+					       geo::WireID const& wid,
+					       uint32_t & zMinChan,
+                                               uint32_t & zMaxChan ) const;
+                                                       ///< Collection channels nearest to the ends of a wire segment of chan
+
 
   private:
 
@@ -99,6 +117,10 @@ namespace apa{
 
     double fChannelRange[2]; // for each induction view: U=0, V=1
 
+    // wire segments of each channel, to avoid calling ChannelToWire and
+    // finding the segment ends for every hit (empty for collection channels)
+    std::vector< std::vector<APAChannelSegment> > fChannelSegments;
+
   }; // class APAGeometryAlg
 
 } // namespace apa
@@ -30,10 +30,59 @@
 #include "TVector2.h"
 #include "TVirtualPad.h"
 
+#include "tbb/tbb.h"
+
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <numeric>
+
+namespace {
+
+  // Union-find over the bins of an image, to label islands of bins
+  class BinUnionFind {
+  public:
+    explicit BinUnionFind(int nbins) : fParent(nbins, -1) {}
+
+    // Root bin of the island of the bin
+    int Find(int bin) {
+      while (fParent[bin] >= 0) {
+        int const parent = fParent[bin];
+        if (fParent[parent] >= 0) fParent[bin] = fParent[parent]; // path halving
+        bin = parent;
+      }
+      return bin;
+    }
+
+    void Join(int a, int b) {
+      a = Find(a);
+      b = Find(b);
+      if (a == b) return;
+      if (fParent[a] > fParent[b]) std::swap(a, b); // keep the larger island root
+      fParent[a] += fParent[b];
+      fParent[b] = a;
+    }
+
+    // Number of bins in the island of the bin
+    unsigned int Size(int bin) { return -fParent[Find(bin)]; }
+
+  private:
+    std::vector<int> fParent; // parent bin, minus the size of the island for roots
+  };
+
+}
 
 cluster::BlurredClusteringAlg::BlurredClusteringAlg(fhicl::ParameterSet const& pset)
+  : BlurredClusteringAlg(pset,
+                         lar::providerFrom<geo::Geometry>(),
+                         lar::providerFrom<detinfo::DetectorPropertiesService>(),
+                         &art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider())
+{}
+
+cluster::BlurredClusteringAlg::BlurredClusteringAlg(fhicl::ParameterSet const& pset,
+                                                    geo::GeometryCore const* geom,
+                                                    detinfo::DetectorProperties const* detProp,
+                                                    lariov::ChannelStatusProvider const* chanStatus)
   : fDebug{pset.get<bool>("Debug",false)}
   , fDetector{pset.get<std::string>("Detector","dune35t")}
   , fBlurWire{pset.get<int>("BlurWire")}
@@ -49,10 +98,15 @@ cluster::BlurredClusteringAlg::BlurredClusteringAlg(fhicl::ParameterSet const& p
   , fMinSeed{pset.get<double>("MinSeed")}
   , fTimeThreshold{pset.get<double>("TimeThreshold")}
   , fChargeThreshold{pset.get<double>("ChargeThreshold")}
+  , fConcurrentBlur{pset.get<bool>("ConcurrentBlur", false)}
   , fKernelWidth{2 * fBlurWire + 1}
   , fKernelHeight{2 * fBlurTick*fMaxTickWidthBlur + 1}
   , fAllKernels{MakeKernels()}
-  , fDetProp{lar::providerFrom<detinfo::DetectorPropertiesService>()}
+  , fWireGaussians{MakeGaussians(fSigmaWire, fBlurWire)}
+  , fTickGaussians{MakeGaussians(fSigmaTick*fMaxTickWidthBlur, fBlurTick*fMaxTickWidthBlur)}
+  , fGeom{geom}
+  , fDetProp{detProp}
+  , fChanStatus{chanStatus}
 {}
 
 cluster::BlurredClusteringAlg::~BlurredClusteringAlg()
@@ -146,8 +200,10 @@ cluster::BlurredClusteringAlg::ConvertRecobHitsToVector(std::vector<art::Ptr<rec
   fUpperWire = upperWire+20;
 
   // Use a map to keep a track of the real hits and their wire/ticks
-  fHitMap.clear();
-  fHitMap.resize(fUpperWire-fLowerWire, std::vector<art::Ptr<recob::Hit>>(fUpperTick-fLowerTick));
+  fNTicks = fUpperTick-fLowerTick;
+  fHits.clear();
+  fHitBins.clear();
+  fHitIndex.assign((fUpperWire-fLowerWire)*fNTicks, -1);
 
   // Create a 2D vector
   std::vector<std::vector<double>> image(fUpperWire-fLowerWire, std::vector<double>(fUpperTick-fLowerTick));
@@ -161,7 +217,13 @@ cluster::BlurredClusteringAlg::ConvertRecobHitsToVector(std::vector<art::Ptr<rec
     // Fill hit map and keep a note of all real hits for later
     if (charge > image.at(wire-fLowerWire).at(tick-fLowerTick)) {
       image.at(wire-fLowerWire).at(tick-fLowerTick) = charge;
-      fHitMap[wire-fLowerWire][tick-fLowerTick] = hit;
+      int const bin = (wire-fLowerWire)*fNTicks + (tick-fLowerTick);
+      if (fHitIndex[bin] < 0) {
+        fHitIndex[bin] = fHits.size();
+        fHits.push_back(hit);
+        fHitBins.push_back(bin);
+      }
+      else fHits[fHitIndex[bin]] = hit;
     }
   }
 
@@ -171,7 +233,7 @@ cluster::BlurredClusteringAlg::ConvertRecobHitsToVector(std::vector<art::Ptr<rec
 
   for (int wire = fLowerWire; wire < fUpperWire; ++wire) {
     raw::ChannelID_t const channel = fGeom->PlaneWireToChannel(planeID.Plane,wire,planeID.TPC,planeID.Cryostat);
-    fDeadWires[wire-fLowerWire] = !fChanStatus.IsGood(channel);
+    fDeadWires[wire-fLowerWire] = !fChanStatus->IsGood(channel);
   }
 
   return image;
@@ -191,38 +253,52 @@ cluster::BlurredClusteringAlg::FindClusters(std::vector<std::vector<double>> con
   std::vector<std::pair<double, int>> values;
 
   // Place the bin number and contents as a pair in the values vector
+  // Only bins above the seed threshold can start a cluster
   for (int xbin = 0; xbin < nbinsx; ++xbin) {
     for (int ybin = 0; ybin < nbinsy; ++ybin) {
-      int const bin = ConvertWireTickToBin(blurred, xbin, ybin);
-      values.emplace_back(ConvertBinToCharge(blurred, bin), bin);
+      if (blurred[xbin][ybin] >= fMinSeed)
+        values.emplace_back(blurred[xbin][ybin], ConvertWireTickToBin(blurred, xbin, ybin));
     }
   }
 
   // Sort the values into charge order
   std::sort(values.rbegin(), values.rend());
 
-  // Count the number of iterations of the cluster forming loop (== number of clusters)
-  int niter = 0;
+  // Label the islands of bins above the charge threshold, joined within the clustering distance.
+  // A cluster grows only over the island of its seed, so seeds on islands smaller than the minimum
+  // cluster size are not grown.
+  BinUnionFind islands(nbins);
+  for (int xbin = 0; xbin < nbinsx; ++xbin) {
+    for (int ybin = 0; ybin < nbinsy; ++ybin) {
+      if (blurred[xbin][ybin] <= fChargeThreshold)
+        continue;
+      int const bin = ConvertWireTickToBin(blurred, xbin, ybin);
+      for (int x = xbin; x <= std::min(xbin + fClusterWireDistance, nbinsx - 1); ++x) {
+        for (int y = std::max(ybin - fClusterTickDistance, 0); y <= std::min(ybin + fClusterTickDistance, nbinsy - 1); ++y) {
+          if ((x == xbin and y <= ybin) or blurred[x][y] <= fChargeThreshold)
+            continue;
+          islands.Join(bin, ConvertWireTickToBin(blurred, x, y));
+        }
+      }
+    }
+  }
 
   // Clustering loops
   // First loop - considers highest charge hits in decreasing order, and puts them in a new cluster if they aren't already clustered (makes new cluster every iteration)
   // Second loop - looks at the direct neighbours of this seed and clusters to this if above charge/time thresholds. Runs recursively over all hits in cluster (inc. new ones)
-  while (true) {
+  for (auto const& [blurred_binval, bin] : values) {
 
     // Start a new cluster each time loop is executed
     std::vector<int> cluster;
     std::vector<double> times;
 
-    // Get the highest charge bin (go no further if below seed threshold)
-    if (double const blurred_binval = values[niter].first; blurred_binval < fMinSeed)
-      break;
-
-    // Iterate through the bins from highest charge down
-    int const bin = values[niter++].second;
-
     // Put this bin in used if not already there
     if (used[bin])
       continue;
+
+    // A cluster grown on a too small island would be dropped
+    if (blurred_binval > fChargeThreshold and islands.Size(bin) < fMinSize)
+      continue;
     used[bin] = true;
 
     // Start a new cluster
@@ -233,9 +309,10 @@ cluster::BlurredClusteringAlg::FindClusters(std::vector<std::vector<double>> con
       times.push_back(time);
 
     // Now cluster neighbouring hits to this seed
+    // Bins can be added on a later pass only if they failed the time cut, as the cluster then has more times
     while (true) {
 
-      bool added_cluster{false};
+      bool added_cluster{false}, failed_time_cut{false};
 
       for (unsigned int clusBin = 0; clusBin < cluster.size(); ++clusBin) {
 
@@ -244,43 +321,40 @@ cluster::BlurredClusteringAlg::FindClusters(std::vector<std::vector<double>> con
         int const biny = ((cluster[clusBin] - binx) / nbinsx) % nbinsy;
 
         // Look for hits in the neighbouring x/y bins
-        for (int x = binx - fClusterWireDistance; x <= binx + fClusterWireDistance; x++) {
-          if (x >= nbinsx or x < 0) continue;
-          for (int y = biny - fClusterTickDistance; y <= biny + fClusterTickDistance; y++) {
-            if (y >= nbinsy or y < 0) continue;
+        for (int x = std::max(binx - fClusterWireDistance, 0); x <= std::min(binx + fClusterWireDistance, nbinsx - 1); x++) {
+          auto const& column = blurred[x];
+          for (int y = std::max(biny - fClusterTickDistance, 0); y <= std::min(biny + fClusterTickDistance, nbinsy - 1); y++) {
             if (x == binx and y == biny) continue;
 
             // Get this bin
             auto const bin = ConvertWireTickToBin(blurred, x, y);
-            if (bin >= nbinsx * nbinsy or bin < 0)
-              continue;
             if (used[bin])
               continue;
 
-            // Get the blurred value and time for this bin
-            double const blurred_binval = ConvertBinToCharge(blurred, bin);
-            double const time = GetTimeOfBin(blurred, bin); // NB for 'fake' hits, time is defaulted to -10000
+            // Add to cluster if bin value is above threshold
+            if (column[y] <= fChargeThreshold)
+              continue;
 
             // Check real hits pass time cut (ignores fake hits)
-            if (time > 0 && times.size() > 0 && ! PassesTimeCut(times, time))
+            double const time = GetTimeOfBin(blurred, bin); // NB for 'fake' hits, time is defaulted to -10000
+            if (time > 0 && times.size() > 0 && ! PassesTimeCut(times, time)) {
+              failed_time_cut = true;
               continue;
+            }
 
-            // Add to cluster if bin value is above threshold
-            if (blurred_binval > fChargeThreshold) {
-              used[bin] = true;
-              cluster.push_back(bin);
-              added_cluster = true;
-              if (time > 0) {
-                times.push_back(time);
-              }
-            } // End of adding blurred bin to cluster
+            used[bin] = true;
+            cluster.push_back(bin);
+            added_cluster = true;
+            if (time > 0) {
+              times.push_back(time);
+            }
 
           }
         } // End of looking at directly neighbouring bins
 
       } // End of looping over bins already in this cluster
 
-      if (!added_cluster)
+      if (!added_cluster or !failed_time_cut)
         break;
 
     } // End of adding hits to this cluster
@@ -420,7 +494,8 @@ cluster::BlurredClusteringAlg::GaussianBlur(std::vector<std::vector<double>> con
   if (fSigmaWire == 0 and fSigmaTick == 0)
     return image;
 
-  auto const [blur_wire, blur_tick, sigma_wire, sigma_tick] = FindBlurringParameters();
+  auto const blurring = FindBlurringParameters();
+  int const blur_wire = blurring[0], blur_tick = blurring[1], sigma_wire = blurring[2], sigma_tick = blurring[3];
 
   // Convolve the Gaussian
   int width = 2 * blur_wire + 1;
@@ -428,48 +503,119 @@ cluster::BlurredClusteringAlg::GaussianBlur(std::vector<std::vector<double>> con
   int nbinsx = image.size();
   int nbinsy = image.at(0).size();
 
-  // Blurred histogram and normalisation for each bin
-  std::vector<std::vector<double>> copy(nbinsx, std::vector<double>(nbinsy, 0));
+  // The kernels are products of a Gaussian in the wire direction and one in the tick direction.
+  // The hits are first smeared along the ticks, into one row per wire, and the rows are then smeared
+  // along the wires. Hits with dead wires in their blurring region have the kernel stretched over the
+  // dead wires, these are smeared with the 2D kernel at the end.
+  struct HitToBlur { int x, y, tick_scale; };
+  std::vector<HitToBlur> hitsToBlur, deadRegionHits;
+  std::vector<int> hitsOnWire(nbinsx + 1, 0);
+
+  // Hits in the order of the bins, wire after wire
+  std::vector<int> hitOrder(fHits.size());
+  std::iota(hitOrder.begin(), hitOrder.end(), 0);
+  std::sort(hitOrder.begin(), hitOrder.end(), [this](int a, int b){ return fHitBins[a] < fHitBins[b]; });
+
+  for (int const h : hitOrder) {
+    int const x = fHitBins[h] / fNTicks;
+    int const y = fHitBins[h] % fNTicks;
+    if (image[x][y] == 0)
+      continue;
 
-  // Loop through all the bins in the histogram to blur
-  for (int x = 0; x < nbinsx; ++x) {
-    for (int y = 0; y < nbinsy; ++y) {
+    // Scale the tick blurring based on the width of the hit
+    int tick_scale = std::sqrt(cet::square(fHits[h]->RMS()) + cet::square(sigma_tick)) / (double)sigma_tick;
+    tick_scale = std::max(std::min(tick_scale, fMaxTickWidthBlur), 1);
 
-      if (image[x][y] == 0)
-        continue;
+    // Find any dead wires in the potential blurring region
+    if (auto const [lower_bin_dead, upper_bin_dead] = DeadWireCount(x, width); lower_bin_dead or upper_bin_dead) {
+      deadRegionHits.push_back({x, y, tick_scale});
+      continue;
+    }
 
-      // Scale the tick blurring based on the width of the hit
-      int tick_scale = std::sqrt(cet::square(fHitMap[x][y]->RMS()) + cet::square(sigma_tick)) / (double)sigma_tick;
-      tick_scale = std::max(std::min(tick_scale, fMaxTickWidthBlur), 1);
-      auto const& correct_kernel = fAllKernels[sigma_wire][sigma_tick*tick_scale];
-
-      // Find any dead wires in the potential blurring region
-      auto const [lower_bin_dead, upper_bin_dead] = DeadWireCount(x, width);
-
-      // Note of how many dead wires we have passed whilst blurring in the wire direction
-      // If blurring below the seed hit, need to keep a note of how many dead wires to come
-      // If blurring above, need to keep a note of how many dead wires have passed
-      auto dead_wires_passed{lower_bin_dead};
-
-      // Loop over the blurring region around this hit
-      for (int blurx = -(width/2+lower_bin_dead); blurx < (width+1)/2+upper_bin_dead; ++blurx) {
-        if (x + blurx < 0) continue;
-        for (int blury = -height/2*tick_scale; blury < ((((height+1)/2)-1)*tick_scale)+1; ++blury) {
-          if (blurx < 0 and fDeadWires[x+blurx])
-            dead_wires_passed -= 1;
-
-          // Smear the charge of this hit
-          double const weight = correct_kernel[fKernelWidth * (fKernelHeight / 2 + blury) + (fKernelWidth / 2 + (blurx - dead_wires_passed))];
-          if (x + blurx >= 0 and x + blurx < nbinsx and y + blury >= 0 and y + blury < nbinsy)
-            copy[x+blurx][y+blury] += weight * image[x][y];
-
-          if (blurx > 0 and fDeadWires[x+blurx])
-            dead_wires_passed += 1;
-        }
-      } // blurring region
+    hitsToBlur.push_back({x, y, tick_scale});
+    ++hitsOnWire[x+1];
+  }
+  std::partial_sum(hitsOnWire.begin(), hitsOnWire.end(), hitsOnWire.begin());
+
+  // Ticks reached by the hits on each wire; only these are kept after smearing along the ticks
+  std::vector<int> firstTick(nbinsx, nbinsy), lastTick(nbinsx, 0);
+  for (auto const& hit : hitsToBlur) {
+    int const reach = blur_tick * hit.tick_scale;
+    firstTick[hit.x] = std::min(firstTick[hit.x], std::max(hit.y - reach, 0));
+    lastTick[hit.x] = std::max(lastTick[hit.x], std::min(hit.y + reach + 1, nbinsy));
+  }
+  std::vector<size_t> rowBegin(nbinsx + 1, 0);
+  for (int x = 0; x < nbinsx; ++x)
+    rowBegin[x+1] = rowBegin[x] + std::max(lastTick[x] - firstTick[x], 0);
+
+  // Smear along the ticks
+  std::vector<double> tickBlurred(rowBegin[nbinsx], 0);
+  auto const blurTicks = [&](size_t x) {
+    for (int h = hitsOnWire[x]; h < hitsOnWire[x+1]; ++h) {
+      auto const& hit = hitsToBlur[h];
+      int const reach = blur_tick * hit.tick_scale;
+      int const y0 = std::max(hit.y - reach, 0);
+      int const y1 = std::min(hit.y + reach + 1, nbinsy);
+      double const charge = image[x][hit.y];
+      double* __restrict out = tickBlurred.data() + rowBegin[x] + (y0 - firstTick[x]);
+      double const* __restrict gaussian = fTickGaussians[sigma_tick*hit.tick_scale].data() + fKernelHeight / 2 + (y0 - hit.y);
+      for (int i = 0; i < y1 - y0; ++i)
+        out[i] += gaussian[i] * charge;
+    }
+  };
 
+  // Smear along the wires
+  std::vector<std::vector<double>> copy(nbinsx, std::vector<double>(nbinsy, 0));
+  auto const& wire_gaussian = fWireGaussians[sigma_wire];
+  auto const blurWires = [&](size_t x) {
+    for (int blurx = -blur_wire; blurx <= blur_wire; ++blurx) {
+      int const from = static_cast<int>(x) - blurx;
+      if (from < 0 or from >= nbinsx or firstTick[from] >= lastTick[from])
+        continue;
+      double const weight = wire_gaussian[fKernelWidth / 2 + blurx];
+      double* __restrict out = copy[x].data() + firstTick[from];
+      double const* __restrict in = tickBlurred.data() + rowBegin[from];
+      for (int i = 0; i < lastTick[from] - firstTick[from]; ++i)
+        out[i] += weight * in[i];
     }
-  } // hits to blur
+  };
+
+  if (fConcurrentBlur) {
+    tbb::parallel_for(static_cast<size_t>(0), static_cast<size_t>(nbinsx), blurTicks);
+    tbb::parallel_for(static_cast<size_t>(0), static_cast<size_t>(nbinsx), blurWires);
+  }
+  else {
+    for (int x = 0; x < nbinsx; ++x) blurTicks(x);
+    for (int x = 0; x < nbinsx; ++x) blurWires(x);
+  }
+
+  // Hits next to dead wires
+  for (auto const [x, y, tick_scale] : deadRegionHits) {
+    auto const& correct_kernel = fAllKernels[sigma_wire][sigma_tick*tick_scale];
+    auto const [lower_bin_dead, upper_bin_dead] = DeadWireCount(x, width);
+
+    // Note of how many dead wires we have passed whilst blurring in the wire direction
+    // If blurring below the seed hit, need to keep a note of how many dead wires to come
+    // If blurring above, need to keep a note of how many dead wires have passed
+    auto dead_wires_passed{lower_bin_dead};
+
+    // Loop over the blurring region around this hit
+    for (int blurx = -(width/2+lower_bin_dead); blurx < (width+1)/2+upper_bin_dead; ++blurx) {
+      if (x + blurx < 0) continue;
+      for (int blury = -height/2*tick_scale; blury < ((((height+1)/2)-1)*tick_scale)+1; ++blury) {
+        if (blurx < 0 and fDeadWires[x+blurx])
+          dead_wires_passed -= 1;
+
+        // Smear the charge of this hit
+        double const weight = correct_kernel[fKernelWidth * (fKernelHeight / 2 + blury) + (fKernelWidth / 2 + (blurx - dead_wires_passed))];
+        if (x + blurx >= 0 and x + blurx < nbinsx and y + blury >= 0 and y + blury < nbinsy)
+          copy[x+blurx][y+blury] += weight * image[x][y];
+
+        if (blurx > 0 and fDeadWires[x+blurx])
+          dead_wires_passed += 1;
+      }
+    } // blurring region
+  }
 
   // HAVE REMOVED NOMALISATION CODE
   // WHEN USING DIFFERENT KERNELS, THERE'S NO EASY WAY OF DOING THIS...
@@ -635,7 +781,8 @@ cluster::BlurredClusteringAlg::ConvertBinToRecobHit(std::vector<std::vector<doub
 {
   int const wire = bin % image.size();
   int const tick = bin / image.size();
-  return fHitMap[wire][tick];
+  int const index = fHitIndex[wire*fNTicks + tick];
+  return index < 0 ? art::Ptr<recob::Hit>{} : fHits[index];
 }
 
 int
@@ -646,15 +793,6 @@ cluster::BlurredClusteringAlg::ConvertWireTickToBin(std::vector<std::vector<doub
   return ybin * image.size() + xbin;
 }
 
-double
-cluster::BlurredClusteringAlg::ConvertBinToCharge(std::vector<std::vector<double>> const& image,
-                                                  int const bin) const
-{
-  int const x = bin % image.size();
-  int const y = bin / image.size();
-  return image.at(x).at(y);
-}
-
 std::pair<int, int>
 cluster::BlurredClusteringAlg::DeadWireCount(int const wire_bin, int const width) const
 {
@@ -681,19 +819,16 @@ std::array<int, 4>
 cluster::BlurredClusteringAlg::FindBlurringParameters() const
 {
   // Calculate least squares slope
+  // (the sums are of integers, exact in any order)
   double nhits{}, sumx{}, sumy{}, sumx2{}, sumxy{};
-  for (unsigned int wireIt = 0; wireIt < fHitMap.size(); ++wireIt) {
-    for (unsigned int tickIt = 0; tickIt < fHitMap.at(wireIt).size(); ++tickIt) {
-      if (fHitMap[wireIt][tickIt].isNull())
-        continue;
-      ++nhits;
-      int const x = wireIt + fLowerWire;
-      int const y = tickIt + fLowerTick;
-      sumx += x;
-      sumy += y;
-      sumx2 += x*x;
-      sumxy += x*y;
-    }
+  for (int const bin : fHitBins) {
+    ++nhits;
+    int const x = bin / fNTicks + fLowerWire;
+    int const y = bin % fNTicks + fLowerTick;
+    sumx += x;
+    sumy += y;
+    sumx2 += x*x;
+    sumxy += x*y;
   }
   double const gradient = (nhits * sumxy - sumx * sumy) / (nhits * sumx2 - sumx * sumx);
 
@@ -714,8 +849,8 @@ double
 cluster::BlurredClusteringAlg::GetTimeOfBin(std::vector<std::vector<double>> const& image,
                                             int const bin) const
 {
-  auto const hit = ConvertBinToRecobHit(image, bin);
-  return hit.isNull() ? -10000. : hit->PeakTime();
+  int const index = fHitIndex[(bin % image.size())*fNTicks + bin / image.size()];
+  return index < 0 ? -10000. : fHits[index]->PeakTime();
 }
 
 std::vector<std::vector<std::vector<double>>>
@@ -754,6 +889,20 @@ cluster::BlurredClusteringAlg::MakeKernels() const
   return allKernels;
 }
 
+std::vector<std::vector<double>>
+cluster::BlurredClusteringAlg::MakeGaussians(int const maxSigma, int const radius) const
+{
+  std::vector<std::vector<double>> gaussians(maxSigma + 1, std::vector<double>(2 * radius + 1));
+
+  // Same values as the factors of the kernels
+  for (int sigma = 1; sigma <= maxSigma; ++sigma) {
+    double const sig2 = 2. * sigma * sigma;
+    for (int i = -radius; i <= radius; ++i)
+      gaussians[sigma][i + radius] = 1. / std::sqrt(sig2 * M_PI) * std::exp(-i * i / sig2);
+  }
+  return gaussians;
+}
+
 unsigned int
 cluster::BlurredClusteringAlg::NumNeighbours(int const nbinsx,
                                              std::vector<bool> const& used,
@@ -22,7 +22,7 @@
 namespace detinfo { class DetectorProperties; }
 namespace fhicl { class ParameterSet; }
 namespace lariov { class ChannelStatusProvider; }
-namespace geo { struct WireID; }
+namespace geo { class GeometryCore; struct WireID; }
 
 // ROOT
 #include "TString.h"
@@ -42,6 +42,12 @@ class cluster::BlurredClusteringAlg {
 public:
 
   BlurredClusteringAlg(fhicl::ParameterSet const& pset);
+
+  /// Uses the providers given instead of the ones of the art services
+  BlurredClusteringAlg(fhicl::ParameterSet const& pset,
+                       geo::GeometryCore const* geom,
+                       detinfo::DetectorProperties const* detProp,
+                       lariov::ChannelStatusProvider const* chanStatus);
   ~BlurredClusteringAlg();
 
   /// Create the PDF to save debug images
@@ -83,6 +89,9 @@ public:
 
 private:
 
+  //this is for unit testing...class has no other purpose
+  friend class BlurredClusteringAlgTest;
+
   /// Converts a vector of bins into a hit selection - not all the hits in the bins vector are real hits
   art::PtrVector<recob::Hit> ConvertBinsToRecobHits(std::vector<std::vector<double>> const& image, std::vector<int> const& bins) const;
 
@@ -92,9 +101,6 @@ private:
   /// Converts an xbin and a ybin to a global bin number
   int ConvertWireTickToBin(std::vector<std::vector<double>> const& image, int xbin, int ybin) const;
 
-  /// Returns the charge stored in the global bin value
-  double ConvertBinToCharge(std::vector<std::vector<double>> const& image, int bin) const;
-
   /// Count how many dead wires there are in the blurring region for a particular hit
   /// Returns a pair of counters representing how many dead wires there are below and above the hit respectively
   std::pair<int, int> DeadWireCount(int wire_bin, int width) const;
@@ -108,6 +114,9 @@ private:
   /// Makes all the kernels which could be required given the tuned parameters
   std::vector<std::vector<std::vector<double>>> MakeKernels() const;
 
+  /// Makes the 1D Gaussians, for all integer sigmas up to maxSigma, which the kernels are products of
+  std::vector<std::vector<double>> MakeGaussians(int maxSigma, int radius) const;
+
   /// Determines the number of clustered neighbours of a hit
   unsigned int NumNeighbours(int nx, std::vector<bool> const& used, int bin) const;
 
@@ -131,13 +140,18 @@ private:
   double       fMinSeed;                  // minimum seed after blurring needed before clustering proceeds
   double       fTimeThreshold;            // time threshold for clustering
   double       fChargeThreshold;          // charge threshold for clustering
+  bool         fConcurrentBlur;           // blur several wires at the same time
 
   // Blurring stuff
   int fKernelWidth, fKernelHeight;
   std::vector<std::vector<std::vector<double>>> fAllKernels;
+  std::vector<std::vector<double>> fWireGaussians, fTickGaussians;
 
   // Hit containers
-  std::vector<std::vector<art::Ptr<recob::Hit>>> fHitMap;
+  std::vector<art::Ptr<recob::Hit>> fHits;   // hits in the image, one per bin
+  std::vector<int> fHitBins;                 // bin of each of fHits, wire * fNTicks + tick
+  std::vector<int> fHitIndex;                // index in fHits of the hit in each bin (same numbering), -1 if none
+  int fNTicks{};
   std::vector<bool> fDeadWires;
 
   int fLowerTick, fUpperTick;
@@ -147,10 +161,10 @@ private:
   TCanvas* fDebugCanvas{nullptr};
   std::string fDebugPDFName{};
 
-  // art service handles
-  art::ServiceHandle<geo::Geometry const> fGeom;
+  // Providers, from the art services unless given
+  geo::GeometryCore const* fGeom;
   detinfo::DetectorProperties const* fDetProp;
-  lariov::ChannelStatusProvider const& fChanStatus{art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider()};
+  lariov::ChannelStatusProvider const* fChanStatus;
 
 };
 
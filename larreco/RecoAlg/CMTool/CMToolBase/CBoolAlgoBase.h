@@ -29,7 +29,7 @@ namespace cmtool {
   public:
 
     /// Default constructor
-    CBoolAlgoBase(){}
+    CBoolAlgoBase(){ _max_interaction_dist = -1; }
 
     /// Default destructor
     virtual ~CBoolAlgoBase(){}
@@ -44,6 +44,21 @@ namespace cmtool {
       else return true;
     }
 
+    /**
+       Optional setting: distance [cm] in the wire/time plane beyond which two clusters
+       never give true. CMergeManager then skips pairs whose hits lie further apart than
+       this. A negative value (default) means any pair may be given to Bool().
+    */
+    void SetMaxInteractionDistance(float dist) { _max_interaction_dist = dist; }
+
+    /// Getter for the maximum interaction distance (negative if not set)
+    float MaxInteractionDistance() const { return _max_interaction_dist; }
+
+  protected:
+
+    /// Maximum distance [cm] between two clusters for Bool() to return true
+    float _max_interaction_dist;
+
   };
 
 }
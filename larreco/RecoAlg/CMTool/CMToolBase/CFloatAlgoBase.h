@@ -29,7 +29,7 @@ namespace cmtool {
   public:
 
     /// Default constructor
-    CFloatAlgoBase(){}
+    CFloatAlgoBase(){ _max_interaction_dist = -1; }
 
     /// Default destructor
     virtual ~CFloatAlgoBase(){}
@@ -44,6 +44,22 @@ namespace cmtool {
       else return -1;
     }
 
+    /**
+       Optional setting: distance [cm] along the drift (time) direction beyond which two
+       clusters of a combination never give a positive score. CMatchManager then skips
+       combinations with a pair of clusters further apart than this in time. A negative
+       value (default) means every combination is given to Float().
+    */
+    void SetMaxInteractionDistance(float dist) { _max_interaction_dist = dist; }
+
+    /// Getter for the maximum interaction distance (negative if not set)
+    float MaxInteractionDistance() const { return _max_interaction_dist; }
+
+  protected:
+
+    /// Maximum time distance [cm] between clusters for Float() to give a positive score
+    float _max_interaction_dist;
+
   };
 
 }
@@ -4,8 +4,10 @@
 #include "TStopwatch.h"
 #include "TString.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <string>
 #include <utility>
@@ -28,6 +30,7 @@ namespace cmtool {
   {
     _planes.clear();
     _in_clusters.clear();
+    _extents.clear();
     if(_priority_algo) _priority_algo->Reset();
   }
 
@@ -196,5 +199,45 @@ namespace cmtool {
 
   }
 
+  void CMManagerBase::ComputeExtents(const std::vector<cluster::ClusterParamsAlg> &clusters) {
+
+    // The polygon of a cluster is made from a selection of its hits: use all the hits
+    // so that the extent never excludes a part of the cluster an algorithm looks at
+    _extents.clear();
+    _extents.reserve(clusters.size());
+
+    for(auto const& c : clusters) {
+
+      ClusterExtent ext;
+      ext.w_min = ext.t_min = std::numeric_limits<float>::max();
+      ext.w_max = ext.t_max = std::numeric_limits<float>::lowest();
+
+      for(auto const& hit : c.GetHitVector()) {
+	ext.w_min = std::min(ext.w_min, (float)hit.w);
+	ext.w_max = std::max(ext.w_max, (float)hit.w);
+	ext.t_min = std::min(ext.t_min, (float)hit.t);
+	ext.t_max = std::max(ext.t_max, (float)hit.t);
+      }
+
+      _extents.push_back(ext);
+    }
+
+  }
+
+  bool CMManagerBase::WithinDistance(size_t index1, size_t index2, float dist) const {
+
+    if(dist < 0) return true;
+
+    auto const& ext1 = _extents.at(index1);
+    auto const& ext2 = _extents.at(index2);
+
+    // No hits to tell where the cluster is
+    if(ext1.w_min > ext1.w_max || ext2.w_min > ext2.w_max) return true;
+
+    float dw = std::max(0.f, std::max(ext1.w_min,ext2.w_min) - std::min(ext1.w_max,ext2.w_max));
+    float dt = std::max(0.f, std::max(ext1.t_min,ext2.t_min) - std::min(ext1.t_max,ext2.t_max));
+
+    return (dw*dw + dt*dt) <= dist*dist;
+  }
 
 }
@@ -93,11 +93,22 @@ namespace cmtool {
     /// A setter for an analysis output file
     void SetAnaFile(TFile* fout) { _fout = fout; }
 
+    /// Wire/time extent [cm] of the hits of a cluster (min > max for a cluster w/o hits)
+    struct ClusterExtent {
+      float w_min, w_max, t_min, t_max;
+    };
+
   protected:
 
     /// Function to compute priority
     void ComputePriority(const std::vector<cluster::ClusterParamsAlg>& clusters);
 
+    /// Function to compute the hit extent of each cluster, stored in _extents
+    void ComputeExtents(const std::vector<cluster::ClusterParamsAlg>& clusters);
+
+    /// Whether the hits of two clusters (indexes in _extents) are within dist [cm] in the wire/time plane
+    bool WithinDistance(size_t index1, size_t index2, float dist) const;
+
     /// FMWK function called @ beginning of Process()
     virtual void EventBegin(){}
 
@@ -142,6 +153,9 @@ namespace cmtool {
     /// A holder for # of unique planes in the clusters, computed in ComputePriority() function
     std::set<UChar_t> _planes;
 
+    /// Hit extent of each cluster, computed in ComputeExtents() function
+    std::vector<ClusterExtent> _extents;
+
   };
 }
 
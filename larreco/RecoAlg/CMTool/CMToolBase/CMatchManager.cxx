@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <stdlib.h>
 #include <string>
@@ -166,6 +167,68 @@ namespace cmtool {
 
   }
 
+  void TimeCompatibleCombinations(const std::vector<size_t>& plane_comb,
+				  const std::vector<std::vector<size_t> >& cluster_array,
+				  const std::vector<CMManagerBase::ClusterExtent>& extents,
+				  float max_dist,
+				  float t_lo,
+				  float t_hi,
+				  std::vector<std::pair<size_t,size_t> >& comb,
+				  std::vector<std::vector<std::pair<size_t,size_t> > >& result)
+  {
+    // Same ordering as ClusterCombinations (last plane runs fastest), dropping a partial
+    // combination as soon as two of its clusters are more than max_dist apart in time
+    if(comb.size() == plane_comb.size()) {
+      result.push_back(comb);
+      return;
+    }
+
+    size_t plane_index = plane_comb.at(comb.size());
+    auto const& clusters_per_plane = cluster_array.at(plane_index);
+
+    for(size_t i=0; i<clusters_per_plane.size(); ++i) {
+
+      auto const& ext = extents.at(clusters_per_plane[i]);
+
+      float lo = t_lo;
+      float hi = t_hi;
+
+      if(ext.t_min <= ext.t_max) {
+	lo = std::max(lo,ext.t_min);
+	hi = std::min(hi,ext.t_max);
+	if(lo - hi > max_dist) continue;
+      }
+
+      comb.push_back(std::make_pair(plane_index,i));
+      TimeCompatibleCombinations(plane_comb,cluster_array,extents,max_dist,lo,hi,comb,result);
+      comb.pop_back();
+    }
+  }
+
+  std::vector<std::vector<std::pair<size_t,size_t> > >
+  TimeCompatiblePlaneClusterCombinations(const std::vector<std::vector<size_t> >& cluster_array,
+					 const std::vector<CMManagerBase::ClusterExtent>& extents,
+					 float max_dist)
+  {
+    std::vector<std::vector<std::pair<size_t,size_t> > > result;
+
+    std::vector<std::pair<size_t,size_t> > comb;
+
+    // Same plane combinations as PlaneClusterCombinations
+    for(size_t i=0; i<cluster_array.size(); ++i) {
+
+      if(cluster_array.size() < 2+i) break;
+
+      for(auto const& plane_comb : SimpleCombination(cluster_array.size(),cluster_array.size()-i))
+
+	TimeCompatibleCombinations(plane_comb, cluster_array, extents, max_dist,
+				   std::numeric_limits<float>::lowest(),
+				   std::numeric_limits<float>::max(),
+				   comb, result);
+    }
+    return result;
+  }
+
   bool CMatchManager::IterationProcess()
   {
 
@@ -210,13 +273,26 @@ namespace cmtool {
       cluster_array.at( plane_to_index.at(_in_clusters.at((*riter).second).Plane()) ).push_back((*riter).second);
 
     // Find combinations
-    std::vector<size_t> seed;
-    seed.reserve(cluster_array.size());
-    for(auto const& clusters_per_plane : cluster_array)
+    std::vector<std::vector<std::pair<size_t,size_t> > > combinations;
+
+    float max_dist = _match_algo->MaxInteractionDistance();
+
+    if(max_dist < 0) {
+
+      std::vector<size_t> seed;
+      seed.reserve(cluster_array.size());
+      for(auto const& clusters_per_plane : cluster_array)
 
-      seed.push_back(clusters_per_plane.size());
+	seed.push_back(clusters_per_plane.size());
 
-    auto const& combinations = PlaneClusterCombinations(seed);
+      combinations = PlaneClusterCombinations(seed);
+    }
+    else {
+
+      // Only combinations of clusters close enough in time for the algorithm
+      ComputeExtents(_in_clusters);
+      combinations = TimeCompatiblePlaneClusterCombinations(cluster_array, _extents, max_dist);
+    }
 
     // Loop over combinations and call algorithm
     for(auto const& comb : combinations) {
@@ -6,6 +6,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 
 #include "lardata/Utilities/PxUtils.h"
 #include "larreco/RecoAlg/CMTool/CMToolBase/CBoolAlgoBase.h"
@@ -29,6 +30,7 @@ namespace cmtool {
     CMManagerBase::Reset();
     _tmp_merged_clusters.clear();
     _tmp_merged_indexes.clear();
+    _tmp_separated_pairs.clear();
     _out_clusters.clear();
     _book_keeper.Reset();
     _book_keeper_v.clear();
@@ -73,6 +75,7 @@ namespace cmtool {
     _iter_ctr = 0;
     _tmp_merged_clusters.clear();
     _tmp_merged_indexes.clear();
+    _tmp_separated_pairs.clear();
     _book_keeper_v.clear();
 
   }
@@ -161,6 +164,7 @@ namespace cmtool {
     _book_keeper_v.clear();
     _tmp_merged_clusters.clear();
     _tmp_merged_indexes.clear();
+    _tmp_separated_pairs.clear();
   }
 
   bool CMergeManager::IterationProcess()
@@ -177,18 +181,47 @@ namespace cmtool {
 
     std::vector<bool> merge_switch(_tmp_merged_clusters.size(),true);
 
+    // Clusters left untouched by the last iteration: map their previous index to the current one
+    std::vector<int> unchanged_index(_tmp_merged_clusters.size(),-1);
+
     for(size_t i=0; i<_tmp_merged_indexes.size(); ++i)
 
-      if(_tmp_merged_indexes.at(i).size()==1)
+      if(_tmp_merged_indexes.at(i).size()==1) {
 
 	merge_switch.at(i) = false;
 
+	unchanged_index.at(_tmp_merged_indexes.at(i).at(0)) = i;
+      }
+
     ComputePriority(_tmp_merged_clusters);
 
+    // Cluster extents, only needed if an algorithm declares an interaction distance
+    if(_merge_algo->MaxInteractionDistance() >= 0 ||
+       (_separate_algo && _separate_algo->MaxInteractionDistance() >= 0))
+
+      ComputeExtents(_tmp_merged_clusters);
+
     // Run separation algorithm
-    if(_separate_algo)
+    if(_separate_algo) {
+
+      // Separated pairs of untouched clusters carry over from the last iteration
+      std::vector<std::pair<unsigned short,unsigned short> > known_pairs;
+      for(auto const& prev_pair : _tmp_separated_pairs) {
 
-      RunSeparate(_tmp_merged_clusters, bk);
+	if(prev_pair.first >= unchanged_index.size() || prev_pair.second >= unchanged_index.size())
+	  continue;
+
+	int index1 = unchanged_index.at(prev_pair.first);
+	int index2 = unchanged_index.at(prev_pair.second);
+	if(index1 < 0 || index2 < 0) continue;
+
+	known_pairs.push_back(std::make_pair(index1,index2));
+      }
+
+      std::vector<std::pair<unsigned short,unsigned short> > separated_pairs;
+      RunSeparate(_tmp_merged_clusters, merge_switch, known_pairs, bk, separated_pairs);
+      _tmp_separated_pairs.swap(separated_pairs);
+    }
 
     // Run merging algorithm
     RunMerge(_tmp_merged_clusters, merge_switch, bk);
@@ -274,6 +307,9 @@ namespace cmtool {
     // Merging
     //
 
+    float max_dist = _merge_algo->MaxInteractionDistance();
+    if(_extents.size() != in_clusters.size()) max_dist = -1;
+
     // Run over clusters and execute merging algorithms
     for(auto citer1 = _priority.rbegin();
 	citer1 != _priority.rend();
@@ -297,6 +333,9 @@ namespace cmtool {
 	// Skip if this combination is not allowed to merge
 	if(!(book_keeper.MergeAllowed((*citer1).second,(*citer2).second))) continue;
 
+	// Skip if the clusters are too far apart for the algorithm to merge them
+	if(!WithinDistance((*citer1).second,(*citer2).second,max_dist)) continue;
+
 	if(_debug_mode <= kPerMerging){
 
 	  std::cout
@@ -348,14 +387,26 @@ namespace cmtool {
   void CMergeManager::RunSeparate(const std::vector<cluster::ClusterParamsAlg> &in_clusters,
 				  CMergeBookKeeper &book_keeper) const
   {
-    /*
+    std::vector<std::pair<unsigned short,unsigned short> > separated_pairs;
+    RunSeparate(in_clusters,
+		std::vector<bool>(in_clusters.size(),true),
+		std::vector<std::pair<unsigned short,unsigned short> >(),
+		book_keeper,
+		separated_pairs);
+  }
+
+  void CMergeManager::RunSeparate(const std::vector<cluster::ClusterParamsAlg> &in_clusters,
+				  const std::vector<bool> &separate_flag,
+				  const std::vector<std::pair<unsigned short,unsigned short> > &known_pairs,
+				  CMergeBookKeeper &book_keeper,
+				  std::vector<std::pair<unsigned short,unsigned short> > &separated_pairs) const
+  {
     if(separate_flag.size() != in_clusters.size())
       throw CMTException(Form("in_clusters (%zu) and separate_flag (%zu) vectors must be of same length!",
 				   in_clusters.size(),
 				   separate_flag.size()
 				   )
 			      );
-    */
     if(_debug_mode <= kPerIteration){
 
       std::cout
@@ -368,6 +419,18 @@ namespace cmtool {
     // Separation
     //
 
+    float max_dist = _separate_algo->MaxInteractionDistance();
+    if(_extents.size() != in_clusters.size()) max_dist = -1;
+
+    separated_pairs.clear();
+
+    for(auto const& known : known_pairs) {
+
+      book_keeper.ProhibitMerge(known.first,known.second);
+
+      separated_pairs.push_back(known);
+    }
+
     // Run over clusters and execute merging algorithms
     for(size_t cindex1 = 0; cindex1 < in_clusters.size(); ++cindex1) {
 
@@ -380,7 +443,10 @@ namespace cmtool {
 	if(plane1 != plane2) continue;
 
 	// Skip if this combination is not meant to be compared
-	//if(!(separate_flag.at(cindex2))) continue;
+	if(!(separate_flag.at(cindex2)) && !(separate_flag.at(cindex1))) continue;
+
+	// Skip if the clusters are too far apart for the algorithm to separate them
+	if(!WithinDistance(cindex1,cindex2,max_dist)) continue;
 
 	if(_debug_mode <= kPerMerging){
 
@@ -405,10 +471,13 @@ namespace cmtool {
 
 	} // end looping over all sets of algorithms
 
-	if(separate)
+	if(separate) {
 
 	  book_keeper.ProhibitMerge(cindex1,cindex2);
 
+	  separated_pairs.push_back(std::make_pair(cindex1,cindex2));
+	}
+
       } // end looping over all cluster pairs for citer1
 
     } // end looping over clusters
@@ -18,6 +18,7 @@
 #include "CMergeBookKeeper.h"
 
 #include "larreco/RecoAlg/ClusterRecoUtil/ClusterParamsAlg.h"
+#include <utility>
 #include <vector>
 
 namespace cmtool {
@@ -87,6 +88,17 @@ namespace cmtool {
     void RunSeparate(const std::vector<cluster::ClusterParamsAlg > &in_clusters,
 		     CMergeBookKeeper &book_keeper) const;
 
+    /**
+       Separation over pairs with at least one cluster flagged in separate_flag. For pairs of
+       unflagged clusters the outcome is taken from known_pairs, the separated pairs found
+       for these clusters in an earlier pass. All separated pairs are added to separated_pairs.
+    */
+    void RunSeparate(const std::vector<cluster::ClusterParamsAlg > &in_clusters,
+		     const std::vector<bool> &separate_flag,
+		     const std::vector<std::pair<unsigned short,unsigned short> > &known_pairs,
+		     CMergeBookKeeper &book_keeper,
+		     std::vector<std::pair<unsigned short,unsigned short> > &separated_pairs) const;
+
   protected:
 
     /// Output clusters
@@ -109,6 +121,9 @@ namespace cmtool {
 
     std::vector<cluster::ClusterParamsAlg> _tmp_merged_clusters;
 
+    /// Pairs of _tmp_merged_clusters found to be separated in the last iteration
+    std::vector<std::pair<unsigned short,unsigned short> > _tmp_separated_pairs;
+
   };
 }
 
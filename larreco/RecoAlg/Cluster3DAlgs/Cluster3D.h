@@ -69,7 +69,44 @@ public:
 
     ClusterHit2D(const ClusterHit2D&);
 
-    unsigned           getStatusBits()   const {return m_statusBits;}
+    /**
+     *  @brief 2D hits are shared by clusters, so when clusters are processed at once the changes to the
+     *         status bits are kept per cluster instead, as the bits set and the bits cleared for each hit.
+     *         Each cluster then sees the bits as they were before plus its own changes, and the changes
+     *         are applied to the hits afterwards in the order of the clusters.
+     */
+    using StatusBitsChanges = std::unordered_map<const ClusterHit2D*, std::pair<unsigned,unsigned>>;
+
+    /**
+     *  @brief Keeps the status bit changes made by this thread in the given map while in scope
+     */
+    class StatusBitsChangesScope
+    {
+    public:
+        explicit StatusBitsChangesScope(StatusBitsChanges& changes) : m_previous(s_statusBitsChanges) {s_statusBitsChanges = &changes;}
+        ~StatusBitsChangesScope() {s_statusBitsChanges = m_previous;}
+        StatusBitsChangesScope(const StatusBitsChangesScope&) = delete;
+        StatusBitsChangesScope& operator=(const StatusBitsChangesScope&) = delete;
+    private:
+        StatusBitsChanges* m_previous;
+    };
+
+    /**
+     *  @brief Apply the status bit changes kept for a cluster to the hits
+     */
+    static void applyStatusBitsChanges(const StatusBitsChanges& changes)
+    {
+        for(const auto& change : changes)
+            change.first->m_statusBits = (change.first->m_statusBits & ~change.second.second) | change.second.first;
+    }
+
+    unsigned           getStatusBits()   const
+    {
+        if (!s_statusBitsChanges) return m_statusBits;
+        auto changeItr = s_statusBitsChanges->find(this);
+        if (changeItr == s_statusBitsChanges->end()) return m_statusBits;
+        return (m_statusBits & ~changeItr->second.second) | changeItr->second.first;
+    }
     float              getDocaToAxis()   const {return m_docaToAxis;}
     float              getArcLenToPoca() const {return m_arcLenToPoca;}
     float              getXPosition()    const {return m_xPosition;}
@@ -77,8 +114,20 @@ public:
     const geo::WireID& WireID()          const {return m_wireID;}
     const recob::Hit*  getHit()          const {return m_hit;}
 
-    void setStatusBit(unsigned bits)    const {m_statusBits   |= bits;}
-    void clearStatusBits(unsigned bits) const {m_statusBits   &= ~bits;}
+    void setStatusBit(unsigned bits)    const
+    {
+        if (!s_statusBitsChanges) {m_statusBits |= bits; return;}
+        auto& change = (*s_statusBitsChanges)[this];
+        change.first  |= bits;
+        change.second &= ~bits;
+    }
+    void clearStatusBits(unsigned bits) const
+    {
+        if (!s_statusBitsChanges) {m_statusBits &= ~bits; return;}
+        auto& change = (*s_statusBitsChanges)[this];
+        change.first  &= ~bits;
+        change.second |= bits;
+    }
     void setDocaToAxis(float doca)      const {m_docaToAxis    = doca;}
     void setArcLenToPoca(float poca)    const {m_arcLenToPoca  = poca;}
 
@@ -87,6 +136,10 @@ public:
     friend std::ostream& operator << (std::ostream& o, const ClusterHit2D& c);
     friend bool          operator <  (const ClusterHit2D & a, const ClusterHit2D & b);
 
+private:
+
+    static inline thread_local StatusBitsChanges* s_statusBitsChanges = nullptr; ///< Changes kept by this thread, if any
+
 };
 
 using ClusterHit2DVec = std::vector<const reco::ClusterHit2D*>;
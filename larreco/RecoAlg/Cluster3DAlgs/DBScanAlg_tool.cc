@@ -21,7 +21,9 @@
 #include "larreco/RecoAlg/Cluster3DAlgs/kdTree.h"
 
 // std includes
+#include <limits>
 #include <memory>
+#include <vector>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // implementation follows
@@ -73,11 +75,18 @@ public:
 
 private:
 
+    /**
+     *  @brief Run DBScan over the hits of the flat kd tree, visiting them in input order
+     */
+    void runDBScan(const kdTree::FlatKdTree&,
+                   reco::ClusterParametersList&) const;
+
     /**
      *  @brief the main routine for DBScan
      */
-    void expandCluster(const kdTree::KdTreeNode&,
-                       kdTree::CandPairList&,
+    void expandCluster(const kdTree::FlatKdTree&,
+                       const kdTree::NeighborPool&,
+                       size_t,
                        reco::ClusterParameters&,
                        size_t) const;
 
@@ -129,7 +138,7 @@ void DBScanAlg::configure(fhicl::ParameterSet const &pset)
 
     kdTreeParams.put_or_replace<float>("RefLeafBestDist", maxBestDist);
 
-    m_kdTree = kdTree(kdTreeParams);
+    m_kdTree.configure(kdTreeParams);
 }
 
 void DBScanAlg::Cluster3DHits(reco::HitPairList&           hitPairList,
@@ -139,78 +148,14 @@ void DBScanAlg::Cluster3DHits(reco::HitPairList&           hitPairList,
      *  @brief Driver for processing input 2D hits, transforming to 3D hits and building lists
      *         of associated 3D hits (candidate 3D clusters)
      */
-    cet::cpu_timer theClockDBScan;
-
     m_timeVector.resize(NUMTIMEVALUES, 0.);
 
     // DBScan is driven of its "epsilon neighborhood". Computing adjacency within DBScan can be time
     // consuming so the idea is the prebuild the adjaceny map and then run DBScan.
     // We'll employ a kdTree to implement this scheme
-    kdTree::KdTreeNodeList kdTreeNodeContainer;
-    kdTree::KdTreeNode     topNode = m_kdTree.BuildKdTree(hitPairList, kdTreeNodeContainer);
-
-    if (m_enableMonitoring) m_timeVector[BUILDHITTOHITMAP] = m_kdTree.getTimeToExecute();
-
-    if (m_enableMonitoring) theClockDBScan.start();
-
-    // Ok, here we go!
-    // The idea is to loop through all of the input 3D hits and do the clustering
-    for(const auto& hit : hitPairList)
-    {
-        // Check if the hit has already been visited
-        if (hit.getStatusBits() & reco::ClusterHit3D::CLUSTERVISITED) continue;
-
-        // Mark as visited
-        hit.setStatusBit(reco::ClusterHit3D::CLUSTERVISITED);
-
-        // Find the neighborhood for this hit
-        kdTree::CandPairList candPairList;
-        float                bestDistance(std::numeric_limits<float>::max());
-
-        m_kdTree.FindNearestNeighbors(&hit, topNode, candPairList, bestDistance);
-
-        if (candPairList.size() < m_minPairPts)
-        {
-            hit.setStatusBit(reco::ClusterHit3D::CLUSTERNOISE);
-        }
-        else
-        {
-            // "Create" a new cluster and get a reference to it
-            clusterParametersList.push_back(reco::ClusterParameters());
-
-            reco::ClusterParameters& curCluster = clusterParametersList.back();
-
-            hit.setStatusBit(reco::ClusterHit3D::CLUSTERATTACHED);
-            curCluster.addHit3D(&hit);
-
-            // expand the cluster
-            expandCluster(topNode, candPairList, curCluster, m_minPairPts);
-        }
-    }
-
-    if (m_enableMonitoring)
-    {
-        theClockDBScan.stop();
-
-        m_timeVector[RUNDBSCAN] = theClockDBScan.accumulated_real_time();
-    }
-
-    // Initial clustering is done, now trim the list and get output parameters
-    cet::cpu_timer theClockBuildClusters;
-
-    // Start clocks if requested
-    if (m_enableMonitoring) theClockBuildClusters.start();
-
-    m_clusterBuilder->BuildClusterInfo(clusterParametersList);
-
-    if (m_enableMonitoring)
-    {
-        theClockBuildClusters.stop();
+    kdTree::FlatKdTree flatKdTree = m_kdTree.BuildFlatKdTree(hitPairList);
 
-        m_timeVector[BUILDCLUSTERINFO] = theClockBuildClusters.accumulated_real_time();
-    }
-
-    mf::LogDebug("Cluster3D") << ">>>>> DBScan done, found " << clusterParametersList.size() << " clusters" << std::endl;
+    runDBScan(flatKdTree, clusterParametersList);
 
     return;
 }
@@ -222,37 +167,46 @@ void DBScanAlg::Cluster3DHits(reco::HitPairListPtr&        hitPairList,
      *  @brief Driver for processing input 2D hits, transforming to 3D hits and building lists
      *         of associated 3D hits (candidate 3D clusters)
      */
-    cet::cpu_timer theClockDBScan;
-
     m_timeVector.resize(NUMTIMEVALUES, 0.);
 
     // DBScan is driven of its "epsilon neighborhood". Computing adjacency within DBScan can be time
     // consuming so the idea is the prebuild the adjaceny map and then run DBScan.
     // We'll employ a kdTree to implement this scheme
-    kdTree::KdTreeNodeList kdTreeNodeContainer;
-    kdTree::KdTreeNode     topNode = m_kdTree.BuildKdTree(hitPairList, kdTreeNodeContainer);
+    kdTree::FlatKdTree flatKdTree = m_kdTree.BuildFlatKdTree(hitPairList);
+
+    runDBScan(flatKdTree, clusterParametersList);
+
+    return;
+}
+
+void DBScanAlg::runDBScan(const kdTree::FlatKdTree&    flatKdTree,
+                          reco::ClusterParametersList& clusterParametersList) const
+{
+    // The epsilon neighborhood of every hit is found up front, all queries at once
+    kdTree::NeighborPool neighborPool;
+
+    m_kdTree.FindAllNearestNeighbors(flatKdTree, neighborPool, std::numeric_limits<float>::max());
 
-    if (m_enableMonitoring) m_timeVector[BUILDHITTOHITMAP] = m_kdTree.getTimeToExecute();
+    if (m_enableMonitoring) m_timeVector[BUILDHITTOHITMAP] = m_kdTree.getTimeToExecute() + m_kdTree.getTimeToQuery();
+
+    cet::cpu_timer theClockDBScan;
 
     if (m_enableMonitoring) theClockDBScan.start();
 
     // Ok, here we go!
     // The idea is to loop through all of the input 3D hits and do the clustering
-    for(const auto& hit : hitPairList)
+    for(const auto& leaf : flatKdTree.leafOfInput)
     {
+        const reco::ClusterHit3D* hit = flatKdTree.hits[leaf];
+
         // Check if the hit has already been visited
         if (hit->getStatusBits() & reco::ClusterHit3D::CLUSTERVISITED) continue;
 
         // Mark as visited
         hit->setStatusBit(reco::ClusterHit3D::CLUSTERVISITED);
 
-        // Find the neighborhood for this hit
-        kdTree::CandPairList candPairList;
-        float                bestDistance(std::numeric_limits<float>::max());
-
-        m_kdTree.FindNearestNeighbors(hit, topNode, candPairList, bestDistance);
-
-        if (candPairList.size() < m_minPairPts)
+        // The neighborhood for this hit
+        if (neighborPool.size(leaf) < m_minPairPts)
         {
             hit->setStatusBit(reco::ClusterHit3D::CLUSTERNOISE);
         }
@@ -267,7 +221,7 @@ void DBScanAlg::Cluster3DHits(reco::HitPairListPtr&        hitPairList,
             curCluster.addHit3D(hit);
 
             // expand the cluster
-            expandCluster(topNode, candPairList, curCluster, m_minPairPts);
+            expandCluster(flatKdTree, neighborPool, leaf, curCluster, m_minPairPts);
         }
     }
 
@@ -298,18 +252,23 @@ void DBScanAlg::Cluster3DHits(reco::HitPairListPtr&        hitPairList,
     return;
 }
 
-void DBScanAlg::expandCluster(const kdTree::KdTreeNode& topNode,
-                              kdTree::CandPairList&     candPairList,
-                              reco::ClusterParameters&  cluster,
-                              size_t                    minPts) const
+void DBScanAlg::expandCluster(const kdTree::FlatKdTree&   flatKdTree,
+                              const kdTree::NeighborPool& neighborPool,
+                              size_t                      seedLeaf,
+                              reco::ClusterParameters&    cluster,
+                              size_t                      minPts) const
 {
     // This is the main inside loop for the DBScan based clustering algorithm
+    // The list of hits still to process is kept as leaf indices in a vector used as a queue
+    std::vector<size_t> candLeafVec;
+
+    for(auto pairItr = neighborPool.begin(seedLeaf); pairItr != neighborPool.end(seedLeaf); pairItr++) candLeafVec.emplace_back(pairItr->second);
 
     // Loop over added hits until list has been exhausted
-    while(!candPairList.empty())
+    for(size_t candIdx = 0; candIdx < candLeafVec.size(); candIdx++)
     {
-        // Dereference the point so we can see in the debugger...
-        const reco::ClusterHit3D* neighborHit = candPairList.front().second;
+        size_t                    neighborLeaf = candLeafVec[candIdx];
+        const reco::ClusterHit3D* neighborHit  = flatKdTree.hits[neighborLeaf];
 
         // Process if we've not been here before
         if (!(neighborHit->getStatusBits() & reco::ClusterHit3D::CLUSTERVISITED))
@@ -317,16 +276,11 @@ void DBScanAlg::expandCluster(const kdTree::KdTreeNode& topNode,
             // set as visited
             neighborHit->setStatusBit(reco::ClusterHit3D::CLUSTERVISITED);
 
-            // get the neighborhood around this point
-            kdTree::CandPairList neighborCandPairList;
-            float                bestDistance(std::numeric_limits<float>::max());
-
-            m_kdTree.FindNearestNeighbors(neighborHit, topNode, neighborCandPairList, bestDistance);
-
             // If the epsilon neighborhood of this point is large enough then add its points to our list
-            if (neighborCandPairList.size() >= minPts)
+            if (neighborPool.size(neighborLeaf) >= minPts)
             {
-                std::copy(neighborCandPairList.begin(),neighborCandPairList.end(),std::back_inserter(candPairList));
+                for(auto pairItr = neighborPool.begin(neighborLeaf); pairItr != neighborPool.end(neighborLeaf); pairItr++)
+                    candLeafVec.emplace_back(pairItr->second);
             }
         }
 
@@ -336,8 +290,6 @@ void DBScanAlg::expandCluster(const kdTree::KdTreeNode& topNode,
             neighborHit->setStatusBit(reco::ClusterHit3D::CLUSTERATTACHED);
             cluster.addHit3D(neighborHit);
         }
-
-        candPairList.pop_front();
     }
 
     return;
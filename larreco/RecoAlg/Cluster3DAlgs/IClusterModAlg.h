@@ -15,6 +15,12 @@
 // Algorithm includes
 #include "larreco/RecoAlg/Cluster3DAlgs/Cluster3D.h"
 
+// TBB
+#include "tbb/parallel_for.h"
+
+// std includes
+#include <vector>
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 namespace art
 {
@@ -62,6 +68,45 @@ public:
      */
     virtual float getTimeToExecute() const = 0;
 
+protected:
+    /**
+     *  @brief Apply a function to each cluster of the input list. In the concurrent mode each cluster
+     *         is processed as its own TBB task, so the function must only modify the cluster it is given
+     *         (and anything shared across clusters in a thread safe way). The status bits of the shared
+     *         2D hits are the exception: each cluster keeps its own changes, which are applied in list
+     *         order at the end, so the result does not depend on the order the tasks run in
+     *
+     *  @param clusterParametersList A list of cluster objects (parameters from associated hits)
+     *  @param concurrent            Process the clusters concurrently
+     *  @param function              Function taking a reco::ClusterParameters&
+     */
+    template <typename Function>
+    static void forEachCluster(reco::ClusterParametersList& clusterParametersList, bool concurrent, const Function& function)
+    {
+        if (!concurrent)
+        {
+            for(auto& clusterParameters : clusterParametersList) function(clusterParameters);
+            return;
+        }
+
+        // The list gives no random access, so go through a vector of pointers to its elements
+        std::vector<reco::ClusterParameters*> clusterPtrVec;
+
+        clusterPtrVec.reserve(clusterParametersList.size());
+
+        for(auto& clusterParameters : clusterParametersList) clusterPtrVec.push_back(&clusterParameters);
+
+        std::vector<reco::ClusterHit2D::StatusBitsChanges> statusBitsChangesVec(clusterPtrVec.size());
+
+        tbb::parallel_for(size_t(0), clusterPtrVec.size(), [&](size_t idx)
+        {
+            reco::ClusterHit2D::StatusBitsChangesScope statusBitsChangesScope(statusBitsChangesVec[idx]);
+
+            function(*clusterPtrVec[idx]);
+        });
+
+        for(const auto& statusBitsChanges : statusBitsChangesVec) reco::ClusterHit2D::applyStatusBitsChanges(statusBitsChanges);
+    }
 };
 
 } // namespace lar_cluster3d
@@ -80,7 +80,7 @@ private:
     /**
      *  @brief Driver for Prim's algorithm
      */
-    void RunPrimsAlgorithm(reco::HitPairList&, kdTree::KdTreeNode&, reco::ClusterParametersList&) const;
+    void RunPrimsAlgorithm(reco::HitPairList&, const kdTree::FlatKdTree&, reco::ClusterParametersList&) const;
 
     /**
      *  @brief Prune the obvious ambiguous hits
@@ -100,12 +100,12 @@ private:
     /**
      *  @brief Alternative version of FindBestPathInCluster utilizing an A* algorithm
      */
-    void FindBestPathInCluster(reco::ClusterParameters&, kdTree::KdTreeNode&) const;
+    void FindBestPathInCluster(reco::ClusterParameters&, const kdTree::FlatKdTree&) const;
 
     /**
      *  @brief Algorithm to find shortest path between two 3D hits
      */
-    void AStar(const reco::ClusterHit3D*, const reco::ClusterHit3D*, float alpha, kdTree::KdTreeNode&, reco::ClusterParameters&) const;
+    void AStar(const reco::ClusterHit3D*, const reco::ClusterHit3D*, float alpha, const kdTree::FlatKdTree&, reco::ClusterParameters&) const;
 
     using BestNodeTuple = std::tuple<const reco::ClusterHit3D*,float,float>;
     using BestNodeMap   = std::unordered_map<const reco::ClusterHit3D*,BestNodeTuple>;
@@ -219,8 +219,7 @@ void MinSpanTreeAlg::Cluster3DHits(reco::HitPairList&           hitPairList,
     // DBScan is driven of its "epsilon neighborhood". Computing adjacency within DBScan can be time
     // consuming so the idea is the prebuild the adjaceny map and then run DBScan.
     // The following call does this work
-    kdTree::KdTreeNodeList kdTreeNodeContainer;
-    kdTree::KdTreeNode     topNode = m_kdTree.BuildKdTree(hitPairList, kdTreeNodeContainer);
+    kdTree::FlatKdTree topNode = m_kdTree.BuildFlatKdTree(hitPairList);
 
     if (m_enableMonitoring) m_timeVector.at(BUILDHITTOHITMAP) = m_kdTree.getTimeToExecute();
 
@@ -252,7 +251,7 @@ void MinSpanTreeAlg::Cluster3DHits(reco::HitPairList&           hitPairList,
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 void MinSpanTreeAlg::RunPrimsAlgorithm(reco::HitPairList&           hitPairList,
-                                       kdTree::KdTreeNode&          topNode,
+                                       const kdTree::FlatKdTree&    topNode,
                                        reco::ClusterParametersList& clusterParametersList) const
 {
     // If no hits then no work
@@ -304,8 +303,8 @@ void MinSpanTreeAlg::RunPrimsAlgorithm(reco::HitPairList&           hitPairList,
         curCluster->push_back(lastAddedHit);
 
         // Set up to find the list of nearest neighbors to the last used hit...
-        kdTree::CandPairList CandPairList;
-        float                bestDistance(1.5); //std::numeric_limits<float>::max());
+        kdTree::NeighborBuffer CandPairList;
+        float                  bestDistance(1.5); //std::numeric_limits<float>::max());
 
         // And find them... result will be an unordered list of neigbors
         m_kdTree.FindNearestNeighbors(lastAddedHit, topNode, CandPairList, bestDistance);
@@ -439,7 +438,7 @@ void MinSpanTreeAlg::FindBestPathInCluster(reco::ClusterParameters& curCluster)
     return;
 }
 
-void MinSpanTreeAlg::FindBestPathInCluster(reco::ClusterParameters& clusterParams, kdTree::KdTreeNode& topNode) const
+void MinSpanTreeAlg::FindBestPathInCluster(reco::ClusterParameters& clusterParams, const kdTree::FlatKdTree& topNode) const
 {
     // Set up for timing the function
     cet::cpu_timer theClockPathFinding;
@@ -533,7 +532,7 @@ void MinSpanTreeAlg::FindBestPathInCluster(reco::ClusterParameters& clusterParam
 void MinSpanTreeAlg::AStar(const reco::ClusterHit3D* startNode,
                            const reco::ClusterHit3D* goalNode,
                            float                     alpha,
-                           kdTree::KdTreeNode&       topNode,
+                           const kdTree::FlatKdTree& topNode,
                            reco::ClusterParameters&  clusterParams) const
 {
     // Recover the list of hits and edges
@@ -28,6 +28,7 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // implementation follows
@@ -135,6 +136,7 @@ private:
      *  @brief FHICL parameters
      */
     bool                                        fEnableMonitoring;      ///<
+    bool                                        fConcurrentClusters;    ///< Process the input clusters concurrently
     size_t                                      fMinTinyClusterSize;    ///< Minimum size for a "tiny" cluster
     float                                       fMinGapSize;            ///< Minimum gap size to break at gaps
     float                                       fMinEigen0To1Ratio;     ///< Minimum ratio of eigen 0 to 1 to continue breaking
@@ -146,6 +148,7 @@ private:
      *  @brief Histogram definitions
      */
     bool                                        fFillHistograms;
+    mutable std::mutex                          fHistMutex;             ///< Serializes the fills in the concurrent mode
 
     TH1F*                                       fTopNum3DHits;
     TH1F*                                       fTopNumEdges;
@@ -194,6 +197,7 @@ ConvexHullPathFinder::~ConvexHullPathFinder()
 void ConvexHullPathFinder::configure(fhicl::ParameterSet const &pset)
 {
     fEnableMonitoring     = pset.get<bool>  ("EnableMonitoring",   true );
+    fConcurrentClusters   = pset.get<bool>  ("ConcurrentClusters", false);
     fMinTinyClusterSize   = pset.get<size_t>("MinTinyClusterSize", 40   );
     fMinGapSize           = pset.get<float >("MinClusterGapSize",   2.0 );
     fMinEigen0To1Ratio    = pset.get<float >("MinEigen0To1Ratio",  10.0 );
@@ -261,15 +265,9 @@ void ConvexHullPathFinder::ModifyClusters(reco::ClusterParametersList& clusterPa
     if (fEnableMonitoring) theClockBuildClusters.start();
 
     // This is the loop over candidate 3D clusters
-    // Note that it might be that the list of candidate clusters is modified by splitting
-    // So we use the following construct to make sure we get all of them
-    reco::ClusterParametersList::iterator clusterParametersListItr = clusterParametersList.begin();
-
-    while(clusterParametersListItr != clusterParametersList.end())
+    // Note that the splitting only adds daughters to each cluster, so the clusters can be processed concurrently
+    forEachCluster(clusterParametersList, fConcurrentClusters, [this](reco::ClusterParameters& clusterParameters)
     {
-        // Dereference to get the cluster paramters
-        reco::ClusterParameters& clusterParameters = *clusterParametersListItr;
-
         // It turns out that computing the convex hull surrounding the points in the 2D projection onto the
         // plane of largest spread in the PCA is a good way to break up the cluster... and we do it here since
         // we (currently) want this to be part of the standard output
@@ -316,22 +314,23 @@ void ConvexHullPathFinder::ModifyClusters(reco::ClusterParametersList& clusterPa
                         int                        num3DHits      = cluster.getHitPairListPtr().size();
                         int                        numEdges       = cluster.getConvexHull().getConvexHullEdgeList().size();
 
-                        fTopNum3DHits->Fill(std::min(num3DHits,199), 1.);
-                        fTopNumEdges->Fill(std::min(numEdges,199),   1.);
-                        fTopEigen21Ratio->Fill(eigen2To1Ratio, 1.);
-                        fTopEigen20Ratio->Fill(eigen2To0Ratio, 1.);
-                        fTopEigen10Ratio->Fill(eigen1To0Ratio, 1.);
-                        fTopPrimaryLength->Fill(std::min(eigenValVec[2],199.), 1.);
-//                        fTopExtremeSep->Fill(std::min(edgeLen,199.), 1.);
+                        {
+                            std::lock_guard<std::mutex> histLock(fHistMutex);
+
+                            fTopNum3DHits->Fill(std::min(num3DHits,199), 1.);
+                            fTopNumEdges->Fill(std::min(numEdges,199),   1.);
+                            fTopEigen21Ratio->Fill(eigen2To1Ratio, 1.);
+                            fTopEigen20Ratio->Fill(eigen2To0Ratio, 1.);
+                            fTopEigen10Ratio->Fill(eigen1To0Ratio, 1.);
+                            fTopPrimaryLength->Fill(std::min(eigenValVec[2],199.), 1.);
+//                            fTopExtremeSep->Fill(std::min(edgeLen,199.), 1.);
+                        }
                         fillConvexHullHists(clusterParameters, true);
                     }
                 }
             }
         }
-
-        // Go to next cluster parameters object
-        clusterParametersListItr++;
-    }
+    });
 
     if (fEnableMonitoring)
     {
@@ -488,6 +487,8 @@ reco::ClusterParametersList::iterator ConvexHullPathFinder::subDivideCluster(rec
             // Are we filling histograms
             if (fFillHistograms)
             {
+                std::lock_guard<std::mutex> histLock(fHistMutex);
+
                 std::vector<double> eigenValVec = {3. * std::sqrt(fullPCA.getEigenValues()[0]),
                                                    3. * std::sqrt(fullPCA.getEigenValues()[1]),
                                                    3. * std::sqrt(fullPCA.getEigenValues()[2])};
@@ -962,6 +963,8 @@ bool ConvexHullPathFinder::breakClusterByMaxDefect(reco::ClusterParameters& clus
             {
                 if (fFillHistograms)
                 {
+                    std::lock_guard<std::mutex> histLock(fHistMutex);
+
                     fSubMaxDefect->Fill(std::get<0>(distEdgeTupleVec.front()), 1.);
                     fSubUsedDefect->Fill(usedDefectDist, 1.);
                 }
@@ -1210,6 +1213,8 @@ void ConvexHullPathFinder::buildConvexHull(reco::ClusterParameters& clusterParam
 
 void ConvexHullPathFinder::fillConvexHullHists(reco::ClusterParameters& clusterParameters, bool top) const
 {
+    std::lock_guard<std::mutex> histLock(fHistMutex);
+
     reco::ProjectedPointList& convexHullPoints = clusterParameters.getConvexHull().getConvexHullPointList();
 
     if (convexHullPoints.size() > 2)
@@ -42,6 +42,7 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // implementation follows
@@ -102,7 +103,7 @@ private:
     /**
      *  @brief Driver for Prim's algorithm
      */
-    void RunPrimsAlgorithm(const reco::HitPairListPtr&, kdTree::KdTreeNode&, reco::ClusterParametersList&) const;
+    void RunPrimsAlgorithm(const reco::HitPairListPtr&, const kdTree::FlatKdTree&, reco::ClusterParametersList&) const;
     
     /**
      *  @brief Prune the obvious ambiguous hits
@@ -122,12 +123,12 @@ private:
     /**
      *  @brief Alternative version of FindBestPathInCluster utilizing an A* algorithm
      */
-    void FindBestPathInCluster(reco::ClusterParameters&, kdTree::KdTreeNode&) const;
+    void FindBestPathInCluster(reco::ClusterParameters&, const kdTree::FlatKdTree&) const;
     
     /**
      *  @brief Algorithm to find shortest path between two 3D hits
      */
-    void AStar(const reco::ClusterHit3D*, const reco::ClusterHit3D*, float alpha, kdTree::KdTreeNode&, reco::ClusterParameters&) const;
+    void AStar(const reco::ClusterHit3D*, const reco::ClusterHit3D*, float alpha, const kdTree::FlatKdTree&, reco::ClusterParameters&) const;
     
     using BestNodeTuple = std::tuple<const reco::ClusterHit3D*,float,float>;
     using BestNodeMap   = std::unordered_map<const reco::ClusterHit3D*,BestNodeTuple>;
@@ -164,11 +165,13 @@ private:
      *  @brief Data members to follow
      */
     bool                                                      fEnableMonitoring;      ///<
+    bool                                                      fConcurrentClusters;    ///< Process the input clusters concurrently
     size_t                                                    fMinTinyClusterSize;    ///< Minimum size for a "tiny" cluster
     float                                                     fConvexHullKinkAngle;   ///< Angle to declare a kink in convex hull calc
     float                                                     fConvexHullMinSep;      ///< Min hit separation to conisder in convex hull
 
     mutable std::vector<float>                                fTimeVector;            ///<
+    mutable std::mutex                                        fTimeMutex;             ///< Protects fTimeVector in the concurrent mode
     
     geo::Geometry const*                                      fGeometry;              //< pointer to the Geometry service
     
@@ -196,6 +199,7 @@ MSTPathFinder::~MSTPathFinder()
 void MSTPathFinder::configure(fhicl::ParameterSet const &pset)
 {
     fEnableMonitoring     = pset.get<bool>  ("EnableMonitoring",    true);
+    fConcurrentClusters   = pset.get<bool>  ("ConcurrentClusters",  false);
     fMinTinyClusterSize   = pset.get<size_t>("MinTinyClusterSize",  40  );
     fConvexHullKinkAngle  = pset.get<float >("ConvexHullKinkAgle",  0.95);
     fConvexHullMinSep     = pset.get<float >("ConvexHullMinSep",    0.65);
@@ -244,8 +248,8 @@ void MSTPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParameter
     if (fEnableMonitoring) theClockBuildClusters.start();
     
     // Ok, the idea here is to loop over the input clusters and the process one at a time and then use the MST algorithm
-    // to deghost and try to find the best path.
-    for(auto& clusterParams : clusterParametersList)
+    // to deghost and try to find the best path. The clusters are independent here, so they can be processed concurrently
+    forEachCluster(clusterParametersList, fConcurrentClusters, [this](reco::ClusterParameters& clusterParams)
     {
         // It turns out that computing the convex hull surrounding the points in the 2D projection onto the
         // plane of largest spread in the PCA is a good way to break up the cluster... and we do it here since
@@ -258,10 +262,14 @@ void MSTPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParameter
             // DBScan is driven of its "epsilon neighborhood". Computing adjacency within DBScan can be time
             // consuming so the idea is the prebuild the adjaceny map and then run DBScan.
             // The following call does this work
-            kdTree::KdTreeNodeList kdTreeNodeContainer;
-            kdTree::KdTreeNode     topNode = fkdTree.BuildKdTree(clusterParams.getHitPairListPtr(), kdTreeNodeContainer);
+            kdTree::FlatKdTree topNode = fkdTree.BuildFlatKdTree(clusterParams.getHitPairListPtr());
             
-            if (fEnableMonitoring) fTimeVector.at(BUILDHITTOHITMAP) = fkdTree.getTimeToExecute();
+            if (fEnableMonitoring)
+            {
+                std::lock_guard<std::mutex> timeLock(fTimeMutex);
+
+                fTimeVector.at(BUILDHITTOHITMAP) = fkdTree.getTimeToExecute();
+            }
             
             // We are making subclusters
             reco::ClusterParametersList&  daughterParametersList = clusterParams.daughterList();
@@ -281,13 +289,15 @@ void MSTPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParameter
             {
                 theClockBuildClusters.stop();
                 
+                std::lock_guard<std::mutex> timeLock(fTimeMutex);
+
                 fTimeVector[BUILDCLUSTERINFO] = theClockBuildClusters.accumulated_real_time();
             }
             
             // Test run the path finding algorithm
             for(auto& daughterParams : daughterParametersList) FindBestPathInCluster(daughterParams, topNode);
         }
-    }
+    });
 
     if (fEnableMonitoring)
     {
@@ -303,7 +313,7 @@ void MSTPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParameter
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 void MSTPathFinder::RunPrimsAlgorithm(const reco::HitPairListPtr&  hitPairList,
-                                      kdTree::KdTreeNode&          topNode,
+                                      const kdTree::FlatKdTree&    topNode,
                                       reco::ClusterParametersList& clusterParametersList) const
 {
     // If no hits then no work
@@ -355,8 +365,8 @@ void MSTPathFinder::RunPrimsAlgorithm(const reco::HitPairListPtr&  hitPairList,
         curClusterHitList->push_back(lastAddedHit);
         
         // Set up to find the list of nearest neighbors to the last used hit...
-        kdTree::CandPairList CandPairList;
-        float                bestDistance(1.5); //std::numeric_limits<float>::max());
+        kdTree::NeighborBuffer CandPairList;
+        float                  bestDistance(1.5); //std::numeric_limits<float>::max());
         
         // And find them... result will be an unordered list of neigbors
         fkdTree.FindNearestNeighbors(lastAddedHit, topNode, CandPairList, bestDistance);
@@ -418,6 +428,8 @@ void MSTPathFinder::RunPrimsAlgorithm(const reco::HitPairListPtr&  hitPairList,
     {
         theClockDBScan.stop();
         
+        std::lock_guard<std::mutex> timeLock(fTimeMutex);
+
         fTimeVector[RUNDBSCAN] = theClockDBScan.accumulated_real_time();
     }
     
@@ -484,13 +496,15 @@ void MSTPathFinder::FindBestPathInCluster(reco::ClusterParameters& curCluster) c
     {
         theClockPathFinding.stop();
         
+        std::lock_guard<std::mutex> timeLock(fTimeMutex);
+
         fTimeVector[PATHFINDING] += theClockPathFinding.accumulated_real_time();
     }
     
     return;
 }
     
-void MSTPathFinder::FindBestPathInCluster(reco::ClusterParameters& clusterParams, kdTree::KdTreeNode& topNode) const
+void MSTPathFinder::FindBestPathInCluster(reco::ClusterParameters& clusterParams, const kdTree::FlatKdTree& topNode) const
 {
     // Set up for timing the function
     cet::cpu_timer theClockPathFinding;
@@ -582,6 +596,8 @@ void MSTPathFinder::FindBestPathInCluster(reco::ClusterParameters& clusterParams
     {
         theClockPathFinding.stop();
         
+        std::lock_guard<std::mutex> timeLock(fTimeMutex);
+
         fTimeVector[PATHFINDING] += theClockPathFinding.accumulated_real_time();
     }
     
@@ -591,7 +607,7 @@ void MSTPathFinder::FindBestPathInCluster(reco::ClusterParameters& clusterParams
 void MSTPathFinder::AStar(const reco::ClusterHit3D* startNode,
                            const reco::ClusterHit3D* goalNode,
                            float                     alpha,
-                           kdTree::KdTreeNode&       topNode,
+                           const kdTree::FlatKdTree& topNode,
                            reco::ClusterParameters&  clusterParams) const
 {
     // Recover the list of hits and edges
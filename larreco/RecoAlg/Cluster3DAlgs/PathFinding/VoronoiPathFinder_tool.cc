@@ -10,6 +10,7 @@
 #include "art/Utilities/make_tool.h"
 #include "art_root_io/TFileDirectory.h"
 #include "cetlib/cpu_timer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "larreco/RecoAlg/Cluster3DAlgs/IClusterModAlg.h"
 #include "larreco/RecoAlg/Cluster3DAlgs/ConvexHull/ConvexHull.h"
@@ -22,6 +23,9 @@
 // Eigen
 #include <Eigen/Core>
 
+// TBB
+#include "tbb/enumerable_thread_specific.h"
+
 // Root histograms
 #include "TH1F.h"
 
@@ -29,6 +33,7 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // implementation follows
@@ -125,6 +130,7 @@ private:
      *  @brief FHICL parameters
      */
     bool                                        fEnableMonitoring;      ///<
+    bool                                        fConcurrentClusters;    ///< Process the input clusters concurrently
     size_t                                      fMinTinyClusterSize;    ///< Minimum size for a "tiny" cluster
     mutable float                               fTimeToProcess;         ///<
 
@@ -132,6 +138,7 @@ private:
      *  @brief Histogram definitions
      */
     bool                                        fFillHistograms;
+    mutable std::mutex                          fHistMutex;             ///< Serializes the fills in the concurrent mode
 
     TH1F*                                       fTopNum3DHits;
     TH1F*                                       fTopNumEdges;
@@ -156,6 +163,11 @@ private:
      */
     std::unique_ptr<lar_cluster3d::IClusterAlg> fClusterAlg;            ///<  Algorithm to do 3D space point clustering
     PrincipalComponentsAlg                      fPCAAlg;                // For running Principal Components Analysis
+
+    /**
+     *  @brief Construction arenas for the Voronoi diagrams, one per thread and reused from cluster to cluster
+     */
+    mutable tbb::enumerable_thread_specific<voronoi2d::VoronoiArena> fVoronoiArenas;
 };
 
 VoronoiPathFinder::VoronoiPathFinder(fhicl::ParameterSet const &pset) :
@@ -175,6 +187,7 @@ VoronoiPathFinder::~VoronoiPathFinder()
 void VoronoiPathFinder::configure(fhicl::ParameterSet const &pset)
 {
     fEnableMonitoring   = pset.get<bool>  ("EnableMonitoring",  true  );
+    fConcurrentClusters = pset.get<bool>  ("ConcurrentClusters",false );
     fMinTinyClusterSize = pset.get<size_t>("MinTinyClusterSize",40);
     fClusterAlg         = art::make_tool<lar_cluster3d::IClusterAlg>(pset.get<fhicl::ParameterSet>("ClusterAlg"));
 
@@ -232,19 +245,11 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
     // Start clocks if requested
     if (fEnableMonitoring) theClockBuildClusters.start();
 
-    int countClusters(0);
-
     // This is the loop over candidate 3D clusters
-    // Note that it might be that the list of candidate clusters is modified by splitting
-    // So we use the following construct to make sure we get all of them
-    reco::ClusterParametersList::iterator clusterParametersListItr = clusterParametersList.begin();
-
-    while(clusterParametersListItr != clusterParametersList.end())
+    // Note that the splitting only adds daughters to each cluster, so the clusters can be processed concurrently
+    forEachCluster(clusterParametersList, fConcurrentClusters, [this](reco::ClusterParameters& clusterParameters)
     {
-        // Dereference to get the cluster paramters
-        reco::ClusterParameters& clusterParameters = *clusterParametersListItr;
-
-        std::cout << "**> Looking at Cluster " << countClusters++ << ", # hits: " << clusterParameters.getHitPairListPtr().size() << std::endl;
+        mf::LogDebug("VoronoiPathFinder") << "**> Looking at Cluster with # hits: " << clusterParameters.getHitPairListPtr().size() << std::endl;
 
         // It turns out that computing the convex hull surrounding the points in the 2D projection onto the
         // plane of largest spread in the PCA is a good way to break up the cluster... and we do it here since
@@ -262,7 +267,7 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
             //fClusterAlg->Cluster3DHits(clusterParameters.getHitPairListPtr(), reclusteredParameters);
             reclusteredParameters.push_back(clusterParameters);
 
-            std::cout << ">>>>>>>>>>> Reclustered to " << reclusteredParameters.size() << " Clusters <<<<<<<<<<<<<<<" << std::endl;
+            mf::LogDebug("VoronoiPathFinder") << ">>>>>>>>>>> Reclustered to " << reclusteredParameters.size() << " Clusters <<<<<<<<<<<<<<<" << std::endl;
 
             // Only process non-empty results
             if (!reclusteredParameters.empty())
@@ -270,7 +275,7 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
                 // Loop over the reclustered set
                 for (auto& cluster : reclusteredParameters)
                 {
-                    std::cout << "****> Calling breakIntoTinyBits with " << cluster.getHitPairListPtr().size() << " hits" << std::endl;
+                    mf::LogDebug("VoronoiPathFinder") << "****> Calling breakIntoTinyBits with " << cluster.getHitPairListPtr().size() << " hits" << std::endl;
 
                     // It turns out that computing the convex hull surrounding the points in the 2D projection onto the
                     // plane of largest spread in the PCA is a good way to break up the cluster... and we do it here since
@@ -280,9 +285,12 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
                     // Break our cluster into smaller elements...
                     subDivideCluster(cluster, cluster.getFullPCA(), cluster.daughterList().end(), cluster.daughterList(), 4);
 
-                    std::cout << "****> Broke Cluster with " << cluster.getHitPairListPtr().size() << " into " << cluster.daughterList().size() << " sub clusters";
-                    for(auto& clus : cluster.daughterList()) std::cout << ", " << clus.getHitPairListPtr().size();
-                    std::cout << std::endl;
+                    {
+                        mf::LogDebug brokeClusterLog("VoronoiPathFinder");
+
+                        brokeClusterLog << "****> Broke Cluster with " << cluster.getHitPairListPtr().size() << " into " << cluster.daughterList().size() << " sub clusters";
+                        for(auto& clus : cluster.daughterList()) brokeClusterLog << ", " << clus.getHitPairListPtr().size();
+                    }
 
                     // Add the daughters to the cluster
                     clusterParameters.daughterList().insert(clusterParameters.daughterList().end(),cluster);
@@ -290,6 +298,8 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
                     // If filling histograms we do the main cluster here
                     if (fFillHistograms)
                     {
+                        std::lock_guard<std::mutex> histLock(fHistMutex);
+
                         reco::PrincipalComponents& fullPCA        = cluster.getFullPCA();
                         std::vector<double>        eigenValVec    = {3. * std::sqrt(fullPCA.getEigenValues()[0]),
                                                                      3. * std::sqrt(fullPCA.getEigenValues()[1]),
@@ -310,10 +320,7 @@ void VoronoiPathFinder::ModifyClusters(reco::ClusterParametersList& clusterParam
                 }
             }
         }
-
-        // Go to next cluster parameters object
-        clusterParametersListItr++;
-    }
+    });
 
     if (fEnableMonitoring)
     {
@@ -533,6 +540,8 @@ reco::ClusterParametersList::iterator VoronoiPathFinder::breakIntoTinyBits(reco:
         // Are we filling histograms
         if (fFillHistograms)
         {
+            std::lock_guard<std::mutex> histLock(fHistMutex);
+
             int             num3DHits = clusterToBreak.getHitPairListPtr().size();
             int             numEdges  = clusterToBreak.getBestEdgeList().size();
             Eigen::Vector3f newPrimaryVec(fullPCA.getEigenVectors().row(2));
@@ -750,6 +759,8 @@ reco::ClusterParametersList::iterator VoronoiPathFinder::subDivideCluster(reco::
             // Are we filling histograms
             if (fFillHistograms)
             {
+                std::lock_guard<std::mutex> histLock(fHistMutex);
+
                 // Recover the new fullPCA
                 reco::PrincipalComponents& newFullPCA = clusterParams.getFullPCA();
 
@@ -1027,7 +1038,7 @@ void VoronoiPathFinder::buildVoronoiDiagram(reco::ClusterParameters& clusterPara
     std::cout << "  ==> Build V diagram, sorted point list contains " << pointList.size() << " hits" << std::endl;
 
     // Set up the voronoi diagram builder
-    voronoi2d::VoronoiDiagram voronoiDiagram(clusterParameters.getHalfEdgeList(),clusterParameters.getVertexList(),clusterParameters.getFaceList());
+    voronoi2d::VoronoiDiagram voronoiDiagram(clusterParameters.getHalfEdgeList(),clusterParameters.getVertexList(),clusterParameters.getFaceList(),fVoronoiArenas.local());
 
     // And make the diagram
     voronoiDiagram.buildVoronoiDiagram(pointList);
@@ -153,17 +153,17 @@ private:
 
     /**
      *  @brief This builds a list of candidate hit pairs from lists of hits on two planes
+     *         The pairs are returned in wire order (and in time order for a given wire)
      */
     using HitMatchPair       = std::pair<const reco::ClusterHit2D*,reco::ClusterHit3D>;
     using HitMatchPairVec    = std::vector<HitMatchPair>;
-    using HitMatchPairVecMap = std::map<geo::WireID,HitMatchPairVec>;
 
-    int findGoodHitPairs(const reco::ClusterHit2D*, HitVector::iterator&, HitVector::iterator&, HitMatchPairVecMap&) const;
+    int findGoodHitPairs(const reco::ClusterHit2D*, HitVector::iterator&, HitVector::iterator&, HitMatchPairVec&) const;
 
     /**
      *  @brief This algorithm takes lists of hit pairs and finds good triplets
      */
-    void findGoodTriplets(HitMatchPairVecMap&, HitMatchPairVecMap&, reco::HitPairList&, bool = false) const;
+    void findGoodTriplets(HitMatchPairVec&, HitMatchPairVec&, reco::HitPairList&, bool = false) const;
 
     /**
      *  @brief Make a HitPair object by checking two hits
@@ -669,43 +669,58 @@ size_t StandardHit3DBuilder::BuildHitPairMapByTPC(PlaneHitVectorItrPairVec& hitI
     size_t nTriplets(0);
     size_t nDeadChanHits(0);
 
+    // The hits in each plane are in "earliest time" order and the golden hits are taken in that order too, so the
+    // first hit of a plane which can overlap the golden hit never moves backwards. Keep it for each plane so the
+    // sweep steps over each hit once instead of starting again from the first unused hit for every golden hit
+    std::vector<HitVector::iterator> windowStartVec = {hitItrVec[0].first, hitItrVec[1].first, hitItrVec[2].first};
+    std::vector<size_t>              planeOrderVec  = {0, 1, 2};
+    SetStartTimeOrder                startTimeOrder(m_numSigmaPeakTime);
+
+    // Since we'll use these many times in the internal loops, keep the pair containers between golden hits
+    HitMatchPairVec pair12Vec;
+    HitMatchPairVec pair13Vec;
+
     //*********************************************************************************
     // Basically, we try to loop until done...
     while(1)
     {
         // Sort so that the earliest hit time will be the first element, etc.
-        std::sort(hitItrVec.begin(),hitItrVec.end(),SetStartTimeOrder(m_numSigmaPeakTime));
+        std::sort(planeOrderVec.begin(),planeOrderVec.end(),[&](size_t left, size_t right){return startTimeOrder(hitItrVec[left],hitItrVec[right]);});
+
+        size_t plane0 = planeOrderVec[0];
+        size_t plane1 = planeOrderVec[1];
+        size_t plane2 = planeOrderVec[2];
 
         // This loop iteration's golden hit
-        const reco::ClusterHit2D* goldenHit = *hitItrVec[0].first;
+        const reco::ClusterHit2D* goldenHit = *hitItrVec[plane0].first;
 
         // The range of history... (for this hit)
         float goldenTimeStart = goldenHit->getTimeTicks() - m_numSigmaPeakTime * goldenHit->getHit()->RMS() - std::numeric_limits<float>::epsilon();
         float goldenTimeEnd   = goldenHit->getTimeTicks() + m_numSigmaPeakTime * goldenHit->getHit()->RMS() + std::numeric_limits<float>::epsilon();
 
         // Set iterators to insure we'll be in the overlap ranges
-        HitVector::iterator hitItr1Start = SetStartIterator(hitItrVec[1].first, hitItrVec[1].second, m_numSigmaPeakTime, goldenTimeStart);
-        HitVector::iterator hitItr1End   = SetEndIterator( hitItr1Start,        hitItrVec[1].second, m_numSigmaPeakTime, goldenTimeEnd);
-        HitVector::iterator hitItr2Start = SetStartIterator(hitItrVec[2].first, hitItrVec[2].second, m_numSigmaPeakTime, goldenTimeStart);
-        HitVector::iterator hitItr2End   = SetEndIterator( hitItr2Start,        hitItrVec[2].second, m_numSigmaPeakTime, goldenTimeEnd);
+        windowStartVec[plane1] = SetStartIterator(std::max(windowStartVec[plane1], hitItrVec[plane1].first), hitItrVec[plane1].second, m_numSigmaPeakTime, goldenTimeStart);
+        windowStartVec[plane2] = SetStartIterator(std::max(windowStartVec[plane2], hitItrVec[plane2].first), hitItrVec[plane2].second, m_numSigmaPeakTime, goldenTimeStart);
 
-        // Since we'll use these many times in the internal loops, pre make the pairs for the second set of hits
-        size_t             curHitListSize(hitPairList.size());
-        HitMatchPairVecMap pair12Map;
-        HitMatchPairVecMap pair13Map;
+        HitVector::iterator hitItr1Start = windowStartVec[plane1];
+        HitVector::iterator hitItr1End   = SetEndIterator( hitItr1Start, hitItrVec[plane1].second, m_numSigmaPeakTime, goldenTimeEnd);
+        HitVector::iterator hitItr2Start = windowStartVec[plane2];
+        HitVector::iterator hitItr2End   = SetEndIterator( hitItr2Start, hitItrVec[plane2].second, m_numSigmaPeakTime, goldenTimeEnd);
 
-        size_t n12Pairs = findGoodHitPairs(goldenHit, hitItr1Start, hitItr1End, pair12Map);
-        size_t n13Pairs = findGoodHitPairs(goldenHit, hitItr2Start, hitItr2End, pair13Map);
+        size_t curHitListSize(hitPairList.size());
+
+        size_t n12Pairs = findGoodHitPairs(goldenHit, hitItr1Start, hitItr1End, pair12Vec);
+        size_t n13Pairs = findGoodHitPairs(goldenHit, hitItr2Start, hitItr2End, pair13Vec);
 
         nDeadChanHits  += hitPairList.size() - curHitListSize;
         curHitListSize  = hitPairList.size();
 
-        if (n12Pairs > n13Pairs) findGoodTriplets(pair12Map, pair13Map, hitPairList);
-        else                     findGoodTriplets(pair13Map, pair12Map, hitPairList);
+        if (n12Pairs > n13Pairs) findGoodTriplets(pair12Vec, pair13Vec, hitPairList);
+        else                     findGoodTriplets(pair13Vec, pair12Vec, hitPairList);
 
         nTriplets += hitPairList.size() - curHitListSize;
 
-        hitItrVec[0].first++;
+        hitItrVec[plane0].first++;
 
         int nPlanesWithHits(0);
 
@@ -721,10 +736,13 @@ size_t StandardHit3DBuilder::BuildHitPairMapByTPC(PlaneHitVectorItrPairVec& hitI
 int StandardHit3DBuilder::findGoodHitPairs(const reco::ClusterHit2D* goldenHit,
                                            HitVector::iterator&      startItr,
                                            HitVector::iterator&      endItr,
-                                           HitMatchPairVecMap&       hitMatchMap) const
+                                           HitMatchPairVec&          hitMatchVec) const
 {
     int numPairs(0);
 
+    // The container is reused from one golden hit to the next
+    hitMatchVec.clear();
+
     // Loop through the input secon hits and make pairs
     while(startItr != endItr)
     {
@@ -734,69 +752,49 @@ int StandardHit3DBuilder::findGoodHitPairs(const reco::ClusterHit2D* goldenHit,
         // pair returned with a negative ave time is signal of failure
         if (!makeHitPair(pair, goldenHit, hit, m_hitWidthSclFctr)) continue;
 
-        geo::WireID wireID = hit->WireID();
-
-        hitMatchMap[wireID].emplace_back(hit,pair);
+        hitMatchVec.emplace_back(hit,pair);
 
         numPairs++;
     }
 
+    // Group the pairs by wire, keeping the time order on each wire
+    std::stable_sort(hitMatchVec.begin(),hitMatchVec.end(),[](const auto& left, const auto& right){return left.first->WireID() < right.first->WireID();});
+
     return numPairs;
 }
 
-void StandardHit3DBuilder::findGoodTriplets(HitMatchPairVecMap& pair12Map, HitMatchPairVecMap& pair13Map, reco::HitPairList& hitPairList, bool tagged) const
+void StandardHit3DBuilder::findGoodTriplets(HitMatchPairVec& pair12Vec, HitMatchPairVec& pair13Vec, reco::HitPairList& hitPairList, bool tagged) const
 {
     // Build triplets from the two lists of hit pairs
-    if (!pair12Map.empty())
+    if (!pair12Vec.empty())
     {
         // temporary container for dead channel hits
         std::vector<reco::ClusterHit3D> tempDeadChanVec;
         reco::ClusterHit3D              deadChanPair;
 
-        // Keep track of which third plane hits have been used
-        std::map<const reco::ClusterHit3D*,bool> usedPairMap;
-
-        // Initial population of this map with the pair13Map hits
-        for(const auto& pair13 : pair13Map)
-        {
-            for(const auto& hit2Dhit3DPair : pair13.second) usedPairMap[&hit2Dhit3DPair.second] = false;
-        }
+        // Keep track of which pairs have been used in triplets
+        std::vector<bool> used12Vec(pair12Vec.size(), false);
+        std::vector<bool> used13Vec(pair13Vec.size(), false);
 
         // The outer loop is over all hit pairs made from the first two plane combinations
-        for(const auto& pair12 : pair12Map)
+        for(size_t idx12 = 0; idx12 < pair12Vec.size(); idx12++)
         {
-            if (pair12.second.empty()) continue;
+            const reco::ClusterHit3D& pair1 = pair12Vec[idx12].second;
 
-            // This loop is over hit pairs that share the same first two plane wires but may have different
-            // hit times on those wires
-            for(const auto& hit2Dhit3DPair12 : pair12.second)
+            // The simplest approach here is to loop over all possibilities and let the triplet builder weed out the weak candidates
+            for(size_t idx13 = 0; idx13 < pair13Vec.size(); idx13++)
             {
-                const reco::ClusterHit3D& pair1  = hit2Dhit3DPair12.second;
+                const reco::ClusterHit2D* hit2 = pair13Vec[idx13].first;
 
-                // populate the map with initial value
-                usedPairMap[&pair1] = false;
+                // If success try for the triplet
+                reco::ClusterHit3D triplet;
 
-                // The simplest approach here is to loop over all possibilities and let the triplet builder weed out the weak candidates
-                for(const auto& pair13 : pair13Map)
+                if (makeHitTriplet(triplet, pair1, hit2))
                 {
-                    if (pair13.second.empty()) continue;
-
-                    for(const auto& hit2Dhit3DPair13 : pair13.second)
-                    {
-                        const reco::ClusterHit2D* hit2  = hit2Dhit3DPair13.first;
-                        const reco::ClusterHit3D& pair2 = hit2Dhit3DPair13.second;
-
-                        // If success try for the triplet
-                        reco::ClusterHit3D triplet;
-
-                        if (makeHitTriplet(triplet, pair1, hit2))
-                        {
-                            triplet.setID(hitPairList.size());
-                            hitPairList.emplace_back(triplet);
-                            usedPairMap[&pair1] = true;
-                            usedPairMap[&pair2] = true;
-                        }
-                    }
+                    triplet.setID(hitPairList.size());
+                    hitPairList.emplace_back(triplet);
+                    used12Vec[idx12] = true;
+                    used13Vec[idx13] = true;
                 }
             }
         }
@@ -804,15 +802,19 @@ void StandardHit3DBuilder::findGoodTriplets(HitMatchPairVecMap& pair12Map, HitMa
         // One more loop through the other pairs to check for sick channels
         if (m_numBadChannels > 0)
         {
-            for(const auto& pairMapPair : usedPairMap)
+            auto checkUnusedPairs = [&](const HitMatchPairVec& pairVec, const std::vector<bool>& usedVec)
             {
-                if (pairMapPair.second) continue;
+                for(size_t idx = 0; idx < pairVec.size(); idx++)
+                {
+                    if (usedVec[idx]) continue;
 
-                const reco::ClusterHit3D* pair = pairMapPair.first;
+                    // Here we look to see if we failed to make a triplet because the partner wire was dead/noisy/sick
+                    if (makeDeadChannelPair(deadChanPair, pairVec[idx].second, 4, 0, 0.)) tempDeadChanVec.emplace_back(deadChanPair);
+                }
+            };
 
-                // Here we look to see if we failed to make a triplet because the partner wire was dead/noisy/sick
-                if (makeDeadChannelPair(deadChanPair, *pair, 4, 0, 0.)) tempDeadChanVec.emplace_back(deadChanPair);
-            }
+            checkUnusedPairs(pair12Vec, used12Vec);
+            checkUnusedPairs(pair13Vec, used13Vec);
 
             // Handle the dead wire triplets
             if(!tempDeadChanVec.empty())
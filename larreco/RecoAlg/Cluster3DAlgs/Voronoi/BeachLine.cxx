@@ -103,8 +103,7 @@ BSTNode* BeachLine::insertNewLeaf(IEvent* event, BSTNode* node)
     // Have we found a null pointer?
     if (node == NULL)
     {
-        m_nodeVec.push_back(BSTNode(event));
-        node = &m_nodeVec.back();
+        node = m_nodeArena.create(event);
         return node;
     }
 
@@ -122,21 +121,10 @@ BSTNode* BeachLine::insertNewLeaf(IEvent* event, BSTNode* node)
     // current arc. So we are going to replace the input leaf with a subtree having three leaves
     // (two breakpoints)...
     // Start by creating a node for the new arc
-    m_nodeVec.push_back(BSTNode(event));  // This will be the new site point
-
-    BSTNode* newLeaf = &m_nodeVec.back();
-
-    m_nodeVec.push_back(BSTNode(*node));  // This will be the new left leaf (the original arc)
-
-    BSTNode* leftLeaf = &m_nodeVec.back();
-
-    m_nodeVec.push_back(BSTNode(event));  // This will be the breakpoint between the left and new leaves
-
-    BSTNode* breakNode = &m_nodeVec.back();
-
-    m_nodeVec.push_back(BSTNode(event)); // Finally, this is the breakpoint between new and right leaves
-
-    BSTNode* topNode = &m_nodeVec.back();
+    BSTNode* newLeaf   = m_nodeArena.create(event);  // This will be the new site point
+    BSTNode* leftLeaf  = m_nodeArena.create(*node);  // This will be the new left leaf (the original arc)
+    BSTNode* breakNode = m_nodeArena.create(event);  // This will be the breakpoint between the left and new leaves
+    BSTNode* topNode   = m_nodeArena.create(event);  // Finally, this is the breakpoint between new and right leaves
 
     // Set this to be the king of the local world
     topNode->setParent(node->getParent());
@@ -11,6 +11,7 @@
 
 #include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/IEvent.h"
 #include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/EventUtilities.h"
+#include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/ObjectArena.h"
 namespace dcel2d { class Face; class HalfEdge; }
 
 // std includes
@@ -114,7 +115,8 @@ private:
     dcel2d::Face*     m_face;         // If a leaf then we associated faces
 };
 
-using BSTNodeList = std::list<BSTNode>;
+using BSTNodeList  = std::list<BSTNode>;
+using BSTNodeArena = ObjectArena<BSTNode>;
 
 /**
  * @brief This defines the actual beach line. The idea is to implement this as a
@@ -124,7 +126,7 @@ using BSTNodeList = std::list<BSTNode>;
 class BeachLine
 {
 public:
-    BeachLine() : m_root(NULL) {m_nodeVec.clear();}
+    BeachLine(BSTNodeArena& nodeArena) : m_root(NULL), m_nodeArena(nodeArena) {}
 
     bool           isEmpty()                         const {return m_root == NULL;}
     void           setEmpty()                              {m_root = NULL;}
@@ -163,7 +165,7 @@ private:
     BSTNode* rotateWithRightChild(BSTNode*);
 
     BSTNode*       m_root;      // the root of all evil, er, the top node
-    BSTNodeList    m_nodeVec;   // Use this to keep track of the nodes
+    BSTNodeArena&  m_nodeArena; // The nodes live here (and are reset with the arena)
 
     EventUtilities m_utilities;
 };
@@ -0,0 +1,87 @@
+/**
+ *  @file   ObjectArena.h
+ *
+ *  @brief  A simple arena for the objects made while building a Voronoi diagram
+ *
+ */
+#ifndef ObjectArena_voronoi2d_h
+#define ObjectArena_voronoi2d_h
+
+// std includes
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace voronoi2d
+{
+/**
+ *  @brief  ObjectArena hands out objects from blocks of contiguous storage.
+ *
+ *          Objects keep their address until the arena is reset, which destroys
+ *          them all but keeps the blocks. An arena reset between diagrams stops
+ *          allocating once it has grown to the size of the largest one.
+ */
+template <typename T>
+class ObjectArena
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  blockSize number of objects in each block of storage
+     */
+    explicit ObjectArena(size_t blockSize = 1024) : m_blockSize(blockSize), m_size(0) {}
+
+    /**
+     *  @brief  Destructor
+     */
+    ~ObjectArena() {reset();}
+
+    ObjectArena(const ObjectArena&)            = delete;
+    ObjectArena& operator=(const ObjectArena&) = delete;
+
+    /**
+     *  @brief Construct a new object in the arena and return its address
+     */
+    template <typename... Args>
+    T* create(Args&&... args)
+    {
+        size_t block = m_size / m_blockSize;
+
+        if (block == m_blockVec.size()) m_blockVec.emplace_back(new Storage[m_blockSize]);
+
+        T* object = new (&m_blockVec[block][m_size % m_blockSize]) T(std::forward<Args>(args)...);
+
+        m_size++;
+
+        return object;
+    }
+
+    /**
+     *  @brief Destroy all objects, keeping the storage for the next use
+     */
+    void reset()
+    {
+        for(size_t idx = 0; idx < m_size; idx++)
+            reinterpret_cast<T*>(&m_blockVec[idx / m_blockSize][idx % m_blockSize])->~T();
+
+        m_size = 0;
+    }
+
+    size_t size()     const {return m_size;}
+    size_t capacity() const {return m_blockVec.size() * m_blockSize;}
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    size_t                                  m_blockSize;  // Number of objects in a block
+    size_t                                  m_size;       // Number of objects currently in the arena
+    std::vector<std::unique_ptr<Storage[]>> m_blockVec;   // The blocks of storage
+};
+
+} // namespace voronoi2d
+#endif
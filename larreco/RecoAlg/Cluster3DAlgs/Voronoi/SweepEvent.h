@@ -12,6 +12,7 @@
 // LArSoft includes
 #include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/DCEL.h"
 #include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/IEvent.h"
+#include "larreco/RecoAlg/Cluster3DAlgs/Voronoi/ObjectArena.h"
 namespace voronoi2d { class BSTNode; }
 
 // std includes
@@ -97,8 +98,10 @@ private:
     BSTNode*       m_node;
 };
 
-using SiteEventList   = std::list<SiteEvent>;
-using CircleEventList = std::list<CircleEvent>;
+using SiteEventList    = std::list<SiteEvent>;
+using CircleEventList  = std::list<CircleEvent>;
+using SiteEventArena   = ObjectArena<SiteEvent>;
+using CircleEventArena = ObjectArena<CircleEvent>;
 
 } // namespace lar_cluster3d
 #endif
@@ -49,9 +49,20 @@ namespace boost
 namespace voronoi2d {
 
 VoronoiDiagram::VoronoiDiagram(dcel2d::HalfEdgeList& halfEdgeList, dcel2d::VertexList& vertexList, dcel2d::FaceList& faceList) :
+    VoronoiDiagram(halfEdgeList, vertexList, faceList, fLocalArena)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+VoronoiDiagram::VoronoiDiagram(dcel2d::HalfEdgeList& halfEdgeList,
+                               dcel2d::VertexList&   vertexList,
+                               dcel2d::FaceList&     faceList,
+                               VoronoiArena&         arena) :
     fHalfEdgeList(halfEdgeList),
     fVertexList(vertexList),
     fFaceList(faceList),
+    fArena(arena),
     fXMin(0.),
     fXMax(0.),
     fYMin(0.),
@@ -62,9 +73,7 @@ VoronoiDiagram::VoronoiDiagram(dcel2d::HalfEdgeList& halfEdgeList, dcel2d::Verte
     fVertexList.clear();
     fFaceList.clear();
     fPointList.clear();
-    fSiteEventList.clear();
-    fCircleEventList.clear();
-    fCircleNodeList.clear();
+    fArena.reset();
     fConvexHullList.clear();
 
     // And the area
@@ -137,9 +146,7 @@ void VoronoiDiagram::buildVoronoiDiagram(const dcel2d::PointList& pointList)
     fVertexList.clear();
     fFaceList.clear();
     fPointList.clear();
-    fSiteEventList.clear();
-    fCircleEventList.clear();
-    fCircleNodeList.clear();
+    fArena.reset();
     fNumBadCircles = 0;
 
     std::cout << "******************************************************************************************************************" << std::endl;
@@ -153,16 +160,12 @@ void VoronoiDiagram::buildVoronoiDiagram(const dcel2d::PointList& pointList)
     // Now populate the event queue with site events
     for(const auto& point : pointList)
     {
-        fSiteEventList.emplace_back(point);
-        IEvent* iEvent = &fSiteEventList.back();
+        IEvent* iEvent = fArena.fSiteEventArena.create(point);
         eventQueue.push(iEvent);
     }
 
     // Declare the beachline which will contain the BSTNode objects for site events
-    BeachLine beachLine;
-
-    // Finally, we need a container for our circle event BSTNodes
-    BSTNodeList circleNodeList;
+    BeachLine beachLine(fArena.fNodeArena);
 
     // Now process the queue
     while(!eventQueue.empty())
@@ -253,9 +256,7 @@ void VoronoiDiagram::buildVoronoiDiagram(const dcel2d::PointList& pointList)
     std::cout << "******************************************************************************************************************" << std::endl;
 
     // Clear internal containers that are no longer useful
-    fSiteEventList.clear();
-    fCircleEventList.clear();
-    fCircleNodeList.clear();
+    fArena.reset();
 
     return;
 }
@@ -269,9 +270,7 @@ void VoronoiDiagram::buildVoronoiDiagramBoost(const dcel2d::PointList& pointList
     fVertexList.clear();
     fFaceList.clear();
     fPointList.clear();
-    fSiteEventList.clear();
-    fCircleEventList.clear();
-    fCircleNodeList.clear();
+    fArena.reset();
     fNumBadCircles = 0;
 
     std::cout << "******************************************************************************************************************" << std::endl;
@@ -311,9 +310,7 @@ void VoronoiDiagram::buildVoronoiDiagramBoost(const dcel2d::PointList& pointList
     std::cout << "******************************************************************************************************************" << std::endl;
 
     // Clear internal containers that are no longer useful
-    fSiteEventList.clear();
-    fCircleEventList.clear();
-    fCircleNodeList.clear();
+    fArena.reset();
 
     return;
 }
@@ -578,10 +575,8 @@ void VoronoiDiagram::makeLeftCircleEvent(EventQueue&  eventQueue,
                 // Did we succeed in making a circle event?
                 if (circleEvent)
                 {
-                    // Add to the circle node list
-                    fCircleNodeList.emplace_back(circleEvent);
-
-                    BSTNode* circleNode = &fCircleNodeList.back();
+                    // Add to the circle nodes
+                    BSTNode* circleNode = fArena.fNodeArena.create(circleEvent);
 
                     // If there was an associated circle event to this node, invalidate it
                     if (midLeaf->getAssociated())
@@ -625,10 +620,8 @@ void VoronoiDiagram::makeRightCircleEvent(EventQueue& eventQueue,
                 // Did we succeed in making a circle event?
                 if (circleEvent)
                 {
-                    // Add to the circle node list
-                    fCircleNodeList.emplace_back(circleEvent);
-
-                    BSTNode* circleNode = &fCircleNodeList.back();
+                    // Add to the circle nodes
+                    BSTNode* circleNode = fArena.fNodeArena.create(circleEvent);
 
                     // If there was an associated circle event to this node, invalidate it
                     if (midLeaf->getAssociated())
@@ -676,9 +669,7 @@ IEvent* VoronoiDiagram::makeCircleEvent(BSTNode* arc1, BSTNode* arc2, BSTNode* a
             // Making a circle event!
             dcel2d::Point circleBottom(circleBottomX, center[1], NULL);
 
-            fCircleEventList.emplace_back(circleBottom, center);
-
-            circle = &fCircleEventList.back();
+            circle = fArena.fCircleEventArena.create(circleBottom, center);
         }
         else if (circleBottomX - beachLinePos < 1.e-4)
             std::cout << "==> Circle close, beachLine: " << beachLinePos << ", circleBottomX: " << circleBottomX << ", deltaR: " << deltaR << ", d: " << circleBottomX - beachLinePos << std::endl;
@@ -25,6 +25,25 @@
 
 namespace voronoi2d
 {
+/**
+ *  @brief  The beach line nodes and events used while building a diagram. These are only needed
+ *          during the construction so one arena can be kept (per thread) and reused from one
+ *          diagram to the next
+ */
+struct VoronoiArena
+{
+    BSTNodeArena     fNodeArena;            //< Beach line and circle event nodes
+    SiteEventArena   fSiteEventArena;       //< Site events
+    CircleEventArena fCircleEventArena;     //< Circle events
+
+    void reset()
+    {
+        fNodeArena.reset();
+        fSiteEventArena.reset();
+        fCircleEventArena.reset();
+    }
+};
+
 /**
  *  @brief  VoronoiDiagram class definiton
  */
@@ -41,6 +60,11 @@ public:
      */
     VoronoiDiagram(dcel2d::HalfEdgeList&, dcel2d::VertexList&, dcel2d::FaceList&);
 
+    /**
+     *  @brief  Constructor using an external arena for the construction, which is reset by each build
+     */
+    VoronoiDiagram(dcel2d::HalfEdgeList&, dcel2d::VertexList&, dcel2d::FaceList&, VoronoiArena&);
+
     /**
      *  @brief  Destructor
      */
@@ -187,9 +211,8 @@ private:
     dcel2d::FaceList&     fFaceList;
 
     dcel2d::PointList     fPointList;
-    SiteEventList         fSiteEventList;       //< Container for site events
-    CircleEventList       fCircleEventList;     //< Container for circle events
-    BSTNodeList           fCircleNodeList;      //< Container for the circle "nodes"
+    VoronoiArena          fLocalArena;          //< Arena used when none is given
+    VoronoiArena&         fArena;               //< Container for the events and beach line nodes
 
     dcel2d::PointList     fConvexHullList;      //< Points representing the convex hull
     dcel2d::Coords        fConvexHullCenter;    //< Center of the convex hull
@@ -14,7 +14,15 @@
 #include "larreco/RecoAlg/Cluster3DAlgs/kdTree.h"
 
 // std includes
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+// TBB
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // implementation follows
@@ -42,6 +50,7 @@ void kdTree::configure(fhicl::ParameterSet const &pset)
     fMaxWireDeltas     = pset.get<int>  ("MaxWireDeltas",     3   );
 
     fTimeToBuild = 0;
+    fTimeToQuery = 0;
 
     return;
 }
@@ -269,6 +278,325 @@ bool kdTree::FindEntryBrute(const reco::ClusterHit3D* refHit, const KdTreeNode&
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+struct kdTree::QueryHit
+{
+    const reco::ClusterHit3D* hit;
+    float                     position[3];
+    float                     avePeakTime;
+    float                     sigmaPeakTime;
+    int                       wires[3];
+    unsigned int              cryostatTPC;
+};
+
+namespace {
+    // Pack cryostat and TPC into one word for a single comparison
+    unsigned int packCryostatTPC(const geo::WireID& wireID) {return (wireID.Cryostat << 16) | (wireID.TPC & 0xFFFF);}
+}
+
+kdTree::QueryHit kdTree::makeQueryHit(const reco::ClusterHit3D* hit3D) const
+{
+    const Eigen::Vector3f& position = hit3D->getPosition();
+
+    QueryHit queryHit;
+
+    queryHit.hit           = hit3D;
+    queryHit.position[0]   = position[0];
+    queryHit.position[1]   = position[1];
+    queryHit.position[2]   = position[2];
+    queryHit.avePeakTime   = hit3D->getAvePeakTime();
+    queryHit.sigmaPeakTime = hit3D->getSigmaPeakTime();
+    queryHit.cryostatTPC   = packCryostatTPC(hit3D->getWireIDs()[0]);
+
+    for(size_t idx = 0; idx < 3; idx++) queryHit.wires[idx] = hit3D->getWireIDs()[idx].Wire;
+
+    return queryHit;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+kdTree::FlatKdTree kdTree::BuildFlatKdTree(const reco::HitPairList& hitPairList) const
+{
+    cet::cpu_timer theClockBuildNeighborhood;
+
+    if (fEnableMonitoring) theClockBuildNeighborhood.start();
+
+    // The input is a list and we need to copy to a vector so we can sort ranges
+    Hit3DVec hit3DVec;
+
+    hit3DVec.reserve(hitPairList.size());
+
+    for(const auto& hit : hitPairList) hit3DVec.emplace_back(&hit);
+
+    FlatKdTree tree;
+
+    if (!hit3DVec.empty()) BuildFlatKdTree(hit3DVec.begin(), hit3DVec.end(), tree);
+
+    // Leaves are created in tree order, recover the leaf for each input hit
+    std::unordered_map<const reco::ClusterHit3D*,size_t> leafMap;
+
+    for(size_t leaf = 0; leaf < tree.numLeaves(); leaf++) leafMap[tree.hits[leaf]] = leaf;
+
+    tree.leafOfInput.reserve(hitPairList.size());
+
+    for(const auto& hit : hitPairList) tree.leafOfInput.emplace_back(leafMap[&hit]);
+
+    if (fEnableMonitoring)
+    {
+        theClockBuildNeighborhood.stop();
+        fTimeToBuild = theClockBuildNeighborhood.accumulated_real_time();
+    }
+
+    return tree;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+kdTree::FlatKdTree kdTree::BuildFlatKdTree(const reco::HitPairListPtr& hitPairList) const
+{
+    cet::cpu_timer theClockBuildNeighborhood;
+
+    if (fEnableMonitoring) theClockBuildNeighborhood.start();
+
+    Hit3DVec hit3DVec;
+
+    hit3DVec.reserve(hitPairList.size());
+
+    for(const auto& hit3D : hitPairList)
+    {
+        // Make sure all the bits used by the clustering stage have been cleared
+        hit3D->clearStatusBits(~(reco::ClusterHit3D::HITINVIEW0 | reco::ClusterHit3D::HITINVIEW1 | reco::ClusterHit3D::HITINVIEW2));
+        for(const auto& hit2D : hit3D->getHits())
+            if (hit2D) hit2D->clearStatusBits(0xFFFFFFFF);
+        hit3DVec.emplace_back(hit3D);
+    }
+
+    FlatKdTree tree;
+
+    if (!hit3DVec.empty()) BuildFlatKdTree(hit3DVec.begin(), hit3DVec.end(), tree);
+
+    std::unordered_map<const reco::ClusterHit3D*,size_t> leafMap;
+
+    for(size_t leaf = 0; leaf < tree.numLeaves(); leaf++) leafMap[tree.hits[leaf]] = leaf;
+
+    tree.leafOfInput.reserve(hitPairList.size());
+
+    for(const auto& hit3D : hitPairList) tree.leafOfInput.emplace_back(leafMap[hit3D]);
+
+    if (fEnableMonitoring)
+    {
+        theClockBuildNeighborhood.stop();
+        fTimeToBuild = theClockBuildNeighborhood.accumulated_real_time();
+    }
+
+    return tree;
+}
+
+void kdTree::BuildFlatKdTree(Hit3DVec::iterator first,
+                             Hit3DVec::iterator last,
+                             FlatKdTree&        tree) const
+{
+    // A single hit makes a leaf, copy the hit data needed by the queries
+    if (std::distance(first,last) < 2)
+    {
+        const reco::ClusterHit3D* hit3D = *first;
+
+        tree.nodes.push_back({FlatKdTree::leaf, 0., static_cast<unsigned int>(tree.hits.size())});
+
+        tree.hits.emplace_back(hit3D);
+        tree.yPos.emplace_back(hit3D->getY());
+        tree.zPos.emplace_back(hit3D->getZ());
+        tree.avePeakTime.emplace_back(hit3D->getAvePeakTime());
+        tree.sigmaPeakTime.emplace_back(hit3D->getSigmaPeakTime());
+        tree.cryostatTPC.emplace_back(packCryostatTPC(hit3D->getWireIDs()[0]));
+
+        for(size_t idx = 0; idx < 3; idx++) tree.wires[idx].emplace_back(hit3D->getWireIDs()[idx].Wire);
+
+        return;
+    }
+
+    // Otherwise split exactly as the node based tree does
+    std::pair<Hit3DVec::iterator,Hit3DVec::iterator> minMaxXPair = std::minmax_element(first,last,[](const reco::ClusterHit3D* left, const reco::ClusterHit3D* right){return left->getX() < right->getX();});
+    std::pair<Hit3DVec::iterator,Hit3DVec::iterator> minMaxYPair = std::minmax_element(first,last,[](const reco::ClusterHit3D* left, const reco::ClusterHit3D* right){return left->getY() < right->getY();});
+    std::pair<Hit3DVec::iterator,Hit3DVec::iterator> minMaxZPair = std::minmax_element(first,last,[](const reco::ClusterHit3D* left, const reco::ClusterHit3D* right){return left->getZ() < right->getZ();});
+
+    float rangeVec[] = {(*minMaxXPair.second)->getX() - (*minMaxXPair.first)->getX(),
+                        (*minMaxYPair.second)->getY() - (*minMaxYPair.first)->getY(),
+                        (*minMaxZPair.second)->getZ() - (*minMaxZPair.first)->getZ()};
+
+    size_t maxRangeIdx = std::distance(rangeVec, std::max_element(rangeVec, rangeVec + 3));
+
+    std::sort(first,last,[maxRangeIdx](const auto& left, const auto& right){return left->getPosition()[maxRangeIdx] < right->getPosition()[maxRangeIdx];});
+
+    Hit3DVec::iterator middleItr = first;
+
+    std::advance(middleItr, std::distance(first,last) / 2);
+
+    // Point at the first occurence of a repeated median value
+    if (std::distance(first,middleItr) > 1)
+    {
+        while(middleItr != first+1)
+        {
+            if (!((*(middleItr-1))->getPosition()[maxRangeIdx] < (*middleItr)->getPosition()[maxRangeIdx])) middleItr--;
+            else break;
+        }
+    }
+
+    float  axisVal = 0.5*((*middleItr)->getPosition()[maxRangeIdx] + (*(middleItr-1))->getPosition()[maxRangeIdx]);
+    size_t nodeIdx = tree.nodes.size();
+
+    tree.nodes.push_back({static_cast<FlatKdTree::NodeType>(maxRangeIdx), axisVal, 0});
+
+    BuildFlatKdTree(first, middleItr, tree);
+
+    tree.nodes[nodeIdx].index = tree.nodes.size();
+
+    BuildFlatKdTree(middleItr, last, tree);
+
+    return;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+size_t kdTree::FindNearestNeighbors(const reco::ClusterHit3D* refHit, const FlatKdTree& tree, NeighborBuffer& neighbors, float& bestDist) const
+{
+    if (tree.empty()) return neighbors.size();
+
+    QueryHit queryHit = makeQueryHit(refHit);
+
+    auto addNeighbor = [&tree, &neighbors](float dist, size_t leaf){neighbors.push_back(CandPair(dist, tree.hits[leaf]));};
+
+    FindNearestNeighbors(queryHit, tree, 0, addNeighbor, bestDist);
+
+    return neighbors.size();
+}
+
+void kdTree::FindAllNearestNeighbors(const FlatKdTree& tree, NeighborPool& neighbors, float startDist) const
+{
+    cet::cpu_timer theClockQuery;
+
+    if (fEnableMonitoring) theClockQuery.start();
+
+    size_t const numLeaves = tree.numLeaves();
+
+    neighbors.fOffsets.assign(numLeaves + 1, 0);
+    neighbors.fPairs.clear();
+
+    // Query chunks of consecutive leaves concurrently, each into its own store
+    size_t const chunkSize = 512;
+    size_t const numChunks = (numLeaves + chunkSize - 1) / chunkSize;
+
+    std::vector<std::vector<NeighborPool::LeafPair>> chunkPairs(numChunks);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numChunks), [&](const tbb::blocked_range<size_t>& range)
+    {
+        for(size_t chunk = range.begin(); chunk != range.end(); chunk++)
+        {
+            std::vector<NeighborPool::LeafPair>& pairs = chunkPairs[chunk];
+
+            auto addNeighbor = [&pairs](float dist, size_t leaf){pairs.emplace_back(dist, leaf);};
+
+            for(size_t leaf = chunk * chunkSize; leaf < std::min(numLeaves, (chunk + 1) * chunkSize); leaf++)
+            {
+                QueryHit queryHit = makeQueryHit(tree.hits[leaf]);
+                float    bestDist(startDist);
+                size_t   firstPair(pairs.size());
+
+                FindNearestNeighbors(queryHit, tree, 0, addNeighbor, bestDist);
+
+                neighbors.fOffsets[leaf + 1] = pairs.size() - firstPair;
+            }
+        }
+    });
+
+    std::partial_sum(neighbors.fOffsets.begin(), neighbors.fOffsets.end(), neighbors.fOffsets.begin());
+
+    neighbors.fPairs.resize(neighbors.fOffsets.back());
+
+    for(size_t chunk = 0; chunk < numChunks; chunk++)
+        std::copy(chunkPairs[chunk].begin(), chunkPairs[chunk].end(), neighbors.fPairs.begin() + neighbors.fOffsets[chunk * chunkSize]);
+
+    if (fEnableMonitoring)
+    {
+        theClockQuery.stop();
+        fTimeToQuery = theClockQuery.accumulated_real_time();
+    }
+
+    return;
+}
+
+template <typename AddNeighbor>
+void kdTree::FindNearestNeighbors(const QueryHit& refHit, const FlatKdTree& tree, size_t nodeIdx, AddNeighbor& addNeighbor, float& bestDist) const
+{
+    const FlatKdTree::Node& node = tree.nodes[nodeIdx];
+
+    // If at a leaf then time to decide to add hit or not
+    if (node.type == FlatKdTree::leaf)
+    {
+        // Is this the droid we are looking for?
+        if (refHit.hit == tree.hits[node.index]) bestDist = fRefLeafBestDist;
+        // This is the tight constraint on the hits
+        else if (consistentPairs(refHit, tree, node.index, bestDist))
+        {
+            addNeighbor(bestDist, node.index);
+
+            bestDist = std::max(fRefLeafBestDist, bestDist);
+        }
+    }
+    // Otherwise we need to keep searching, the left subtree follows this node
+    else
+    {
+        float refPosition = refHit.position[node.type];
+
+        if (refPosition < node.axisValue)
+        {
+            FindNearestNeighbors(refHit, tree, nodeIdx + 1, addNeighbor, bestDist);
+
+            if (refPosition + bestDist > node.axisValue) FindNearestNeighbors(refHit, tree, node.index, addNeighbor, bestDist);
+        }
+        else
+        {
+            FindNearestNeighbors(refHit, tree, node.index, addNeighbor, bestDist);
+
+            if (refPosition - bestDist < node.axisValue) FindNearestNeighbors(refHit, tree, nodeIdx + 1, addNeighbor, bestDist);
+        }
+    }
+
+    return;
+}
+
+bool kdTree::consistentPairs(const QueryHit& refHit, const FlatKdTree& tree, size_t leaf, float& bestDist) const
+{
+    // Same selection as consistentPairs for two hits, on the copied leaf data
+    bool consistent(false);
+
+    if (bestDist < std::numeric_limits<float>::max() && refHit.cryostatTPC == tree.cryostatTPC[leaf])
+    {
+        if (std::fabs(refHit.avePeakTime - tree.avePeakTime[leaf]) < fPairSigmaPeakTime * (refHit.sigmaPeakTime + tree.sigmaPeakTime[leaf]))
+        {
+            int wireDeltas[] = {0, 0, 0};
+
+            for(size_t idx = 0; idx < 3; idx++)
+                wireDeltas[idx] = std::abs(refHit.wires[idx] - tree.wires[idx][leaf]);
+
+            std::sort(wireDeltas, wireDeltas + 3);
+
+            if (wireDeltas[2] < 3)
+            {
+                float deltaY        = refHit.position[1] - tree.yPos[leaf];
+                float deltaZ        = refHit.position[2] - tree.zPos[leaf];
+                float hitSeparation = std::max(float(0.0001),std::sqrt(deltaY*deltaY + deltaZ*deltaZ));
+
+                if (hitSeparation < bestDist)
+                {
+                    bestDist = hitSeparation;
+                    consistent = true;
+                }
+            }
+        }
+    }
+
+    return consistent;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 bool kdTree::consistentPairs(const reco::ClusterHit3D* pair1, const reco::ClusterHit3D* pair2, float& bestDist) const
 {
     // Strategy: We consider comparing "hit pairs" which may consist of 2 or 3 actual hits.
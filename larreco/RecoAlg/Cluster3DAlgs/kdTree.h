@@ -16,6 +16,8 @@
 #include "larreco/RecoAlg/Cluster3DAlgs/Cluster3D.h"
 
 // std includes
+#include <array>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <utility>
@@ -35,6 +37,7 @@ public:
      */
     kdTree() : fEnableMonitoring(false),
                fTimeToBuild(0.),
+               fTimeToQuery(0.),
                fPairSigmaPeakTime(0.),
                fRefLeafBestDist(0.),
                fMaxWireDeltas(0) {}
@@ -94,8 +97,56 @@ public:
 
     float getTimeToExecute() const {return fTimeToBuild;}
 
+    /**
+     *  @brief Define the flat version of the tree and the containers for its query results
+     */
+    class FlatKdTree;
+    class NeighborBuffer;
+    class NeighborPool;
+
+    /**
+     *  @brief Given an input HitPairList (or HitPairListPtr), build the flat kd tree
+     */
+    FlatKdTree BuildFlatKdTree(const reco::HitPairList&)    const;
+    FlatKdTree BuildFlatKdTree(const reco::HitPairListPtr&) const;
+
+    /**
+     *  @brief Find the nearest neighbors of a hit in the flat tree, results are those of the node tree version
+     *
+     *  @param refHit    The hit to find neighbors for
+     *  @param tree      The flat kd tree
+     *  @param neighbors Buffer receiving the (distance, hit) pairs, it is not cleared
+     *  @param bestDist  Starting search distance, updated as for the node tree version
+     */
+    size_t FindNearestNeighbors(const reco::ClusterHit3D*, const FlatKdTree&, NeighborBuffer&, float&) const;
+
+    /**
+     *  @brief Find the nearest neighbors of every hit in the flat tree at once (multithreaded)
+     *
+     *  @param tree      The flat kd tree
+     *  @param neighbors Pool receiving, for each leaf of the tree, the (distance, leaf index) of its neighbors
+     *  @param bestDist  Starting search distance for each hit
+     */
+    void FindAllNearestNeighbors(const FlatKdTree&, NeighborPool&, float) const;
+
+    float getTimeToQuery() const {return fTimeToQuery;}
+
 private:
 
+    /**
+     *  @brief Hit data needed for queries of the flat tree
+     */
+    struct QueryHit;
+
+    QueryHit makeQueryHit(const reco::ClusterHit3D*) const;
+
+    void BuildFlatKdTree(Hit3DVec::iterator, Hit3DVec::iterator, FlatKdTree&) const;
+
+    template <typename AddNeighbor>
+    void FindNearestNeighbors(const QueryHit&, const FlatKdTree&, size_t, AddNeighbor&, float&) const;
+
+    bool consistentPairs(const QueryHit&, const FlatKdTree&, size_t, float&) const;
+
     /**
      *  @brief The bigger question: are two pairs of hits consistent?
      */
@@ -105,7 +156,8 @@ private:
     float DistanceBetweenNodesYZ(const reco::ClusterHit3D*,const reco::ClusterHit3D*) const;
 
     bool           fEnableMonitoring;      ///<
-    mutable float  fTimeToBuild;           ///<
+    mutable std::atomic<float> fTimeToBuild; ///< Time for the last tree build (trees can be built concurrently)
+    mutable std::atomic<float> fTimeToQuery; ///< Time for the last FindAllNearestNeighbors
     float          fPairSigmaPeakTime;     ///< Consider hits consistent if "significance" less than this
     float          fRefLeafBestDist;       ///< Set neighborhood distance to this when ref leaf found
     int            fMaxWireDeltas;          ///< Maximum total number of delta wires
@@ -166,5 +218,100 @@ private:
     const KdTreeNode&         m_rightTree;
 };
 
+/**
+ *  @brief define the flat kd tree
+ *
+ *  Nodes are kept in one vector in depth first order: the left subtree of a split node
+ *  immediately follows it so only the index of the right subtree is stored. The tree has
+ *  exactly the splits of the node based tree, so queries visit the hits in the same order.
+ *  The hit quantities used by the queries are copied at the leaves into structure of
+ *  arrays indexed by leaf number, so a query does not need to touch the hits themselves.
+ */
+class kdTree::FlatKdTree
+{
+public:
+    enum NodeType : unsigned char {xPlane = 0,
+                                   yPlane = 1,
+                                   zPlane = 2,
+                                   leaf   = 3
+    };
+
+    struct Node
+    {
+        NodeType     type;
+        float        axisValue;   ///< Split value (split nodes only)
+        unsigned int index;       ///< Index of the right subtree node, or of the leaf data for leaves
+    };
+
+    bool   empty()    const {return nodes.empty();}
+    size_t numLeaves() const {return hits.size();}
+
+    std::vector<Node>                      nodes;
+    std::vector<size_t>                    leafOfInput;     ///< Leaf index of each hit in input order
+
+    // Leaf data
+    std::vector<const reco::ClusterHit3D*> hits;
+    std::vector<float>                     yPos;
+    std::vector<float>                     zPos;
+    std::vector<float>                     avePeakTime;
+    std::vector<float>                     sigmaPeakTime;
+    std::array<std::vector<int>,3>         wires;
+    std::vector<unsigned int>              cryostatTPC;     ///< Cryostat and TPC of the first wire ID, packed
+};
+
+/**
+ *  @brief Container for the neighbors of a single hit
+ *
+ *  The first kCapacity entries live inside the object so a query does not allocate
+ *  memory in the common case; beyond that the entries are moved to the heap.
+ */
+class kdTree::NeighborBuffer
+{
+public:
+    static constexpr size_t kCapacity = 32;
+
+    NeighborBuffer() : fSize(0) {}
+
+    void            clear()                {fSize = 0; fSpill.clear();}
+    bool            empty()          const {return fSize == 0;}
+    size_t          size()           const {return fSize;}
+    const CandPair* begin()          const {return fSpill.empty() ? fInline.data() : fSpill.data();}
+    const CandPair* end()            const {return begin() + fSize;}
+
+    void push_back(const CandPair& candPair)
+    {
+        if (fSize < kCapacity && fSpill.empty()) fInline[fSize] = candPair;
+        else
+        {
+            if (fSpill.empty()) fSpill.assign(fInline.begin(), fInline.end());
+            fSpill.push_back(candPair);
+        }
+        fSize++;
+    }
+
+private:
+    std::array<CandPair,kCapacity> fInline;
+    std::vector<CandPair>          fSpill;
+    size_t                         fSize;
+};
+
+/**
+ *  @brief Neighbors of all leaves of a flat tree, stored contiguously
+ *
+ *  The neighbors of leaf i are the (distance, leaf index) pairs from begin(i) to end(i).
+ */
+class kdTree::NeighborPool
+{
+public:
+    using LeafPair = std::pair<float,unsigned int>;
+
+    size_t          size(size_t leaf)  const {return fOffsets[leaf+1] - fOffsets[leaf];}
+    const LeafPair* begin(size_t leaf) const {return fPairs.data() + fOffsets[leaf];}
+    const LeafPair* end(size_t leaf)   const {return fPairs.data() + fOffsets[leaf+1];}
+
+    std::vector<size_t>   fOffsets;
+    std::vector<LeafPair> fPairs;
+};
+
 } // namespace lar_cluster3d
 #endif
@@ -14,6 +14,10 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm> // std::fill(), std::find(), std::sort()...
+#include <chrono>
+
+// TBB
+#include "tbb/parallel_for.h"
 
 // framework libraries
 #include "fhiclcpp/ParameterSet.h"
@@ -48,6 +52,7 @@ namespace cluster {
 
   //------------------------------------------------------------------------------
   ClusterCrawlerAlg::ClusterCrawlerAlg(fhicl::ParameterSet const& pset)
+    : fKeepVtxWindows(false)
   {
     reconfigure(pset);
   }
@@ -78,6 +83,8 @@ namespace cluster {
     fChkClusterDS       = pset.get< bool   >("ChkClusterDS",false);
     fVtxClusterSplit    = pset.get< bool   >("VtxClusterSplit", false);
     fFindStarVertices   = pset.get< bool   >("FindStarVertices", false);
+    fParallelPlanes     = pset.get< bool   >("ParallelPlanes", false);
+    fChkVtxPlane        = pset.get< bool   >("ChkVtxPlane", false);
     if(pset.has_key("HammerCluster")) {
       mf::LogWarning("CC")<<"fcl setting HammerCluster is replaced by FindHammerClusters. Ignoring...";
     }
@@ -165,6 +172,7 @@ namespace cluster {
     // unMergedHits.clear();
 
     ClearResults();
+    fCTPCrawlTime.clear();
   }
 
   //------------------------------------------------------------------------------
@@ -189,7 +197,17 @@ namespace cluster {
 
     CrawlInit();
 
+    // with ParallelPlanes each plane is crawled by a copy of the algorithm,
+    // made here while it holds no results
+    std::vector<ClusterCrawlerAlg> workers;
+    if(fParallelPlanes && fNumPass > 0 && srchits.size() >= 3) {
+      unsigned int nPlanes = 0;
+      for(geo::TPCID const& tpcid : geom->IterateTPCIDs()) nPlanes += geom->TPC(tpcid).Nplanes();
+      workers.assign(nPlanes, *this);
+    }
+
     fHits = srchits; // plain copy of the sources; it's the base of our hit result
+    fNHitsEvent = fHits.size();
 
     if(fHits.size() < 3) return;
     if(fHits.size() > UINT_MAX) {
@@ -212,62 +230,41 @@ namespace cluster {
        mergeAvailable[iht] = false;
      }
 
+    // the wire pitch used for the slope scale factor is that of the view of
+    // the first hit, in all the planes
+    raw::ChannelID_t const scaleChannel = fHits.front().Channel();
     const detinfo::DetectorProperties* detprop = lar::providerFrom<detinfo::DetectorPropertiesService>();
+    lariov::ChannelStatusProvider const& channelStatus
+      = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
+
+    // crawl all the planes at once; each TPC then takes the results of its
+    // planes before its 3D vertex steps
+    std::vector<unsigned int> workerFirstHit;
+    std::vector<double> workerCrawlTime;
+    if(fParallelPlanes)
+      CrawlPlanesParallel(workers, workerFirstHit, workerCrawlTime, detprop, channelStatus, scaleChannel);
+    unsigned int iWorker = 0;
 
     for (geo::TPCID const& tpcid: geom->IterateTPCIDs()) {
       geo::TPCGeo const& TPC = geom->TPC(tpcid);
-      for(plane = 0; plane < TPC.Nplanes(); ++plane){
-        WireHitRange.clear();
-        // define a code to ensure clusters are compared within the same plane
-        clCTP = EncodeCTP(tpcid.Cryostat, tpcid.TPC, plane);
-        cstat = tpcid.Cryostat;
-        tpc = tpcid.TPC;
-        // fill the WireHitRange vector with first/last hit on each wire
-        // dead wires and wires with no hits are flagged < 0
-        GetHitRange(clCTP);
-
-// sanity check
-/*
-  std::cout<<"Plane "<<plane<<" sanity check. Wire range "<<fFirstWire<<" "<<fLastWire;
-  unsigned int nhts = 0;
-  for(unsigned int wire = fFirstWire; wire < fLastWire; ++wire) {
-    if(WireHitRange[wire].first < 0) continue;
-    unsigned int fhit = WireHitRange[wire].first;
-    unsigned int lhit = WireHitRange[wire].second;
-    for(unsigned int hit = fhit; hit < lhit; ++hit) {
-      ++nhts;
-      if(fHits[hit].WireID().Wire != wire) {
-        std::cout<<"Bad wire "<<hit<<" "<<fHits[hit].WireID().Wire<<" "<<wire<<"\n";
-        return;
-      } // check wire
-      if(fHits[hit].WireID().Plane != plane) {
-        std::cout<<"Bad plane "<<hit<<" "<<fHits[hit].WireID().Plane<<" "<<plane<<"\n";
-        return;
-      } // check plane
-      if(fHits[hit].WireID().TPC != tpc) {
-        std::cout<<"Bad tpc "<<hit<<" "<<fHits[hit].WireID().TPC<<" "<<tpc<<"\n";
-        return;
-      } // check tpc
-    } // hit
-  } // wire
-  std::cout<<" is OK. nhits "<<nhts<<"\n";
-*/
-        if (WireHitRange.empty()||(fFirstWire == fLastWire)) continue;
-        raw::ChannelID_t channel = fHits[fFirstHit].Channel();
-        // get the scale factor to convert dTick/dWire to dX/dU. This is used
-        // to make the kink and merging cuts
-        float wirePitch = geom->WirePitch(geom->View(channel));
-        float tickToDist = detprop->DriftVelocity(detprop->Efield(),detprop->Temperature());
-        tickToDist *= 1.e-3 * detprop->SamplingRate(); // 1e-3 is conversion of 1/us to 1/ns
-        fScaleF = tickToDist / wirePitch;
-        // convert Large Angle Cluster crawling cut to a slope cut
-        if(fLAClusAngleCut > 0)
-          fLAClusSlopeCut = std::tan(3.142 * fLAClusAngleCut / 180.) / fScaleF;
-        fMaxTime = detprop->NumberTimeSamples();
-        fNumWires = geom->Nwires(plane, tpc, cstat);
-        // look for clusters
-        if(fNumPass > 0) ClusterLoop();
-      } // plane
+      if(fParallelPlanes) {
+        for(unsigned int ipl = 0; ipl < TPC.Nplanes(); ++ipl, ++iWorker)
+          MergePlane(workers[iWorker], workerFirstHit[iWorker], workerCrawlTime[iWorker],
+            detprop, channelStatus, scaleChannel);
+        // the serial loop leaves the plane counter past the last plane
+        plane = TPC.Nplanes();
+      } else {
+        for(plane = 0; plane < TPC.Nplanes(); ++plane){
+          // define a code to ensure clusters are compared within the same plane
+          clCTP = EncodeCTP(tpcid.Cryostat, tpcid.TPC, plane);
+          cstat = tpcid.Cryostat;
+          tpc = tpcid.TPC;
+          auto const start = std::chrono::steady_clock::now();
+          if(!CrawlPlane(detprop, channelStatus, scaleChannel)) continue;
+          std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+          fCTPCrawlTime.emplace_back(clCTP, elapsed.count());
+        } // plane
+      }
       if(fVertex3DCut > 0) {
         // Match vertices in 3 planes
         VtxMatch(tpcid);
@@ -282,6 +279,12 @@ namespace cluster {
       }
     } // for all tpcs
 
+    if(!fCTPCrawlTime.empty()) {
+      mf::LogDebug log("CC");
+      log<<"Crawl time per plane (ms):";
+      for(auto const& ctpTime : fCTPCrawlTime) log<<" "<<DecodeCTP(ctpTime.first)<<" "<<1000. * ctpTime.second;
+    }
+
     // clean up
     WireHitRange.clear();
     fcl2hits.clear();
@@ -330,6 +333,184 @@ namespace cluster {
 
   } // RunCrawler
 
+//------------------------------------------------------------------------------
+  bool ClusterCrawlerAlg::CrawlPlane(detinfo::DetectorProperties const* detprop,
+    lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel)
+  {
+    // Crawls the hits in the Cryostat/TPC/Plane clCTP
+    WireHitRange.clear();
+    // fill the WireHitRange vector with first/last hit on each wire
+    // dead wires and wires with no hits are flagged < 0
+    GetHitRange(clCTP, channelStatus);
+
+    if (WireHitRange.empty()||(fFirstWire == fLastWire)) return false;
+    // get the scale factor to convert dTick/dWire to dX/dU. This is used
+    // to make the kink and merging cuts
+    float wirePitch = geom->WirePitch(geom->View(scaleChannel));
+    float tickToDist = detprop->DriftVelocity(detprop->Efield(),detprop->Temperature());
+    tickToDist *= 1.e-3 * detprop->SamplingRate(); // 1e-3 is conversion of 1/us to 1/ns
+    fScaleF = tickToDist / wirePitch;
+    // convert Large Angle Cluster crawling cut to a slope cut
+    if(fLAClusAngleCut > 0)
+      fLAClusSlopeCut = std::tan(3.142 * fLAClusAngleCut / 180.) / fScaleF;
+    fMaxTime = detprop->NumberTimeSamples();
+    fNumWires = geom->Nwires(plane, tpc, cstat);
+    // look for clusters
+    if(fNumPass > 0) ClusterLoop();
+    return true;
+  } // CrawlPlane
+
+//------------------------------------------------------------------------------
+  void ClusterCrawlerAlg::CrawlPlanesParallel(std::vector<ClusterCrawlerAlg>& workers,
+    std::vector<unsigned int>& firstHits, std::vector<double>& crawlTimes,
+    detinfo::DetectorProperties const* detprop,
+    lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel)
+  {
+    // Crawls all the planes concurrently. workers holds a copy of the
+    // algorithm without results for each plane, in the order of the serial
+    // loop. Each copy gets only the hits of its plane. The first hit of each
+    // plane and its crawl time (< 0 if it has no hits) are returned for
+    // MergePlane.
+    // The crawl does not look at the hits or clusters of another plane, but
+    // two vertex searches (ClusterVertex, AddHit) look at the vertices of all
+    // planes unless fChkVtxPlane is set. The windows of these searches are
+    // kept, so that MergePlane can find the planes that the serial loop would
+    // have crawled differently.
+
+    firstHits.assign(workers.size(), 0);
+    crawlTimes.assign(workers.size(), -1.);
+
+    // the hits are sorted by wire ID so each plane is a contiguous range
+    unsigned int iWorker = 0;
+    auto first = fHits.cbegin();
+    for(geo::PlaneID const& planeID : geom->IteratePlaneIDs()) {
+      first = std::partition_point(first, fHits.cend(),
+        [&planeID](recob::Hit const& hit){ return hit.WireID().planeID().cmp(planeID) < 0; });
+      auto last = std::partition_point(first, fHits.cend(),
+        [&planeID](recob::Hit const& hit){ return hit.WireID().planeID() == planeID; });
+      unsigned int const firstHit = first - fHits.cbegin(), lastHit = last - fHits.cbegin();
+      ClusterCrawlerAlg& worker = workers[iWorker];
+      worker.fHits.assign(fHits.begin() + firstHit, fHits.begin() + lastHit);
+      worker.inClus.assign(inClus.begin() + firstHit, inClus.begin() + lastHit);
+      worker.mergeAvailable.assign(mergeAvailable.begin() + firstHit, mergeAvailable.begin() + lastHit);
+      worker.fNHitsEvent = fNHitsEvent;
+      worker.fKeepVtxWindows = !fChkVtxPlane;
+      worker.plane = planeID.Plane;
+      worker.clCTP = EncodeCTP(planeID);
+      worker.cstat = planeID.Cryostat;
+      worker.tpc = planeID.TPC;
+      firstHits[iWorker] = firstHit;
+      first = last;
+      ++iWorker;
+    } // planeID
+
+    tbb::parallel_for(std::size_t(0), workers.size(), [&](std::size_t iw){
+      auto const start = std::chrono::steady_clock::now();
+      if(!workers[iw].CrawlPlane(detprop, channelStatus, scaleChannel)) return;
+      crawlTimes[iw] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+
+  } // CrawlPlanesParallel
+
+//------------------------------------------------------------------------------
+  void ClusterCrawlerAlg::MergePlane(ClusterCrawlerAlg& worker, unsigned int firstHit, double crawlTime,
+    detinfo::DetectorProperties const* detprop,
+    lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel)
+  {
+    // Appends the results of a plane crawled by CrawlPlanesParallel with the
+    // hit, cluster and vertex indices shifted, which gives the same result as
+    // the serial loop
+
+    // In the serial loop the cluster IDs of this plane follow those of the
+    // previous planes and TmpStore refuses new clusters at SHRT_MAX. If the
+    // IDs could have got there, or if one of the vertices found so far was
+    // missed, crawl the plane again as the serial loop does
+    if(NClusters + worker.NClusters >= SHRT_MAX || worker.VtxInWindows(vtx)) {
+      plane = worker.plane;
+      clCTP = worker.clCTP;
+      cstat = worker.cstat;
+      tpc = worker.tpc;
+      auto const start = std::chrono::steady_clock::now();
+      if(!CrawlPlane(detprop, channelStatus, scaleChannel)) return;
+      std::chrono::duration<double> const recrawlTime = std::chrono::steady_clock::now() - start;
+      fCTPCrawlTime.emplace_back(clCTP, crawlTime + recrawlTime.count());
+      return;
+    }
+
+    short const clOffset = NClusters;
+    short const vtxOffset = vtx.size();
+    std::move(worker.fHits.begin(), worker.fHits.end(), fHits.begin() + firstHit);
+    for(unsigned int iht = 0; iht < worker.inClus.size(); ++iht) {
+      short const icl = worker.inClus[iht];
+      inClus[firstHit + iht] = (icl > 0) ? icl + clOffset : icl;
+      mergeAvailable[firstHit + iht] = worker.mergeAvailable[iht];
+    } // iht
+    for(auto& clstr : worker.tcl) {
+      clstr.ID += (clstr.ID > 0) ? clOffset : -clOffset;
+      if(clstr.BeginVtx >= 0) clstr.BeginVtx += vtxOffset;
+      if(clstr.EndVtx >= 0) clstr.EndVtx += vtxOffset;
+      for(auto& iht : clstr.tclhits) iht += firstHit;
+      tcl.push_back(std::move(clstr));
+    } // clstr
+    vtx.insert(vtx.end(), worker.vtx.begin(), worker.vtx.end());
+    NClusters += worker.NClusters;
+    // Leave the plane variables as the serial loop does, since the TPC steps
+    // read them. A plane without hits only gets its hit range
+    if(crawlTime >= 0.) {
+      fCTPCrawlTime.emplace_back(worker.clCTP, crawlTime);
+      TakePlaneState(std::move(worker));
+      for(auto& iht : fcl2hits) iht += firstHit;
+    } else {
+      plane = worker.plane;
+      clCTP = worker.clCTP;
+      cstat = worker.cstat;
+      tpc = worker.tpc;
+      fFirstHit = worker.fFirstHit;
+      fFirstWire = worker.fFirstWire;
+      fLastWire = worker.fLastWire;
+      WireHitRange = std::move(worker.WireHitRange);
+    }
+    for(auto& range : WireHitRange) {
+      if(range.first < 0) continue;
+      range.first += firstHit;
+      range.second += firstHit;
+    } // range
+
+  } // MergePlane
+
+//------------------------------------------------------------------------------
+  void ClusterCrawlerAlg::TakePlaneState(ClusterCrawlerAlg&& worker)
+  {
+    // The worker has the configuration of this algorithm. It takes the
+    // results of the event and then replaces this algorithm as a whole
+    std::swap(fHits, worker.fHits);
+    std::swap(fNHitsEvent, worker.fNHitsEvent);
+    std::swap(inClus, worker.inClus);
+    std::swap(mergeAvailable, worker.mergeAvailable);
+    std::swap(tcl, worker.tcl);
+    std::swap(vtx, worker.vtx);
+    std::swap(vtx3, worker.vtx3);
+    std::swap(NClusters, worker.NClusters);
+    std::swap(fCTPCrawlTime, worker.fCTPCrawlTime);
+    std::swap(fKeepVtxWindows, worker.fKeepVtxWindows);
+    std::swap(fVtxWindows, worker.fVtxWindows);
+    *this = std::move(worker);
+  } // TakePlaneState
+
+//------------------------------------------------------------------------------
+  bool ClusterCrawlerAlg::VtxInWindows(std::vector<VtxStore> const& vertices) const
+  {
+    // Returns true if one of the vertices is inside a window searched while
+    // crawling
+    for(auto const& vertex : vertices) {
+      for(auto const& window : fVtxWindows) {
+        if(std::abs(window.wire - vertex.Wire) < window.dWire &&
+           std::abs(window.time - vertex.Time) < window.dTime) return true;
+      } // window
+    } // vertex
+    return false;
+  } // VtxInWindows
+
   ////////////////////////////////////////////////
     void ClusterCrawlerAlg::ClusterLoop()
     {
@@ -483,7 +664,7 @@ namespace cluster {
                 }
                 ClusterAdded = true;
                 nHitsUsed += fcl2hits.size();
-                AllDone = (nHitsUsed == fHits.size());
+                AllDone = (nHitsUsed == fNHitsEvent);
                 break;
               } else {
                 // abandon it
@@ -2484,8 +2665,15 @@ namespace cluster {
           dwie = std::abs(vtx[iv].Wire - tcl[it].EndWir);
           if(dwie > 2) dwie = 2;
           dwjb = 999; dwje = 999;
+          if(fKeepVtxWindows) {
+            // vertices of all planes are compared. One closer than 3 wires
+            // to an end could change the match
+            fVtxWindows.push_back({ (float)tcl[it].BeginWir, tcl[it].BeginTim, 3, 50 });
+            fVtxWindows.push_back({ (float)tcl[it].EndWir, tcl[it].EndTim, 3, 50 });
+          }
           for(jv = 0; jv < vtx.size(); ++jv) {
             if(iv == jv) continue;
+            if(fChkVtxPlane && vtx[jv].CTP != clCTP) continue;
             if(std::abs(vtx[jv].Time - tcl[it].BeginTim) < 50) {
               if(std::abs(vtx[jv].Wire - tcl[it].BeginWir) < dwjb)
                 dwjb = std::abs(vtx[jv].Wire - tcl[it].BeginWir);
@@ -5036,6 +5224,7 @@ namespace cluster {
     if(lastClHit != UINT_MAX && fAveHitWidth > 0 && fHitMergeChiCut > 0 && hit.Multiplicity() == 2) {
       bool doMerge = true;
       for(unsigned short ivx = 0; ivx < vtx.size(); ++ivx) {
+        if(fChkVtxPlane && vtx[ivx].CTP != clCTP) continue;
         if(std::abs(kwire - vtx[ivx].Wire) < 10 &&
            std::abs(int(hit.PeakTime() - vtx[ivx].Time)) < 20 )
         {
@@ -5043,6 +5232,7 @@ namespace cluster {
           break;
         }
       } // ivx
+      if(doMerge && fKeepVtxWindows) fVtxWindows.push_back({ (float)kwire, hit.PeakTime(), 10, 20 });
       // quit if localindex does not make sense.
       if (hit.LocalIndex() != 0 && imbest == 0) doMerge = false;
       if (doMerge) {
@@ -6078,6 +6268,12 @@ namespace cluster {
 
 //////////////////////////////////
     void ClusterCrawlerAlg::GetHitRange(CTP_t CTP)
+    {
+      GetHitRange(CTP, art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider());
+    } // GetHitRange()
+
+//////////////////////////////////
+    void ClusterCrawlerAlg::GetHitRange(CTP_t CTP, lariov::ChannelStatusProvider const& channelStatus)
     {
       // fills the WireHitRange vector for the supplied Cryostat/TPC/Plane code
       // Hits must have been sorted by increasing wire number
@@ -6122,9 +6318,6 @@ namespace cluster {
         ++nHitInPlane;
       }
       // overwrite with the "dead wires" condition
-      lariov::ChannelStatusProvider const& channelStatus
-        = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
-
       flag.first = -1; flag.second = -1;
       unsigned int nbad = 0;
       for(wire = 0; wire < nwires; ++wire) {
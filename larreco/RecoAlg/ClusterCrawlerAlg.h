@@ -18,9 +18,12 @@
 // framework libraries
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 namespace geo { class Geometry; }
+namespace detinfo { class DetectorProperties; }
+namespace lariov { class ChannelStatusProvider; }
 
 // LArSoft libraries
 #include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h"
 #include "larcore/Geometry/Geometry.h"
 #include "lardataobj/RecoBase/Hit.h"
 #include "larreco/RecoAlg/LinFitAlg.h"
@@ -125,6 +128,10 @@ namespace cluster {
     /// Returns a constant reference to the 3D vertices found
     std::vector<Vtx3Store> const& GetVertices() const { return vtx3; }
 
+    /// Returns the wall-clock time (s) spent crawling each plane in the last event
+    std::vector<std::pair<CTP_t, double>> const& GetCTPCrawlTimes() const
+      { return fCTPCrawlTime; }
+
 
     /// Deletes all the results (might saves memory)
     /// @note The current implementation typically does NOT save memory.
@@ -168,6 +175,9 @@ namespace cluster {
     bool fVtxClusterSplit;
     bool fFindStarVertices;
   //  bool fFindTrajVertices;
+    bool fParallelPlanes;   ///< crawl the planes concurrently
+    bool fChkVtxPlane;      ///< ignore the vertices of other planes when attaching
+                            ///< clusters to vertices and merging doublets
 
     // global cuts and parameters
     float fHitErrFac;   ///< hit time error = fHitErrFac * hit RMS used for cluster fit
@@ -210,11 +220,23 @@ namespace cluster {
     art::ServiceHandle<geo::Geometry const> geom;
 
     std::vector<recob::Hit> fHits; ///< our version of the hits
+    unsigned int fNHitsEvent;      ///< number of hits in the event
     std::vector<short> inClus;    ///< Hit used in cluster (-1 = obsolete, 0 = free)
     std::vector<bool> mergeAvailable; ///< set true if hit is with HitMergeChiCut of a neighbor hit
     std::vector< ClusterStore > tcl; ///< the clusters we are creating
     std::vector< VtxStore > vtx; ///< the endpoints we are reconstructing
     std::vector< Vtx3Store > vtx3; ///< the 3D vertices we are reconstructing
+    std::vector<std::pair<CTP_t, double>> fCTPCrawlTime; ///< crawl time of each plane
+
+    /// A (wire, tick) window searched for the 2D vertices of all the planes
+    struct VtxWindow {
+      float wire;
+      float time;
+      float dWire;
+      float dTime;
+    };
+    bool fKeepVtxWindows;  ///< keep the vertex windows searched by the crawl
+    std::vector<VtxWindow> fVtxWindows; ///< the vertex windows searched by the crawl
 
     trkf::LinFitAlg fLinFitAlg;
 
@@ -287,6 +309,23 @@ namespace cluster {
     std::string fhitsModuleLabel;
     // ******** crawling routines *****************
 
+    // Finds the hit range of the current plane and crawls it. Returns false
+    // if the plane has no hits
+    bool CrawlPlane(detinfo::DetectorProperties const* detprop,
+      lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel);
+    // Crawls all the planes concurrently, each with its own copy of the algorithm
+    void CrawlPlanesParallel(std::vector<ClusterCrawlerAlg>& workers,
+      std::vector<unsigned int>& firstHits, std::vector<double>& crawlTimes,
+      detinfo::DetectorProperties const* detprop,
+      lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel);
+    // Appends the results of a plane crawled by CrawlPlanesParallel
+    void MergePlane(ClusterCrawlerAlg& worker, unsigned int firstHit, double crawlTime,
+      detinfo::DetectorProperties const* detprop,
+      lariov::ChannelStatusProvider const& channelStatus, raw::ChannelID_t scaleChannel);
+    // Takes the plane and cluster variables of a worker, keeping the results
+    void TakePlaneState(ClusterCrawlerAlg&& worker);
+    // Returns true if one of the vertices is in fVtxWindows
+    bool VtxInWindows(std::vector<VtxStore> const& vertices) const;
     // Loops over wires looking for seed clusters
     void ClusterLoop();
     // Returns true if the hits on a cluster have a consistent width
@@ -395,6 +434,7 @@ namespace cluster {
     void ClusterInit();
     // fills the wirehitrange vector for the supplied Cryostat/TPC/Plane code
     void GetHitRange(CTP_t CTP);
+    void GetHitRange(CTP_t CTP, lariov::ChannelStatusProvider const& channelStatus);
     // Stores cluster information in a temporary vector
     bool TmpStore();
     // Gets a temp cluster and puts it into the working cluster variables
@@ -11,9 +11,13 @@
 #include "cetlib/pow.h"
 #include "fhiclcpp/ParameterSet.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include <algorithm>
-#include <stdio.h>
-#include <stdlib.h>
+#include <cmath>
+#include <numeric>
+#include <utility>
 
 cluster::DBScan3DAlg::DBScan3DAlg(fhicl::ParameterSet const& pset)
   : epsilon(pset.get< float >("epsilon"))
@@ -29,23 +33,7 @@ cluster::DBScan3DAlg::DBScan3DAlg(fhicl::ParameterSet const& pset)
 void cluster::DBScan3DAlg::init(const std::vector<art::Ptr<recob::SpacePoint>>& sps, art::FindManyP<recob::Hit>& hitFromSp)
 {
 
-  if (badchannelmap.empty()){
-    lariov::ChannelStatusProvider const& channelStatus = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
-    geo::GeometryCore const* geom = &*(art::ServiceHandle<geo::Geometry const>());
-    // build a map to count bad channels around each wire ID
-    for (auto &pid : geom->IteratePlaneIDs()){
-      for (auto& wid1: geom->IterateWireIDs(pid)) {
-        unsigned int nbadchs = 0;
-        for (auto& wid2: geom->IterateWireIDs(pid)) {
-          if (wid1==wid2) continue;
-          if (util::absDiff(wid1.Wire,wid2.Wire)<neighbors &&
-              !channelStatus.IsGood(geom->PlaneWireToChannel(wid2))) ++nbadchs;
-        }
-        badchannelmap[wid1] = nbadchs;
-      }
-    }
-    std::cout<<"Done building bad channel map."<<std::endl;
-  }
+  if (badchannelmap.empty()) build_bad_channel_map();
 
   points.clear();
   for (auto& spt : sps){
@@ -62,153 +50,214 @@ void cluster::DBScan3DAlg::init(const std::vector<art::Ptr<recob::SpacePoint>>&
   }
 }
 
-node_t *cluster::DBScan3DAlg::create_node(unsigned int index)
+//----------------------------------------------------------
+void cluster::DBScan3DAlg::build_bad_channel_map()
 {
-  node_t *n = (node_t *) calloc(1, sizeof(node_t));
-  if (n == NULL)
-    perror("Failed to allocate node.");
-  else {
-    n->index = index;
-    n->next = NULL;
+  lariov::ChannelStatusProvider const& channelStatus = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
+  geo::GeometryCore const* geom = &*(art::ServiceHandle<geo::Geometry const>());
+  // count bad channels around each wire ID: all other wires of the plane
+  // closer than "neighbors", done with a running sum over the plane
+  for (auto &pid : geom->IteratePlaneIDs()){
+    unsigned int const nwires = geom->Nwires(pid);
+    std::vector<unsigned int> nbadbelow(nwires + 1, 0); // bad channels among wires [0, w)
+    for (auto& wid: geom->IterateWireIDs(pid)) {
+      nbadbelow[wid.Wire + 1] = channelStatus.IsGood(geom->PlaneWireToChannel(wid)) ? 0 : 1;
+    }
+    std::partial_sum(nbadbelow.begin(), nbadbelow.end(), nbadbelow.begin());
+    for (auto& wid: geom->IterateWireIDs(pid)) {
+      unsigned int nbadchs = 0;
+      if (neighbors > 0) {
+        unsigned int const first = wid.Wire >= neighbors - 1 ? wid.Wire - (neighbors - 1) : 0;
+        unsigned int const last  = std::min(wid.Wire + neighbors, nwires); // one past the window
+        unsigned int const self  = nbadbelow[wid.Wire + 1] - nbadbelow[wid.Wire];
+        nbadchs = nbadbelow[last] - nbadbelow[first] - self;
+      }
+      badchannelmap[wid] = nbadchs;
+    }
   }
-  return n;
+  std::cout<<"Done building bad channel map."<<std::endl;
 }
 
-int cluster::DBScan3DAlg::append_at_end(unsigned int index,
-                                        epsilon_neighbours_t *en)
+//----------------------------------------------------------
+// Finds the epsilon neighbours of all points at once.
+// Points are sorted into cubic cells of side sqrt(epsilon) addressed by a
+// linear cell key (z fastest), so the cells of one (x, y) column of the
+// search window form a single key range found with one binary search.
+// The search reach is widened by the largest possible bad channel
+// allowance; the exact dist() criterion is applied to every candidate.
+// Neighbour lists are kept in index order, which is the order in which
+// the original full scan found them, so the clustering is unchanged.
+void cluster::DBScan3DAlg::find_all_epsilon_neighbours()
 {
-  node_t *n = create_node(index);
-  if (n == NULL) {
-    free(en);
-    return FAILURE;
-  }
-  if (en->head == NULL) {
-    en->head = n;
-    en->tail = n;
-  } else {
-    en->tail->next = n;
-    en->tail = n;
-  }
-  ++(en->num_members);
-  return SUCCESS;
-}
+  size_t const npts = pos.size();
 
-epsilon_neighbours_t *cluster::DBScan3DAlg::get_epsilon_neighbours(unsigned int index)
-{
-  epsilon_neighbours_t *en = (epsilon_neighbours_t *)
-    calloc(1, sizeof(epsilon_neighbours_t));
-  if (en == NULL) {
-    perror("Failed to allocate epsilon neighbours.");
-    return en;
+  neighbour_offsets.assign(npts + 1, 0);
+  neighbour_pool.clear();
+
+  if (npts == 0) return;
+
+  double const cell = epsilon > 0. ? std::sqrt(epsilon) : 1.;
+
+  std::array<double,3> lo = pos[0], hi = pos[0];
+  for (auto const& p : pos) {
+    for (size_t k = 0; k < 3; ++k) {
+      lo[k] = std::min(lo[k], p[k]);
+      hi[k] = std::max(hi[k], p[k]);
+    }
   }
-  for (unsigned int i = 0; i < points.size(); ++i) {
-    if (i == index)
-      continue;
-    if (dist(&points[index], &points[i]) > epsilon)
-      continue;
-    else {
-      if (append_at_end(i, en) == FAILURE) {
-        destroy_epsilon_neighbours(en);
-        en = NULL;
-        break;
+
+  std::array<long long,3> dims;
+  for (size_t k = 0; k < 3; ++k) dims[k] = (long long)((hi[k] - lo[k]) / cell) + 1;
+
+  auto cellIndex = [&](size_t i, size_t k){ return (long long)((pos[i][k] - lo[k]) / cell); };
+  auto cellKey = [&](long long ix, long long iy, long long iz){ return (ix * dims[1] + iy) * dims[2] + iz; };
+
+  std::vector<std::pair<long long, unsigned int>> sorted(npts);
+  for (size_t i = 0; i < npts; ++i)
+    sorted[i] = std::make_pair(cellKey(cellIndex(i, 0), cellIndex(i, 1), cellIndex(i, 2)), (unsigned int)i);
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<long long> keys(npts);
+  for (size_t i = 0; i < npts; ++i) keys[i] = sorted[i].first;
+
+  unsigned int const maxnbad = *std::max_element(nbad.begin(), nbad.end());
+
+  // query points in fixed chunks, each chunk fills its own pool
+  size_t const chunkSize = 1024;
+  size_t const nchunks = (npts + chunkSize - 1) / chunkSize;
+  std::vector<std::vector<unsigned int>> chunkPools(nchunks);
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, nchunks), [&](tbb::blocked_range<size_t> const& range){
+    std::vector<unsigned int> candidates;
+    for (size_t chunk = range.begin(); chunk != range.end(); ++chunk) {
+      std::vector<unsigned int>& pool = chunkPools[chunk];
+      size_t const last = std::min(npts, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < last; ++i) {
+        double const reach = std::sqrt(epsilon + cet::square((nbad[i] + maxnbad) * badchannelweight));
+        long long const span = (long long)(reach * (1. + 1.e-5) / cell) + 1;
+        long long const ix = cellIndex(i, 0), iy = cellIndex(i, 1), iz = cellIndex(i, 2);
+
+        candidates.clear();
+        for (long long cx = std::max(ix - span, 0LL); cx <= std::min(ix + span, dims[0] - 1); ++cx) {
+          for (long long cy = std::max(iy - span, 0LL); cy <= std::min(iy + span, dims[1] - 1); ++cy) {
+            long long const firstKey = cellKey(cx, cy, std::max(iz - span, 0LL));
+            long long const lastKey  = cellKey(cx, cy, std::min(iz + span, dims[2] - 1));
+            for (size_t s = std::lower_bound(keys.begin(), keys.end(), firstKey) - keys.begin();
+                 s < npts && keys[s] <= lastKey; ++s) {
+              unsigned int const j = sorted[s].second;
+              if (j == i) continue;
+              if (dist(i, j) > epsilon) continue;
+              candidates.push_back(j);
+            }
+          }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        neighbour_offsets[i + 1] = candidates.size();
+        pool.insert(pool.end(), candidates.begin(), candidates.end());
       }
     }
-  }
-  return en;
+  });
+
+  std::partial_sum(neighbour_offsets.begin(), neighbour_offsets.end(), neighbour_offsets.begin());
+  neighbour_pool.resize(neighbour_offsets.back());
+
+  tbb::parallel_for(size_t(0), nchunks, [&](size_t chunk){
+    std::copy(chunkPools[chunk].begin(), chunkPools[chunk].end(), neighbour_pool.begin() + neighbour_offsets[chunk * chunkSize]);
+  });
 }
 
-void cluster::DBScan3DAlg::destroy_epsilon_neighbours(epsilon_neighbours_t *en)
+//----------------------------------------------------------
+void cluster::DBScan3DAlg::dbscan()
 {
-  if (en) {
-    node_t *t, *h = en->head;
-    while (h) {
-      t = h->next;
-      free(h);
-      h = t;
-    }
-    free(en);
+  std::vector<std::array<double,3>> xyz;
+  std::vector<unsigned int> nbadchannels;
+  std::vector<int> cluster_ids;
+
+  xyz.reserve(points.size());
+  nbadchannels.reserve(points.size());
+  for (auto const& point : points) {
+    Double32_t const* p_xyz = point.sp->XYZ();
+    xyz.push_back({p_xyz[0], p_xyz[1], p_xyz[2]});
+    nbadchannels.push_back(point.nbadchannels);
   }
+
+  dbscan(xyz, nbadchannels, cluster_ids);
+
+  for (size_t i = 0; i < points.size(); ++i) points[i].cluster_id = cluster_ids[i];
 }
 
-void cluster::DBScan3DAlg::dbscan()
+//----------------------------------------------------------
+void cluster::DBScan3DAlg::dbscan(const std::vector<std::array<double,3>>& xyz,
+                                  const std::vector<unsigned int>& nbadchannels,
+                                  std::vector<int>& cluster_ids)
 {
+  pos = xyz;
+  nbad = nbadchannels;
+  nbad.resize(pos.size(), 0);
+
+  find_all_epsilon_neighbours();
+
+  cluster_ids.assign(pos.size(), UNCLASSIFIED);
+
+  std::vector<unsigned int> seeds;
   unsigned int i, cluster_id = 0;
-  for (i = 0; i < points.size(); ++i) {
-    if (points[i].cluster_id == UNCLASSIFIED) {
-      if (expand(i, cluster_id) == CORE_POINT)
+  for (i = 0; i < pos.size(); ++i) {
+    if (cluster_ids[i] == UNCLASSIFIED) {
+      if (expand(i, cluster_id, cluster_ids, seeds))
         ++cluster_id;
     }
   }
+
+  // release the working memory
+  pos.clear();
+  nbad.clear();
+  std::vector<size_t>().swap(neighbour_offsets);
+  std::vector<unsigned int>().swap(neighbour_pool);
 }
 
-int cluster::DBScan3DAlg::expand(unsigned int index,
-                                 unsigned int cluster_id)
+//----------------------------------------------------------
+// Seeds are the neighbours of the core point; every seed which turns out
+// to be a core point itself appends its unclassified neighbours to the
+// seed list, which is walked until its end.
+bool cluster::DBScan3DAlg::expand(unsigned int index,
+                                  unsigned int cluster_id,
+                                  std::vector<int>& cluster_ids,
+                                  std::vector<unsigned int>& seeds) const
 {
-  int return_value = NOT_CORE_POINT;
-  epsilon_neighbours_t *seeds =
-    get_epsilon_neighbours(index);
-  if (seeds == NULL)
-    return FAILURE;
-
-  if (seeds->num_members < minpts)
-    points[index].cluster_id = NOISE;
-  else {
-    points[index].cluster_id = cluster_id;
-    node_t *h = seeds->head;
-    while (h) {
-      points[h->index].cluster_id = cluster_id;
-      h = h->next;
-    }
-
-    h = seeds->head;
-    while (h) {
-      spread(h->index, seeds, cluster_id);
-      h = h->next;
-    }
+  seeds.assign(neighbour_pool.begin() + neighbour_offsets[index],
+               neighbour_pool.begin() + neighbour_offsets[index + 1]);
 
-    return_value = CORE_POINT;
+  if (seeds.size() < minpts) {
+    cluster_ids[index] = NOISE;
+    return false;
   }
-  destroy_epsilon_neighbours(seeds);
-  return return_value;
-}
 
-int cluster::DBScan3DAlg::spread(unsigned int index,
-                                 epsilon_neighbours_t *seeds,
-                                 unsigned int cluster_id)
-{
-  epsilon_neighbours_t *spread =
-    get_epsilon_neighbours(index);
-  if (spread == NULL)
-    return FAILURE;
-  if (spread->num_members >= minpts) {
-    node_t *n = spread->head;
-    point_t *d;
-    while (n) {
-      d = &points[n->index];
-      if (d->cluster_id == NOISE ||
-          d->cluster_id == UNCLASSIFIED) {
-        if (d->cluster_id == UNCLASSIFIED) {
-          if (append_at_end(n->index, seeds)
-              == FAILURE) {
-            destroy_epsilon_neighbours(spread);
-            return FAILURE;
-          }
-        }
-        d->cluster_id = cluster_id;
+  cluster_ids[index] = cluster_id;
+  for (auto seed : seeds) cluster_ids[seed] = cluster_id;
+
+  for (size_t s = 0; s < seeds.size(); ++s) {
+    size_t const first = neighbour_offsets[seeds[s]];
+    size_t const last = neighbour_offsets[seeds[s] + 1];
+    if (last - first < minpts) continue;
+    for (size_t n = first; n < last; ++n) {
+      unsigned int const neighbour = neighbour_pool[n];
+      int& id = cluster_ids[neighbour];
+      if (id == NOISE || id == UNCLASSIFIED) {
+        if (id == UNCLASSIFIED) seeds.push_back(neighbour);
+        id = cluster_id;
       }
-      n = n->next;
     }
   }
 
-  destroy_epsilon_neighbours(spread);
-  return SUCCESS;
+  return true;
 }
 
-float cluster::DBScan3DAlg::dist(point_t *a, point_t *b) const
+//----------------------------------------------------------
+float cluster::DBScan3DAlg::dist(size_t a, size_t b) const
 {
-  Double32_t const* a_xyz = a->sp->XYZ();
-  Double32_t const* b_xyz = b->sp->XYZ();
-  auto const nbadchannels = a->nbadchannels + b->nbadchannels;
+  std::array<double,3> const& a_xyz = pos[a];
+  std::array<double,3> const& b_xyz = pos[b];
+  auto const nbadchannels = nbad[a] + nbad[b];
   float const dx = a_xyz[0] - b_xyz[0];
   float const dy = a_xyz[1] - b_xyz[1];
   float const dz = a_xyz[2] - b_xyz[2];
@@ -43,7 +43,10 @@
 #include "canvas/Persistency/Common/FindManyP.h"
 namespace fhicl { class ParameterSet; }
 
+#include <array>
+#include <cstddef>
 #include <map>
+#include <vector>
 
 #include "larcoreobj/SimpleTypesAndConstants/geo_types.h"  // for WireID
 
@@ -59,18 +62,6 @@ struct point_s {
   int cluster_id;
 };
 
-typedef struct node_s node_t;
-struct node_s {
-  unsigned int index;
-  node_t *next;
-};
-
-typedef struct epsilon_neighbours_s epsilon_neighbours_t;
-struct epsilon_neighbours_s {
-  unsigned int num_members;
-  node_t *head, *tail;
-};
-
 namespace cluster{
 
 //---------------------------------------------------------------
@@ -86,6 +77,12 @@ class DBScan3DAlg {
               art::FindManyP<recob::Hit>& hitFromSp);
     void dbscan();
 
+    // Same as dbscan() on bare positions and bad channel counts,
+    // cluster ids are returned in the convention of point_t::cluster_id
+    void dbscan(const std::vector<std::array<double,3>>& xyz,
+                const std::vector<unsigned int>& nbadchannels,
+                std::vector<int>& cluster_ids);
+
   private:
 
     double epsilon;
@@ -94,17 +91,19 @@ class DBScan3DAlg {
     unsigned int neighbors;
     std::map<geo::WireID, int> badchannelmap;
 
-    node_t *create_node(unsigned int index);
-    int append_at_end(unsigned int index,
-                      epsilon_neighbours_t *en);
-    epsilon_neighbours_t *get_epsilon_neighbours(unsigned int index);
-    void destroy_epsilon_neighbours(epsilon_neighbours_t *en);
-    int expand(unsigned int index,
-               unsigned int cluster_id);
-    int spread(unsigned int index,
-               epsilon_neighbours_t *seeds,
-               unsigned int cluster_id);
-    float dist(point_t *a, point_t *b) const;
+    // working state of a clustering pass
+    std::vector<std::array<double,3>> pos;        ///< point positions
+    std::vector<unsigned int> nbad;               ///< bad channels near each point
+    std::vector<size_t> neighbour_offsets;        ///< neighbours of point i are
+    std::vector<unsigned int> neighbour_pool;     ///< pool[offsets[i]] to pool[offsets[i+1]]
+
+    void build_bad_channel_map();
+    void find_all_epsilon_neighbours();
+    bool expand(unsigned int index,
+                unsigned int cluster_id,
+                std::vector<int>& cluster_ids,
+                std::vector<unsigned int>& seeds) const;
+    float dist(size_t a, size_t b) const;
 
 
   }; // class DBScan3DAlg
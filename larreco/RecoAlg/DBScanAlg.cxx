@@ -28,8 +28,14 @@
 #include "lardataobj/RecoBase/Hit.h"
 #include "larcorealg/CoreUtils/NumericUtils.h" // util::absDiff()
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <cstdlib>
+#include <limits>
+
+#include <sys/resource.h>
 
 //----------------------------------------------------------
 // RStarTree stuff
@@ -309,20 +315,7 @@ void cluster::DBScanAlg::InitScan(const std::vector< art::Ptr<recob::Hit> >& all
   for(size_t p = 0; p < geom->Nplanes(); ++p)
     fWirePitch.push_back(geom->WirePitch(p));
 
-
-  // Collect the bad wire list into a useful form
-  if (fClusterMethod) { // Using the R*-tree
-    fBadWireSum.resize(geom->Nchannels());
-    unsigned int count=0;
-    for (unsigned int i=0; i<fBadWireSum.size(); ++i) {
-      count += fBadChannels.count(i);
-      fBadWireSum[i] = count;
-    }
-  }
-
-  // Collect the hits in a useful form,
-  // and take note of the maximum time width
-  fMaxWidth=0.0;
+  // Collect the hits in a useful form
   for (unsigned int j = 0; j < allhits.size(); ++j){
     int dims = 3;//our point is defined by 3 elements:wire#,center of the hit, and the hit width
     std::vector<double> p(dims);
@@ -334,12 +327,66 @@ void cluster::DBScanAlg::InitScan(const std::vector< art::Ptr<recob::Hit> >& all
     p[1] = allhits[j]->PeakTime()*tickToDist;
     p[2] = 2.*allhits[j]->RMS()*tickToDist;   //width of a hit in cm
 
+    fps.push_back(p);
+  }
+
+  InitPoints(geom->Nchannels());
+
+  return;
+}
+
+//----------------------------------------------------------
+void cluster::DBScanAlg::InitScan(std::vector<std::vector<double> > points,
+				  std::set<uint32_t>                 badChannels,
+				  const std::vector<double>&         wirePitch)
+{
+  fpointId_to_clusterId.clear();
+  fnoise.clear();
+  fvisited.clear();
+  fsim.clear();
+  fsim2.clear();
+  fsim3.clear();
+  fclusters.clear();
+
+  fps = std::move(points);
+  fWirePitch = wirePitch;
+  fBadChannels = std::move(badChannels);
+  fBadWireSum.clear();
+
+  fRTree.Remove(RTree::AcceptAny(),RTree::RemoveLeaf());
+  fRect.clear();
+
+  // there is no geometry to ask, so count channels up to the last wire in use
+  unsigned int nChannels = fBadChannels.empty()? 0: *fBadChannels.rbegin() + 1;
+  for (const auto& p : fps)
+    nChannels = std::max(nChannels, (unsigned int) (p[0]/fWirePitch[0] + 0.5) + 1);
+
+  InitPoints(nChannels);
+}
+
+//----------------------------------------------------------
+// Fill the search structures of the selected method from fps
+void cluster::DBScanAlg::InitPoints(unsigned int nChannels)
+{
+  // Collect the bad wire list into a useful form
+  if (fClusterMethod == 1 || fClusterMethod == 2) { // Using the R*-tree
+    fBadWireSum.resize(nChannels);
+    unsigned int count=0;
+    for (unsigned int i=0; i<fBadWireSum.size(); ++i) {
+      count += fBadChannels.count(i);
+      fBadWireSum[i] = count;
+    }
+  }
+
+  // take note of the maximum time width
+  fMaxWidth=0.0;
+  for (unsigned int j = 0; j < fps.size(); ++j){
+    const std::vector<double>& p = fps[j];
+
     // check on the maximum width condition
     if ( p[2] > fMaxWidth ) fMaxWidth = p[2];
 
-    fps.push_back(p);
-
-    if (fClusterMethod) { // Using the R*-tree
+    if (fClusterMethod == 1 || fClusterMethod == 2) { // Using the R*-tree
       // Convert these same values into dbsPoints to feed into the R*-tree
       dbsPoint pp(p[0], p[1], 0.0, p[2]/2.0); // note dividing by two
       fRTree.Insert(j, pp.bounds());
@@ -352,15 +399,61 @@ void cluster::DBScanAlg::InitScan(const std::vector< art::Ptr<recob::Hit> >& all
   fnoise.resize(fps.size(), false);
   fvisited.resize(fps.size(), false);
 
-  if (fClusterMethod) { // Using the R*-tree
+  if (fClusterMethod == 1 || fClusterMethod == 2) { // Using the R*-tree
     Visitor visitor =
       fRTree.Query(RTree::AcceptAny(),Visitor());
     mf::LogInfo("DBscan") << "InitScan: hits RTree loaded with "
 			     << visitor.count << " items.";
   }
+  if (fClusterMethod == 3) {
+    BuildGrid();
+    mf::LogInfo("DBscan") << "InitScan: hits indexed on "
+			     << fGridColumns.size() << " wires.";
+  }
   mf::LogInfo("DBscan") << "InitScan: hits vector size is " << fps.size();
+}
 
-  return;
+//----------------------------------------------------------
+// Sort the points in columns of wire and drift coordinate, and count the
+// bad wires below each column so that the wires to bridge between two
+// points are a difference rather than a loop over fBadChannels
+void cluster::DBScanAlg::BuildGrid()
+{
+  fGridColumns.clear();
+  fGridOrder.clear();
+  fGridColumnOf.assign(fps.size(), 0);
+
+  /// \todo this code assumes that all planes have the same wire pitch
+  double wire_dist = fWirePitch[0];
+
+  std::vector<unsigned int> wires(fps.size());
+  for (unsigned int j = 0; j < fps.size(); ++j){
+    wires[j] = (unsigned int)(fps[j][0]/wire_dist+0.5); // as in getSimilarity()
+    fGridOrder.push_back(j);
+  }
+
+  std::sort(fGridOrder.begin(), fGridOrder.end(),
+	    [this, &wires](unsigned int a, unsigned int b){
+	      if (wires[a] != wires[b]) return wires[a] < wires[b];
+	      if (fps[a][1] != fps[b][1]) return fps[a][1] < fps[b][1];
+	      return a < b;
+	    });
+
+  const std::vector<uint32_t> badWires(fBadChannels.begin(), fBadChannels.end());
+
+  for (unsigned int i = 0; i < fGridOrder.size(); ++i){
+    unsigned int const j = fGridOrder[i];
+    if (fGridColumns.empty() || fGridColumns.back().wire != wires[j]) {
+      WireColumn column;
+      column.wire  = wires[j];
+      column.x     = fps[j][0];
+      column.bad   = std::lower_bound(badWires.begin(), badWires.end(), wires[j]) - badWires.begin();
+      column.begin = i;
+      fGridColumns.push_back(column);
+    }
+    fGridColumns.back().end = i + 1;
+    fGridColumnOf[j] = fGridColumns.size() - 1;
+  }
 }
 
 //----------------------------------------------------------
@@ -446,12 +539,18 @@ double cluster::DBScanAlg::getWidthFactor(const std::vector<double> v1, const st
 
   //double k=0.78;
   //..................................................
+  return WidthFactor(v1[2], v2[2]);
+}
+
+//----------------------------------------------------------------
+double cluster::DBScanAlg::WidthFactor(double width1, double width2){
+
   double k = 0.1;//for 4.5 coeff
-  double WFactor = (exp(4.6*(( v1[2]*v1[2])+( v2[2]*v2[2]))))*k;
+  double WFactor = (exp(4.6*(( width1*width1)+( width2*width2))))*k;
   //........................................................
   //Let's try something different:
   // double k=1.96;
-  // double WFactor=(( v1[2]*v1[2])+( v2[2]*v2[2]))*k;
+  // double WFactor=(( width1*width1)+( width2*width2))*k;
   if(WFactor > 1){
     if(WFactor < 6.25) return WFactor;  //remember that we are increasing the distance in
                                         //eps2 as std::sqrt of this number (i.e std::sqrt(6.25))
@@ -518,22 +617,122 @@ void cluster::DBScanAlg::computeWidthFactor()
 }
 
 
+//------------------------------------------------------------------
+// The ellipse test of findNeighbors() with the similarities computed on
+// demand; bad1 and bad2 are the bad wires below the wire of each point
+bool cluster::DBScanAlg::IsNeighbor(unsigned int p1, unsigned int p2,
+				    unsigned int bad1, unsigned int bad2) const
+{
+  const std::vector<double>& v1 = fps[p1];
+  const std::vector<double>& v2 = fps[p2];
+
+  /// \todo this code assumes that all planes have the same wire pitch
+  double wire_dist = fWirePitch[0];
+
+  double cmtobridge = util::absDiff(bad1, bad2)*wire_dist;
+
+  // getSimilarity()
+  double sim = ( std::abs(v2[0]-v1[0])-cmtobridge)*( std::abs(v2[0]-v1[0])-cmtobridge);
+
+  // getSimilarity2()
+  if (std::abs(v2[0]-v1[0])>1e-10){
+    cmtobridge *= std::abs((v2[1]-v1[1])/(v2[0]-v1[0]));
+  }
+  else cmtobridge = 0;
+  double sim2 = ( std::abs(v2[1]-v1[1])-cmtobridge)*( std::abs(v2[1]-v1[1])-cmtobridge);
+
+  // getWidthFactor()
+  double WFactor = WidthFactor(v1[2], v2[2]);
+
+  // the acceptance of RegionQuery(), which includes the point itself
+  return (((sim )/(fEps*fEps)           ) +
+	  ((sim2)/(fEps2*fEps2*(WFactor))) <= 1 );
+}
+
+//----------------------------------------------------------------
+// Find the neighbours of the given point looking only at the wires that
+// are close enough once the bad wires are bridged, and on each of them
+// only in the drift window the ellipse allows.
+std::set<unsigned int> cluster::DBScanAlg::RegionQuery_grid(unsigned int point) const
+{
+  std::set<unsigned int> result;
+
+  /// \todo this code assumes that all planes have the same wire pitch
+  double wire_dist = fWirePitch[0];
+
+  const WireColumn& home = fGridColumns[fGridColumnOf[point]];
+  const double t = fps[point][1];
+
+  // the largest width factor any other point can give
+  const double maxWFactor = WidthFactor(fps[point][2], fMaxWidth);
+  const double tolerance = 1. + 1e-9;
+
+  auto scanColumn = [&](const WireColumn& column) {
+    // wire distance left after bridging the bad wires; the drift distance
+    // is scaled down by the same ratio in getSimilarity2()
+    double const dx = std::abs(column.x - fps[point][0]);
+    double const dxbridged = dx - util::absDiff(column.bad, home.bad)*wire_dist;
+    if (dxbridged > fEps*tolerance) return false;
+
+    double window = std::numeric_limits<double>::max();
+    double const left = 1. - dxbridged*dxbridged/(fEps*fEps);
+    if (dx <= 1e-10 || dxbridged > 0.) {
+      window = fEps2*std::sqrt(maxWFactor*std::max(left, 0.))*tolerance + 1e-9;
+      if (dx > 1e-10) window *= dx/dxbridged;
+    }
+
+    auto const begin = fGridOrder.begin() + column.begin;
+    auto const end   = fGridOrder.begin() + column.end;
+    auto itr = std::lower_bound(begin, end, t - window,
+				[this](unsigned int p, double time){ return fps[p][1] < time; });
+    for (; itr != end && fps[*itr][1] <= t + window; ++itr) {
+      if (IsNeighbor(point, *itr, home.bad, column.bad)) result.insert(*itr);
+    }
+    return true;
+  };
+
+  // the wire distance after bridging only grows moving away from the point,
+  // so stop at the first wire out of reach on each side
+  size_t const c = fGridColumnOf[point];
+  scanColumn(home);
+  for (size_t i = c; i-- > 0; ) {
+    if (!scanColumn(fGridColumns[i])) break;
+  }
+  for (size_t i = c + 1; i < fGridColumns.size(); ++i) {
+    if (!scanColumn(fGridColumns[i])) break;
+  }
+
+  return result;
+}
+
 //----------------------------------------------------------------
 /////////////////////////////////////////////////////////////////
 // This is the algorithm that finds clusters:
 // Run the selected clustering algorithm
 void cluster::DBScanAlg::run_cluster() {
+  auto start = std::chrono::steady_clock::now();
+
   switch(fClusterMethod) {
+  case 3:
   case 2:
-    return run_dbscan_cluster();
+    run_dbscan_cluster();
+    break;
   case 1:
-    return run_FN_cluster();
+    run_FN_cluster();
+    break;
   default:
     computeSimilarity();  // watch out for this, they are *slow*
     computeSimilarity2(); // "
     computeWidthFactor(); // "
-    return run_FN_naive_cluster();
+    run_FN_naive_cluster();
   }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  mf::LogInfo("DBscan") << "Method " << fClusterMethod << ": " << fps.size()
+			   << " hits clustered in " << elapsed.count() << " ms, peak RSS "
+			   << usage.ru_maxrss/1024 << " MB";
 }
 
 //----------------------------------------------------------------
@@ -576,7 +775,8 @@ void cluster::DBScanAlg::run_dbscan_cluster() {
       fclusters[c].push_back(y);
     }
   }
-  mf::LogInfo("DBscan") << "DWM (R*-tree): Found "
+  mf::LogInfo("DBscan") << "DWM (" << ((fClusterMethod == 3)? "wire index": "R*-tree")
+			   << "): Found "
 			   << cid << " clusters...";
   for (unsigned int c = 0; c < cid; ++c){
     mf::LogVerbatim("DBscan") << "\t" << "Cluster " << c << ":\t"
@@ -588,6 +788,8 @@ void cluster::DBScanAlg::run_dbscan_cluster() {
 //----------------------------------------------------------------
 // Find the neighbos of the given point
 std::set<unsigned int> cluster::DBScanAlg::RegionQuery(unsigned int point){
+  if (fClusterMethod == 3) return RegionQuery_grid(point);
+
   dbsPoint region(fRect[point]);
   Visitor visitor =
 //     fRTree.Query(RTree::AcceptOverlapping(region.bounds()),Visitor());
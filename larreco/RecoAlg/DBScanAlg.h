@@ -39,6 +39,11 @@ namespace cluster{
     void InitScan(const std::vector< art::Ptr<recob::Hit> >& allhits,
 		  std::set<uint32_t> badChannels,
 		  const std::vector<geo::WireID> & wireids = std::vector< geo::WireID>()); //wireids is optional
+    // Points already in the (wire coordinate, drift coordinate, width) form
+    // of fps, in cm, with the wire pitch of each plane; no service is used
+    void InitScan(std::vector<std::vector<double> > points,
+		  std::set<uint32_t> badChannels,
+		  const std::vector<double>& wirePitch);
     double getSimilarity(const std::vector<double> v1,
 			 const std::vector<double> v2);
     std::vector<unsigned int> findNeighbors( unsigned int pid,
@@ -86,6 +91,26 @@ namespace cluster{
     std::vector<uint32_t>  fBadWireSum;    ///< running total of bad channels. Used for fast intervening
                                            ///< dead wire counting ala fBadChannelSum[m]-fBadChannelSum[n].
 
+    // Index of the points for the on-demand similarity of Method 3: the
+    // points of each wire sorted in drift coordinate, and the wires with
+    // points sorted in wire number. The memory is O(N) in the number of hits
+    // rather than the O(N^2) of fsim, fsim2 and fsim3.
+    struct WireColumn {
+      unsigned int wire;   ///< wire number as computed in getSimilarity()
+      double       x;      ///< wire coordinate of the points [cm]
+      unsigned int bad;    ///< number of bad wires below this one
+      unsigned int begin;  ///< first entry of the column in fGridOrder
+      unsigned int end;    ///< one past the last entry in fGridOrder
+    };
+    std::vector<WireColumn>   fGridColumns;  ///< wires with points, by increasing wire
+    std::vector<unsigned int> fGridOrder;    ///< point IDs by wire, then drift coordinate
+    std::vector<unsigned int> fGridColumnOf; ///< column of each point
+
+    void InitPoints(unsigned int nChannels);
+    void BuildGrid();
+    bool IsNeighbor(unsigned int p1, unsigned int p2, unsigned int bad1, unsigned int bad2) const;
+    static double WidthFactor(double width1, double width2);
+
     // Three differnt version of the clustering code
     void run_dbscan_cluster();
     void run_FN_cluster();
@@ -96,6 +121,9 @@ namespace cluster{
     bool ExpandCluster(unsigned int point /* to be added */,
 		       unsigned int clusterID /* which is being expanded */);
     std::set<unsigned int> RegionQuery(unsigned int point);
+    // Neighbours with the bad wire and width factor aware similarity of
+    // findNeighbors(), plus the point itself as in RegionQuery() (Method 3)
+    std::set<unsigned int> RegionQuery_grid(unsigned int point) const;
     // Helper for the accelerated run_FN_cluster()
     std::vector<unsigned int> RegionQuery_vector(unsigned int point);
 
@@ -28,9 +28,13 @@
 
 
 
+#include "tbb/tbb.h"
+
+#include <algorithm>
 #include <map>
 #include <cmath>
 #include <cstdlib>
+#include <sstream>
 
 
 namespace apa{
@@ -39,6 +43,7 @@ DisambigAlg::DisambigAlg(fhicl::ParameterSet const& pset)
   : fAPAGeo(pset.get< fhicl::ParameterSet >("APAGeometryAlg"))
 {
   this->reconfigure(pset);
+  fAPAGeo.InitChannelSegments();
 }
 
 //----------------------------------------------------------
@@ -51,6 +56,7 @@ void DisambigAlg::reconfigure(fhicl::ParameterSet const& p)
   fCloseHitsRadius  =  p.get< double >("CloseHitsRadius");
   fMaxEndPDegRange  =  p.get< double >("MaxEndPDegRange");
   fNChanJumps       =  p.get< unsigned int >("NChanJumps");
+  fConcurrentAPAs   =  p.get< bool >("ConcurrentAPAs", false);
 
 }
 
@@ -63,30 +69,36 @@ void DisambigAlg::RunDisambig(   art::Handle< std::vector<recob::Hit> > ChannelH
   // **tomporarily** here to look at performance without noise hits
   art::ServiceHandle<cheat::BackTrackerService const> bt_serv;
 
-  fUeffSoFar.clear();
-  fVeffSoFar.clear();
-  fnUSoFar.clear();
-  fnVSoFar.clear();
-  fnDUSoFar.clear();
-  fnDVSoFar.clear();
-  fChannelToHits.clear();
-  fAPAToUVHits.clear();
-  fAPAToZHits.clear();
-  fAPAToHits.clear();
-  fAPAToEndPHits.clear();
-  fAPAToDHits.clear();
   fDisambigHits.clear();
-  fChanTimeToWid.clear();
-  fHasBeenDisambiged.clear();
 
 
   std::vector< art::Ptr<recob::Hit> >  ChHits;
   art::fill_ptr_vector(ChHits, ChannelHits);
 
 
-  fHasBeenDisambiged.clear();
+  // Per-APA lists are indexed by APA number and keep their memory between events
+  unsigned int nAPAs = geom->Nchannels()/fAPAGeo.ChannelsPerAPA() + 1;
+  for(auto APAHits : { &fAPAToUVHits, &fAPAToZHits, &fAPAToHits, &fAPAToEndPHits }){
+    APAHits->resize(nAPAs);
+    for(auto& hits : *APAHits) hits.clear();
+  }
+  fAPAToDHits.resize(nAPAs);
+  for(auto& Dhits : fAPAToDHits) Dhits.clear();
+  fAPASummary.assign(nAPAs, std::string());
+  fUeffSoFar.assign(nAPAs, 0.);   fVeffSoFar.assign(nAPAs, 0.);
+  fnUSoFar.assign(nAPAs, 0);      fnVSoFar.assign(nAPAs, 0);
+  fnDUSoFar.assign(nAPAs, 0);     fnDVSoFar.assign(nAPAs, 0);
+
+  fChannelHitsBegin.assign(geom->Nchannels()+1, 0);
+  fChanTimeToWid.assign(ChHits.size(), geo::WireID());
+  fHasBeenDisambiged.assign(ChHits.size(), 0);
+
+
   unsigned int skipNoise(0);
-  // Map hits by channel/APA, initialize the disambiguation status map
+  std::vector< art::Ptr<recob::Hit> > UVHits;
+  std::vector< raw::ChannelID_t > UVChannels(ChHits.size(), raw::InvalidChannelID);
+  std::vector< float > PeakTimes(ChHits.size(), 0.);
+  // Map hits by channel/APA, initialize the disambiguation status
   for( size_t h = 0; h < ChHits.size(); h++ ){
     art::Ptr<recob::Hit> hit = ChHits[h];
 
@@ -105,79 +117,147 @@ void DisambigAlg::RunDisambig(   art::Handle< std::vector<recob::Hit> > ChannelH
       fAPAToZHits[apa].push_back(hit);
       continue;
     } else if ( view==geo::kU || view==geo::kV ){
-      std::pair<double,double> ChanTime( hit->Channel()*1., hit->PeakTime()*1. );
-      this->fHasBeenDisambiged[apa][ChanTime] = false;
-      fChannelToHits[ hit->Channel() ].push_back( hit );
+      fChannelHitsBegin[ hit->Channel()+1 ]++;
+      UVHits.push_back( hit );
+      UVChannels[h] = hit->Channel();
+      PeakTimes[h]  = hit->PeakTime();
       fAPAToUVHits[apa].push_back(hit);
     }
   }
 
+  // Group the UV hits by channel, keeping their order on each channel
+  for(size_t c = 0; c+1 < fChannelHitsBegin.size(); c++) fChannelHitsBegin[c+1] += fChannelHitsBegin[c];
+  fChannelHits.resize(UVHits.size());
+  std::vector<size_t> nextOnChannel(fChannelHitsBegin.begin(), fChannelHitsBegin.end()-1);
+  for(size_t h = 0; h < UVHits.size(); h++) fChannelHits[ nextOnChannel[UVHits[h]->Channel()]++ ] = UVHits[h];
+
+  // Hits with the same channel and peak time are disambiguated together
+  fChanTimeIndex = ChanTimeIndex(UVChannels, PeakTimes);
+
   if(skipNoise>0)
     mf::LogWarning("DisambigAlg")<<"\nSkipped "<< skipNoise <<" induction noise hits using the BackTrackerService.\n"
 				 <<"This is only to temporarily deal with the excessive amount of noise due to the bad deconvolution.\n";
 
   mf::LogVerbatim("RunDisambig")<<"\n~~~~~~~~~~~ Running Disambiguation ~~~~~~~~~~~\n";
 
-  std::map<unsigned int, std::vector< art::Ptr< recob::Hit> > >::iterator APA_it;
-  for( APA_it = fAPAToUVHits.begin(); APA_it != fAPAToUVHits.end(); APA_it++ ){
-    unsigned int apa = APA_it->first;
-
-    mf::LogVerbatim("RunDisambig")<<"APA "<<apa<<":";
+  std::vector<unsigned int> APAs;
+  for( unsigned int apa = 0; apa < nAPAs; apa++ ){
+    if( fAPAToUVHits[apa].size() == 0 ) continue;
+    APAs.push_back(apa);
+  }
 
-    fUeffSoFar[apa] = 0.;   fVeffSoFar[apa] = 0.;
-    fnUSoFar[apa]   = 0;    fnVSoFar[apa]   = 0;
-    fnDUSoFar[apa]  = 0;    fnDVSoFar[apa]  = 0;
+  // APAs are independent, but the crawl wraps channels per APA only in the first cryostat
+  if( fConcurrentAPAs && geom->Ncryostats() == 1 ){
+    tbb::parallel_for(static_cast<size_t>(0), APAs.size(),
+		      [&](size_t a){ this->DisambigAPA(APAs[a]); });
+    for( unsigned int apa : APAs ){
+      mf::LogVerbatim("RunDisambig") << fAPASummary[apa];
+      fDisambigHits.insert(fDisambigHits.end(), fAPAToDHits[apa].begin(), fAPAToDHits[apa].end());
+    }
+  }
+  else{
+    for( unsigned int apa : APAs ){
+      this->DisambigAPA(apa);
+      mf::LogVerbatim("RunDisambig") << fAPASummary[apa];
 
-    // Always run this...
-    this->TrivialDisambig(apa);
-    this->AssessDisambigSoFar(apa);
-    mf::LogVerbatim("RunDisambig") << "  Trivial Disambig -->  "
-				   << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
-				   << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
+      // For now just buld a simple list to get from the module
+      fDisambigHits.insert(fDisambigHits.end(), fAPAToDHits[apa].begin(), fAPAToDHits[apa].end());
+    }
+  }
 
 
-    // ... and pick the rest with the configurations.
-    if( fCrawl ){
-      this->Crawl(apa);
-      this->AssessDisambigSoFar(apa);
-      mf::LogVerbatim("RunDisambig") << "  Crawl            -->  "
-				     << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
-				     << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
-    }
+}
 
 
-    if(fUseEndP){
-      this->FindChanTimeEndPts(apa);
-      this->UseEndPts(apa); // does the crawl from inside
-      this->AssessDisambigSoFar(apa);
-      mf::LogVerbatim("RunDisambig") << "  Endpoint Crawl   -->  "
-				     << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
-				     << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
-    }
 
+//-------------------------------------------------
+//-------------------------------------------------
+std::vector<size_t> DisambigAlg::ChanTimeIndex( std::vector<raw::ChannelID_t> const& channels,
+                                                std::vector<float> const& peakTimes )
+{
 
-    if(fCompareViews){
-      unsigned int nDisambig(1);
-      while(nDisambig > 0){
-	nDisambig = 0;
-	nDisambig = this->CompareViews(apa);
-	this->Crawl(apa);
+  std::vector<size_t> index(channels.size());
+  for(size_t h = 0; h < channels.size(); h++) index[h] = h;
+
+  // Hits by channel, keeping their order on each channel
+  std::vector<size_t> byChannel;
+  for(size_t h = 0; h < channels.size(); h++)
+    if( channels[h] != raw::InvalidChannelID ) byChannel.push_back(h);
+  std::stable_sort(byChannel.begin(), byChannel.end(),
+		   [&channels](size_t a, size_t b){ return channels[a] < channels[b]; });
+
+  size_t begin(0);
+  while( begin < byChannel.size() ){
+    size_t end(begin+1);
+    while( end < byChannel.size() && channels[byChannel[end]] == channels[byChannel[begin]] ) end++;
+    for(size_t i = begin; i < end; i++){
+      for(size_t j = begin; j < i; j++){
+	if( peakTimes[byChannel[j]] != peakTimes[byChannel[i]] ) continue;
+	index[ byChannel[i] ] = index[ byChannel[j] ];
+	break;
       }
-      this->AssessDisambigSoFar(apa);
-      mf::LogVerbatim("RunDisambig") << "  Compare Views    -->  "
-				     << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
-				     << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
     }
+    begin = end;
+  }
+
+  return index;
+}
+
+
+
+//-------------------------------------------------
+//-------------------------------------------------
+void DisambigAlg::DisambigAPA( unsigned int apa )
+{
+
+  std::ostringstream summary;
+  summary << "APA " << apa << ":";
 
+  // Always run this...
+  this->TrivialDisambig(apa);
+  this->AssessDisambigSoFar(apa);
+  summary << "\n  Trivial Disambig -->  "
+	  << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
+	  << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
+
+
+  // ... and pick the rest with the configurations.
+  if( fCrawl ){
+    this->Crawl(apa);
+    this->AssessDisambigSoFar(apa);
+    summary << "\n  Crawl            -->  "
+	    << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
+	    << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
+  }
 
-    //this->GatherLeftoverHits()
 
-    // For now just buld a simple list to get from the module
-    for(size_t i=0; i<fAPAToDHits[apa].size(); i++)
-      fDisambigHits.push_back(fAPAToDHits[apa][i]);
+  if(fUseEndP){
+    this->FindChanTimeEndPts(apa);
+    this->UseEndPts(apa); // does the crawl from inside
+    this->AssessDisambigSoFar(apa);
+    summary << "\n  Endpoint Crawl   -->  "
+	    << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
+	    << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
+  }
 
-  } // end loop through APA
 
+  if(fCompareViews){
+    unsigned int nDisambig(1);
+    while(nDisambig > 0){
+      nDisambig = 0;
+      nDisambig = this->CompareViews(apa);
+      this->Crawl(apa);
+    }
+    this->AssessDisambigSoFar(apa);
+    summary << "\n  Compare Views    -->  "
+	    << fnDUSoFar[apa] << " / " << fnUSoFar[apa] << " U,  "
+	    << fnDVSoFar[apa] << " / " << fnVSoFar[apa] << " V";
+  }
+
+
+  //this->GatherLeftoverHits()
+
+  fAPASummary[apa] = summary.str();
 
 }
 
@@ -191,8 +271,8 @@ void DisambigAlg::MakeDisambigHit( art::Ptr<recob::Hit> hit,
 					  unsigned int apa )
 {
 
-  std::pair<double,double> ChanTime( hit->Channel()*1., hit->PeakTime()*1. );
-  if( fHasBeenDisambiged[apa][ChanTime] ) return;
+  size_t ChanTime = fChanTimeIndex[hit.key()];
+  if( fHasBeenDisambiged[ChanTime] ) return;
 
   if( !wid.isValid ){
     mf::LogWarning("InvalidWireID") << "wid is invalid, hit not being made\n";
@@ -200,7 +280,7 @@ void DisambigAlg::MakeDisambigHit( art::Ptr<recob::Hit> hit,
 
   std::pair<art::Ptr<recob::Hit>,geo::WireID> Dhit(hit, wid);
   fAPAToDHits[apa].push_back(Dhit);
-  fHasBeenDisambiged[apa][ChanTime] = true;
+  fHasBeenDisambiged[ChanTime] = 1;
   fChanTimeToWid[ChanTime] = wid;
   return;
 
@@ -244,27 +324,14 @@ void DisambigAlg::TrivialDisambig( unsigned int apa )
     raw::ChannelID_t chan = hit->Channel();
     unsigned int peakT = hit->PeakTime();
 
-    std::vector<geo::WireID> hitwids = geom->ChannelToWire(chan);
-    std::vector<bool> IsReasonableWid(hitwids.size(),false);
+    const std::vector<APAChannelSegment>& hitsegs = fAPAGeo.ChannelSegments(chan);
+    std::vector<bool> IsReasonableWid(hitsegs.size(),false);
     unsigned short nPossibleWids(0);
-    for(size_t w=0; w<hitwids.size(); w++){
-      geo::WireID wid = hitwids[w];
-
-      double xyzStart[3] = {0.};  double xyzEnd[3] = {0.};
-      geom->WireEndPoints(wid.Cryostat, wid.TPC, wid.Plane, wid.Wire, xyzStart, xyzEnd);
-      unsigned int side(wid.TPC%2), cryo(wid.Cryostat);
-      double zminPos(xyzStart[2]), zmaxPos(xyzEnd[2]);
-
-      // get appropriate x and y with tpc center
-      TVector3 tpcCenter(0,0,0);
-      unsigned int tpc = 2*apa + side - cryo*geom->NTPC(); // apa number does not reset per cryo
-      tpcCenter = geom->Cryostat(cryo).TPC(tpc).LocalToWorld(tpcCenter);
+    for(size_t w=0; w<hitsegs.size(); w++){
 
-      // get channel range
-      TVector3 Min(tpcCenter); Min[2] = zminPos;
-      TVector3 Max(tpcCenter); Max[2] = zmaxPos;
-      raw::ChannelID_t ZminChan = geom->NearestChannel( Min, 2, tpc, cryo );
-      raw::ChannelID_t ZmaxChan = geom->NearestChannel( Max, 2, tpc, cryo );
+      // get channel range, from the table made with the geometry
+      uint32_t ZminChan(hitsegs[w].zMinChan), ZmaxChan(hitsegs[w].zMaxChan);
+      if( !hitsegs[w].hasZRange ) fAPAGeo.SegmentZChannelRange(chan, hitsegs[w].wid, ZminChan, ZmaxChan);
 
       for( size_t z=0; z < fAPAToZHits[apa].size(); z++ ){
 	raw::ChannelID_t chan = fAPAToZHits[apa][z]->Channel();
@@ -286,16 +353,14 @@ void DisambigAlg::TrivialDisambig( unsigned int apa )
 
 
     if(nPossibleWids==0){
-      std::vector<double> xyz;
-      try{ xyz = bt_serv->HitToXYZ(hit); } // TEMPORARY
-      catch(...){ continue; }
+      // noise hits were already skipped with the BackTrackerService in RunDisambig
       ///\ todo: Figure out why sometimes non-noise hits dont match any Z hits at all.
       mf::LogWarning ("UniqueTimeSeg") << "U/V hit inconsistent with Z info; peak time is "
 				       << peakT << " in APA " << apa << " on channel " << hit->Channel();
     }
     else if(nPossibleWids==1){
-      for(size_t d=0; d<hitwids.size(); d++)
-	if(IsReasonableWid[d]) this->MakeDisambigHit( hit, hitwids[d], apa );
+      for(size_t d=0; d<hitsegs.size(); d++)
+	if(IsReasonableWid[d]) this->MakeDisambigHit( hit, hitsegs[d].wid, apa );
     }
     else if(nPossibleWids==2){
       ///\ todo: Add mechanism to at least eliminate the wids that aren't even possible, for the benefit of future methods
@@ -336,32 +401,31 @@ unsigned int DisambigAlg::MakeCloseHits( int ext, geo::WireID Dwid, double Dmin,
   raw::ChannelID_t chan = (raw::ChannelID_t)(tempchan);
 
   // There may just be no hits
-  if( fChannelToHits.count(chan) == 0 ) return 0;
+  if( chan+1 >= fChannelHitsBegin.size() || fChannelHitsBegin[chan] == fChannelHitsBegin[chan+1] ) return 0;
 
   // There are close channel hits, so for each
   unsigned int apa(0), cryo(0);
   fAPAGeo.ChannelToAPA(chan, apa, cryo);
   unsigned int MakeCount(0);
-  for(size_t i=0; i<fChannelToHits[chan].size(); i++){
-    art::Ptr< recob::Hit > closeHit = fChannelToHits[chan][i];
+  const std::vector<APAChannelSegment>& segs = fAPAGeo.ChannelSegments(chan);
+  for(size_t i=fChannelHitsBegin[chan]; i<fChannelHitsBegin[chan+1]; i++){
+    art::Ptr< recob::Hit > closeHit = fChannelHits[i];
     double st = closeHit->PeakTimeMinusRMS();
     double et = closeHit->PeakTimePlusRMS();
-    std::vector<geo::WireID> wids = geom->ChannelToWire(chan);
 
     if( !(Dmin <= st && st <= Dmax) && !(Dmin <= et && et <= Dmax) ) continue;
 
 
     // Found hit with window overlapping given range,
     // now find the only reasonable wireID.
-    for(size_t w=0; w<wids.size(); w++){
-      if( wids[w].TPC != Dwid.TPC ) continue;
-      if( (int)(wids[w].Wire)-(int)(Dwid.Wire) != ext ) continue;
+    for(size_t w=0; w<segs.size(); w++){
+      if( segs[w].wid.TPC != Dwid.TPC ) continue;
+      if( (int)(segs[w].wid.Wire)-(int)(Dwid.Wire) != ext ) continue;
 
       // In this case, we have a unique wireID.
       // Check to see if it has already been made - if so, do not incriment count
-      std::pair<double,double> ChanTime( closeHit->Channel()*1., closeHit->PeakTime()*1. );
-      if( !fHasBeenDisambiged[apa][ChanTime] ){
-	this->MakeDisambigHit(closeHit, wids[w], apa);
+      if( !fHasBeenDisambiged[fChanTimeIndex[closeHit.key()]] ){
+	this->MakeDisambigHit(closeHit, segs[w].wid, apa);
 	MakeCount++;
 	//std::cout << "     Close hit found on channel " << chan << ", time " << st<<"-"<<et << "... \n";
 	//std::cout << " ... giving it wireID ("<< Dwid.Cryostat <<"," << Dwid.TPC
@@ -387,7 +451,7 @@ unsigned int DisambigAlg::MakeCloseHits( int ext, geo::WireID Dwid, double Dmin,
 void DisambigAlg::Crawl( unsigned int apa )
 {
 
-  std::vector<art::Ptr<recob::Hit> > hits = fAPAToUVHits[apa];
+  const std::vector<art::Ptr<recob::Hit> >& hits = fAPAToUVHits[apa];
 
   // repeat this method until stable
   unsigned int nExtended(1);
@@ -396,8 +460,8 @@ void DisambigAlg::Crawl( unsigned int apa )
 
     // Look for any disambiguated hit ...
     for(size_t h=0; h < hits.size(); h++){
-      std::pair<double,double> ChanTime( hits[h]->Channel()*1., hits[h]->PeakTime()*1. );
-      if( !fHasBeenDisambiged[apa][ChanTime] ) continue;
+      size_t ChanTime = fChanTimeIndex[hits[h].key()];
+      if( !fHasBeenDisambiged[ChanTime] ) continue;
       double stD = hits[h]->PeakTimePlusRMS(-1.);
       double etD = hits[h]->PeakTimePlusRMS(+1.);
       double hitWindow = etD - stD;
@@ -440,17 +504,24 @@ unsigned int DisambigAlg::FindChanTimeEndPts( unsigned int apa )
 
   const detinfo::DetectorProperties* detprop = lar::providerFrom<detinfo::DetectorPropertiesService>();
 
+  // Channel and drift positions of the hits, found once instead of for every pair
+  std::vector< std::vector<double> > ChanTimes(fAPAToHits[apa].size(), std::vector<double>(2, 0.));
+  for(size_t h=0; h<fAPAToHits[apa].size(); h++){
+    art::Ptr<recob::Hit> hit = fAPAToHits[apa][h];
+    geo::View_t view = hit->View();
+    unsigned int plane = 0; if(view==geo::kV){ plane = 1; } else if(view==geo::kZ) plane = 2;
+    unsigned int relchan = hit->Channel() - fAPAGeo.FirstChannelInView(hit->Channel());
+    ChanTimes[h][0] = relchan*geom->WirePitch(view);
+    ChanTimes[h][1] = detprop->ConvertTicksToX( hit->PeakTime(),
+						plane,
+						apa*2,  // tpc doesnt matter
+						hit->WireID().Cryostat );
+  }
+
   for(size_t h=0; h<fAPAToHits[apa].size(); h++){
     art::Ptr<recob::Hit> centhit = fAPAToHits[apa][h];
     geo::View_t view = centhit->View();
-    unsigned int plane = 0; if(view==geo::kV){ plane = 1; } else if(view==geo::kZ) plane = 2;
-    std::vector<double> ChanTimeCenter(2, 0.);
-    unsigned int relchan = centhit->Channel() - fAPAGeo.FirstChannelInView(centhit->Channel());
-    ChanTimeCenter[0] = relchan*geom->WirePitch(view);
-    ChanTimeCenter[1] = detprop->ConvertTicksToX( centhit->PeakTime(),
-						  plane,
-						  apa*2,  // tpc doesnt matter
-						  centhit->WireID().Cryostat );
+    const std::vector<double>& ChanTimeCenter = ChanTimes[h];
     //std::vector< art::Ptr<recob::Hit> > CloseHits;
     std::vector<std::vector<double> > CloseHitsChanTime;
     std::vector<double>  FurthestCloseChanTime(2,0.); //double maxDist = 0.;
@@ -461,14 +532,7 @@ unsigned int DisambigAlg::FindChanTimeEndPts( unsigned int apa )
       art::Ptr<recob::Hit> closehit = fAPAToHits[apa][c];
       if(view!=closehit->View()) continue;
       if(view==geo::kZ && centhit->WireID().TPC != closehit->WireID().TPC ) continue;
-      unsigned int plane = 0;  if(view==geo::kV){ plane = 1; } else if(view==geo::kZ) plane = 2;
-      std::vector<double> ChanTimeClose(2, 0.);
-      unsigned int relchanclose = closehit->Channel() - fAPAGeo.FirstChannelInView(closehit->Channel());
-      ChanTimeClose[0] = relchanclose*geom->WirePitch(view);
-      ChanTimeClose[1] = detprop->ConvertTicksToX( closehit->PeakTime(),
-						   plane,
-						   apa*2,  // tpc doesnt matter
-						   closehit->WireID().Cryostat );
+      const std::vector<double>& ChanTimeClose = ChanTimes[c];
       if(ChanTimeClose == ChanTimeCenter) continue; // move on if the same one
 
       double ChanDist = ChanTimeClose[0]-ChanTimeCenter[0];
@@ -700,12 +764,12 @@ unsigned int DisambigAlg::CompareViews( unsigned int apa )
   for(size_t h=0; h < fAPAToUVHits[apa].size(); h++){
     art::Ptr<recob::Hit>      ambighit  = fAPAToUVHits[apa][h];
     raw::ChannelID_t          ambigchan = ambighit->Channel();
-    std::pair<double,double>  ambigChanTime(ambigchan*1.,ambighit->PeakTime());
-    if( fHasBeenDisambiged[apa][ambigChanTime] ) continue;
+    size_t                    ambigChanTime = fChanTimeIndex[ambighit.key()];
+    if( fHasBeenDisambiged[ambigChanTime] ) continue;
     geo::View_t               view      = ambighit->View();
-    std::vector<geo::WireID>  ambigwids = geom->ChannelToWire(ambigchan);
-    std::vector<unsigned int> widDcounts  (ambigwids.size(), 0);
-    std::vector<unsigned int> widAcounts  (ambigwids.size(), 0);
+    const std::vector<APAChannelSegment>& ambigsegs = fAPAGeo.ChannelSegments(ambigchan);
+    std::vector<unsigned int> widDcounts  (ambigsegs.size(), 0);
+    std::vector<unsigned int> widAcounts  (ambigsegs.size(), 0);
 
 
 
@@ -717,20 +781,20 @@ unsigned int DisambigAlg::CompareViews( unsigned int apa )
       // An other-view-hit overlaps in time, see what
       // wids of the ambiguous hit's channels it overlaps
       raw::ChannelID_t          chan = hit->Channel();
-      std::vector<geo::WireID>  wids = geom->ChannelToWire(chan);
-      std::pair<double,double>  ChanTime(chan*1.,hit->PeakTime());
+      size_t                    ChanTime = fChanTimeIndex[hit.key()];
       geo::WireIDIntersection   widIntersect; // only so we can use the function
-      if( fHasBeenDisambiged[apa][ChanTime] ){
-	for(size_t a=0; a<ambigwids.size(); a++)
-	  if( ambigwids[a].TPC == fChanTimeToWid[ChanTime].TPC  &&
-	      geom->WireIDsIntersect(ambigwids[a], fChanTimeToWid[ChanTime], widIntersect) ) widDcounts[a]++;
+      if( fHasBeenDisambiged[ChanTime] ){
+	for(size_t a=0; a<ambigsegs.size(); a++)
+	  if( ambigsegs[a].wid.TPC == fChanTimeToWid[ChanTime].TPC  &&
+	      geom->WireIDsIntersect(ambigsegs[a].wid, fChanTimeToWid[ChanTime], widIntersect) ) widDcounts[a]++;
       } else {
 	// still might be able to glean disambiguation
 	// from the ambiguous hits at this time
-      	for(size_t a=0; a<ambigwids.size(); a++)
-	  for(size_t w=0; w<wids.size(); w++)
-	    if( ambigwids[a].TPC == wids[w].TPC  &&
-		geom->WireIDsIntersect(ambigwids[a], wids[w], widIntersect) ) widAcounts[a]++;
+	const std::vector<APAChannelSegment>& segs = fAPAGeo.ChannelSegments(chan);
+      	for(size_t a=0; a<ambigsegs.size(); a++)
+	  for(size_t w=0; w<segs.size(); w++)
+	    if( ambigsegs[a].wid.TPC == segs[w].wid.TPC  &&
+		geom->WireIDsIntersect(ambigsegs[a].wid, segs[w].wid, widIntersect) ) widAcounts[a]++;
       }
     } // end loop through close-time hits
 
@@ -742,7 +806,7 @@ unsigned int DisambigAlg::CompareViews( unsigned int apa )
     for(size_t a=0; a<widAcounts.size(); a++) Acount += widAcounts[a];
     for(size_t d=0; d<widDcounts.size(); d++){
       if( Dcount == widDcounts[d] && Dcount>0 && Acount==0 ){
-	this->MakeDisambigHit(ambighit, ambigwids[d], apa);
+	this->MakeDisambigHit(ambighit, ambigsegs[d].wid, apa);
 	nDisambiguations++;  } }
     for(size_t a=0; a<widAcounts.size(); a++){
       if( Acount == widAcounts[a] && Acount==1 ){
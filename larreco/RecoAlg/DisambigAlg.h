@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <map>
+#include <string>
 
 #include "art/Framework/Principal/Handle.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
@@ -45,12 +46,19 @@ namespace apa{
     void               AssessDisambigSoFar( unsigned int apa );   ///< See how much disambiguation has been done in this apa so far
 
 
-    std::map<unsigned int, double>         fUeffSoFar;
-    std::map<unsigned int, double>         fVeffSoFar;
-    std::map<unsigned int, unsigned int>   fnUSoFar;
-    std::map<unsigned int, unsigned int>   fnVSoFar;
-    std::map<unsigned int, unsigned int>   fnDUSoFar;
-    std::map<unsigned int, unsigned int>   fnDVSoFar;
+    static std::vector<size_t> ChanTimeIndex( std::vector<raw::ChannelID_t> const& channels,
+                                              std::vector<float> const& peakTimes );
+                                                                  ///< For each hit, the first hit with its channel and peak time
+                                                                  ///< (hits on raw::InvalidChannelID are not grouped)
+
+
+    // Disambiguation so far, indexed by APA number
+    std::vector<double>         fUeffSoFar;
+    std::vector<double>         fVeffSoFar;
+    std::vector<unsigned int>   fnUSoFar;
+    std::vector<unsigned int>   fnVSoFar;
+    std::vector<unsigned int>   fnDUSoFar;
+    std::vector<unsigned int>   fnDVSoFar;
 
     std::vector< std::pair<art::Ptr<recob::Hit>, geo::WireID> > fDisambigHits;
                                                                    ///< The final list of hits to pass back to be made
@@ -63,26 +71,35 @@ namespace apa{
     const detinfo::DetectorProperties*           detprop;
     art::ServiceHandle<cheat::BackTrackerService const> bt_serv;                     ///< For *TEMPORARY* monitering of potential problems
 
-    // Hits organization
-    std::map< raw::ChannelID_t, std::vector< art::Ptr< recob::Hit > > > fChannelToHits;
-    std::map< unsigned int, std::vector< art::Ptr< recob::Hit > > >    fAPAToUVHits, fAPAToZHits;
-    std::map< unsigned int, std::vector< art::Ptr< recob::Hit > > >    fAPAToHits;
+    // Hits organization, per channel and per APA number
+    std::vector< art::Ptr< recob::Hit > >                              fChannelHits;
+    std::vector< size_t >                                              fChannelHitsBegin;
+                                                                   ///< UV hits of channel c are fChannelHits[fChannelHitsBegin[c]] to fChannelHits[fChannelHitsBegin[c+1]-1]
+    std::vector< std::vector< art::Ptr< recob::Hit > > >               fAPAToUVHits, fAPAToZHits;
+    std::vector< std::vector< art::Ptr< recob::Hit > > >               fAPAToHits;
                                                                    ///\ todo: Channel/APA to hits can be done in a unified way
-    std::map< unsigned int, std::vector< art::Ptr< recob::Hit > > >    fAPAToEndPHits;
-    std::map< unsigned int, std::vector< std::pair<art::Ptr<recob::Hit>, geo::WireID> > >  fAPAToDHits;
+    std::vector< std::vector< art::Ptr< recob::Hit > > >               fAPAToEndPHits;
+    std::vector< std::vector< std::pair<art::Ptr<recob::Hit>, geo::WireID> > >  fAPAToDHits;
                                                                    ///< Hold the disambiguations per APA
+    std::vector< std::string >                                         fAPASummary;
+                                                                   ///< Disambiguation so far after each step, per APA
 
 
 
-    // data/function to keep track of disambiguation along the way
-    std::map<std::pair<double,double>, geo::WireID>                      fChanTimeToWid;
-                                    ///< If a hit is disambiguated, map its chan and peak time to the chosen wireID
-    std::map< unsigned int, std::map<std::pair<double,double>, bool> >   fHasBeenDisambiged;
-                                    ///< Convenient way to keep track of disambiguation so far
+    // data/function to keep track of disambiguation along the way, indexed by hit key.
+    // Hits with the same channel and peak time share one entry, the one of the first such hit.
+    std::vector< size_t >                                              fChanTimeIndex;
+                                    ///< Index of the entry of each hit
+    std::vector< geo::WireID >                                         fChanTimeToWid;
+                                    ///< If a hit is disambiguated, the chosen wireID
+    std::vector< char >                                                fHasBeenDisambiged;
+                                    ///< Convenient way to keep track of disambiguation so far (char, so APAs can be filled concurrently)
     void          MakeDisambigHit( art::Ptr<recob::Hit> hit,
 				   geo::WireID,
 				    unsigned int apa);
                                     ///< Makes a disambiguated hit while keeping track of what has already been disambiguated
+    void          DisambigAPA( unsigned int apa );
+                                    ///< Runs the configured disambiguation steps in apa
 
 
 
@@ -99,6 +116,7 @@ namespace apa{
     bool         fCrawl;
     bool         fUseEndP;
     bool         fCompareViews;
+    bool         fConcurrentAPAs;   ///< Disambiguate the APAs at the same time
     unsigned int fNChanJumps;       ///< Number of channels the crawl can jump over
     double       fCloseHitsRadius;  ///< Distance (cm) away from a hit to look when checking if it's an endpoint
     double       fMaxEndPDegRange;  ///< Within the close hits radius, how spread can the majority
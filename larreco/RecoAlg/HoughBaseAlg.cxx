@@ -108,8 +108,8 @@ typename cluster::HoughTransformCounters<K, C, S, A, SC>::PairValue_t
     for (size_t index = 0; index < block.size(); ++index) {
       if (block[index] > max.second)
         max = { Base_t::make_const_iterator(iCBlock, index), block[index] };
-      ++iCBlock;
     } // for elements in this block
+    ++iCBlock;
   } // while blocks
   return max;
 } // cluster::HoughTransformCounters<>::get_max(SubCounter_t)
@@ -204,6 +204,201 @@ cluster::HoughTransformCounters<K, C, S, A, SC>::unchecked_add_range_max(
 
 
 
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::Clear(unsigned int numRows)
+{
+  fRows.clear();
+  fRows.resize(numRows);
+  fPool.resize(1); // block 0 stands for "no block"
+  fPeakHeap.clear();
+  fDirtyRows.clear();
+} // cluster::HoughDenseAccumulator::Clear()
+
+
+//------------------------------------------------------------------------------
+int cluster::HoughDenseAccumulator::Get(int row, int col) const
+{
+  Row_t const& rowData = fRows[row];
+  int const iBlock = BlockOf(col) - rowData.firstBlock;
+  if (iBlock < 0 || iBlock >= (int) rowData.blocks.size()) return 0;
+  unsigned int const poolIndex = rowData.blocks[iBlock];
+  if (poolIndex == 0) return 0;
+  return fPool[poolIndex][col - (rowData.firstBlock + iBlock) * kBlockSize];
+} // cluster::HoughDenseAccumulator::Get()
+
+
+//------------------------------------------------------------------------------
+cluster::HoughDenseAccumulator::Counter_t*
+cluster::HoughDenseAccumulator::GetBlock(int row, int col)
+{
+  Row_t& rowData = fRows[row];
+  int const block = BlockOf(col);
+
+  if (rowData.blocks.empty()) {
+    rowData.firstBlock = block;
+    rowData.blocks.assign(1, 0);
+  }
+  else if (block < rowData.firstBlock) {
+    // grow at the front, at least doubling the table
+    int const nOld = rowData.blocks.size();
+    int const nAdd = std::max(rowData.firstBlock - block, nOld);
+    rowData.blocks.insert(rowData.blocks.begin(), nAdd, 0);
+    rowData.firstBlock -= nAdd;
+  }
+  else if (block >= rowData.firstBlock + (int) rowData.blocks.size()) {
+    int const nOld = rowData.blocks.size();
+    int const nAdd = std::max(block - rowData.firstBlock - nOld + 1, nOld);
+    rowData.blocks.resize(nOld + nAdd, 0);
+  }
+
+  unsigned int& poolIndex = rowData.blocks[block - rowData.firstBlock];
+  if (poolIndex == 0) {
+    poolIndex = fPool.size();
+    fPool.emplace_back();
+    fPool.back().fill(0);
+    // the counters of a new block are present with value 0
+    UpdatePeak(row, block * kBlockSize, 0);
+  }
+  return fPool[poolIndex].data();
+} // cluster::HoughDenseAccumulator::GetBlock()
+
+
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::Set(int row, int col, int value)
+{
+  Counter_t& counter = GetBlock(row, col)[col - BlockOf(col) * kBlockSize];
+  Row_t& rowData = fRows[row];
+  counter = value;
+  if (col == rowData.peakCol && counter < rowData.peak) MarkDirty(row);
+  else UpdatePeak(row, col, counter);
+} // cluster::HoughDenseAccumulator::Set()
+
+
+//------------------------------------------------------------------------------
+std::pair<int, int> cluster::HoughDenseAccumulator::Add
+  (int row, int col_begin, int col_end, int delta, int min_max)
+{
+  std::pair<int, int> max { min_max, -1 };
+  Row_t& rowData = fRows[row];
+
+  int col = col_begin;
+  while (col < col_end) {
+    Counter_t* block = GetBlock(row, col);
+    int const blockStart = BlockOf(col) * kBlockSize;
+    int const blockEnd = std::min(col_end, blockStart + kBlockSize);
+    for (; col < blockEnd; ++col) {
+      Counter_t& counter = block[col - blockStart];
+      Counter_t const old = counter;
+      Counter_t const value = (counter += delta);
+      if (value > max.first) max = { value, col };
+      // counters overflow like the ones in HoughTransformCounters
+      if (value > old) UpdatePeak(row, col, value);
+      else if (col == rowData.peakCol) MarkDirty(row);
+    } // for counters in the block
+  } // while
+
+  return max;
+} // cluster::HoughDenseAccumulator::Add()
+
+
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::UpdatePeak(int row, int col, int value)
+{
+  Row_t& rowData = fRows[row];
+  if (rowData.dirty) return; // the row is going to be scanned anyway
+  if (value < rowData.peak) return;
+  if (value == rowData.peak && col >= rowData.peakCol) return;
+  bool const higher = (value > rowData.peak);
+  rowData.peak = value;
+  rowData.peakCol = col;
+  if (higher) PushPeak(row);
+} // cluster::HoughDenseAccumulator::UpdatePeak()
+
+
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::MarkDirty(int row)
+{
+  if (fRows[row].dirty) return;
+  fRows[row].dirty = true;
+  fDirtyRows.push_back(row);
+} // cluster::HoughDenseAccumulator::MarkDirty()
+
+
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::ScanPeak(int row) const
+{
+  Row_t const& rowData = fRows[row];
+  rowData.peak = std::numeric_limits<int>::min();
+  rowData.peakCol = std::numeric_limits<int>::max();
+  rowData.dirty = false;
+  for (size_t iBlock = 0; iBlock < rowData.blocks.size(); ++iBlock) {
+    if (rowData.blocks[iBlock] == 0) continue;
+    Block_t const& block = fPool[rowData.blocks[iBlock]];
+    for (int index = 0; index < kBlockSize; ++index) {
+      if (block[index] <= rowData.peak) continue;
+      rowData.peak = block[index];
+      rowData.peakCol = (rowData.firstBlock + (int) iBlock) * kBlockSize + index;
+    } // for counters in the block
+  } // for blocks
+  PushPeak(row);
+} // cluster::HoughDenseAccumulator::ScanPeak()
+
+
+//------------------------------------------------------------------------------
+namespace {
+  // heap order: largest peak on top, then lowest row
+  bool PeakHeapLess(std::pair<int, int> const& a, std::pair<int, int> const& b)
+    { return (a.first != b.first)? (a.first < b.first): (a.second > b.second); }
+} // local namespace
+
+void cluster::HoughDenseAccumulator::PushPeak(int row) const
+{
+  // the entries of old peaks are dropped only when they reach the top;
+  // when they pile up, start again from one entry per row
+  if (fPeakHeap.size() >= 2 * fRows.size()) {
+    RebuildPeakHeap();
+    return;
+  }
+  fPeakHeap.emplace_back(fRows[row].peak, row);
+  std::push_heap(fPeakHeap.begin(), fPeakHeap.end(), PeakHeapLess);
+} // cluster::HoughDenseAccumulator::PushPeak()
+
+
+//------------------------------------------------------------------------------
+void cluster::HoughDenseAccumulator::RebuildPeakHeap() const
+{
+  fPeakHeap.clear();
+  for (size_t row = 0; row < fRows.size(); ++row) {
+    Row_t const& rowData = fRows[row];
+    // dirty rows are added when they are scanned
+    if (rowData.dirty || rowData.blocks.empty()) continue;
+    fPeakHeap.emplace_back(rowData.peak, (int) row);
+  } // for rows
+  std::make_heap(fPeakHeap.begin(), fPeakHeap.end(), PeakHeapLess);
+} // cluster::HoughDenseAccumulator::RebuildPeakHeap()
+
+
+//------------------------------------------------------------------------------
+int cluster::HoughDenseAccumulator::GetMax(int& row, int& col) const
+{
+  for (int dirtyRow: fDirtyRows) ScanPeak(dirtyRow);
+  fDirtyRows.clear();
+
+  // drop the entries of peaks that have changed since they were pushed
+  while (!fPeakHeap.empty()) {
+    std::pair<int, int> const& top = fPeakHeap.front();
+    if (fRows[top.second].peak == top.first) break;
+    std::pop_heap(fPeakHeap.begin(), fPeakHeap.end(), PeakHeapLess);
+    fPeakHeap.pop_back();
+  } // while
+
+  if (fPeakHeap.empty() || fPeakHeap.front().first < 0) return -1;
+  row = fPeakHeap.front().second;
+  col = fRows[row].peakCol;
+  return fPeakHeap.front().first;
+} // cluster::HoughDenseAccumulator::GetMax()
+
+
 //------------------------------------------------------------------------------
 cluster::HoughBaseAlg::HoughBaseAlg(fhicl::ParameterSet const& pset)
 {
@@ -231,11 +426,13 @@ void cluster::HoughBaseAlg::reconfigure(fhicl::ParameterSet const& pset)
   fMissedHits                     = pset.get< int    >("MissedHits"                     );
   fMissedHitsDistance             = pset.get< float  >("MissedHitsDistance"             );
   fMissedHitsToLineSize           = pset.get< float  >("MissedHitsToLineSize"           );
+  fDenseAccumulator               = pset.get< bool   >("DenseAccumulator",           false);
   return;
 }
 
 //------------------------------------------------------------------------------
 cluster::HoughTransform::HoughTransform()
+  : m_denseAccum(false)
 {
   //m_accum=NULL;
 }
@@ -372,7 +569,7 @@ size_t cluster::HoughBaseAlg::Transform(
 
   ///Init specifies the size of the two-dimensional accumulator
   ///(based on the arguments, number of wires and number of time samples).
-  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells);
+  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells,fDenseAccumulator);
   /// Adds all of the hits to the accumulator
   //mf::LogInfo("HoughBaseAlg") << "Beginning PPHT";
 
@@ -785,15 +982,15 @@ cluster::HoughTransform::~HoughTransform()
 
 
 //------------------------------------------------------------------------------
-inline int cluster::HoughTransform::GetCell(int row, int col) const {
-  return m_accum[row][col];
+int cluster::HoughTransform::GetCell(int row, int col) const {
+  return m_denseAccum? m_dense.Get(row, col): m_accum[row][col];
 } // cluster::HoughTransform::GetCell()
 
 
 //------------------------------------------------------------------------------
 // returns a vector<int> where the first is the overall maximum,
 // the second is the max x value, and the third is the max y value.
-inline std::array<int, 3> cluster::HoughTransform::AddPointReturnMax(int x, int y)
+std::array<int, 3> cluster::HoughTransform::AddPointReturnMax(int x, int y)
 {
   if ((x > (int) m_dx) || (y > (int) m_dy) || x<0.0 || y<0.0) {
     std::array<int, 3> max;
@@ -806,7 +1003,7 @@ inline std::array<int, 3> cluster::HoughTransform::AddPointReturnMax(int x, int
 
 
 //------------------------------------------------------------------------------
-inline bool cluster::HoughTransform::SubtractPoint(int x, int y)
+bool cluster::HoughTransform::SubtractPoint(int x, int y)
 {
   if ((x > (int) m_dx) || (y > (int) m_dy) || x<0.0 || y<0.0)
     return false;
@@ -819,10 +1016,12 @@ inline bool cluster::HoughTransform::SubtractPoint(int x, int y)
 void cluster::HoughTransform::Init(unsigned int dx,
                                    unsigned int dy,
                                    float rhores,
-                                   unsigned int numACells)
+                                   unsigned int numACells,
+                                   bool denseAccum /* = false */)
 {
   m_numAngleCells=numACells;
   m_rhoResolutionFactor = rhores;
+  m_denseAccum = denseAccum;
 
   m_accum.clear();
   //--- BEGIN issue #19494 -----------------------------------------------------
@@ -857,7 +1056,8 @@ void cluster::HoughTransform::Init(unsigned int dx,
   m_dx = dx;
   m_dy = dy;
   m_rowLength = (unsigned int)(m_rhoResolutionFactor*2 * std::sqrt(dx*dx + dy*dy));
-  m_accum.resize(m_numAngleCells);
+  if (m_denseAccum) m_dense.Clear(m_numAngleCells);
+  else              m_accum.resize(m_numAngleCells);
   //for(int i = 0; i < m_numAngleCells; i++)
     //m_accum[i].resize((unsigned int)(m_rowLength));
 
@@ -884,6 +1084,8 @@ void cluster::HoughTransform::GetEquation
 //------------------------------------------------------------------------------
 int cluster::HoughTransform::GetMax(int &xmax, int &ymax) const
 {
+  if (m_denseAccum) return m_dense.GetMax(xmax, ymax);
+
   int maxVal = -1;
   for(unsigned int i = 0; i < m_accum.size(); i++){
 
@@ -918,6 +1120,43 @@ std::array<int, 3> cluster::HoughTransform::DoAddPointReturnMax
   // lastDist represents next distance to be incremented (but see below)
   int lastDist = (int)(distCenter + (m_rhoResolutionFactor*x));
 
+  if (m_denseAccum) {
+    // Distances at all the angles first; this loop has no dependence between
+    // iterations and is vectorized. The math is the same as below.
+    m_distances.resize(m_numAngleCells);
+    int* distances = m_distances.data();
+    double const* cosTable = m_cosTable.data();
+    double const* sinTable = m_sinTable.data();
+    float const rhoRes = m_rhoResolutionFactor;
+    for (size_t iAngleStep = 1; iAngleStep < m_numAngleCells; ++iAngleStep) {
+      distances[iAngleStep] = (int) (distCenter + rhoRes
+        * (cosTable[iAngleStep]*x + sinTable[iAngleStep]*y)
+        );
+    }
+
+    // then the votes, with the same ranges as below
+    int const delta = bSubtract? -1: +1;
+    for (size_t iAngleStep = 1; iAngleStep < m_numAngleCells; ++iAngleStep) {
+      const int dist = distances[iAngleStep];
+      int first_dist = dist, end_dist = dist + 1;
+      if (lastDist != dist) {
+        first_dist = dist > lastDist? lastDist: dist + 1;
+        end_dist   = dist > lastDist? dist: lastDist + 1;
+      }
+      std::pair<int, int> const max_counter
+        = m_dense.Add(iAngleStep, first_dist, end_dist, delta, max_val);
+      if (!bSubtract && max_counter.first > max_val) {
+        max = {{ max_counter.first, max_counter.second, (int) iAngleStep }};
+        max_val = max_counter.first;
+      }
+      lastDist = dist;
+    } // for angles
+
+    if (bSubtract) --m_numAccumulated;
+    else           ++m_numAccumulated;
+    return max;
+  } // if dense accumulator
+
 
   // loop through all angles a from 0 to 180 degrees
   // (the value of the angle is established in definition of m_cosTable and
@@ -1138,7 +1377,7 @@ size_t cluster::HoughBaseAlg::FastTransform(const std::vector<art::Ptr<recob::Cl
       //Init specifies the size of the two-dimensional accumulator
       //(based on the arguments, number of wires and number of time samples).
       //adds all of the hits (that have not yet been associated with a line) to the accumulator
-      c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells);
+      c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells,fDenseAccumulator);
 
 
       // count is how many points are left to randomly insert
@@ -1556,7 +1795,7 @@ size_t cluster::HoughBaseAlg::FastTransform(std::vector<art::Ptr<recob::Hit>> co
   //Init specifies the size of the two-dimensional accumulator
   //(based on the arguments, number of wires and number of time samples).
   //adds all of the hits (that have not yet been associated with a line) to the accumulator
-  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells);
+  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells,fDenseAccumulator);
 
   // count is how many points are left to randomly insert
   unsigned int count = hit.size();
@@ -1873,7 +2112,7 @@ size_t cluster::HoughBaseAlg::Transform(std::vector< art::Ptr<recob::Hit> > cons
   int dx = geom->Nwires(0);               //number of wires
   const int dy = detprop->ReadOutWindowSize(); // number of time samples.
 
-  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells);
+  c.Init(dx,dy,fRhoResolutionFactor,fNumAngleCells,fDenseAccumulator);
 
   for(unsigned int i=0;i < hits.size(); ++i){
     c.AddPointReturnMax(hits[i]->WireID().Wire, (int)(hits[i]->PeakTime()));
@@ -128,6 +128,7 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <limits>
 #include <utility> // std::pair<>
 
 #include "canvas/Persistency/Common/Ptr.h"
@@ -475,6 +476,108 @@ namespace cluster {
   }; // class HoughTransformCounters
 
 
+  /**
+   * @brief Hough accumulator with directly addressed blocks of counters
+   *
+   * Each row (angle) has a table of blocks of kBlockSize counters, indexed by
+   * the distance divided by the block size. The table grows on demand at
+   * either end, so finding a counter is an index computation instead of a
+   * tree look up. Blocks are taken from a pool shared by all the rows and
+   * they are released only by Clear().
+   *
+   * The largest counter of each row ("peak") is updated on each increase.
+   * A row whose peak is decreased is marked and scanned again only when the
+   * largest counter of the whole accumulator is requested; the peaks of the
+   * rows are kept in a max-heap, so that request does not scan all rows.
+   * Entries of old peaks are left in the heap until they reach its top; the
+   * heap is filled again from the rows when it holds twice as many entries.
+   *
+   * Counters are of the same type as the ones in HoughTransformCounters and
+   * behave the same way, including that the counters of a block that was
+   * created count as present with value 0.
+   */
+  class HoughDenseAccumulator {
+      public:
+
+    using Counter_t = signed char;
+    static constexpr int kBlockSize = 64;
+
+    /// Removes all the counters and sets the number of rows
+    void Clear(unsigned int numRows);
+
+    /// Returns the value of the counter (0 if never set)
+    int Get(int row, int col) const;
+
+    /// Sets the value of a counter
+    void Set(int row, int col, int value);
+
+    /**
+     * @brief Adds delta to the counters [ col_begin, col_end [ of a row
+     * @param min_max only counters larger than this are considered as maximum
+     * @return pair of the largest new value and the lowest column with it
+     *
+     * If no counter ends larger than min_max, the returned value is min_max
+     * and the column is -1.
+     */
+    std::pair<int, int> Add
+      (int row, int col_begin, int col_end, int delta, int min_max);
+
+    /**
+     * @brief Returns the largest counter in the accumulator
+     * @param row (output) row of the counter
+     * @param col (output) column of the counter
+     * @return the value of the counter, -1 if all counters are negative
+     *
+     * Among equal counters, the one with the lowest row and then lowest
+     * column is returned. row and col are not changed if -1 is returned.
+     */
+    int GetMax(int& row, int& col) const;
+
+      private:
+
+    using Block_t = std::array<Counter_t, kBlockSize>;
+
+    struct Row_t {
+      int firstBlock = 0;               ///< block number of blocks[0]
+      std::vector<unsigned int> blocks; ///< index in fPool (0: no block)
+      // the peak is updated also when the maximum is requested
+      mutable int peak = std::numeric_limits<int>::min(); ///< largest counter
+      mutable int peakCol = std::numeric_limits<int>::max(); ///< its column
+      mutable bool dirty = false;       ///< peak needs to be found again
+    }; // Row_t
+
+    /// Returns the number of the block with the column
+    static int BlockOf(int col)
+      { return (col >= 0)? col / kBlockSize: (col + 1) / kBlockSize - 1; }
+
+    std::vector<Row_t> fRows;
+    std::vector<Block_t> fPool;  ///< blocks; the first one is not used
+
+    /// (peak, row) of the rows, in a heap with the largest peak on top
+    mutable std::vector<std::pair<int, int>> fPeakHeap;
+    mutable std::vector<int> fDirtyRows;
+
+    /// Returns the block with the column, creating it if needed
+    Counter_t* GetBlock(int row, int col);
+
+    /// Updates the peak of a row after a counter changed to value
+    void UpdatePeak(int row, int col, int value);
+
+    /// Marks the row peak as to be found again
+    void MarkDirty(int row);
+
+    /// Finds the peak of the row again
+    void ScanPeak(int row) const;
+
+    /// Adds the row peak to the heap
+    void PushPeak(int row) const;
+
+    /// Fills the heap again with the current peak of each row
+    void RebuildPeakHeap() const;
+
+  }; // class HoughDenseAccumulator
+
+
 #define FC_DEVELOP 0
 
   class HoughTransform {
@@ -483,15 +586,21 @@ namespace cluster {
     HoughTransform();
     ~HoughTransform();
 
-    void Init
-      (unsigned int dx, unsigned int dy, float rhores, unsigned int numACells);
+    /// Sets the accumulator size; denseAccum selects HoughDenseAccumulator
+    /// instead of the HoughTransformCounters maps
+    void Init(unsigned int dx, unsigned int dy, float rhores,
+      unsigned int numACells, bool denseAccum = false);
     std::array<int,3> AddPointReturnMax(int x, int y);
     bool SubtractPoint(int x, int y);
     int  GetCell(int row, int col) const;
-    void SetCell(int row, int col, int value) { m_accum[row].set(col, value); }
+    void SetCell(int row, int col, int value)
+    {
+      if (m_denseAccum) m_dense.Set(row, col, value);
+      else              m_accum[row].set(col, value);
+    }
     void GetAccumSize(int &numRows, int &numCols)
     {
-      numRows = m_accum.size();
+      numRows = m_numAngleCells;
       numCols  = (int) m_rowLength;
     }
     int NumAccumulated()                      { return m_numAccumulated; }
@@ -533,9 +642,12 @@ namespace cluster {
     // the vector elements are called by rho, theta is the container key,
     // the number of hits is the value corresponding to the key
     HoughImage_t m_accum;  ///< column (map key)=rho, row (vector index)=theta
+    bool m_denseAccum;     ///< whether m_dense is used instead of m_accum
+    HoughDenseAccumulator m_dense; ///< column=rho, row=theta
     int m_numAccumulated;
     std::vector<double> m_cosTable;
     std::vector<double> m_sinTable;
+    std::vector<int> m_distances; ///< distance at each angle for the last point
 
     std::array<int,3> DoAddPointReturnMax(int x, int y, bool bSubtract = false);
 
@@ -632,6 +744,7 @@ namespace cluster {
                                            ///< segments
     float  fMissedHitsDistance;            ///< Distance between hits in a hough line before a hit is considered missed
     float  fMissedHitsToLineSize;          ///< Ratio of missed hits to line size for a line to be considered a fake
+    bool   fDenseAccumulator;              ///< Use HoughDenseAccumulator rather than maps of counters
 
   protected:
 
@@ -19,9 +19,13 @@ namespace geo { class GeometryCore; }
 
 #include "CLHEP/Random/RandGauss.h"
 
+#include "tbb/tbb.h"
+
+#include <algorithm>
+
 img::DataProviderAlg::DataProviderAlg(const Config& config) :
 	fCryo(9999), fTPC(9999), fPlane(9999),
-	fNWires(0), fNDrifts(0), fNScaledDrifts(0), fNCachedDrifts(0),
+	fNWires(0), fNDrifts(0), fNScaledDrifts(0), fNCachedDrifts(0), fDriftStride(0),
 	fDownscaleMode(img::DataProviderAlg::kMax), fDriftWindow(10),
 	fCalorimetryAlg(config.CalorimetryAlg()),
 	fGeometry( &*(art::ServiceHandle<geo::Geometry const>()) ),
@@ -57,6 +61,7 @@ img::DataProviderAlg::DataProviderAlg(const Config& config) :
 	fDriftWindow = config.DriftWindow();
 	fDownscaleFullView = config.DownscaleFullView();
 	fDriftWindowInv = 1.0 / fDriftWindow;
+	fConcurrentWires = config.ConcurrentWires();
 
 	std::string mode_str = config.DownscaleFn();
 	mf::LogVerbatim("DataProviderAlg") << "Downscale mode is: " << mode_str;
@@ -102,6 +107,21 @@ img::DataProviderAlg::~DataProviderAlg(void)
 }
 // ------------------------------------------------------
 
+std::vector<float> const & img::DataProviderAlg::wireData(size_t widx) const
+{
+    std::lock_guard<std::mutex> lock(fWireDataCopies.mutex);
+
+    if (fWireDataCopies.wires.size() != fNWires) { fWireDataCopies.wires.resize(fNWires); } // algorithm was copied
+    auto & copy = fWireDataCopies.wires[widx];
+    if (copy.size() != fNCachedDrifts)
+    {
+        auto const row = wireRow(widx);
+        copy.assign(row.begin(), row.end());
+    }
+    return copy;
+}
+// ------------------------------------------------------
+
 void img::DataProviderAlg::resizeView(size_t wires, size_t drifts)
 {
     fNWires = wires; fNDrifts = drifts;
@@ -113,12 +133,9 @@ void img::DataProviderAlg::resizeView(size_t wires, size_t drifts)
     fWireChannels.resize(wires);
     std::fill(fWireChannels.begin(), fWireChannels.end(), raw::InvalidChannelID);
 
-    fWireDriftData.resize(wires);
-    for (auto & w : fWireDriftData)
-    {
-    	w.resize(fNCachedDrifts);
-    	std::fill(w.begin(), w.end(), fAdcZero);
-    }
+    fDriftStride = (fNCachedDrifts + 15) & ~size_t(15); // each wire starts at 64 bytes boundary
+    fWireDriftData.assign(wires * fDriftStride, fAdcZero);
+    fWireDataCopies.wires.assign(wires, std::vector<float>());
 
     fLifetimeCorrFactors.resize(fNDrifts);
     if (fCalibrateLifetime)
@@ -147,7 +164,7 @@ float img::DataProviderAlg::poolMax(int wire, int drift, size_t r) const
     float adc, max_adc = 0;
     for (int w = w0; w <= w1; ++w)
     {
-        auto const * col = fWireDriftData[w].data();
+        auto const * col = wireDataPtr(w);
         for (int d = d0; d <= d1; ++d)
         {
             adc = col[d]; if (adc > max_adc) { max_adc = adc; }
@@ -173,7 +190,7 @@ float img::DataProviderAlg::poolSum(int wire, int drift, size_t r) const
     float sum = 0;
     for (int w = w0; w <= w1; ++w)
     {
-        auto const * col = fWireDriftData[w].data();
+        auto const * col = wireDataPtr(w);
         for (int d = d0; d <= d1; ++d) { sum += col[d]; }
     }
 
@@ -181,84 +198,136 @@ float img::DataProviderAlg::poolSum(int wire, int drift, size_t r) const
 }
 // ------------------------------------------------------
 
-void img::DataProviderAlg::downscaleMax(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const
+// Windows which fit in the lifetime correction table are reduced with plain pointers, without bound
+// checks; windows reaching beyond the table (patches at the end of the drift) are done separately, with
+// the last correction factor. Each window is scanned sample by sample, so the results do not change.
+// Reducing all windows together, one sample of each window at a time, vectorizes but is slower due to
+// the strided loads.
+void img::DataProviderAlg::downscaleMax(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const
 {
-        size_t kStop = dst.size();
-        if (adc.size() < kStop) { kStop = adc.size(); }
-	for (size_t i = 0, k0 = 0; i < kStop; ++i, k0 += fDriftWindow)
+	const size_t win = fDriftWindow;
+	const size_t nwin = std::min(ndst, nadc / win);
+	const size_t ncorr = (tick0 < fLifetimeCorrFactors.size()) ? fLifetimeCorrFactors.size() - tick0 : 0;
+	const size_t nfast = std::min(nwin, ncorr / win);
+
+	float * __restrict out = dst;
+	const float * __restrict a = adc;
+	const float * __restrict c = fLifetimeCorrFactors.data() + std::min(tick0, fLifetimeCorrFactors.size());
+
+	for (size_t i = 0, k0 = 0; i < nfast; ++i, k0 += win)
 	{
-		size_t k1 = k0 + fDriftWindow;
+		float max_adc = a[k0] * c[k0];
+		for (size_t k = k0 + 1; k < k0 + win; ++k)
+		{
+			float ak = a[k] * c[k];
+			max_adc = (ak > max_adc) ? ak : max_adc;
+		}
+		out[i] = max_adc;
+	}
 
-		float max_adc = adc[k0] * fLifetimeCorrFactors[k0 + tick0];
-		for (size_t k = k0 + 1; k < k1; ++k)
+	for (size_t i = nfast, k0 = nfast * win; i < nwin; ++i, k0 += win)
+	{
+		float max_adc = adc[k0] * lifetimeCorrFactor(k0 + tick0);
+		for (size_t k = k0 + 1; k < k0 + win; ++k)
 		{
-			float ak = adc[k] * fLifetimeCorrFactors[k + tick0];
+			float ak = adc[k] * lifetimeCorrFactor(k + tick0);
 			if (ak > max_adc) max_adc = ak;
 		}
-
 		dst[i] = max_adc;
 	}
-	scaleAdcSamples(dst);
+	scaleAdcSamples(dst, ndst);
 }
 
-void img::DataProviderAlg::downscaleMaxMean(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const
+void img::DataProviderAlg::downscaleMaxMean(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const
 {
-        size_t kStop = dst.size();
-        if (adc.size() < kStop) { kStop = adc.size(); }
-	for (size_t i = 0, k0 = 0; i < kStop; ++i, k0 += fDriftWindow)
+	const size_t win = fDriftWindow;
+	const size_t nwin = std::min(ndst, nadc / win);
+	const size_t ncorr = (tick0 < fLifetimeCorrFactors.size()) ? fLifetimeCorrFactors.size() - tick0 : 0;
+	const size_t nfast = std::min(nwin, ncorr / win);
+
+	const float * __restrict a = adc;
+	const float * __restrict c = fLifetimeCorrFactors.data() + std::min(tick0, fLifetimeCorrFactors.size());
+
+	for (size_t i = 0, k0 = 0; i < nwin; ++i, k0 += win)
 	{
-		size_t k1 = k0 + fDriftWindow;
+		size_t k1 = k0 + win;
 
 		size_t max_idx = k0;
-		float max_adc = adc[k0] * fLifetimeCorrFactors[k0 + tick0];
-		for (size_t k = k0 + 1; k < k1; ++k)
+		float max_adc;
+		if (i < nfast)
 		{
-			float ak = adc[k] * fLifetimeCorrFactors[k + tick0];
-			if (ak > max_adc) { max_adc = ak; max_idx = k; }
+			max_adc = a[k0] * c[k0];
+			for (size_t k = k0 + 1; k < k1; ++k)
+			{
+				float ak = a[k] * c[k];
+				if (ak > max_adc) { max_adc = ak; max_idx = k; }
+			}
+		}
+		else
+		{
+			max_adc = adc[k0] * lifetimeCorrFactor(k0 + tick0);
+			for (size_t k = k0 + 1; k < k1; ++k)
+			{
+				float ak = adc[k] * lifetimeCorrFactor(k + tick0);
+				if (ak > max_adc) { max_adc = ak; max_idx = k; }
+			}
 		}
 
 		size_t n = 1;
-		if (max_idx > 0) { max_adc += adc[max_idx - 1] * fLifetimeCorrFactors[max_idx - 1 + tick0]; n++; }
-		if (max_idx + 1 < adc.size()) { max_adc += adc[max_idx + 1] * fLifetimeCorrFactors[max_idx + 1 + tick0]; n++; }
+		if (max_idx > 0) { max_adc += adc[max_idx - 1] * lifetimeCorrFactor(max_idx - 1 + tick0); n++; }
+		if (max_idx + 1 < nadc) { max_adc += adc[max_idx + 1] * lifetimeCorrFactor(max_idx + 1 + tick0); n++; }
 
 		dst[i] = max_adc / n;
 	}
-	scaleAdcSamples(dst);
+	scaleAdcSamples(dst, ndst);
 }
 
-void img::DataProviderAlg::downscaleMean(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const
+void img::DataProviderAlg::downscaleMean(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const
 {
-	size_t kStop = dst.size();
-	if (adc.size() < kStop) { kStop = adc.size(); }
-	for (size_t i = 0, k0 = 0; i < kStop; ++i, k0 += fDriftWindow)
+	const size_t win = fDriftWindow;
+	const size_t nwin = std::min(ndst, nadc / win);
+	const size_t ncorr = (tick0 < fLifetimeCorrFactors.size()) ? fLifetimeCorrFactors.size() - tick0 : 0;
+	const size_t nfast = std::min(nwin, ncorr / win);
+
+	float * __restrict out = dst;
+	const float * __restrict a = adc;
+	const float * __restrict c = fLifetimeCorrFactors.data() + std::min(tick0, fLifetimeCorrFactors.size());
+	const float winInv = fDriftWindowInv;
+
+	for (size_t i = 0, k0 = 0; i < nfast; ++i, k0 += win)
 	{
-		size_t k1 = k0 + fDriftWindow;
+		float sum_adc = 0;
+		for (size_t k = k0; k < k0 + win; ++k) { sum_adc += a[k] * c[k]; }
+		out[i] = sum_adc * winInv;
+	}
 
+	for (size_t i = nfast, k0 = nfast * win; i < nwin; ++i, k0 += win)
+	{
 		float sum_adc = 0;
-		for (size_t k = k0; k < k1; ++k)
+		for (size_t k = k0; k < k0 + win; ++k)
 		{
-                  if ( k + tick0 < fLifetimeCorrFactors.size()) sum_adc += adc[k] * fLifetimeCorrFactors[k + tick0];
+			if (k + tick0 < fLifetimeCorrFactors.size()) sum_adc += adc[k] * fLifetimeCorrFactors[k + tick0];
 		}
-        dst[i] = sum_adc * fDriftWindowInv;
+		dst[i] = sum_adc * fDriftWindowInv;
 	}
-	scaleAdcSamples(dst);
+	scaleAdcSamples(dst, ndst);
 }
 
 bool img::DataProviderAlg::setWireData(std::vector<float> const & adc, size_t wireIdx)
 {
-   	if (wireIdx >= fWireDriftData.size()) return false;
-   	auto & wData = fWireDriftData[wireIdx];
+   	if (wireIdx >= fNWires) return false;
+   	float* wData = wireDataPtr(wireIdx);
 
     if (fDownscaleFullView)
     {
-        if (!adc.empty()) { downscale(wData, adc, 0); }
+        if (!adc.empty()) { downscale(wData, fNCachedDrifts, adc.data(), adc.size(), 0); }
         else { return false; }
     }
     else
     {
         if (adc.empty()) { return false; }
-        else if (adc.size() <= wData.size()) { std::copy(adc.begin(), adc.end(), wData.begin()); }
-        else { std::copy(adc.begin(), adc.begin()+wData.size(), wData.begin()); }
+        else if (adc.size() <= fNCachedDrifts) { std::copy(adc.begin(), adc.end(), wData); }
+        else { std::copy(adc.begin(), adc.begin()+fNCachedDrifts, wData); }
     }
     return true;
 }
@@ -282,11 +351,17 @@ bool img::DataProviderAlg::setWireDriftData(const std::vector<recob::Wire> & wir
 
     auto const & channelStatus = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
 
-    bool allWrong = true;
-    for (auto const & wire : wires)
+    // Each wire is written to its own row of the image, so wires can be filled at the same time. Sums
+    // over the threshold are made per wire and then added in the order of wires; samples are >= 10 ADC
+    // so these double precision sums are exact and do not depend on the order anyway.
+    std::vector<double> wireAdcSum(wires.size(), 0);
+    std::vector<size_t> wireAdcArea(wires.size(), 0);
+    std::vector<char> wireSet(wires.size(), 0);
+    auto fillWire = [&](size_t i)
 	{
+		auto const & wire = wires[i];
 		auto wireChannelNumber = wire.Channel();
-		if (!channelStatus.IsGood(wireChannelNumber)) { continue; }
+		if (!channelStatus.IsGood(wireChannelNumber)) { return; }
 
 		size_t w_idx = 0;
 		for (auto const& id : fGeometry->ChannelToWire(wireChannelNumber))
@@ -308,13 +383,24 @@ bool img::DataProviderAlg::setWireDriftData(const std::vector<recob::Wire> & wir
 			    	continue; // also not critical, try to set other wires
 			    }
 
-                for (auto v : adc) { if (v >= fAdcSumThr) { fAdcSumOverThr += v; fAdcAreaOverThr++; } }
+                for (auto v : adc) { if (v >= fAdcSumThr) { wireAdcSum[i] += v; wireAdcArea[i]++; } }
 
 			    fWireChannels[w_idx] = wireChannelNumber;
-			    allWrong = false;
+			    wireSet[i] = 1;
 			}
 		}
-	}
+	};
+
+    if (fConcurrentWires) { tbb::parallel_for(static_cast<size_t>(0), wires.size(), fillWire); }
+    else { for (size_t i = 0; i < wires.size(); ++i) { fillWire(i); } }
+
+    bool allWrong = true;
+    for (size_t i = 0; i < wires.size(); ++i)
+    {
+        fAdcSumOverThr += wireAdcSum[i];
+        fAdcAreaOverThr += wireAdcArea[i];
+        if (wireSet[i]) { allWrong = false; }
+    }
 	if (allWrong)
 	{
 	    mf::LogError("DataProviderAlg") << "Wires data not set in the cryo:"
@@ -340,37 +426,19 @@ float img::DataProviderAlg::scaleAdcSample(float val) const
     return fAdcOffset + fAdcScale * (val - fAdcMin);  // shift and scale to the output range, shift to the output min
 }
 // ------------------------------------------------------
-void img::DataProviderAlg::scaleAdcSamples(std::vector< float > & values) const
+void img::DataProviderAlg::scaleAdcSamples(float* values, size_t size) const
 {
-    float calib = fAmplCalibConst[fPlane];
-    auto * data = values.data();
+    const float calib = fAmplCalibConst[fPlane];
+    const float adcMin = fAdcMin, adcMax = fAdcMax, offset = fAdcOffset, scale = fAdcScale;
+    float * __restrict data = values;
 
-    size_t k = 0, size4 = values.size() >> 2, size = values.size();
-    for (size_t i = 0; i < size4; ++i) // vectorize if you can
+    for (size_t k = 0; k < size; ++k) // saturation written with selects, so it vectorizes
     {
-        data[k] *= calib;  // prescale by plane-to-plane calibration factors
-        data[k+1] *= calib;
-        data[k+2] *= calib;
-        data[k+3] *= calib;
-
-        if (data[k] < fAdcMin) { data[k] = fAdcMin; }  // saturate min
-        if (data[k+1] < fAdcMin) { data[k+1] = fAdcMin; }
-        if (data[k+2] < fAdcMin) { data[k+2] = fAdcMin; }
-        if (data[k+3] < fAdcMin) { data[k+3] = fAdcMin; }
-
-        if (data[k] > fAdcMax) { data[k] = fAdcMax; }  // saturate max
-        if (data[k+1] > fAdcMax) { data[k+1] = fAdcMax; }
-        if (data[k+2] > fAdcMax) { data[k+2] = fAdcMax; }
-        if (data[k+3] > fAdcMax) { data[k+3] = fAdcMax; }
-
-        data[k] = fAdcOffset + fAdcScale * (data[k] - fAdcMin);  // shift and scale to the output range, shift to the output min
-        data[k+1] = fAdcOffset + fAdcScale * (data[k+1] - fAdcMin);
-        data[k+2] = fAdcOffset + fAdcScale * (data[k+2] - fAdcMin);
-        data[k+3] = fAdcOffset + fAdcScale * (data[k+3] - fAdcMin);
-
-        k += 4;
+        float v = data[k] * calib;         // prescale by plane-to-plane calibration factors
+        v = (v < adcMin) ? adcMin : v;     // saturate min
+        v = (v > adcMax) ? adcMax : v;     // saturate max
+        data[k] = offset + scale * (v - adcMin);  // shift and scale to the output range, shift to the output min
     }
-    while (k < size) { data[k] = scaleAdcSample(data[k]); ++k; }  // do the tail
 }
 // ------------------------------------------------------
 
@@ -380,19 +448,17 @@ void img::DataProviderAlg::applyBlur()
 
     size_t margin_left = (fBlurKernel.size()-1) >> 1, margin_right = fBlurKernel.size() - margin_left - 1;
 
-    std::vector< std::vector<float> > src(fWireDriftData.size());
-    for (size_t w = 0; w < fWireDriftData.size(); ++w) { src[w] = fWireDriftData[w]; }
+    auto const src = fWireDriftData;
 
-    for (size_t w = margin_left; w < fWireDriftData.size() - margin_right; ++w)
+    for (size_t w = margin_left; w + margin_right < fNWires; ++w)
     {
-        for (size_t d = 0; d < fWireDriftData[w].size(); ++d)
+        float * __restrict dst = wireDataPtr(w);
+        std::fill(dst, dst + fNCachedDrifts, 0.0F);
+        for (size_t i = 0; i < fBlurKernel.size(); ++i) // same order of the sum for each pixel, along the drift
         {
-            float sum = 0;
-            for (size_t i = 0; i < fBlurKernel.size(); ++i)
-            {
-                sum += fBlurKernel[i] * src[w + i - margin_left][d];
-            }
-            fWireDriftData[w][d] = sum;
+            const float k = fBlurKernel[i];
+            const float * __restrict s = src.data() + (w + i - margin_left) * fDriftStride;
+            for (size_t d = 0; d < fNCachedDrifts; ++d) { dst[d] += k * s[d]; }
         }
     }
 }
@@ -412,25 +478,18 @@ bool img::DataProviderAlg::patchFromDownsampledView(size_t wire, float drift, si
 	int d0 = sd - halfSizeD;
 	int d1 = sd + halfSizeD;
 
-	int wsize = fWireDriftData.size();
+	int wsize = fNWires;
+	int dsize = fNCachedDrifts;
+	int ds0 = std::max(d0, 0), ds1 = std::min(d1, dsize); // drift range of the patch inside the view
 	for (int w = w0, wpatch = 0; w < w1; ++w, ++wpatch)
 	{
 		auto & dst = patch[wpatch];
-		if ((w >= 0) && (w < wsize))
+		if ((w >= 0) && (w < wsize) && (ds0 < ds1))
 		{
-			auto & src = fWireDriftData[w];
-			int dsize = src.size();
-			for (int d = d0, dpatch = 0; d < d1; ++d, ++dpatch)
-			{
-				if ((d >= 0) && (d < dsize))
-				{
-					dst[dpatch] = src[d];
-				}
-				else
-				{
-					dst[dpatch] = fAdcZero;
-				}
-			}
+			const float* src = wireDataPtr(w);
+			std::fill(dst.begin(), dst.begin() + (ds0 - d0), fAdcZero);
+			std::copy(src + ds0, src + ds1, dst.begin() + (ds0 - d0));
+			std::fill(dst.begin() + (ds1 - d0), dst.begin() + (d1 - d0), fAdcZero);
 		}
 		else
 		{
@@ -457,13 +516,13 @@ bool img::DataProviderAlg::patchFromOriginalView(size_t wire, float drift, size_
         if (d0<0) d0 = 0;
 
 	std::vector<float> tmp(dsize);
-	int wsize = fWireDriftData.size();
+	int wsize = fNWires;
 	for (int w = w0, wpatch = 0; w < w1; ++w, ++wpatch)
 	{
 		if ((w >= 0) && (w < wsize))
 		{
-			auto & src = fWireDriftData[w];
-			int src_size = src.size();
+			const float* src = wireDataPtr(w);
+			int src_size = fNCachedDrifts;
 			for (int d = d0, dpatch = 0; d < d1; ++d, ++dpatch)
 			{
 				if ((d >= 0) && (d < src_size))
@@ -486,6 +545,20 @@ bool img::DataProviderAlg::patchFromOriginalView(size_t wire, float drift, size_
 
 	return true;
 }
+
+bool img::DataProviderAlg::getPatchView(size_t wire, float drift, size_t patchSizeW, size_t patchSizeD,
+	img::ImageView & patch) const
+{
+	if (!fDownscaleFullView) { return false; }
+
+	int w0 = wire - patchSizeW / 2;                                    // same corner as in patchFromDownsampledView
+	int d0 = (size_t)(drift / fDriftWindow) - patchSizeD / 2;
+	if ((w0 < 0) || (d0 < 0) ||
+	    ((size_t)w0 + patchSizeW > fNWires) || ((size_t)d0 + patchSizeD > fNCachedDrifts)) { return false; }
+
+	patch = imageView().subView(w0, d0, patchSizeW, patchSizeD);
+	return true;
+}
 // ------------------------------------------------------
 
 void img::DataProviderAlg::addWhiteNoise()
@@ -497,10 +570,11 @@ void img::DataProviderAlg::addWhiteNoise()
 
     CLHEP::RandGauss gauss(fRndEngine);
     std::vector<double> noise(fNCachedDrifts);
-    for (auto & wire : fWireDriftData)
+    for (size_t w = 0; w < fNWires; ++w)
     {
         gauss.fireArray(fNCachedDrifts, noise.data(), 0., effectiveSigma);
-        for (size_t d = 0; d < wire.size(); ++d)
+        float* wire = wireDataPtr(w);
+        for (size_t d = 0; d < fNCachedDrifts; ++d)
         {
             wire[d] += noise[d];
         }
@@ -516,14 +590,14 @@ void img::DataProviderAlg::addCoherentNoise()
     if (fDownscaleFullView) effectiveSigma /= fDriftWindow;
 
     CLHEP::RandGauss gauss(fRndEngine);
-    std::vector<double> amps1(fWireDriftData.size());
-    std::vector<double> amps2(1 + (fWireDriftData.size() / 32));
+    std::vector<double> amps1(fNWires);
+    std::vector<double> amps2(1 + (fNWires / 32));
     gauss.fireArray(amps1.size(), amps1.data(), 1., 0.1); // 10% wire-wire ampl. variation
     gauss.fireArray(amps2.size(), amps2.data(), 1., 0.1); // 10% group-group ampl. variation
 
     double group_amp = 1.0;
     std::vector<double> noise(fNCachedDrifts);
-    for (size_t w = 0; w < fWireDriftData.size(); ++w)
+    for (size_t w = 0; w < fNWires; ++w)
     {
         if ((w & 31) == 0)
         {
@@ -531,8 +605,8 @@ void img::DataProviderAlg::addCoherentNoise()
             gauss.fireArray(fNCachedDrifts, noise.data(), 0., effectiveSigma);
         } // every 32 wires
 
-        auto & wire = fWireDriftData[w];
-        for (size_t d = 0; d < wire.size(); ++d)
+        float* wire = wireDataPtr(w);
+        for (size_t d = 0; d < fNCachedDrifts; ++d)
         {
             wire[d] += group_amp * amps1[w] * noise[d];
         }
@@ -27,14 +27,93 @@
 #include "CLHEP/Random/JamesRandom.h" // for testing on noise, not used by any reco
 
 // ROOT & C++
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 //#include <functional>
 
 namespace img
 {
     class DataProviderAlg;
+
+    /// Allocator of memory aligned to Align bytes. Used for the image buffer, so each wire
+    /// starts on a cache line and SIMD loads along the drift direction are aligned.
+    template <typename T, std::size_t Align>
+    struct AlignedAllocator
+    {
+        using value_type = T;
+        template <typename U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+        AlignedAllocator() = default;
+        template <typename U> AlignedAllocator(const AlignedAllocator<U, Align> &) {}
+
+        T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align))); }
+        void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t(Align)); }
+
+        template <typename U> bool operator==(const AlignedAllocator<U, Align> &) const { return true; }
+        template <typename U> bool operator!=(const AlignedAllocator<U, Align> &) const { return false; }
+    };
+
+    class ImageView;
 }
 
+/// Non-owning view of a 2D block of image stored wire by wire: drift samples of each wire
+/// are contiguous and wires are Stride() samples apart. Valid as long as the image which
+/// it was taken from is not changed or destroyed.
+class img::ImageView
+{
+public:
+    /// Drift samples of one wire, read like std::vector<float> (size, [], begin/end).
+    class Row
+    {
+    public:
+        Row(const float* data, size_t size) : fData(data), fSize(size) {}
+
+        size_t size(void) const { return fSize; }
+        bool empty(void) const { return fSize == 0; }
+        const float* data(void) const { return fData; }
+        const float* begin(void) const { return fData; }
+        const float* end(void) const { return fData + fSize; }
+        const float & operator[](size_t d) const { return fData[d]; }
+
+        /// Copy of the samples, for code which needs them in the vector.
+        operator std::vector<float>() const { return std::vector<float>(begin(), end()); }
+
+    private:
+        const float* fData;
+        size_t fSize;
+    };
+
+    ImageView(void) : fData(nullptr), fNWires(0), fNDrifts(0), fStride(0) {}
+    ImageView(const float* data, size_t nwires, size_t ndrifts, size_t stride) :
+        fData(data), fNWires(nwires), fNDrifts(ndrifts), fStride(stride)
+    {}
+
+    size_t NWires(void) const { return fNWires; }
+    size_t NDrifts(void) const { return fNDrifts; }
+    size_t Stride(void) const { return fStride; }
+
+    size_t size(void) const { return fNWires; }
+    bool empty(void) const { return fNWires == 0; }
+    const float* data(void) const { return fData; }
+
+    Row operator[](size_t w) const { return Row(fData + w * fStride, fNDrifts); }
+    const float & at(size_t w, size_t d) const { return fData[w * fStride + d]; }
+
+    /// View of nwires x ndrifts pixels starting at the wire w0 and the drift d0. Not checked
+    /// if it is inside this view.
+    ImageView subView(size_t w0, size_t d0, size_t nwires, size_t ndrifts) const
+    {
+        return ImageView(fData + w0 * fStride + d0, nwires, ndrifts, fStride);
+    }
+
+private:
+    const float* fData;
+    size_t fNWires, fNDrifts, fStride;
+};
+
 /// Base class providing data for training / running image based classifiers. It can be used
 /// also for any other algorithms where 2D projection image is useful. Currently the image
 /// is 32-bit fp / pixel, as sson as have time will template it so e.g. byte pixels would
@@ -89,6 +168,10 @@ public:
 		fhicl::Atom<float> CoherentSigma {
 			Name("CoherentSigma"), Comment("Coherent noise sigma")
 		};
+
+		fhicl::Atom<bool> ConcurrentWires {
+			Name("ConcurrentWires"), Comment("Fill the image with several wires at the same time"), false
+		};
     };
 
 	DataProviderAlg(const fhicl::ParameterSet& pset) :
@@ -102,7 +185,15 @@ public:
 	bool setWireDriftData(const std::vector<recob::Wire> & wires, // once per plane: setup ADC buffer, collect & downscale ADC's
 		unsigned int plane, unsigned int tpc, unsigned int cryo);
 
-	std::vector<float> const & wireData(size_t widx) const { return fWireDriftData[widx]; }
+	/// Drift samples of the wire. The vector is a copy of the wire made on the first call for it after
+	/// the image is set, use wireRow() to read the image without the copy.
+	std::vector<float> const & wireData(size_t widx) const;
+
+	/// View of the drift samples of the wire in the image, can be used like std::vector<float>.
+	img::ImageView::Row wireRow(size_t widx) const { return img::ImageView::Row(wireDataPtr(widx), fNCachedDrifts); }
+
+	/// View of the full image of the plane.
+	img::ImageView imageView(void) const { return img::ImageView(fWireDriftData.data(), fNWires, fNCachedDrifts, fDriftStride); }
 
 	/// Return patch of data centered on the wire and drift, witht the size in (downscaled) pixels givent
 	/// with patchSizeW and patchSizeD.  Pad with the zero-level calue if patch extends beyond the event
@@ -110,7 +201,7 @@ public:
 	std::vector< std::vector<float> > getPatch(size_t wire, float drift, size_t patchSizeW, size_t patchSizeD) const
 	{
 		bool ok = false;
-		std::vector< std::vector<float> > patch;
+		std::vector< std::vector<float> > patch(patchSizeW, std::vector<float>(patchSizeD, fAdcZero));
 		if (fDownscaleFullView)
 		{
 			ok = patchFromDownsampledView(wire, drift, patchSizeW, patchSizeD, patch);
@@ -127,16 +218,21 @@ public:
 		}
 	}
 
+	/// Set patch to the view of the pixels which getPatch() would copy, without copying them. Possible
+	/// only if the full view is downscaled and the patch is inside the projection, false is returned
+	/// otherwise (then use getPatch).
+	bool getPatchView(size_t wire, float drift, size_t patchSizeW, size_t patchSizeD, img::ImageView & patch) const;
+
     /// Return value from the ADC buffer, or zero if coordinates are out of the view;
     /// will scale the drift according to the downscale settings.
     float getPixelOrZero(int wire, int drift) const
     {
         size_t didx = getDriftIndex(drift), widx = (size_t)wire;
 
-        if ((widx < fWireDriftData.size()) &&
+        if ((widx < fNWires) &&
             (didx < fNCachedDrifts))
         {
-            return fWireDriftData[widx][didx];
+            return wireDataPtr(widx)[didx];
         }
         else { return 0; }
     }
@@ -169,7 +265,20 @@ protected:
 	unsigned int fNWires, fNDrifts, fNScaledDrifts, fNCachedDrifts;
 
 	std::vector< raw::ChannelID_t > fWireChannels;              // wire channels (may need this connection...), InvalidChannelID if not used
-	std::vector< std::vector<float> > fWireDriftData;           // 2D data for entire projection, drifts scaled down
+	size_t fDriftStride;                                        // distance between wires in fWireDriftData, multiple of 16 samples
+	std::vector< float, img::AlignedAllocator<float, 64> > fWireDriftData; // 2D data for entire projection, drifts scaled down, wire after wire
+	/// Wires copied for wireData(), empty until asked for. A copy of the algorithm starts with no
+	/// copies and its own mutex.
+	struct WireDataCopies
+	{
+	    WireDataCopies(void) = default;
+	    WireDataCopies(const WireDataCopies &) {}
+	    WireDataCopies & operator=(const WireDataCopies &) { wires.clear(); return *this; }
+
+	    std::vector< std::vector<float> > wires;
+	    std::mutex mutex;
+	};
+	mutable WireDataCopies fWireDataCopies;
 	std::vector<float> fLifetimeCorrFactors;                    // precalculated correction factors along full drift
 
    	EDownscaleMode fDownscaleMode;
@@ -178,20 +287,35 @@ protected:
    	size_t fDriftWindow;
 	bool fDownscaleFullView;
 	float fDriftWindowInv;
+	bool fConcurrentWires;
 
-	void downscaleMax(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const;
-	void downscaleMaxMean(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const;
-	void downscaleMean(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const;
-	void downscale(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const
+	float* wireDataPtr(size_t widx) { return fWireDriftData.data() + widx * fDriftStride; }
+	const float* wireDataPtr(size_t widx) const { return fWireDriftData.data() + widx * fDriftStride; }
+
+	/// Lifetime correction factor at the tick, the last one for ticks beyond the drift.
+	float lifetimeCorrFactor(size_t tick) const
+	{
+	    return (tick < fLifetimeCorrFactors.size()) ? fLifetimeCorrFactors[tick] : fLifetimeCorrFactors.back();
+	}
+
+	// Downscale kernels: fill ndst samples of dst from nadc samples of adc starting at tick0 of the drift.
+	void downscaleMax(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const;
+	void downscaleMaxMean(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const;
+	void downscaleMean(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const;
+	void downscale(float* dst, size_t ndst, const float* adc, size_t nadc, size_t tick0) const
 	{
 	    switch (fDownscaleMode)
 	    {
-	        case img::DataProviderAlg::kMean: downscaleMean(dst, adc, tick0); break;
-	        case img::DataProviderAlg::kMaxMean: downscaleMaxMean(dst, adc, tick0); break;
-	        case img::DataProviderAlg::kMax: downscaleMax(dst, adc, tick0); break;
+	        case img::DataProviderAlg::kMean: downscaleMean(dst, ndst, adc, nadc, tick0); break;
+	        case img::DataProviderAlg::kMaxMean: downscaleMaxMean(dst, ndst, adc, nadc, tick0); break;
+	        case img::DataProviderAlg::kMax: downscaleMax(dst, ndst, adc, nadc, tick0); break;
 	        default:throw cet::exception("img::DataProviderAlg") << "Downscale mode not supported." << std::endl; break;
 	    }
 	}
+	void downscale(std::vector<float> & dst, std::vector<float> const & adc, size_t tick0) const
+	{
+	    downscale(dst.data(), dst.size(), adc.data(), adc.size(), tick0);
+	}
 
     size_t getDriftIndex(float drift) const
     {
@@ -215,7 +339,7 @@ protected:
 
 private:
     float scaleAdcSample(float val) const;
-    void scaleAdcSamples(std::vector< float > & values) const;
+    void scaleAdcSamples(float* values, size_t size) const;
     std::vector<float> fAmplCalibConst;
     bool fCalibrateAmpl, fCalibrateLifetime;
 
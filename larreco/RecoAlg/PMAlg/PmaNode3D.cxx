@@ -25,6 +25,33 @@ bool pma::Node3D::fGradFixed[3] = { false, false, false };
 
 double pma::Node3D::fMargin = 3.0;
 
+bool pma::Node3D::fAnalyticGradient = false;
+
+namespace
+{
+	// Gradient of pma::Segment3D::GetDist2(h, p0, p1) with respect to p0 (atStart) or p1.
+	template <typename V>
+	V segmentDist2Gradient(const V& h, const V& p0, const V& p1, bool atStart)
+	{
+		V v1 = p1 - p0;
+		double v1Norm2 = v1 * v1;
+		if (v1Norm2 >= 1.0E-6)
+		{
+			V v0 = h - p0, v2 = h - p1;
+			double v0v1 = v0 * v1;
+			if ((v0v1 > 0.0) && (v2 * v1 < 0.0)) // perpendicular distance to the segment line
+			{
+				double t = v0v1 / v1Norm2;
+				V r = v0 - t * v1;
+				return (atStart ? -2.0 * (1.0 - t) : -2.0 * t) * r;
+			}
+			else if (v0v1 <= 0.0) { return (atStart ? -2.0002 : 0.0) * v0; }
+			else { return (atStart ? 0.0 : -2.0002) * v2; }
+		}
+		else { return 0.5 * (p0 + p1) - h; } // short segment, distance to the middle
+	}
+}
+
 pma::Node3D::Node3D(void) :
     fTpcGeo(art::ServiceHandle<geo::Geometry const>()->TPC(0, 0)),
 	fMinX(0), fMaxX(0),
@@ -522,6 +549,83 @@ double pma::Node3D::Mse(void) const
 	else return mse / nhits;
 }
 
+TVector3 pma::Node3D::MseGradient(void) const
+{
+	TVector2 grad2D[3];    // gradient in each 2D view, w.r.t. the node projection
+	TVector3 grad3D(0, 0, 0); // gradient from 3D reference points
+
+	unsigned int nhits = NPrecalcEnabledHits();
+
+	// hits and points of this node
+	if (fTPC >= 0)
+	{
+		for (auto h : fAssignedHits)
+			if (h->IsEnabled())
+		{
+			unsigned int view = h->View2D();
+			grad2D[view] -= (2.0 * OptFactor(view) * h->GetSigmaFactor()) * (h->Point2D() - fProj2D[view]);
+		}
+		if (!fAssignedPoints.empty())
+		{
+			double scale = fAssignedHits.empty() ? 1.0 : 0.2 * fAssignedHits.size() / fAssignedPoints.size();
+			for (auto p : fAssignedPoints)
+			{
+				double d2 = GetDistance2To(*p), d = sqrt(d2);
+				if (d > 0.5) grad3D -= (2.0 * scale * (d - 0.5) / d) * (*p - fPoint3D);
+			}
+		}
+	}
+
+	// hits and points of segments connected to this node
+	std::vector< pma::Segment3D* > segs;
+	for (unsigned int i = 0; i < NextCount(); i++) segs.push_back(static_cast< pma::Segment3D* >(Next(i)));
+	if (prev) segs.push_back(static_cast< pma::Segment3D* >(prev));
+
+	for (auto seg : segs)
+	{
+		nhits += seg->NPrecalcEnabledHits();
+		if (seg->TPC() < 0) continue;
+
+		bool atStart = (seg->Prev() == this);
+		auto const * v0 = static_cast< pma::Node3D* >(seg->Prev());
+		auto const * v1 = static_cast< pma::Node3D* >(seg->Next());
+
+		for (auto h : seg->Hits())
+			if (h->IsEnabled())
+		{
+			unsigned int view = h->View2D();
+			grad2D[view] += (OptFactor(view) * h->GetSigmaFactor()) *
+				segmentDist2Gradient(h->Point2D(), v0->Projection2D(view), v1->Projection2D(view), atStart);
+		}
+		if (seg->NPoints())
+		{
+			double scale = seg->NHits() ? 0.2 * seg->NHits() / seg->NPoints() : 1.0;
+			for (size_t i = 0; i < seg->NPoints(); ++i)
+			{
+				const TVector3 & p = seg->ReferencePoint(i);
+				double d = sqrt(seg->GetDistance2To(p));
+				if (d > 0.5)
+					grad3D += (scale * (d - 0.5) / d) * segmentDist2Gradient(p, v0->Point3D(), v1->Point3D(), atStart);
+			}
+		}
+	}
+	if (!nhits) return TVector3(0, 0, 0);
+
+	// 2D projection is (plane coordinate, x - drift offset), plane coordinate is linear in 3D
+	TVector3 grad(grad3D);
+	for (size_t i = 0; i < fTpcGeo.Nplanes(); ++i)
+	{
+		auto const & plane = fTpcGeo.Plane(i);
+		double c0 = plane.PlaneCoordinate(TVector3(0, 0, 0));
+		TVector3 dir(plane.PlaneCoordinate(TVector3(1, 0, 0)) - c0,
+		             plane.PlaneCoordinate(TVector3(0, 1, 0)) - c0,
+		             plane.PlaneCoordinate(TVector3(0, 0, 1)) - c0);
+		grad += grad2D[i].X() * dir;
+		grad[0] += grad2D[i].Y();
+	}
+	return (1.0 / nhits) * grad;
+}
+
 double pma::Node3D::GetObjFunction(float penaltyValue, float endSegWeight) const
 {
 	return Mse() + penaltyValue * (Penalty(endSegWeight) + PenaltyInWirePlane());
@@ -551,6 +655,8 @@ double pma::Node3D::MakeGradient(float penaltyValue, float endSegWeight)
 
 	if (dxi < 6.0E-37) return 0.0;
 
+	if (fAnalyticGradient) { return MakeAnalyticGradient(penaltyValue, endSegWeight, dxi); }
+
 	double gi, g0, gz;
 	gz = g0 = GetObjFunction(penaltyValue, endSegWeight);
 
@@ -609,6 +715,38 @@ double pma::Node3D::MakeGradient(float penaltyValue, float endSegWeight)
 	return g0;
 }
 
+double pma::Node3D::MakeAnalyticGradient(float penaltyValue, float endSegWeight, double dxi)
+{
+	double g0 = GetObjFunction(penaltyValue, endSegWeight);
+	TVector3 gradMse = MseGradient();
+
+	// penalty terms use only positions of a few nodes, cheap to differentiate numerically
+	TVector3 tmp(fPoint3D), gpoint(fPoint3D);
+	for (size_t i = 0; i < 3; ++i)
+		if (!fGradFixed[i])
+	{
+		fGradient[i] = -gradMse[i];
+		if (penaltyValue != 0.0F)
+		{
+			gpoint[i] = tmp[i] + dxi;
+			SetPoint3D(gpoint);
+			double gUp = Penalty(endSegWeight) + PenaltyInWirePlane();
+
+			gpoint[i] = tmp[i] - dxi;
+			SetPoint3D(gpoint);
+			double gDown = Penalty(endSegWeight) + PenaltyInWirePlane();
+
+			fGradient[i] += penaltyValue * (gDown - gUp) / (2 * dxi);
+			gpoint[i] = tmp[i];
+		}
+	}
+
+	SetPoint3D(tmp);
+	if (fGradient.Mag2() < 6.0E-37) return 0.0;
+
+	return g0;
+}
+
 double pma::Node3D::StepWithGradient(float alfa, float tol, float penalty, float weight)
 {
 	unsigned int steps = 0;
@@ -107,6 +107,15 @@ public:
 	/// Set allowed node position margin around TPC.
 	static void SetMargin(double m) { if (m >= 0.0) fMargin = m; }
 
+	/// Use analytic gradient of the MSE part of the objective function in the node
+	/// optimization (penalty terms are still differentiated numerically).
+	static void SetAnalyticGradient(bool state) { fAnalyticGradient = state; }
+
+	/// Position changed since the last MarkProjected() call?
+	bool MovedSinceProjection(void) const { return fPoint3D != fProjectedPoint3D; }
+	/// Remember the position used to project hits.
+	void MarkProjected(void) { fProjectedPoint3D = fPoint3D; }
+
 private:
 	/// Returns true if node position was trimmed to its TPC volume + fMargin
 	bool LimitPoint3D(void);
@@ -119,8 +128,10 @@ private:
 	double Pi(float endSegWeight, bool doAsymm) const;
 	double Penalty(float endSegWeight) const;
 	double Mse(void) const;
+	TVector3 MseGradient(void) const;
 
 	double MakeGradient(float penaltyValue, float endSegWeight);
+	double MakeAnalyticGradient(float penaltyValue, float endSegWeight, double dxi);
 	double StepWithGradient(float alfa, float tol, float penalty, float weight);
 
     double SumDist2Hits(void) const override;
@@ -131,6 +142,7 @@ private:
 
 	TVector3 fPoint3D;       // node position in 3D space in [cm]
 	TVector2 fProj2D[3];     // node projections to 2D views, scaled to [cm], updated on each change of 3D position
+	TVector3 fProjectedPoint3D; // node position when hits were projected last time (see MarkProjected())
     double fDriftOffset;         // the offset due to t0
 
 	TVector3 fGradient;
@@ -138,6 +150,7 @@ private:
 
 	static bool fGradFixed[3];
 	static double fMargin;
+	static bool fAnalyticGradient;
 };
 
 #endif
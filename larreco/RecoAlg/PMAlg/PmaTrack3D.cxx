@@ -21,6 +21,8 @@
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
+bool pma::Track3D::fFastTreeTuning = false;
+
 pma::Track3D::Track3D(void) :
 	fMaxHitsPerSeg(70),
 	fPenaltyFactor(1.0F),
@@ -1918,7 +1920,7 @@ double pma::Track3D::Optimize(int nNodes, double eps, bool selAllHits, bool setA
 bool pma::Track3D::UpdateParamsInTree(bool skipFirst)
 {
 	const size_t maxTreeDepth = 100; // really big tree...
-	static size_t depth;
+	static thread_local size_t depth; // trees may be tuned in parallel
 
 	pma::Node3D* vtx = fNodes.front();
 	pma::Segment3D* segThis = 0;
@@ -2152,6 +2154,81 @@ void pma::Track3D::MakeProjectionInTree(bool skipFirst)
 	MakeProjection();
 }
 
+bool pma::Track3D::NeedsProjection(void) const
+{
+	for (auto n : fNodes) { if (n->MovedSinceProjection()) return true; }
+
+	for (auto n : { fNodes.front(), fNodes.back() })
+	{
+		if (n->Prev() && static_cast< pma::Node3D* >(n->Prev()->Prev())->MovedSinceProjection()) return true;
+		for (size_t i = 0; i < n->NextCount(); i++)
+		{
+			if (static_cast< pma::Node3D* >(n->Next(i)->Next())->MovedSinceProjection()) return true;
+		}
+	}
+	return false;
+}
+
+size_t pma::Track3D::MakeChangedProjectionInTree(bool skipFirst)
+{
+	pma::Node3D* vtx = fNodes.front();
+	pma::Segment3D* segThis = 0;
+	pma::Segment3D* seg = 0;
+
+	if (skipFirst)
+	{
+		segThis = NextSegment(vtx);
+		if (segThis) vtx = static_cast< pma::Node3D* >(segThis->Next());
+	}
+
+	size_t n = 0;
+	while (vtx)
+	{
+		segThis = NextSegment(vtx);
+
+		for (size_t i = 0; i < vtx->NextCount(); i++)
+		{
+			seg = static_cast< pma::Segment3D* >(vtx->Next(i));
+			if (seg != segThis) n += seg->Parent()->MakeChangedProjectionInTree(true);
+		}
+
+		if (segThis) vtx = static_cast< pma::Node3D* >(segThis->Next());
+		else break;
+	}
+
+	if (NeedsProjection()) { MakeProjection(); n++; }
+	return n;
+}
+
+void pma::Track3D::MarkProjectedInTree(bool skipFirst)
+{
+	pma::Node3D* vtx = fNodes.front();
+	pma::Segment3D* segThis = 0;
+	pma::Segment3D* seg = 0;
+
+	if (skipFirst)
+	{
+		segThis = NextSegment(vtx);
+		if (segThis) vtx = static_cast< pma::Node3D* >(segThis->Next());
+	}
+
+	while (vtx)
+	{
+		segThis = NextSegment(vtx);
+
+		for (size_t i = 0; i < vtx->NextCount(); i++)
+		{
+			seg = static_cast< pma::Segment3D* >(vtx->Next(i));
+			if (seg != segThis) seg->Parent()->MarkProjectedInTree(true);
+		}
+
+		if (segThis) vtx = static_cast< pma::Node3D* >(segThis->Next());
+		else break;
+	}
+
+	for (auto n : fNodes) n->MarkProjected();
+}
+
 void pma::Track3D::SortHitsInTree(bool skipFirst)
 {
 	pma::Node3D* vtx = fNodes.front();
@@ -2236,6 +2313,8 @@ double pma::Track3D::TuneFullTree(double eps, double gmax)
 
 	mf::LogVerbatim("pma::Track3D") << "Tune tree, g = " << g0;
 	//std::cout << "Tune tree, g = " << g0 << std::endl;
+	bool projected = false; // hits projected to the current node positions in the whole tree
+	size_t nProjections = 0, nChanged = 0;
 	unsigned int stepIter = 0;
 	do
 	{
@@ -2246,7 +2325,9 @@ double pma::Track3D::TuneFullTree(double eps, double gmax)
 			g1 = g0;
 			g0 = TuneSinglePass();
 
-			MakeProjectionInTree();
+			if (projected) { nChanged += MakeChangedProjectionInTree(); nProjections++; }
+			else { MakeProjectionInTree(); }
+			if (fFastTreeTuning) { MarkProjectedInTree(); projected = true; }
 			//ReassignHitsInTree();
 
 			if (!UpdateParamsInTree()) { g0 = -2; break; } // negetive to tag destroyed tree
@@ -2263,9 +2344,15 @@ double pma::Track3D::TuneFullTree(double eps, double gmax)
 
 	//ReassignHitsInTree();
 	//TuneSinglePass();
-	MakeProjectionInTree();
+	if (projected) { nChanged += MakeChangedProjectionInTree(); nProjections++; }
+	else { MakeProjectionInTree(); }
 	SortHitsInTree();
 
+	if (nProjections)
+	{
+		mf::LogVerbatim("pma::Track3D") << "  tracks projected again: " << nChanged << " in " << nProjections << " passes";
+	}
+
 	if (g0 >= 0) { mf::LogVerbatim("pma::Track3D") << "  done, g = " << g0; }
 	else { mf::LogError("pma::Track3D") << "TuneFullTree failed."; }
 	return g0;
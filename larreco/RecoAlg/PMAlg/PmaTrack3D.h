@@ -213,6 +213,10 @@ public:
 	double TuneSinglePass(bool skipFirst = false);
 	double TuneFullTree(double eps = 0.001, double gmax = 50.0);
 
+	/// In TuneFullTree() project hits again only in tracks with nodes moved since the
+	/// previous projection.
+	static void SetFastTreeTuning(bool state) { fFastTreeTuning = state; }
+
 	/// Adjust track tree position in the drift direction (when T0 is being corrected).
 	void ApplyDriftShiftInTree(double dx, bool skipFirst = false);
   /// Function to convert dx into dT0
@@ -306,6 +310,15 @@ private:
 		double& dist, bool skipFirst = false);
 	void ReassignHitsInTree(pma::Track3D* plRoot = 0);
 
+	/// Node positions changed since hits were projected (also the nodes of other tracks
+	/// in the tree next to the end nodes, they affect projection of hits at the ends).
+	bool NeedsProjection(void) const;
+	/// Project hits in tracks of the tree which NeedsProjection(), returns number of
+	/// projected tracks.
+	size_t MakeChangedProjectionInTree(bool skipFirst = false);
+	/// Remember node positions used in the last projection of the tree.
+	void MarkProjectedInTree(bool skipFirst = false);
+
 	/// Distance to the nearest subsequent (dir = Track3D::kForward) or preceeding (dir = Track3D::kBackward)
 	/// hit in given view. In case of last (first) hit in this view the half-distance in opposite direction is
 	/// returned. Parameter secondDir is only for internal protection - please leave the default value.
@@ -352,6 +365,8 @@ private:
   bool fT0Flag;
 
 	ETag fTag;
+
+	static bool fFastTreeTuning;
 };
 
 #endif
@@ -22,6 +22,8 @@
 
 #include "TMath.h"
 
+#include <algorithm>
+
 const double pma::VtxCandidate::kMaxDistToTrack = 4.0; // max. dist. track to center to create vtx
 const double pma::VtxCandidate::kMinDistToNode = 2.0;  // min. dist. to node needed to split segment
 
@@ -426,6 +428,14 @@ double pma::VtxCandidate::Compute(void)
 }
 
 bool pma::VtxCandidate::JoinTracks(pma::TrkCandidateColl & tracks, pma::TrkCandidateColl & src)
+{
+	if (!AttachTracks(tracks, src)) return false;
+
+	TuneTree();
+	return FinishJoin(tracks);
+}
+
+bool pma::VtxCandidate::AttachTracks(pma::TrkCandidateColl & tracks, pma::TrkCandidateColl & src)
 {
 	if (tracksJoined)
 	{
@@ -462,7 +472,7 @@ bool pma::VtxCandidate::JoinTracks(pma::TrkCandidateColl & tracks, pma::TrkCandi
 
 	// backup in case of fitting problems
 	std::vector<int> treeIds;
-	pma::TrkCandidateColl backupTracks;
+	pma::TrkCandidateColl & backupTracks = fBackupTracks;
 
 	pma::Node3D* vtxCenter = 0;
 	bool hasInnerCenter = false;
@@ -677,65 +687,77 @@ bool pma::VtxCandidate::JoinTracks(pma::TrkCandidateColl & tracks, pma::TrkCandi
 		}
 	}
 
-	bool result = false;
-	if (vtxCenter)
+	if (!vtxCenter)
 	{
-		pma::Segment3D* rootSeg = 0;
-		if (vtxCenter->NextCount()) rootSeg = static_cast< pma::Segment3D* >(vtxCenter->Next(0));
-		else if (vtxCenter->Prev()) rootSeg = static_cast< pma::Segment3D* >(vtxCenter->Prev());
-		else throw cet::exception("pma::VtxCandidate") << "Vertex with no segments attached.";
+		mf::LogError("pma::VtxCandidate") << "Cannot create common vertex";
+		return false;
+	}
 
-		pma::Track3D* rootTrk = rootSeg->Parent()->GetRoot();
-		if (!rootTrk) rootTrk = rootSeg->Parent();
+	pma::Segment3D* rootSeg = 0;
+	if (vtxCenter->NextCount()) rootSeg = static_cast< pma::Segment3D* >(vtxCenter->Next(0));
+	else if (vtxCenter->Prev()) rootSeg = static_cast< pma::Segment3D* >(vtxCenter->Prev());
+	else throw cet::exception("pma::VtxCandidate") << "Vertex with no segments attached.";
 
-		std::vector< pma::Track3D const * > branchesToRemove;  // change to a more simple check
-		bool noLoops = rootTrk->GetBranches(branchesToRemove); // if there are loops
+	fRootTrk = rootSeg->Parent()->GetRoot();
+	if (!fRootTrk) fRootTrk = rootSeg->Parent();
 
-		bool tuneOK = true;
-		if (noLoops && (nOK > 1))
-		{
-			fAssigned.clear();
-			fCenter = vtxCenter->Point3D();
-			fMse = 0.0; fMse2D = 0.0;
+	std::vector< pma::Track3D const * > branchesToRemove;  // change to a more simple check
+	fNoLoops = fRootTrk->GetBranches(branchesToRemove);    // if there are loops
 
-			double g = rootTrk->TuneFullTree();
+	fTuneTree = fNoLoops && (nOK > 1);
+	fTuneOK = true;
+	if (fTuneTree)
+	{
+		fAssigned.clear();
+		fCenter = vtxCenter->Point3D();
+		fMse = 0.0; fMse2D = 0.0;
+	}
 
-			if (g > -2.0)       // -1.0: high value of g; -2.0: inf. value of g.
-			{
-				result = true;  // all OK, new vertex added
-			}
-			else
-			{
-				tuneOK = false; // inf. g, remove tracks
-			}
-		}
+	// tracks to remove if restored from backup, tree ids may change before FinishJoin()
+	fJoinedTracks.clear();
+	for (auto const & t : tracks.tracks())
+	{
+		if (has(treeIds, t.TreeId())) fJoinedTracks.push_back(t.Track());
+	}
 
-		if (noLoops && tuneOK)
-		{
-			mf::LogVerbatim("pma::VtxCandidate") << "remove backup tracks";
-			for (auto & c : backupTracks.tracks()) c.DeleteTrack();
-		}
-		else
+	return true;
+}
+
+void pma::VtxCandidate::TuneTree(void)
+{
+	if (fTuneTree)
+	{
+		double g = fRootTrk->TuneFullTree();
+
+		fTuneOK = (g > -2.0); // -1.0: high value of g; -2.0: inf. value of g, remove tracks
+	}
+}
+
+bool pma::VtxCandidate::FinishJoin(pma::TrkCandidateColl & tracks)
+{
+	if (fNoLoops && fTuneOK)
+	{
+		mf::LogVerbatim("pma::VtxCandidate") << "remove backup tracks";
+		for (auto & c : fBackupTracks.tracks()) c.DeleteTrack();
+	}
+	else
+	{
+		mf::LogVerbatim("pma::VtxCandidate") << "restore tracks from backup....";
+		size_t t = 0;
+		while (t < tracks.size())
 		{
-			mf::LogVerbatim("pma::VtxCandidate") << "restore tracks from backup....";
-			for (int tid : treeIds)
+			if (std::find(fJoinedTracks.begin(), fJoinedTracks.end(), tracks[t].Track()) != fJoinedTracks.end())
 			{
-				size_t t = 0;
-				while (t < tracks.size())
-				{
-					if (tracks[t].TreeId() == tid)
-					{
-						tracks[t].DeleteTrack();
-						tracks.erase_at(t);
-					}
-					else t++;
-				}
+				tracks[t].DeleteTrack();
+				tracks.erase_at(t);
 			}
-			for (const auto & c : backupTracks.tracks()) tracks.push_back(c);
-			mf::LogVerbatim("pma::VtxCandidate") << "  done";
+			else t++;
 		}
+		for (const auto & c : fBackupTracks.tracks()) tracks.push_back(c);
+		mf::LogVerbatim("pma::VtxCandidate") << "  done";
 	}
-	else mf::LogError("pma::VtxCandidate") << "Cannot create common vertex";
+	fBackupTracks.clear();
+	fJoinedTracks.clear();
 
-	return result;
+	return fTuneTree && fTuneOK; // all OK, new vertex added
 }
@@ -30,7 +30,9 @@ public:
 		fSegMinLength(segMinLength),
 		fMse(0.0), fMse2D(0.0),
 		fCenter(0., 0., 0.),
-		fErr(0., 0., 0.)
+		fErr(0., 0., 0.),
+		fRootTrk(0),
+		fNoLoops(false), fTuneTree(false), fTuneOK(false)
 	{}
 
 	bool Has(pma::Track3D* trk) const;
@@ -58,8 +60,18 @@ public:
 
 	double Compute(void);
 
+	/// Attach tracks to the vertex, tune the tree and restore tracks from the backup
+	/// if tuning failed; returns true if the vertex was added.
 	bool JoinTracks(pma::TrkCandidateColl & tracks, pma::TrkCandidateColl & src);
 
+	/// JoinTracks() in steps: attach tracks, tune the new tree (touches only tracks in
+	/// that tree, so trees of not attached vertices can be tuned concurrently), finish
+	/// with removing backup or restoring tracks. AttachTracks returns false if the
+	/// vertex could not be created, then the other steps should not be called.
+	bool AttachTracks(pma::TrkCandidateColl & tracks, pma::TrkCandidateColl & src);
+	void TuneTree(void);
+	bool FinishJoin(pma::TrkCandidateColl & tracks);
+
 	const TVector3& Center(void) const { return fCenter; }
 	double Mse(void) const { return fMse; }
 	double Mse2D(void) const { return fMse2D; }
@@ -80,6 +92,12 @@ private:
 	double fSegMinLength, fMse, fMse2D;
 	std::vector< std::pair< pma::TrkCandidate, size_t > > fAssigned;
 	TVector3 fCenter, fErr;
+
+	// state kept between AttachTracks() and FinishJoin()
+	pma::TrkCandidateColl fBackupTracks;
+	std::vector< pma::Track3D* > fJoinedTracks;
+	pma::Track3D* fRootTrk;
+	bool fNoLoops, fTuneTree, fTuneOK;
 };
 
 #endif
@@ -450,7 +450,7 @@ double pma::PMAlgTracker::validate(pma::Track3D& trk, unsigned int testView)
     switch (fValidation)
     {
         case pma::PMAlgTracker::kAdc:
-            v = fProjectionMatchingAlg.validate_on_adc(trk, fAdcImages[testView], fAdcValidationThr[testView]);
+            v = fProjectionMatchingAlg.validate_on_adc(trk, fAdcImages[testView], fAdcValidationThr[testView], fAdcProjections);
             break;
 
         case pma::PMAlgTracker::kHits:
@@ -360,6 +360,7 @@ private:
     EValidationMode fValidation;                    // track validation mode
     std::vector< img::DataProviderAlg > fAdcImages; // adc image making algorithms for each plane
     std::vector<double> fAdcValidationThr;          // threshold on pixel values in the adc image
+    pma::ProjectionMatchingAlg::PlaneProjections fAdcProjections; // test plane projections, shared by all tracks
 
     // references to the validation calibration histograms
 	const std::vector< TH1F* > & fAdcInPassingPoints;
@@ -12,6 +12,8 @@
 
 #include "TMath.h"
 
+#include "tbb/parallel_for.h"
+
 pma::PMAlgVertexing::PMAlgVertexing(const pma::PMAlgVertexing::Config& config)
 {
 	this->reconfigure(config);
@@ -24,6 +26,8 @@ void pma::PMAlgVertexing::reconfigure(const pma::PMAlgVertexing::Config& config)
 	fFindKinks = config.FindKinks();
 	fKinkMinDeg = config.KinkMinDeg();
 	fKinkMinStd = config.KinkMinStd();
+
+	fParallelTrees = config.ParallelTrees();
 }
 // ------------------------------------------------------
 
@@ -254,9 +258,29 @@ size_t pma::PMAlgVertexing::makeVertices(std::vector< pma::VtxCandidate >& candi
 	mf::LogVerbatim("pma::PMAlgVertexing") << "*** Vtx selected to join: " << toJoin.size();
 
 	size_t njoined = 0;
-	for (auto & c : toJoin)
+	if (fParallelTrees)
 	{
-		if (c.JoinTracks(fOutTracks, fEmTracks)) njoined++;
+		// vertices selected above do not share any track tree, so after all tracks
+		// are attached each new tree can be tuned independently
+		std::vector< size_t > attached;
+		for (size_t v = 0; v < toJoin.size(); ++v)
+		{
+			if (toJoin[v].AttachTracks(fOutTracks, fEmTracks)) attached.push_back(v);
+		}
+
+		tbb::parallel_for(size_t(0), attached.size(), [&](size_t i) { toJoin[attached[i]].TuneTree(); });
+
+		for (size_t v : attached)
+		{
+			if (toJoin[v].FinishJoin(fOutTracks)) njoined++;
+		}
+	}
+	else
+	{
+		for (auto & c : toJoin)
+		{
+			if (c.JoinTracks(fOutTracks, fEmTracks)) njoined++;
+		}
 	}
 
 	return njoined;
@@ -53,6 +53,12 @@ public:
 			Name("KinkMinStd"),
 			Comment("threshold in no. of stdev of all segment angles needed to tag a kink")
 		};
+
+		fhicl::Atom<bool> ParallelTrees {
+			Name("ParallelTrees"),
+			Comment("tune trees of vertices made in one pass concurrently (they share no tracks)"),
+			false
+		};
     };
 
 	PMAlgVertexing(const Config& config);
@@ -130,6 +136,8 @@ private:
     double fKinkMinDeg;       // min. angle [deg] in XY of a kink
 	double fKinkMinStd;       // threshold in no. of stdev of all segment angles needed to tag a kink
 
+	bool fParallelTrees;      // tune trees of vertices made in one pass concurrently
+
 	// just to remember:
 	//double fInputVtxDist2D; // use vtx given at input if dist. [cm] to track in all 2D projections is below this max. value
 	//double fInputVtxDistY;  // use vtx given at input if dist. [cm] to track in 3D-Y is below this max. value
@@ -35,23 +35,72 @@ pma::ProjectionMatchingAlg::ProjectionMatchingAlg(const pma::ProjectionMatchingA
 	pma::Element3D::SetOptFactor(geo::kV, config.HitWeightV());
 	pma::Element3D::SetOptFactor(geo::kZ, config.HitWeightZ());
 
+	pma::Node3D::SetAnalyticGradient(config.FastTreeTuning());
+	pma::Track3D::SetFastTreeTuning(config.FastTreeTuning());
+
 	fDetProp = lar::providerFrom<detinfo::DetectorPropertiesService>();
 }
 // ------------------------------------------------------
 
+const pma::ProjectionMatchingAlg::PlaneProjection & pma::ProjectionMatchingAlg::getProjection(
+    PlaneProjections & projections, const geo::PlaneID & planeID) const
+{
+	auto it = projections.find(planeID);
+	if (it != projections.end()) { return it->second; }
+
+	PlaneProjection & proj = projections[planeID];
+	unsigned int plane = planeID.Plane, tpc = planeID.TPC, cryo = planeID.Cryostat;
+
+	// both projections are linear (plane wires, uniform drift), take the coefficients
+	// from the services and check them at a few points
+	const double L = 1000.0; // [cm]
+	proj.wire0 = fGeom->WireCoordinate(0, 0, plane, tpc, cryo);
+	proj.wireY = (fGeom->WireCoordinate(L, 0, plane, tpc, cryo) - fGeom->WireCoordinate(-L, 0, plane, tpc, cryo)) / (2 * L);
+	proj.wireZ = (fGeom->WireCoordinate(0, L, plane, tpc, cryo) - fGeom->WireCoordinate(0, -L, plane, tpc, cryo)) / (2 * L);
+	proj.tick0 = fDetProp->ConvertXToTicks(0, plane, tpc, cryo);
+	proj.tickX = (fDetProp->ConvertXToTicks(L, plane, tpc, cryo) - fDetProp->ConvertXToTicks(-L, plane, tpc, cryo)) / (2 * L);
+
+	const double maxErr = 0.01 * PlaneProjection::kIntTolerance;
+	proj.affine = true;
+	for (double y : { -317.3, 151.9, 602.1 })
+		for (double z : { -83.7, 211.3, 1403.9 })
+	{
+		double w = fGeom->WireCoordinate(y, z, plane, tpc, cryo);
+		if (std::fabs(proj.wire0 + proj.wireY * y + proj.wireZ * z - w) > maxErr) { proj.affine = false; }
+	}
+	for (double x : { -371.1, 13.7, 257.3 })
+	{
+		double d = fDetProp->ConvertXToTicks(x, plane, tpc, cryo);
+		if (std::fabs(proj.tick0 + proj.tickX * x - d) > maxErr) { proj.affine = false; }
+	}
+	if (!proj.affine)
+	{
+		mf::LogWarning("ProjectionMatchingAlg") << "non-linear projection to plane " << plane
+			<< " in TPC " << tpc << ", validation uses services at each step";
+	}
+
+	auto const & channelStatus = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
+
+	unsigned int nWires = fGeom->Nwires(planeID);
+	proj.goodWire.resize(nWires);
+	for (unsigned int w = 0; w < nWires; ++w)
+	{
+		proj.goodWire[w] = channelStatus.IsGood(fGeom->PlaneWireToChannel(geo::WireID(planeID, w)));
+	}
+
+	return proj;
+}
+// ------------------------------------------------------
+
 double pma::ProjectionMatchingAlg::validate_on_adc(
-    const pma::Track3D& trk, const img::DataProviderAlg & adcImage, float thr) const
+    const pma::Track3D& trk, const img::DataProviderAlg & adcImage, float thr,
+    PlaneProjections & projections) const
 {
 	unsigned int nAll = 0, nPassed = 0;
 	unsigned int testPlane = adcImage.Plane();
 
-	std::vector< unsigned int > trkTPCs = trk.TPCs();
-	std::vector< unsigned int > trkCryos = trk.Cryos();
-
 	unsigned int tpc, cryo;
 
-	auto const & channelStatus = art::ServiceHandle<lariov::ChannelStatusService const>()->GetProvider();
-
 	double step = 0.3;
 	// check how pixels with a high signal are distributed along the track
 	// namely: are there track sections crossing empty spaces, except dead wires?
@@ -69,30 +118,30 @@ double pma::ProjectionMatchingAlg::validate_on_adc(
 
 		tpc = seg->TPC(); cryo = seg->Cryo();
 
+		// wire/tick coefficients and good wires, instead of the services at every step
+		const PlaneProjection & proj = getProjection(projections, geo::PlaneID(cryo, tpc, testPlane));
+
 		pma::Vector3D dc = step * seg->GetDirection3D();
 
 		double f = pma::GetSegmentProjVector(p, p0, p1);
 		while ((f < 1.0) && node->SameTPC(p))
 		{
-			pma::Vector2D p2d(fGeom->WireCoordinate(p.Y(), p.Z(), testPlane, tpc, cryo), p.X());
-			geo::WireID wireID(cryo, tpc, testPlane, (int)p2d.X());
-
-			int widx = (int)p2d.X();
-			int didx = (int)fDetProp->ConvertXToTicks(p2d.Y(), testPlane, tpc, cryo);
+			int widx, didx;
+			if (!proj.pixel(p, widx, didx)) // close to a pixel edge, ask services for exact values
+			{
+				widx = (int)fGeom->WireCoordinate(p.Y(), p.Z(), testPlane, tpc, cryo);
+				didx = (int)fDetProp->ConvertXToTicks(p.X(), testPlane, tpc, cryo);
+			}
 
-			if (fGeom->HasWire(wireID))
+			if (proj.isGood(widx))
 			{
-			  raw::ChannelID_t ch = fGeom->PlaneWireToChannel(wireID);
-			  if (channelStatus.IsGood(ch))
-			  {
-			      float max_adc = adcImage.poolMax(widx, didx, 2); // +/- 2 wires, can be parameterized
-			      if (max_adc > thr) nPassed++;
+			    float max_adc = adcImage.poolMax(widx, didx, 2); // +/- 2 wires, can be parameterized
+			    if (max_adc > thr) nPassed++;
 
-				  nAll++;
-			  }
-			  //else mf::LogVerbatim("ProjectionMatchingAlg")
-			  //	<< "crossing BAD CHANNEL (wire #" << (int)p2d.X() << ")" << std::endl;
+			    nAll++;
 			}
+			//else mf::LogVerbatim("ProjectionMatchingAlg")
+			//	<< "crossing BAD CHANNEL (wire #" << widx << ")" << std::endl;
 
 			p += dc; f = pma::GetSegmentProjVector(p, p0, p1);
 		}
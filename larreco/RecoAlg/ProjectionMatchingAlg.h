@@ -35,6 +35,8 @@ namespace detinfo { class DetectorProperties; }
 namespace geo { class GeometryCore; class TPCGeo; }
 
 // ROOT & C++
+#include <cmath>
+#include <map>
 #include <memory>
 class TH1F;
 
@@ -95,6 +97,12 @@ public:
 			Name("HitWeightZ"),
 			Comment("weights used for hits in Z plane")
 		};
+
+		fhicl::Atom<bool> FastTreeTuning {
+			Name("FastTreeTuning"),
+			Comment("analytic node gradients, project hits again only in tracks with moved nodes"),
+			false
+		};
     };
 
 	ProjectionMatchingAlg(const Config& config);
@@ -103,10 +111,47 @@ public:
 		ProjectionMatchingAlg(fhicl::Table<Config>(pset, {})())
 	{}
 
+	/// Wire and drift tick coordinates of 3D points in one wire plane, and the wires with
+	/// a good channel; prepared once per plane for the stepping in validate_on_adc().
+	struct PlaneProjection
+	{
+		bool affine = false;              // coefficients reproduce the geometry/detprop services
+		double wire0 = 0, wireY = 0, wireZ = 0; // wire coordinate = wire0 + wireY * y + wireZ * z
+		double tick0 = 0, tickX = 0;      // drift ticks = tick0 + tickX * x
+		std::vector<bool> goodWire;       // wire exists and its channel is good
+
+		/// Integer parts of the wire and tick coordinates, as the pixel indexes are
+		/// taken; false if either is too close to an integer to trust the coefficients.
+		bool pixel(const pma::Vector3D & p, int & widx, int & didx) const
+		{
+			if (!affine) { return false; }
+			double w = wire0 + wireY * p.Y() + wireZ * p.Z();
+			double d = tick0 + tickX * p.X();
+			if ((std::fabs(w - std::round(w)) < kIntTolerance) ||
+			    (std::fabs(d - std::round(d)) < kIntTolerance)) { return false; }
+			widx = (int)w; didx = (int)d;
+			return true;
+		}
+		bool isGood(int widx) const { return (widx >= 0) && ((size_t)widx < goodWire.size()) && goodWire[widx]; }
+
+		static constexpr double kIntTolerance = 1.0e-6;
+	};
+	using PlaneProjections = std::map< geo::PlaneID, PlaneProjection >;
+
 	/// Calculate the fraction of the track that is close to non-empty pixel (above thr value)
 	/// in the ADC image of the testView (a view that was not used to build the track).
 	double validate_on_adc(const pma::Track3D& trk,
-		const img::DataProviderAlg & adcImage, float thr) const;
+		const img::DataProviderAlg & adcImage, float thr) const
+	{
+		PlaneProjections projections;
+		return validate_on_adc(trk, adcImage, thr, projections);
+	}
+
+	/// As above, with the projections of the test plane in the TPCs crossed by the track
+	/// kept in (and added to) projections, to be reused for all tracks in the event.
+	double validate_on_adc(const pma::Track3D& trk,
+		const img::DataProviderAlg & adcImage, float thr,
+		PlaneProjections & projections) const;
 
 	/// Calculate the fraction of the track that is closer than fTrkValidationDist2D
 	/// to any hit from hits in the testView (a view that was not used to build the track).
@@ -264,6 +309,9 @@ private:
 	// Calculate good number of segments depending on the number of hits.
 	static size_t getSegCount(size_t trk_size);
 
+	// Projection of the plane for validate_on_adc, made on the first use.
+	const PlaneProjection & getProjection(PlaneProjections & projections, const geo::PlaneID & planeID) const;
+
 
 	// Parameters used in the algorithm
 
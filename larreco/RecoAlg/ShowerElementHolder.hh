@@ -20,6 +20,12 @@
 #include <memory>
 #include <iomanip>
 #include <cxxabi.h>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
 
 namespace reco {
   namespace shower {
@@ -27,6 +33,8 @@ namespace reco {
     template <class T> class ShowerElementAccessor;     
     template <class T> class ShowerDataProduct; 
     template <class T, class T2> class ShowerProperty;
+    class ShowerElementRegistry;
+    class ShowerElementSlot;
     class ShowerElementHolder;
   }
 }
@@ -47,6 +55,10 @@ public:
 
   virtual std::string GetType() = 0;
 
+  //Type of the element and of its error (void if it has none). Checked before the element is cast down.
+  virtual const std::type_info& GetElementType() const = 0;
+  virtual const std::type_info& GetErrorType() const { return typeid(void); }
+
   //Check if the element has been set.
   bool CheckShowerElement(){
     if(elementPtr) return true;
@@ -105,6 +117,10 @@ public:
     return abi::__cxa_demangle(typeid(element).name(),NULL,NULL,&status);  
   }
 
+  const std::type_info& GetElementType() const override {
+    return typeid(T);
+  }
+
 protected:
   T   element; 
 };
@@ -184,6 +200,10 @@ public:
     this->element = T();
     this->elementPtr = 0;
   }
+
+  const std::type_info& GetErrorType() const override {
+    return typeid(T2);
+  }
   
 private:
   T2   propertyErr;
@@ -191,205 +211,337 @@ private:
 };
 
 
-//Class to holder all the reco::shower::ShowerElement objects. This is essentially a map from a string the object so people can 
-//add an object in a tool and get it back later. 
+//Registry of the element names. Every name is given an integer slot the first time it is seen, which is the same for
+//all the element holders in the job. Tools resolve their names to slots once when they are configured (see
+//ShowerElementSlot) so the holder can find an element with a vector index rather than a string lookup.
+class reco::shower::ShowerElementRegistry{
+
+public:
+
+  static constexpr size_t NoSlot = std::numeric_limits<size_t>::max();
+
+  static ShowerElementRegistry& Instance(){
+    static ShowerElementRegistry registry;
+    return registry;
+  }
+
+  //Return the slot of the name, giving it a new one if this is the first time it is seen.
+  size_t Register(const std::string& Name){
+    std::unique_lock<std::shared_mutex> lock(fMutex);
+    auto const slotIter = fSlots.find(Name);
+    if(slotIter != fSlots.end()) return slotIter->second;
+    size_t slot = fNames.size();
+    fSlots.emplace(Name,slot);
+    fNames.push_back(Name);
+    return slot;
+  }
+
+  //Return the slot of the name without registering it, NoSlot if it has not been seen.
+  size_t Find(const std::string& Name) const {
+    std::shared_lock<std::shared_mutex> lock(fMutex);
+    auto const slotIter = fSlots.find(Name);
+    return slotIter != fSlots.end() ? slotIter->second : NoSlot;
+  }
+
+  //Return the name of a slot.
+  std::string GetName(size_t slot) const {
+    std::shared_lock<std::shared_mutex> lock(fMutex);
+    return slot < fNames.size() ? fNames[slot] : std::string();
+  }
+
+  //Number of names registered so far.
+  size_t Size() const {
+    std::shared_lock<std::shared_mutex> lock(fMutex);
+    return fNames.size();
+  }
+
+private:
+
+  ShowerElementRegistry() = default;
+
+  mutable std::shared_mutex               fMutex;
+  std::unordered_map<std::string,size_t>  fSlots;
+  std::vector<std::string>                fNames;
+};
+
+//Name of an element together with its slot in the element holder. Use it in place of the std::string label in a tool
+//e.g. reco::shower::ShowerElementSlot fShowerDirectionInputLabel; and the holder calls with it skip the name lookup.
+//It converts back to the name so it can still be given to the functions that take a std::string.
+class reco::shower::ShowerElementSlot{
+
+public:
+
+  ShowerElementSlot() : name(), slot(reco::shower::ShowerElementRegistry::NoSlot) {}
+
+  explicit ShowerElementSlot(const std::string& Name) :
+    name(Name), slot(reco::shower::ShowerElementRegistry::Instance().Register(Name)) {}
+
+  ShowerElementSlot& operator=(const std::string& Name){
+    *this = ShowerElementSlot(Name);
+    return *this;
+  }
+
+  //Slot of a name which is only looked up and not registered. The slot is NoSlot if the name has not been seen, which
+  //the holder treats as an element that does not exist.
+  static ShowerElementSlot Find(const std::string& Name){
+    return ShowerElementSlot(Name,reco::shower::ShowerElementRegistry::Instance().Find(Name));
+  }
+
+  const std::string& Name() const { return name; }
+  size_t             Slot() const { return slot; }
+
+  operator const std::string&() const { return name; }
+
+  friend std::ostream& operator<<(std::ostream& os, const ShowerElementSlot& element){
+    return os << element.name;
+  }
+
+private:
+
+  ShowerElementSlot(const std::string& Name, size_t Slot) : name(Name), slot(Slot) {}
+
+  std::string name;
+  size_t      slot;
+};
+
+//Class to holder all the reco::shower::ShowerElement objects. The elements are stored by the slot of their name (see
+//ShowerElementRegistry) so people can add an object in a tool and get it back later. The calls which take a
+//ShowerElementSlot go straight to the element. The calls which take a std::string look the slot up first and are kept
+//for convenience, they are slower. Only the set calls register a name the registry has not seen.
 class reco::shower::ShowerElementHolder{
 
 public:
-  
+
+  ShowerElementHolder(){
+    //Make room for all the elements the tools have asked for so far.
+    size_t nslots = reco::shower::ShowerElementRegistry::Instance().Size();
+    showerproperties.resize(nslots);
+    showerdataproducts.resize(nslots);
+    showernumber = 0;
+  }
+
   //Getter function for accessing the shower property e..g the direction ShowerElementHolder.GetElement("MyShowerValue"); The name is used access the value and precise names are required for a complete shower in sbnshower: ShowerStartPosition, ShowerDirection, ShowerEnergy ,ShowerdEdx.
   template <class T >
-  int GetElement(std::string Name, T& Element){
-    if(showerproperties.find(Name) != showerproperties.end()){
-      if(showerproperties[Name]->CheckShowerElement()){
-	  reco::shower::ShowerElementAccessor<T> *showerprop = dynamic_cast<reco::shower::ShowerElementAccessor<T> *>(showerproperties[Name].get());
-	  if(showerprop == NULL){
-	    throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element you are filling is not the correct type" << std::endl;
-	  }
-	  showerprop->GetShowerElement(Element);
-	  return 0;
-	}
+  int GetElement(const reco::shower::ShowerElementSlot& Element_slot, T& Element){
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      if(showerprop->CheckShowerElement()){
+	GetAccessor<T>(showerprop,Element_slot)->GetShowerElement(Element);
+	return 0;
+      }
       else{
-	mf::LogWarning("ShowerElementHolder") << "Trying to get Element " << Name << ". This elment has not been filled" << std::endl;
+	mf::LogWarning("ShowerElementHolder") << "Trying to get Element " << Element_slot << ". This elment has not been filled" << std::endl;
 	return 1;
       }
     }
-    else if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      if(showerdataproducts[Name]->CheckShowerElement()){
-	reco::shower::ShowerElementAccessor<T> *showerprop = dynamic_cast<reco::shower::ShowerElementAccessor<T> *>(showerdataproducts[Name].get());
-	if(showerprop == NULL){
-	  throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element you are filling is not the correct type" << std::endl;
-	}
-	showerprop->GetShowerElement(Element);
+    else if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      if(showerdataprod->CheckShowerElement()){
+	GetAccessor<T>(showerdataprod,Element_slot)->GetShowerElement(Element);
 	return 0;
       }
       else{
-	mf::LogWarning("ShowerElementHolder") << "Trying to get Element " << Name << ". This elment has not been filled" << std::endl;
+	mf::LogWarning("ShowerElementHolder") << "Trying to get Element " << Element_slot << ". This elment has not been filled" << std::endl;
 	return 1;
       }
     }
-    throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element does not exist in the element holder" << std::endl;
+    throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Element_slot << ". This element does not exist in the element holder" << std::endl;
     return 1;
   }
 
+  template <class T >
+  int GetElement(std::string Name, T& Element){
+    return GetElement(reco::shower::ShowerElementSlot::Find(Name),Element);
+  }
+
   //Alternative get function that returns the object. Not recommended.
-  template <class T > 
-  T GetElement(std::string Name){
-    if(showerproperties.find(Name) != showerproperties.end()){ 
-      if(showerproperties[Name]->CheckShowerElement()){
-	reco::shower::ShowerElementAccessor<T> *showerprop = dynamic_cast<reco::shower::ShowerElementAccessor<T> *>(showerproperties[Name].get());
-	if(showerprop == NULL){
-	  throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element you are filling is not the correct type" << std::endl;
-	}
-	return showerprop->GetShowerElement();
+  template <class T >
+  T GetElement(const reco::shower::ShowerElementSlot& Element_slot){
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      if(showerprop->CheckShowerElement()){
+	return GetAccessor<T>(showerprop,Element_slot)->GetShowerElement();
       }
     }
-    else if(showerdataproducts.find(Name) != showerdataproducts.end()){   
-      if(showerdataproducts[Name]->CheckShowerElement()){ 
-	reco::shower::ShowerElementAccessor<T> *showerprop = dynamic_cast<reco::shower::ShowerElementAccessor<T> *>(showerdataproducts[Name].get());
-	if(showerprop == NULL){
-	  throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element you are filling is not the correct type" << std::endl;
-	}
-	return showerprop->GetShowerElement();
+    else if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      if(showerdataprod->CheckShowerElement()){
+	return GetAccessor<T>(showerdataprod,Element_slot)->GetShowerElement();
       }
-    }	
-    throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Name << ". This element does not exist in the element holder" << std::endl;
-    return 1;
+    }
+    throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Element_slot << ". This element does not exist in the element holder" << std::endl;
   }
-  
+
+  template <class T >
+  T GetElement(std::string Name){
+    return GetElement<T>(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
   //Getter function for accessing the shower property error e.g the direction ShowerElementHolder.GetElement("MyShowerValue");
   template <class T, class T2>
-  int GetElementAndError(std::string Name, T& Element,  T2& ElementErr){
-    if(showerproperties.find(Name) == showerproperties.end()){
-      mf::LogError("ShowerElementHolder") << "Trying to get Element Error: " << Name << ". This elment does not exist in the element holder" << std::endl;
+  int GetElementAndError(const reco::shower::ShowerElementSlot& Element_slot, T& Element,  T2& ElementErr){
+    reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot);
+    if(!showerprop){
+      mf::LogError("ShowerElementHolder") << "Trying to get Element Error: " << Element_slot << ". This elment does not exist in the element holder" << std::endl;
       return 1;
     }
-    reco::shower::ShowerProperty<T,T2> *showerprop = dynamic_cast<reco::shower::ShowerProperty<T,T2> *>(showerproperties[Name].get());
-    showerprop->GetShowerElement(Element);  
-    showerprop->GetShowerPropertyError(ElementErr);
+    GetPropertyAccessor<T,T2>(showerprop,Element_slot)->GetShowerElement(Element);
+    GetPropertyAccessor<T,T2>(showerprop,Element_slot)->GetShowerPropertyError(ElementErr);
     return 0;
   }
 
+  template <class T, class T2>
+  int GetElementAndError(std::string Name, T& Element,  T2& ElementErr){
+    return GetElementAndError(reco::shower::ShowerElementSlot::Find(Name),Element,ElementErr);
+  }
 
   //This sets the value of the data product. Just give a name and a object
   //e.g. TVector3 ShowerElementHolder.SetElement((TVector3) StartPosition, "StartPosition");
   template <class T>
-  void SetElement(T& dataproduct, std::string Name, bool checktag=false){
-    
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      reco::shower::ShowerDataProduct<T>* showerdataprod = dynamic_cast<reco::shower::ShowerDataProduct<T> *>(showerdataproducts[Name].get());
-      showerdataprod->SetShowerElement(dataproduct);
-      showerdataprod->SetCheckTag(checktag);
+  void SetElement(T& dataproduct, const reco::shower::ShowerElementSlot& Element_slot, bool checktag=false){
+
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      CheckType<T>(showerdataprod,Element_slot);
+      reco::shower::ShowerDataProduct<T>* showerdataproduct = static_cast<reco::shower::ShowerDataProduct<T> *>(showerdataprod);
+      showerdataproduct->SetShowerElement(dataproduct);
+      showerdataproduct->SetCheckTag(checktag);
       return;
     }
     else{
-      showerdataproducts[Name] = std::unique_ptr<reco::shower::ShowerDataProduct<T> >(new reco::shower::ShowerDataProduct<T>(dataproduct,checktag));
+      MakeRoom(showerdataproducts,Element_slot)  = std::unique_ptr<reco::shower::ShowerDataProduct<T> >(new reco::shower::ShowerDataProduct<T>(dataproduct,checktag));
       return;
     }
   }
 
+  template <class T>
+  void SetElement(T& dataproduct, std::string Name, bool checktag=false){
+    SetElement(dataproduct,reco::shower::ShowerElementSlot(Name),checktag);
+  }
+
   //This sets the value of the property. Just give a name and a object
   //e.g. TVector3 ShowerElementHolder.SetElement((art::Ptr<recob::Track>) track, "StartPosition", save);
   template <class T, class T2>
-  void SetElement(T& propertyval, T2& propertyvalerror, std::string Name){
+  void SetElement(T& propertyval, T2& propertyvalerror, const reco::shower::ShowerElementSlot& Element_slot){
 
-    if(showerproperties.find(Name) != showerproperties.end()){
-      reco::shower::ShowerProperty<T,T2>* showerprop = dynamic_cast<reco::shower::ShowerProperty<T,T2> *>(showerproperties[Name].get());
-      showerprop->SetShowerProperty(propertyval,propertyvalerror);
-    return;
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      GetPropertyAccessor<T,T2>(showerprop,Element_slot)->SetShowerProperty(propertyval,propertyvalerror);
+      return;
     }
     else{
-      showerproperties[Name] = std::unique_ptr<reco::shower::ShowerProperty<T,T2> >(new reco::shower::ShowerProperty<T,T2>(propertyval,propertyvalerror));
+      MakeRoom(showerproperties,Element_slot) = std::unique_ptr<reco::shower::ShowerProperty<T,T2> >(new reco::shower::ShowerProperty<T,T2>(propertyval,propertyvalerror));
       return;
     }
   }
 
-  //Check that a property is filled 
-  bool CheckElement(std::string Name){
-    if(showerproperties.find(Name) != showerproperties.end()){
-      return showerproperties[Name]->CheckShowerElement();
+  template <class T, class T2>
+  void SetElement(T& propertyval, T2& propertyvalerror, std::string Name){
+    SetElement(propertyval,propertyvalerror,reco::shower::ShowerElementSlot(Name));
+  }
+
+  //Check that a property is filled
+  bool CheckElement(const reco::shower::ShowerElementSlot& Element_slot) const {
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      return showerprop->CheckShowerElement();
     }
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      return showerdataproducts[Name]->CheckShowerElement();
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      return showerdataprod->CheckShowerElement();
     }
     return false;
   }
 
+  bool CheckElement(std::string Name) const {
+    return CheckElement(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
   //Check All the properties
   bool CheckAllElements(){
     bool checked = true;
     for(auto const& showerprop: showerproperties){
-     checked *= showerprop.second->CheckShowerElement();
+      if(showerprop) checked *= showerprop->CheckShowerElement();
     }
     for(auto const& showerdataprod: showerdataproducts){
-      checked *= showerdataprod.second->CheckShowerElement();
+      if(showerdataprod) checked *= showerdataprod->CheckShowerElement();
     }
     return checked;
   }
 
-  
+
   //Clear Fucntion. This does not delete the element.
-  void ClearElement(std::string Name){
-    if(showerproperties.find(Name) != showerproperties.end()){
-      return showerproperties[Name]->Clear();
+  void ClearElement(const reco::shower::ShowerElementSlot& Element_slot){
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      return showerprop->Clear();
     }
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      return showerdataproducts[Name]->Clear();
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      return showerdataprod->Clear();
     }
-    mf::LogError("ShowerElementHolder") << "Trying to clear Element: " << Name << ". This element does not exist in the element holder" << std::endl;
+    mf::LogError("ShowerElementHolder") << "Trying to clear Element: " << Element_slot << ". This element does not exist in the element holder" << std::endl;
     return;
   }
 
-  //Clear all the shower properties. This does not delete the element.
+  void ClearElement(std::string Name){
+    ClearElement(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
+  //Clear all the shower properties. This does not delete the element so the next shower reuses it.
   void ClearAll(){
     for(auto const& showerprop: showerproperties){
-      (showerprop.second)->Clear();
+      if(showerprop) showerprop->Clear();
     }
-    for(auto const& showerdataproducts: showerdataproducts){
-      (showerdataproducts.second)->Clear();
+    for(auto const& showerdataprod: showerdataproducts){
+      if(showerdataprod) showerdataprod->Clear();
     }
   }
 
   //Find if the product is one what is being stored.
-  bool CheckElementTag(std::string Name){
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-    return showerdataproducts[Name]->CheckTag();
+  bool CheckElementTag(const reco::shower::ShowerElementSlot& Element_slot){
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      return showerdataprod->CheckTag();
     }
     return false;
   }
- 
+
+  bool CheckElementTag(std::string Name){
+    return CheckElementTag(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
   //Delete a product. I see no reason for it.
-  void DeleteElement(std::string Name){
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      showerdataproducts[Name].reset(nullptr);
+  void DeleteElement(const reco::shower::ShowerElementSlot& Element_slot){
+    if(GetDataProduct(Element_slot)){
+      showerdataproducts[Element_slot.Slot()].reset(nullptr);
       return;
     }
-    if(showerproperties.find(Name) != showerproperties.end()){
-      showerproperties[Name].reset(nullptr);
+    if(GetProperty(Element_slot)){
+      showerproperties[Element_slot.Slot()].reset(nullptr);
       return;
     }
-    mf::LogError("ShowerElementHolder") << "Trying to delete Element: " << Name << ". This element does not exist in the element holder" << std::endl;
+    mf::LogError("ShowerElementHolder") << "Trying to delete Element: " << Element_slot << ". This element does not exist in the element holder" << std::endl;
     return;
   }
 
+  void DeleteElement(std::string Name){
+    DeleteElement(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
   //Set the indicator saying if the shower is going to be stored.
-  void SetElementTag(std::string Name, bool checkelement){
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      showerdataproducts[Name]->SetCheckTag(checkelement);
+  void SetElementTag(const reco::shower::ShowerElementSlot& Element_slot, bool checkelement){
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      showerdataprod->SetCheckTag(checkelement);
       return;
     }
-    mf::LogError("ShowerElementHolder") << "Trying set the checking of the data product: " << Name << ". This data product does not exist in the element holder" << std::endl;
+    mf::LogError("ShowerElementHolder") << "Trying set the checking of the data product: " << Element_slot << ". This data product does not exist in the element holder" << std::endl;
     return;
   }
 
+  void SetElementTag(std::string Name, bool checkelement){
+    SetElementTag(reco::shower::ShowerElementSlot::Find(Name),checkelement);
+  }
+
   bool CheckAllElementTags(){
     bool checked = true;
-    for(auto const& showerdataproduct: showerdataproducts){
-      bool check  = showerdataproduct.second->CheckTag();
+    for(size_t slot=0; slot<showerdataproducts.size(); ++slot){
+      auto const& showerdataproduct = showerdataproducts[slot];
+      if(!showerdataproduct) continue;
+      bool check  = showerdataproduct->CheckTag();
       if(check){
-	bool elementset = showerdataproduct.second->CheckShowerElement();
+	bool elementset = showerdataproduct->CheckShowerElement();
 	if(!elementset){
-	  mf::LogError("ShowerElementHolder") << "The following element is not set and was asked to be checked: " << showerdataproduct.first << std::endl;
+	  mf::LogError("ShowerElementHolder") << "The following element is not set and was asked to be checked: " << reco::shower::ShowerElementRegistry::Instance().GetName(slot) << std::endl;
 	  checked = false;
 	}
       }
@@ -401,51 +553,57 @@ public:
   void SetShowerNumber(int& shower_iter){
     showernumber = shower_iter;
   }
-  
+
   //Get the shower number.
   int GetShowerNumber(){
     return showernumber;
   }
 
-  void PrintElement(std::string Name){
-    if(showerdataproducts.find(Name) != showerdataproducts.end()){
-      std::string Type = showerdataproducts[Name]->GetType();
-      std::cout << "Element Name: " << Name << " Type: " << Type << std::endl;
+  void PrintElement(const reco::shower::ShowerElementSlot& Element_slot){
+    if(reco::shower::ShowerElementBase* showerdataprod = GetDataProduct(Element_slot)){
+      std::string Type = showerdataprod->GetType();
+      std::cout << "Element Name: " << Element_slot << " Type: " << Type << std::endl;
       return;
     }
-    if(showerproperties.find(Name) != showerproperties.end()){
-      std::string Type = showerproperties[Name]->GetType();
-      std::cout << "Element Name: " << Name << " Type: " << Type << std::endl;
+    if(reco::shower::ShowerElementBase* showerprop = GetProperty(Element_slot)){
+      std::string Type = showerprop->GetType();
+      std::cout << "Element Name: " << Element_slot << " Type: " << Type << std::endl;
       return;
     }
-    mf::LogError("ShowerElementHolder") << "Trying to print Element: " << Name << ". This element does not exist in the element holder" << std::endl;
+    mf::LogError("ShowerElementHolder") << "Trying to print Element: " << Element_slot << ". This element does not exist in the element holder" << std::endl;
     return;
   }
 
-  //This function will print out all the elements and there types for the user to check. 
+  void PrintElement(std::string Name){
+    PrintElement(reco::shower::ShowerElementSlot::Find(Name));
+  }
+
+  //This function will print out all the elements and there types for the user to check.
   void PrintElements(){
 
-    unsigned int maxname = 0;
-    for(auto const& showerprop: showerproperties){
-      if(showerprop.first.size() > maxname){
-	maxname = showerprop.first.size();
-      }
+    std::map<std::string,std::string> Type_showerprops;
+    std::map<std::string,std::string> Type_showerdataprods;
+    for(size_t slot=0; slot<showerproperties.size(); ++slot){
+      if(!showerproperties[slot]) continue;
+      std::string Type = showerproperties[slot]->GetType();
+      Type_showerprops[reco::shower::ShowerElementRegistry::Instance().GetName(slot)] = Type;
     }
-    for(auto const& showerdataprod: showerdataproducts){
-      if(showerdataprod.first.size() > maxname){
-	maxname = showerdataprod.first.size();
-      }
+    for(size_t slot=0; slot<showerdataproducts.size(); ++slot){
+      if(!showerdataproducts[slot]) continue;
+      std::string Type = showerdataproducts[slot]->GetType();
+      Type_showerdataprods[reco::shower::ShowerElementRegistry::Instance().GetName(slot)] = Type;
     }
 
-    std::map<std::string,std::string> Type_showerprops;
-    std::map<std::string,std::string> Type_showerdataprods;
-    for(auto const& showerprop: showerproperties){
-      std::string Type = (showerprop.second)->GetType();
-      Type_showerprops[showerprop.first] = Type;
+    unsigned int maxname = 0;
+    for(auto const& Type_showerprop: Type_showerprops){
+      if(Type_showerprop.first.size() > maxname){
+	maxname = Type_showerprop.first.size();
+      }
     }
-    for(auto const& showerdataprod: showerdataproducts){
-      std::string Type = (showerdataprod.second)->GetType();
-      Type_showerdataprods[showerdataprod.first] = Type;
+    for(auto const& Type_showerdataprod: Type_showerdataprods){
+      if(Type_showerdataprod.first.size() > maxname){
+	maxname = Type_showerdataprod.first.size();
+      }
     }
 
     unsigned int maxtype = 0;
@@ -474,17 +632,61 @@ public:
     }
     std::cout << std::left << std::setfill('*') << std::setw(n-1) << "*" <<std::endl;
     std::cout << std::setfill(' ');
-    std::cout << std::setw(0); 
+    std::cout << std::setw(0);
     return;
   }
 
 private:
 
-  //Storage for all the shower properties.
-  std::map<std::string,std::unique_ptr<reco::shower::ShowerElementBase> > showerproperties;
-  
-  //Storage for all the data products
-  std::map<std::string,std::unique_ptr<reco::shower::ShowerElementBase> > showerdataproducts;
+  //Element in a slot, nullptr if there is none.
+  reco::shower::ShowerElementBase* GetProperty(const reco::shower::ShowerElementSlot& Element_slot) const {
+    return Element_slot.Slot() < showerproperties.size() ? showerproperties[Element_slot.Slot()].get() : nullptr;
+  }
+
+  reco::shower::ShowerElementBase* GetDataProduct(const reco::shower::ShowerElementSlot& Element_slot) const {
+    return Element_slot.Slot() < showerdataproducts.size() ? showerdataproducts[Element_slot.Slot()].get() : nullptr;
+  }
+
+  //Grow the storage if the slot was registered after the holder was made and return the slot.
+  std::unique_ptr<reco::shower::ShowerElementBase>& MakeRoom(std::vector<std::unique_ptr<reco::shower::ShowerElementBase> >& elements,
+							      const reco::shower::ShowerElementSlot& Element_slot){
+    if(Element_slot.Slot() == reco::shower::ShowerElementRegistry::NoSlot){
+      throw cet::exception("ShowerElementHolder") << "Trying to set an element with no name" << std::endl;
+    }
+    if(Element_slot.Slot() >= elements.size()){
+      elements.resize(Element_slot.Slot()+1);
+    }
+    return elements[Element_slot.Slot()];
+  }
+
+  //Check the type of the element before casting it down.
+  template <class T>
+  void CheckType(reco::shower::ShowerElementBase* element, const reco::shower::ShowerElementSlot& Element_slot) const {
+    if(element->GetElementType() != typeid(T)){
+      throw cet::exception("ShowerElementHolder") << "Trying to access Element: " << Element_slot << ". This element is not of the type asked for" << std::endl;
+    }
+  }
+
+  template <class T>
+  reco::shower::ShowerElementAccessor<T>* GetAccessor(reco::shower::ShowerElementBase* element, const reco::shower::ShowerElementSlot& Element_slot) const {
+    CheckType<T>(element,Element_slot);
+    return static_cast<reco::shower::ShowerElementAccessor<T> *>(element);
+  }
+
+  template <class T, class T2>
+  reco::shower::ShowerProperty<T,T2>* GetPropertyAccessor(reco::shower::ShowerElementBase* element, const reco::shower::ShowerElementSlot& Element_slot) const {
+    CheckType<T>(element,Element_slot);
+    if(element->GetErrorType() != typeid(T2)){
+      throw cet::exception("ShowerElementHolder") << "Trying to get Element: " << Element_slot << ". The error of this element is not the correct type" << std::endl;
+    }
+    return static_cast<reco::shower::ShowerProperty<T,T2> *>(element);
+  }
+
+  //Storage for all the shower properties, by slot.
+  std::vector<std::unique_ptr<reco::shower::ShowerElementBase> > showerproperties;
+
+  //Storage for all the data products, by slot.
+  std::vector<std::unique_ptr<reco::shower::ShowerElementBase> > showerdataproducts;
 
   //Shower ID number. Use this to set ptr makers.
   int showernumber;
@@ -6,11 +6,9 @@ namespace tca {
 
   TCEvent evt;
   TCConfig tcc;
-  std::vector<TjForecast> tjfs;
   ShowerTreeVars stv;
   // vector of hits, tjs, etc in each slice
   std::vector<TCSlice> slices;
-  std::vector<TrajPoint> seeds;
 
   const std::vector<std::string> AlgBitNames {
     "FillGaps3D",
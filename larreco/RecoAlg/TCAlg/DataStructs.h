@@ -641,18 +641,19 @@ namespace tca {
     std::vector<ShowerStruct> cots;       // Clusters of Trajectories that define 2D showers
     std::vector<DontClusterStruct> dontCluster; // pairs of Tjs that shouldn't clustered in one shower
     std::vector<ShowerStruct3D> showers;  // 3D showers
+    // Working state used while reconstructing this slice
+    std::vector<TjForecast> tjfs;         ///< forecasts made while stepping the current Tj
+    std::vector<TrajPoint> seeds;         ///< seed TPs saved for a later attempt to make Tjs
     bool isValid {false};                 // set false if this slice failed reconstruction
    };
 
+  // Event-wide state shared by all slices, so slices are reconstructed one after another
   extern TCEvent evt;
   extern TCConfig tcc;
   extern ShowerTreeVars stv;
-  extern std::vector<TjForecast> tjfs;
 
   // vector of hits, tjs, etc in each slice
   extern std::vector<TCSlice> slices;
-  // vector of seed TPs
-  extern std::vector<TrajPoint> seeds;
 
 } // namespace tca
 
@@ -66,15 +66,15 @@ namespace tca {
     bool useMaxChiCut = (tj.PDGCode == 13 || !tj.Strategy[kSlowing]);
 
     // Get the first forecast when there are 6 points with charge
-    tjfs.resize(1);
-    tjfs[0].nextForecastUpdate = 6;
+    slc.tjfs.resize(1);
+    slc.tjfs[0].nextForecastUpdate = 6;
 
     for(unsigned short step = 1; step < 10000; ++step) {
       unsigned short npwc = NumPtsWithCharge(slc, tj, false);
       // analyze the Tj when there are 6 points to see if we should stop
       if(npwc == 6 && StopShort(slc, tj, tcc.dbgStp)) break;
       // Get a forecast of what is ahead.
-      if(tcc.doForecast && !tj.AlgMod[kRvPrp] && npwc == tjfs[tjfs.size() - 1].nextForecastUpdate) {
+      if(tcc.doForecast && !tj.AlgMod[kRvPrp] && npwc == slc.tjfs[slc.tjfs.size() - 1].nextForecastUpdate) {
         Forecast(slc, tj);
         SetStrategy(slc, tj);
         SetPDGCode(slc, tj);
@@ -344,9 +344,9 @@ namespace tca {
   void SetStrategy(TCSlice& slc, Trajectory& tj)
   {
     // Determine if the tracking strategy is appropriate and make some tweaks if it isn't
-    if(tjfs.empty()) return;
+    if(slc.tjfs.empty()) return;
     // analyze the last forecast
-    auto& tjf = tjfs[tjfs.size() - 1];
+    auto& tjf = slc.tjfs[slc.tjfs.size() - 1];
 
     auto& lastTP = tj.Pts[tj.EndPt[1]];
     // Stay in Slowing strategy if we are in it and reduce the number of points fit further
@@ -449,9 +449,9 @@ namespace tca {
     if(tj.Pts[tj.EndPt[1]].AngleCode == 2) return;
 
     // add a new forecast
-    tjfs.resize(tjfs.size() + 1);
+    slc.tjfs.resize(slc.tjfs.size() + 1);
     // assume there is insufficient info to make a decision
-    auto& tjf = tjfs[tjfs.size() - 1];
+    auto& tjf = slc.tjfs[slc.tjfs.size() - 1];
     tjf.outlook = -1;
     tjf.nextForecastUpdate = USHRT_MAX;
 
@@ -2778,7 +2778,7 @@ namespace tca {
       if(tcc.dbgStp) mf::LogVerbatim("TC")<<"  clobber TPs "<<PrintPos(slc, tj.Pts[0])<<" to "<<PrintPos(slc, tj.Pts[firstPtFit])<<". Call TrimEndPts then ReversePropagate ";
       // first save the first TP on this trajectory. We will try to re-use it if
       // it isn't used during reverse propagation
-      seeds.push_back(tj.Pts[0]);
+      slc.seeds.push_back(tj.Pts[0]);
       for(unsigned short ipt = 0; ipt <= firstPtFit; ++ipt) UnsetUsedHits(slc, tj.Pts[ipt]);
       SetEndPoints(tj);
       tj.AlgMod[kFTBRvProp] = true;
@@ -99,10 +99,10 @@ class shower::TRACSAlg {
     art::ServiceHandle<geo::Geometry const> fGeom;
     art::ServiceHandle<art::TFileService>   tfs;
 
-    std::string fInitialTrackInputLabel;
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionInputLabel;
-    std::string fInitialTrackSpacePointsInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackInputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackSpacePointsInputLabel;
 
 };
 
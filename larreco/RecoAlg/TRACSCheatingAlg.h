@@ -65,9 +65,9 @@ class shower::TRACSCheatingAlg {
     art::ServiceHandle<art::TFileService>   tfs;
 
 
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionInputLabel;
-    std::string fInitialTrackSpacePointsInputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackSpacePointsInputLabel;
 
 };
 #endif
@@ -1,6 +1,7 @@
 #include "TrackKalmanFitter.h"
 
 #include "canvas/Persistency/Common/Ptr.h"
+#include "cetlib_except/exception.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include <float.h>
@@ -33,6 +34,9 @@
 #include "larreco/TrackFinder/TrackMaker.h"
 #include "larreco/RecoAlg/TrackCreationBookKeeper.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 bool trkf::TrackKalmanFitter::fitTrack(const recob::TrackTrajectory& traj, const int tkID, const SMatrixSym55& covVtx, const SMatrixSym55& covEnd,
 				       const std::vector<art::Ptr<recob::Hit> >& hits, const double pval, const int pdgid, const bool flipDirection,
 				       recob::Track& outTrack, std::vector<art::Ptr<recob::Hit> >& outHits, trkmkr::OptionalOutputs& optionals) const {
@@ -86,6 +90,22 @@ bool trkf::TrackKalmanFitter::fitTrack(const recob::TrackTrajectory& traj, const
   }
 }
 
+void trkf::TrackKalmanFitter::fitTracks(const std::vector<TrackFitInput>& inputs, std::vector<TrackFitOutput>& outputs, size_t grainSize) const {
+  if (outputs.size()!=inputs.size()) {
+    throw cet::exception("TrackKalmanFitter") << "fitTracks called with " << inputs.size() << " inputs and " << outputs.size() << " outputs\n";
+  }
+  //each track only reads the configuration and the services, and writes to its own output
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, inputs.size(), std::max(grainSize, size_t(1))),
+		    [&](const tbb::blocked_range<size_t>& range) {
+		      for (size_t i = range.begin(); i != range.end(); ++i) {
+			const TrackFitInput& in = inputs[i];
+			TrackFitOutput& out = outputs[i];
+			out.fitok = fitTrack(*in.traj, in.tkID, in.covVtx, in.covEnd, in.hits, in.pval, in.pdgid, in.flipDirection,
+					     *out.track, *out.hits, *out.optionals);
+		      }
+		    });
+}
+
 bool trkf::TrackKalmanFitter::fitTrack(const Point_t& position, const Vector_t& direction, SMatrixSym55& trackStateCov,
 				       const std::vector<art::Ptr<recob::Hit> >& hits, const std::vector<recob::TrajectoryPointFlags>& flags,
 				       const int tkID, const double pval, const int pdgid,
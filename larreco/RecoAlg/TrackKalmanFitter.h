@@ -10,6 +10,8 @@
 #include "lardata/RecoObjects/KFTrackState.h"
 #include "lardataobj/RecoBase/TrajectoryPointFlags.h"
 
+#include <vector>
+
 namespace recob {
   class Hit;
   class Track;
@@ -37,6 +39,8 @@ namespace trkf {
    *
    * Outputs are: resulting recob::Track, associated hits, and trkmkr::OptionalOutputs.
    *
+   * Parallel per-track fitting: fitTracks() fits the tracks of an event independently on TBB workers, with the same results as calling fitTrack() on each of them in turn.
+   *
    * For configuration options see TrackKalmanFitter#Config
    *
    * @author  G. Cerati (FNAL, MicroBooNE)
@@ -187,6 +191,31 @@ namespace trkf {
 		  const int tkID, const double pval, const int pdgid,
 		  recob::Track& outTrack, std::vector<art::Ptr<recob::Hit> >& outHits, trkmkr::OptionalOutputs& optionals) const;
 
+    /// Arguments of fitTrack starting from TrackTrajectory, for one track of a batch
+    struct TrackFitInput {
+      const recob::TrackTrajectory* traj = nullptr;
+      int tkID = -1;
+      SMatrixSym55 covVtx;
+      SMatrixSym55 covEnd;
+      std::vector<art::Ptr<recob::Hit> > hits;
+      double pval = 0.;
+      int pdgid = 0;
+      bool flipDirection = false;
+    };
+
+    /// Results of fitTrack for one track of a batch, written to objects owned by the caller
+    struct TrackFitOutput {
+      bool fitok = false;
+      recob::Track* track = nullptr;
+      std::vector<art::Ptr<recob::Hit> >* hits = nullptr;
+      trkmkr::OptionalOutputs* optionals = nullptr;
+    };
+
+    /// Parallel per-track fitting: fit each track of a batch with fitTrack starting from TrackTrajectory, spread over TBB workers in chunks of grainSize tracks.
+    /// inputs and outputs must have the same size, and each output must point to its own track, hits and optionals (initialized by the caller as for fitTrack).
+    /// The outputs are identical to the ones of fitTrack called in sequence.
+    void fitTracks(const std::vector<TrackFitInput>& inputs, std::vector<TrackFitOutput>& outputs, size_t grainSize = 1) const;
+
     /// Function where the core of the fit is performed
     bool doFitWork(KFTrackState& trackState, std::vector<HitState>& hitstatev, std::vector<recob::TrajectoryPointFlags::Mask_t>& hitflagsv,
 		   std::vector<KFTrackState>& fwdPrdTkState, std::vector<KFTrackState>& fwdUpdTkState,
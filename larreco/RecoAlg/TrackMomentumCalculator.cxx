@@ -18,8 +18,6 @@
 #include "Math/GenVector/PositionVector3D.h"
 #include "Minuit2/Minuit2Minimizer.h"
 #include "Rtypes.h"
-#include "TAxis.h"
-#include "TGraphErrors.h"
 #include "TMath.h"
 #include "TMatrixDSymEigen.h"
 #include "TMatrixDSymfwd.h"
@@ -27,7 +25,6 @@
 #include "TMatrixT.h"
 #include "TMatrixTSym.h"
 #include "TPolyLine3D.h"
-#include "TSpline.h"
 #include "TVectorDfwd.h"
 #include "TVectorT.h"
 #include "canvas/Persistency/Common/Ptr.h"
@@ -56,8 +53,94 @@ namespace {
     10,    14,    20,    30,    40,     80,     100,    140,    200,   300,
     400,   800,   1000,  1400,  2000,   3000,   4000,   8000,   10000, 14000,
     20000, 30000, 40000, 80000, 100000, 140000, 200000, 300000, 400000}};
-  TGraph const KEvsR{29, Range_grampercm.data(), KE_MeV.data()};
-  TSpline3 const KEvsR_spline3{"KEvsRS", &KEvsR};
+
+  // Cubic spline of kinetic energy versus range, built at compile time with
+  // the not-a-knot end conditions that TSpline3 uses by default (de Boor's
+  // CUBSPL); the polynomial of each interval is y + dx*(b + dx*(c + dx*d)).
+  class KEvsRSpline {
+  public:
+    static constexpr std::size_t N = 29;
+
+    constexpr KEvsRSpline(std::array<float, N> const& range,
+                          std::array<float, N> const& ke)
+    {
+      std::array<double, N> c3{}, c4{};
+      for (std::size_t i = 0; i < N; ++i) {
+        x_[i] = range[i];
+        y_[i] = ke[i];
+      }
+      // first differences of the knots and first divided differences
+      for (std::size_t m = 1; m < N; ++m) {
+        c3[m] = x_[m] - x_[m - 1];
+        c4[m] = (y_[m] - y_[m - 1]) / c3[m];
+      }
+      // not-a-knot condition at the first knot
+      c4[0] = c3[2];
+      c3[0] = c3[1] + c3[2];
+      b_[0] = ((c3[1] + 2. * c3[0]) * c4[1] * c3[2] + c3[1] * c3[1] * c4[2]) / c3[0];
+      // forward elimination of the tridiagonal system for the slopes
+      for (std::size_t m = 1; m < N - 1; ++m) {
+        double const g = -c3[m + 1] / c4[m - 1];
+        b_[m] = g * b_[m - 1] + 3. * (c3[m] * c4[m + 1] + c3[m + 1] * c4[m]);
+        c4[m] = g * c3[m - 1] + 2. * (c3[m] + c3[m + 1]);
+      }
+      // not-a-knot condition at the last knot
+      double g = c3[N - 2] + c3[N - 1];
+      b_[N - 1] = ((c3[N - 1] + 2. * g) * c4[N - 1] * c3[N - 2] +
+                   c3[N - 1] * c3[N - 1] * (y_[N - 2] - y_[N - 3]) / c3[N - 2]) / g;
+      g = -g / c4[N - 2];
+      c4[N - 1] = g * c3[N - 2] + c3[N - 2];
+      b_[N - 1] = (g * b_[N - 2] + b_[N - 1]) / c4[N - 1];
+      // back substitution
+      for (std::size_t j = N - 1; j-- > 0;) {
+        b_[j] = (b_[j] - c3[j] * b_[j + 1]) / c4[j];
+      }
+      // polynomial coefficients of each interval
+      for (std::size_t i = 1; i < N; ++i) {
+        double const dtau = c3[i];
+        double const divdf1 = (y_[i] - y_[i - 1]) / dtau;
+        double const divdf3 = b_[i - 1] + b_[i] - 2. * divdf1;
+        c_[i - 1] = (divdf1 - b_[i - 1] - divdf3) / dtau;
+        d_[i - 1] = (divdf3 / dtau) / dtau;
+      }
+    }
+
+    // outside the table the first or the last interval is extrapolated
+    constexpr double
+    Eval(double const r) const
+    {
+      std::size_t klow = 0;
+      if (r >= x_[N - 1]) {
+        klow = N - 2;
+      }
+      else if (r > x_[0]) {
+        std::size_t khig = N - 1;
+        while (khig - klow > 1) {
+          std::size_t const mid = (klow + khig) / 2;
+          if (r > x_[mid])
+            klow = mid;
+          else
+            khig = mid;
+        }
+      }
+      double const dx = r - x_[klow];
+      return y_[klow] + dx * (b_[klow] + dx * (c_[klow] + dx * d_[klow]));
+    }
+
+  private:
+    std::array<double, N> x_{}, y_{}, b_{}, c_{}, d_{};
+  };
+
+  constexpr KEvsRSpline KEvsR_spline3{Range_grampercm, KE_MeV};
+
+  // momenta of the likelihood scan of GetMomentumMultiScatterLLHD
+  std::vector<double> const llhd_p_tests = [] {
+    std::vector<double> p_tests;
+    for (int k = 0; k <= 750; ++k) {
+      p_tests.push_back(0.001 + k * 0.01);
+    }
+    return p_tests;
+  }();
 
 
   TVector3 const basex{1, 0, 0};
@@ -296,28 +379,31 @@ namespace trkf {
     double logL = 1e+16;
     double bf = -666.0; // double errs = -666.0;
 
-    int const start1{};
-    int const end1{750};
-    int const start2{};
-    int const end2{}; // 800.0;
-
-    for (int k = start1; k <= end1; ++k) {
-      double const p_test = 0.001 + k * 0.01;
-
-      for (int l = start2; l <= end2; ++l) {
-        double const res_test = 2.0; // 0.001+l*1.0;
-        double const fv = my_mcs_llhd(dEi, dEj, dthij, ind, p_test, res_test);
+    double const res_test = 2.0; // 0.001+l*1.0;
+    std::vector<double> llhd_values;
+    my_mcs_llhd_scan(dEi, dEj, dthij, ind, llhd_p_tests, res_test, llhd_values);
 
-        if (fv < logL) {
-          bf = p_test;
-          logL = fv;
-          // errs = res_test;
-        }
+    for (std::size_t k = 0; k < llhd_p_tests.size(); ++k) {
+      if (llhd_values[k] < logL) {
+        bf = llhd_p_tests[k];
+        logL = llhd_values[k];
       }
     }
     return bf;
   }
 
+  std::vector<double>
+  TrackMomentumCalculator::GetMomentumMultiScatterLLHD(
+    std::vector<art::Ptr<recob::Track>> const& trks)
+  {
+    std::vector<double> result;
+    result.reserve(trks.size());
+    for (auto const& trk : trks) {
+      result.push_back(GetMomentumMultiScatterLLHD(trk));
+    }
+    return result;
+  }
+
   TVector3
   TrackMomentumCalculator::GetMultiScatterStartingPoint(
     const art::Ptr<recob::Track>& trk)
@@ -525,9 +611,6 @@ namespace trkf {
     if (recoL < minLength || recoL > maxLength)
       return -1;
 
-    double ymax = -999.0;
-    double ymin = +999.0;
-
     std::vector<double> xmeas;
     std::vector<double> ymeas;
     std::vector<double> eymeas;
@@ -554,11 +637,6 @@ namespace trkf {
       xmeas.push_back(trial); // Is this what is intended?
       ymeas.push_back(rms);
       eymeas.push_back(std::sqrt(cet::sum_of_squares(rmse, 0.05 * rms))); // <--- conservative syst. error to fix chi^{2} behaviour !!!
-
-      if (ymin > rms)
-        ymin = rms;
-      if (ymax < rms)
-        ymax = rms;
     }
 
     assert(xmeas.size() == ymeas.size());
@@ -567,21 +645,6 @@ namespace trkf {
       return -1.0;
     }
 
-    TGraphErrors gr_meas{n_steps, xmeas.data(), ymeas.data(), nullptr, eymeas.data()};
-
-    gr_meas.SetTitle("(#Delta#theta)_{rms} versus material thickness; Material "
-                     "thickness in cm; (#Delta#theta)_{rms} in mrad");
-
-    gr_meas.SetLineColor(kBlack);
-    gr_meas.SetMarkerColor(kBlack);
-    gr_meas.SetMarkerStyle(20);
-    gr_meas.SetMarkerSize(1.2);
-
-    gr_meas.GetXaxis()->SetLimits(steps.at(0) - steps.at(0),
-                                  steps.at(n_steps - 1) + steps.at(0));
-    gr_meas.SetMinimum(0.0);
-    gr_meas.SetMaximum(1.80 * ymax);
-
     ROOT::Minuit2::Minuit2Minimizer mP{};
     FcnWrapper const wrapper{move(xmeas), move(ymeas), move(eymeas)};
     ROOT::Math::Functor FCA([&wrapper](double const* xs) { return wrapper.my_mcs_chi2(xs); }, 2);
@@ -609,6 +672,18 @@ namespace trkf {
     return mstatus ? p_mcs : -1.0;
   }
 
+  std::vector<double>
+  TrackMomentumCalculator::GetMomentumMultiScatterChi2(
+    std::vector<art::Ptr<recob::Track>> const& trks)
+  {
+    std::vector<double> result;
+    result.reserve(trks.size());
+    for (auto const& trk : trks) {
+      result.push_back(GetMomentumMultiScatterChi2(trk));
+    }
+    return result;
+  }
+
   bool
   TrackMomentumCalculator::plotRecoTracks_(std::vector<float> const& xxx,
                                            std::vector<float> const& yyy,
@@ -1286,4 +1361,62 @@ namespace trkf {
     return result;
   }
 
+  void
+  TrackMomentumCalculator::my_mcs_llhd_scan(std::vector<float> const& dEi,
+                                            std::vector<float> const& dEj,
+                                            std::vector<float> const& dthij,
+                                            std::vector<float> const& ind,
+                                            std::vector<double> const& p_tests,
+                                            double const x1,
+                                            std::vector<double>& results) const
+  {
+    // Same terms as my_mcs_llhd, summed in the same order for each momentum:
+    // the loop over the momenta is innermost and has no dependencies.
+    auto const np = p_tests.size();
+    results.assign(np, 0.0);
+    std::vector<double> addth_values(np, 0.0);
+
+    double const red_length = (10.0) / 14.0;
+    double const hl_log = 1.0 + 0.038 * std::log(red_length);
+    double const hl_sqrt = std::sqrt(red_length);
+    double const theta0x2 = pow(x1, 2.0);
+    double const g_const = -0.5 * std::log(2.0 * TMath::Pi());
+
+    double const* p = p_tests.data();
+    double* addth = addth_values.data();
+    double* result = results.data();
+
+    auto const n = dEi.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      double const ei = dEi[i];
+      double const ej = dEj[i];
+
+      if (ind[i] != 1) {
+        for (std::size_t k = 0; k < np; ++k) {
+          if (p[k] - ei > 0 && p[k] - ej < 0)
+            addth[k] = 3.14 * 1000.0;
+        }
+        continue;
+      }
+
+      double const dth = dthij[i];
+      for (std::size_t k = 0; k < np; ++k) {
+        double const Ei = p[k] - ei;
+        double const Ej = p[k] - ej;
+
+        if (Ei > 0 && Ej < 0)
+          addth[k] = 3.14 * 1000.0;
+
+        double const tH0 =
+          (13.6 / std::sqrt(std::abs(Ei) * std::abs(Ej))) * hl_log * hl_sqrt;
+        double const rms = std::sqrt(tH0 * tH0 + theta0x2);
+        double const arg = (dth + addth[k]) / rms;
+        double const prob =
+          (rms == 0.) ? 0. : g_const - std::log(rms) - 0.5 * arg * arg;
+
+        result[k] = result[k] - 2.0 * prob;
+      }
+    }
+  }
+
 } // namespace track
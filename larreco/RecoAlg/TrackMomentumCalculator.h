@@ -27,6 +27,8 @@ namespace trkf {
     double GetTrackMomentum(double trkrange, int pdg) const;
     double GetMomentumMultiScatterChi2(art::Ptr<recob::Track> const& trk);
     double GetMomentumMultiScatterLLHD(art::Ptr<recob::Track> const& trk);
+    std::vector<double> GetMomentumMultiScatterChi2(std::vector<art::Ptr<recob::Track>> const& trks);
+    std::vector<double> GetMomentumMultiScatterLLHD(std::vector<art::Ptr<recob::Track>> const& trks);
     double GetMuMultiScatterLLHD3(art::Ptr<recob::Track> const& trk, bool dir);
     TVector3 GetMultiScatterStartingPoint(art::Ptr<recob::Track> const& trk);
 
@@ -65,6 +67,15 @@ namespace trkf {
                        std::vector<float> const& ind,
                        double x0, double x1) const;
 
+    // my_mcs_llhd for all of p_tests at once
+    void my_mcs_llhd_scan(std::vector<float> const& dEi,
+                          std::vector<float> const& dEj,
+                          std::vector<float> const& dthij,
+                          std::vector<float> const& ind,
+                          std::vector<double> const& p_tests,
+                          double x1,
+                          std::vector<double>& results) const;
+
     float seg_stop{-1.};
     int n_seg{};
 
@@ -101,6 +112,9 @@ namespace trkf {
     TGraph gr_seg_yz{};
     TGraph gr_seg_xz{};
 
+    //this is for unit testing...class has no other purpose
+    friend class TrackMomentumCalculatorTest;
+
   };
 
 } // namespace trkf
@@ -297,7 +297,6 @@ namespace tca {
 
     if(!CreateSlice(hitsInSlice, sliceID)) return;
 
-    seeds.resize(0);
     // get a reference to the stored slice
     auto& slc = slices[slices.size() - 1];
     // special debug mode reconstruction
@@ -560,7 +559,7 @@ namespace tca {
 
       // See if there are any seed trajectory points that were saved before reverse
       // propagation and try to make Tjs from them
-      for(auto tp : seeds) {
+      for(auto tp : slc.seeds) {
         unsigned short nAvailable = 0;
         for(unsigned short ii = 0; ii < tp.Hits.size(); ++ii) {
           if(!tp.UseHit[ii]) continue;
@@ -610,7 +609,7 @@ namespace tca {
         BraggSplit(slc, slc.tjs.size() - 1);
       } // seed
 
-       seeds.resize(0);
+       slc.seeds.resize(0);
 
        bool lastPass = (pass == tcc.minPtsFit.size() - 1);
        // don't use lastPass cuts if we will use LastEndMerge
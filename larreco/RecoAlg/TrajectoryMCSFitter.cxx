@@ -3,6 +3,10 @@
 #include "TMatrixDSym.h"
 #include "TMatrixDSymEigen.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 using namespace std;
 using namespace trkf;
 using namespace recob::tracking;
@@ -95,6 +99,7 @@ void TrajectoryMCSFitter::breakTrajInSegments(const recob::TrackTrajectory& traj
 }
 
 const TrajectoryMCSFitter::ScanResult TrajectoryMCSFitter::doLikelihoodScan(std::vector<float>& dtheta, std::vector<float>& seg_nradlengths, std::vector<float>& cumLen, bool fwdFit, bool momDepConst, int pid) const {
+  if (goldenSearch_) return doLikelihoodSearch(dtheta, seg_nradlengths, cumLen, fwdFit, momDepConst, pid);
   int    best_idx  = -1;
   double best_logL = std::numeric_limits<double>::max();
   double best_p    = -1.0;
@@ -129,7 +134,79 @@ const TrajectoryMCSFitter::ScanResult TrajectoryMCSFitter::doLikelihoodScan(std:
       } else break;
     }
   }
-  return ScanResult(best_p, std::max(lunc,runc), best_logL);
+  return ScanResult(best_p, std::max(lunc,runc), best_logL, vlogL.size());
+}
+
+const TrajectoryMCSFitter::ScanResult TrajectoryMCSFitter::doLikelihoodSearch(std::vector<float>& dtheta, std::vector<float>& seg_nradlengths, std::vector<float>& cumLen, bool fwdFit, bool momDepConst, int pid) const {
+  //
+  // same momentum grid as the scan, each point evaluated at most once
+  //
+  std::vector<double> vp;
+  for (double p_test = pMin_; p_test <= pMax_; p_test+=pStep_) vp.push_back(p_test);
+  const int np = vp.size();
+  if (np==0) return ScanResult(-1.0, -1.0, std::numeric_limits<double>::max());
+  std::vector<double> vlogL(np);
+  std::vector<bool> done(np, false);
+  int nEvals = 0;
+  auto logL = [&](const int idx) {
+    if (!done[idx]) {
+      vlogL[idx] = mcsLikelihood(vp[idx], angResol_, dtheta, seg_nradlengths, cumLen, fwdFit, momDepConst, pid);
+      done[idx] = true;
+      nEvals++;
+    }
+    return vlogL[idx];
+  };
+  //
+  // coarse bracketing: the first of the lowest points, as in the scan
+  //
+  constexpr int nCoarse = 32;
+  const int stride = std::max(1, np/nCoarse);
+  int best_idx = 0;
+  for (int i = stride; i < np+stride-1; i+=stride) {
+    const int idx = std::min(i, np-1);
+    if (logL(idx) < logL(best_idx)) best_idx = idx;
+  }
+  int lo = std::max(0, best_idx-stride);
+  int hi = std::min(np-1, best_idx+stride);
+  //
+  // golden-section search on the grid points within the bracket; ties move towards low momenta
+  //
+  constexpr double invPhi = 0.6180339887498949;
+  while (hi-lo>3) {
+    const int x1 = hi - std::lround(invPhi*(hi-lo));
+    const int x2 = std::max(int(lo + std::lround(invPhi*(hi-lo))), x1+1);
+    if (logL(x1) <= logL(x2)) hi = x2;
+    else lo = x1;
+  }
+  for (int i = lo; i <= hi; ++i) {
+    if (logL(i) < logL(best_idx) || (logL(i) == logL(best_idx) && i < best_idx)) best_idx = i;
+  }
+  //
+  // uncertainty from the curvature at the minimum, where logL changes by 0.5: first from the neighbouring
+  // grid points, then from the points at that distance so that the estimate covers the width of the minimum
+  //
+  double unc = -1.0;
+  int h = 1;
+  for (int iter = 0; iter < 2; ++iter) {
+    if (best_idx-h<0 || best_idx+h>np-1) break;
+    const double d2logL = (logL(best_idx-h) - 2.*logL(best_idx) + logL(best_idx+h))/(h*h*pStep_*pStep_);
+    if (!std::isfinite(d2logL) || d2logL<=0.) break;
+    unc = 1./std::sqrt(d2logL);
+    h = std::max(1, int(std::lround(unc/pStep_)));
+    if (h>std::min(best_idx, np-1-best_idx)) break;
+  }
+  //
+  // no curvature at the edges of the grid or next to unphysical momenta: walk away from the minimum as in the scan
+  //
+  if (unc<0.) {
+    for (int dir : {-1, +1}) {
+      for (int j = best_idx+dir; j>=0 && j<np; j+=dir) {
+	if (logL(j)-logL(best_idx)<0.5) unc = std::max(unc, std::abs(j-best_idx)*pStep_);
+	else break;
+      }
+    }
+  }
+  return ScanResult(vp[best_idx], unc, logL(best_idx), nEvals);
 }
 
 void TrajectoryMCSFitter::linearRegression(const recob::TrackTrajectory& traj, const size_t firstPoint, const size_t lastPoint, Vector_t& pcdir) const {
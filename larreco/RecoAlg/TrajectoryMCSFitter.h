@@ -20,6 +20,9 @@ namespace trkf {
    *
    * Inputs are: a Track or Trajectory, and various fit parameters (pIdHypothesis, minNumSegments, segmentLength, pMin, pMax, pStep, angResol)
    *
+   * The likelihood is minimized on the momentum grid from pMin to pMax in pStep steps, either scanning all grid points or,
+   * with goldenSectionSearch, bracketing the minimum on a coarse grid and refining it with a golden-section search.
+   *
    * Outputs are: a recob::MCSFitResult, containing:
    *   resulting momentum, momentum uncertainty, and best likelihood value (both for fwd and bwd fit);
    *   vector of segment (radiation) lengths, vector of scattering angles, and PID hypothesis used in the fit.
@@ -87,10 +90,15 @@ namespace trkf {
 	Comment("Angular resolution parameter used in modified Highland formula. Unit is mrad."),
 	3.0
       };
+      fhicl::Atom<bool> goldenSectionSearch {
+        Name("goldenSectionSearch"),
+	Comment("Bracket the likelihood minimum on a coarse momentum grid and refine it with a golden-section search instead of the full scan; the momentum uncertainty is then computed from the curvature of the likelihood."),
+	false
+      };
     };
     using Parameters = fhicl::Table<Config>;
     //
-    TrajectoryMCSFitter(int pIdHyp, int minNSegs, double segLen, int minHitsPerSegment, int nElossSteps, int eLossMode, double pMin, double pMax, double pStep, double angResol){
+    TrajectoryMCSFitter(int pIdHyp, int minNSegs, double segLen, int minHitsPerSegment, int nElossSteps, int eLossMode, double pMin, double pMax, double pStep, double angResol, bool goldenSearch = false){
       pIdHyp_ = pIdHyp;
       minNSegs_ = minNSegs;
       segLen_ = segLen;
@@ -101,9 +109,10 @@ namespace trkf {
       pMax_ = pMax;
       pStep_ = pStep;
       angResol_ = angResol;
+      goldenSearch_ = goldenSearch;
     }
     explicit TrajectoryMCSFitter(const Parameters & p)
-      : TrajectoryMCSFitter(p().pIdHypothesis(),p().minNumSegments(),p().segmentLength(),p().minHitsPerSegment(),p().nElossSteps(),p().eLossMode(),p().pMin(),p().pMax(),p().pStep(),p().angResol()) {}
+      : TrajectoryMCSFitter(p().pIdHypothesis(),p().minNumSegments(),p().segmentLength(),p().minHitsPerSegment(),p().nElossSteps(),p().eLossMode(),p().pMin(),p().pMax(),p().pStep(),p().angResol(),p().goldenSectionSearch()) {}
     //
     recob::MCSFitResult fitMcs(const recob::TrackTrajectory& traj, bool momDepConst = true) const { return fitMcs(traj,pIdHyp_,momDepConst); }
     recob::MCSFitResult fitMcs(const recob::Track& track,          bool momDepConst = true) const { return fitMcs(track,pIdHyp_,momDepConst); }
@@ -123,11 +132,15 @@ namespace trkf {
     //
     struct ScanResult {
       public:
-        ScanResult(double ap, double apUnc, double alogL) : p(ap), pUnc(apUnc), logL(alogL) {}
+        ScanResult(double ap, double apUnc, double alogL, int anEvals = 0) : p(ap), pUnc(apUnc), logL(alogL), nEvals(anEvals) {}
         double p, pUnc, logL;
+        int nEvals; ///< number of likelihood evaluations
     };
     //
+    /// Minimum of the likelihood on the momentum grid, with the full scan or the golden-section search depending on the configuration
     const ScanResult doLikelihoodScan(std::vector<float>& dtheta, std::vector<float>& seg_nradlengths, std::vector<float>& cumLen, bool fwdFit, bool momDepConst, int pid) const;
+    /// Coarse bracketing of the minimum followed by a golden-section search on the grid points; uncertainty from the likelihood curvature
+    const ScanResult doLikelihoodSearch(std::vector<float>& dtheta, std::vector<float>& seg_nradlengths, std::vector<float>& cumLen, bool fwdFit, bool momDepConst, int pid) const;
     //
     inline double MomentumDependentConstant(const double p) const {
       //these are from https://arxiv.org/abs/1703.06187
@@ -158,6 +171,7 @@ namespace trkf {
     double pMax_;
     double pStep_;
     double angResol_;
+    bool   goldenSearch_;
   };
 }
 
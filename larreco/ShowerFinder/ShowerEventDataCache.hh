@@ -0,0 +1,201 @@
+//###################################################################
+//### Name:        ShowerEventDataCache                           ###
+//### Description: Class to hold the event data the shower tools  ###
+//###              read, e.g. handles and FindManyP tables. The   ###
+//###              tools ask for what they need when the module   ###
+//###              is made and it is read once per event.         ###
+//###################################################################
+
+#ifndef ShowerEventDataCache_HH
+#define ShowerEventDataCache_HH
+
+//Framework includes
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "canvas/Persistency/Common/FindManyP.h"
+#include "canvas/Persistency/Common/FindOneP.h"
+#include "canvas/Utilities/InputTag.h"
+#include "cetlib_except/exception.h"
+
+//C++ Includes
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace reco {
+  namespace shower {
+    class ShowerEventDataBase;
+    template <class T> class ShowerEventHandle;
+    template <class F, class B> class ShowerEventAssociation;
+    class ShowerEventDataCache;
+  }
+}
+
+//Base class for an entry of the cache.
+class reco::shower::ShowerEventDataBase {
+
+public:
+
+  virtual ~ShowerEventDataBase() noexcept = default;
+
+  //Read the entry from the event.
+  virtual void Fill(const art::Event& evt) = 0;
+
+  //Forget the entry of the last event.
+  virtual void Clear() = 0;
+};
+
+//Handle to the std::vector<T> made by a module.
+template <class T>
+class reco::shower::ShowerEventHandle : public reco::shower::ShowerEventDataBase {
+
+public:
+
+  ShowerEventHandle(const art::InputTag& Label) : label(Label) {}
+
+  void Fill(const art::Event& evt) override {
+    evt.getByLabel(label, handle);
+  }
+
+  void Clear() override {
+    handle.clear();
+  }
+
+  const art::Handle<std::vector<T> >& GetHandle() const {
+    return handle;
+  }
+
+private:
+
+  art::InputTag                  label;
+  art::Handle<std::vector<T> >   handle;
+};
+
+//Association table F (e.g. art::FindManyP<recob::Hit>) of the std::vector<B> made by a module, made with the
+//associations of the same module.
+template <class F, class B>
+class reco::shower::ShowerEventAssociation : public reco::shower::ShowerEventDataBase {
+
+public:
+
+  ShowerEventAssociation(const art::InputTag& Label) : label(Label) {}
+
+  void Fill(const art::Event& evt) override {
+    art::Handle<std::vector<B> > handle;
+    if(evt.getByLabel(label, handle)){
+      association = std::make_unique<F>(handle, evt, label);
+    }
+    else{
+      association.reset();
+    }
+  }
+
+  void Clear() override {
+    association.reset();
+  }
+
+  const F* GetAssociation() const {
+    return association.get();
+  }
+
+private:
+
+  art::InputTag        label;
+  std::unique_ptr<F>   association;
+};
+
+//Read-only event data shared by the shower tools. The tools ask for their handles and associations in
+//RequestEventData() when the module is made, the module fills the cache once per event before running the tools
+//and the tools get the entries back while they calculate the shower. Nothing is read from the event after the cache
+//is filled so it can be used by the tools of several PFParticles at the same time.
+class reco::shower::ShowerEventDataCache {
+
+public:
+
+  //Ask for the handle to the std::vector<T> made by the module Label.
+  template <class T>
+  void RequestHandle(const art::InputTag& Label){
+    Request<reco::shower::ShowerEventHandle<T> >(typeid(std::vector<T>), Label);
+  }
+
+  //Ask for the art::FindManyP<A> of the std::vector<B> made by the module Label.
+  template <class A, class B>
+  void RequestFindManyP(const art::InputTag& Label){
+    Request<reco::shower::ShowerEventAssociation<art::FindManyP<A>,B> >(typeid(std::pair<art::FindManyP<A>,B>), Label);
+  }
+
+  //Ask for the art::FindOneP<A> of the std::vector<B> made by the module Label.
+  template <class A, class B>
+  void RequestFindOneP(const art::InputTag& Label){
+    Request<reco::shower::ShowerEventAssociation<art::FindOneP<A>,B> >(typeid(std::pair<art::FindOneP<A>,B>), Label);
+  }
+
+  //Read all the requested data from the event.
+  void Fill(const art::Event& evt){
+    for(auto const& entry: entries){
+      entry.second->Fill(evt);
+    }
+  }
+
+  //Forget the data of the last event.
+  void Clear(){
+    for(auto const& entry: entries){
+      entry.second->Clear();
+    }
+  }
+
+  template <class T>
+  const art::Handle<std::vector<T> >& GetHandle(const art::InputTag& Label) const {
+    return Get<reco::shower::ShowerEventHandle<T> >(typeid(std::vector<T>), Label).GetHandle();
+  }
+
+  template <class A, class B>
+  const art::FindManyP<A>& GetFindManyP(const art::InputTag& Label) const {
+    return GetAssociation<art::FindManyP<A>,B>(typeid(std::pair<art::FindManyP<A>,B>), Label);
+  }
+
+  template <class A, class B>
+  const art::FindOneP<A>& GetFindOneP(const art::InputTag& Label) const {
+    return GetAssociation<art::FindOneP<A>,B>(typeid(std::pair<art::FindOneP<A>,B>), Label);
+  }
+
+private:
+
+  using Key = std::pair<std::type_index,std::string>;
+
+  template <class E>
+  void Request(const std::type_info& type, const art::InputTag& Label){
+    Key key(type, Label.encode());
+    if(entries.find(key) == entries.end()){
+      entries[key] = std::make_unique<E>(Label);
+    }
+  }
+
+  template <class E>
+  const E& Get(const std::type_info& type, const art::InputTag& Label) const {
+    auto const entry = entries.find(Key(type, Label.encode()));
+    if(entry == entries.end()){
+      throw cet::exception("ShowerEventDataCache") << "Trying to get " << type.name() << " from " << Label.encode() << ". This was not requested in RequestEventData()" << std::endl;
+    }
+    return static_cast<const E&>(*entry->second);
+  }
+
+  template <class F, class B>
+  const F& GetAssociation(const std::type_info& type, const art::InputTag& Label) const {
+    const F* association = Get<reco::shower::ShowerEventAssociation<F,B> >(type, Label).GetAssociation();
+    if(association == nullptr){
+      throw cet::exception("ShowerEventDataCache") << "Could not make the association " << type.name() << " from " << Label.encode() << ". The products are not in the event" << std::endl;
+    }
+    return *association;
+  }
+
+  //Requested data, by type and module label.
+  std::map<Key,std::unique_ptr<reco::shower::ShowerEventDataBase> > entries;
+
+};
+
+
+#endif
@@ -0,0 +1,88 @@
+//###################################################################
+//### Name:        ShowerPFParticleLoop                           ###
+//### Description: The loops TRACS runs over the PFParticles of an ###
+//###              event: one PFParticle at a time, or the tools  ###
+//###              for all the shower PFParticles at once and the ###
+//###              showers made after in the PFParticle order.    ###
+//###################################################################
+
+#ifndef ShowerPFParticleLoop_HH
+#define ShowerPFParticleLoop_HH
+
+//LArSoft Includes
+#include "larreco/RecoAlg/ShowerElementHolder.hh"
+
+//C++ Includes
+#include <cstddef>
+#include <vector>
+
+//TBB Includes
+#include "tbb/parallel_for.h"
+
+namespace reco {
+  namespace shower {
+
+    //Only electron and photon like PFParticles are made into showers.
+    template <class PFPPtr>
+    bool IsShowerPFParticle(const PFPPtr& pfp){
+      return pfp->PdgCode() == 11 || pfp->PdgCode() == 22;
+    }
+
+    //Runs the tools for each shower PFParticle and then makes the shower, one PFParticle at a time.
+    //The holder is shared so the elements of a PFParticle are still there for the next one.
+    //runTools(pfp,holder) returns the error code of the tools and makeShower(pfp,err,holder,shower_iter)
+    //increases shower_iter when it makes a shower.
+    template <class PFPPtr, class RunTools, class MakeShower>
+    void LoopPFParticles(const std::vector<PFPPtr>& pfps, int& shower_iter,
+                         RunTools&& runTools, MakeShower&& makeShower){
+
+      //Holder to pass to the functions, contains the 6 properties of the shower
+      // - Start Poistion
+      // - Direction
+      // - Initial Track
+      // - Initial Track Hits
+      // - Energy
+      // - dEdx
+      reco::shower::ShowerElementHolder selement_holder;
+      for(auto const& pfp: pfps){
+
+        //Update the shower iterator
+        selement_holder.SetShowerNumber(shower_iter);
+
+        //loop only over showers.
+        if(!IsShowerPFParticle(pfp)){continue;}
+
+        int err = runTools(pfp,selement_holder);
+        makeShower(pfp,err,selement_holder,shower_iter);
+      }
+    }
+
+    //Same as LoopPFParticles but the tools run for all the shower PFParticles at the same time,
+    //each with its own holder, so the tools must be reentrant. The showers are then made in the
+    //PFParticle order so the products are the same as in LoopPFParticles. Each PFParticle starts
+    //with an empty holder and the shower number is only set for makeShower.
+    template <class PFPPtr, class RunTools, class MakeShower>
+    void LoopPFParticlesConcurrently(const std::vector<PFPPtr>& pfps, int& shower_iter,
+                                     RunTools&& runTools, MakeShower&& makeShower){
+
+      std::vector<PFPPtr> showerpfps;
+      for(auto const& pfp: pfps){
+        if(IsShowerPFParticle(pfp)){showerpfps.push_back(pfp);}
+      }
+
+      std::vector<reco::shower::ShowerElementHolder> selement_holders(showerpfps.size());
+      std::vector<int> errs(showerpfps.size(),0);
+      tbb::parallel_for(static_cast<std::size_t>(0), showerpfps.size(), [&](std::size_t pfp_iter){
+        errs[pfp_iter] = runTools(showerpfps[pfp_iter],selement_holders[pfp_iter]);
+      });
+
+      for(std::size_t pfp_iter=0; pfp_iter<showerpfps.size(); ++pfp_iter){
+        selement_holders[pfp_iter].SetShowerNumber(shower_iter);
+        makeShower(showerpfps[pfp_iter],errs[pfp_iter],selement_holders[pfp_iter],shower_iter);
+      }
+    }
+
+  }
+}
+
+#endif
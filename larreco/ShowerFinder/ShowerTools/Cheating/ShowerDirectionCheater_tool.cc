@@ -70,9 +70,9 @@ namespace ShowerRecoTools {
     float vertexDotProduct;
     float rmsGradient;
 
-    std::string fShowerStartPositionInputLabel;
-    std::string fTrueParticleInputLabel;
-    std::string fShowerDirectionOuputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fTrueParticleInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionOuputLabel;
 
   };
 
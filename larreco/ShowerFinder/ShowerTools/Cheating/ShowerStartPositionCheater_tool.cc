@@ -53,8 +53,8 @@ namespace ShowerRecoTools {
       art::InputTag fPFParticleModuleLabel;
       art::InputTag fHitModuleLabel;
 
-      std::string fShowerStartPositionOutputLabel;
-      std::string fTrueParticleOutputLabel;
+      reco::shower::ShowerElementSlot fShowerStartPositionOutputLabel;
+      reco::shower::ShowerElementSlot fTrueParticleOutputLabel;
 
   };
 
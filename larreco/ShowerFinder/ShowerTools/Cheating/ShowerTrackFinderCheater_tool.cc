@@ -58,11 +58,11 @@ namespace ShowerRecoTools {
       art::InputTag fPFParticleModuleLabel;
       art::InputTag fHitModuleLabel;
 
-      std::string fTrueParticleIntputLabel;
-      std::string fShowerStartPositionInputTag;
-      std::string fShowerDirectionInputTag;
-      std::string fInitialTrackHitsOutputLabel;
-      std::string fInitialTrackSpacePointsOutputLabel;
+      reco::shower::ShowerElementSlot fTrueParticleIntputLabel;
+      reco::shower::ShowerElementSlot fShowerStartPositionInputTag;
+      reco::shower::ShowerElementSlot fShowerDirectionInputTag;
+      reco::shower::ShowerElementSlot fInitialTrackHitsOutputLabel;
+      reco::shower::ShowerElementSlot fInitialTrackSpacePointsOutputLabel;
   };
 
 
@@ -20,6 +20,7 @@
 #include "lardataobj/RecoBase/PFParticle.h"
 #include "larreco/RecoAlg/ShowerElementHolder.hh"
 #include "larreco/ShowerFinder/ShowerProduedPtrsHolder.hh"
+#include "larreco/ShowerFinder/ShowerEventDataCache.hh"
 #include "larreco/RecoAlg/TRACSAlg.h"
 
 //C++ Includes
@@ -72,6 +73,23 @@ namespace ShowerRecoTools{
         UniquePtrs = &uniqueproducerPtrs;
       }
 
+      //Function to ask for the handles and associations the tool reads from the event i.e.
+      //cache.RequestFindManyP<recob::Hit,recob::Cluster>(fPFParticleModuleLabel); commands go here.
+      virtual void RequestEventData(reco::shower::ShowerEventDataCache& cache){}
+
+      //Initialises the event data cache so that the tool can read the event data without going to the event.
+      void InitialiseEventDataCache(const reco::shower::ShowerEventDataCache& cache){
+        EventDataCache = &cache;
+      }
+
+      //Whether CalculateElement can run for several PFParticles at once. A tool that changes
+      //its own members, uses an algorithm or service that does, or writes to the TFileService
+      //must keep the default.
+      virtual bool IsReentrant() const { return false; }
+
+      //Whether the event display is run after the element is calculated.
+      bool EventDisplayEnabled() const { return fRunEventDisplay; }
+
       //End function so the user can add associations
       virtual int  AddAssociations(art::Event& Event,
           reco::shower::ShowerElementHolder& ShowerEleHolder){return 0;}
@@ -79,11 +97,22 @@ namespace ShowerRecoTools{
     protected:
       const shower::TRACSAlg& GetTRACSAlg() { return fTRACSAlg; };
 
+      //Event data asked for in RequestEventData(), filled for the current event.
+      const reco::shower::ShowerEventDataCache& GetEventDataCache(){
+        if(EventDataCache == nullptr){
+          throw cet::exception("IShowerTool") << "The event data cache has not been set" << std::endl;
+        }
+        return *EventDataCache;
+      }
+
     private:
 
       //ptr to the holder of all the unique ptrs.
       reco::shower::ShowerProduedPtrsHolder* UniquePtrs;
 
+      //ptr to the event data read by the tools.
+      const reco::shower::ShowerEventDataCache* EventDataCache = nullptr;
+
       //Algorithm functions
       shower::TRACSAlg fTRACSAlg;
 
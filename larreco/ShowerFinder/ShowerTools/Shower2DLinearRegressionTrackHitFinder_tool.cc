@@ -44,6 +44,9 @@ namespace ShowerRecoTools{
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
+
+    //Only reads the event and the element holder.
+    bool IsReentrant() const override { return true; }
     
   private:
     
@@ -64,10 +67,10 @@ namespace ShowerRecoTools{
     bool                       fApplyChargeWeight;  //Apply charge weighting to the fit.
     art::InputTag              fPFParticleModuleLabel;
     art::InputTag              fHitsModuleLabel;
-    std::string                fShowerStartPositionInputLabel;
-    std::string                fShowerDirectionInputLabel;
-    std::string                fInitialTrackHitsOutputLabel;
-    std::string                fInitialTrackSpacePointsOutputLabel;
+    reco::shower::ShowerElementSlot                fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot                fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot                fInitialTrackHitsOutputLabel;
+    reco::shower::ShowerElementSlot                fInitialTrackSpacePointsOutputLabel;
   };
   
 
@@ -43,11 +43,17 @@ namespace ShowerRecoTools{
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
+
+    void RequestEventData(reco::shower::ShowerEventDataCache& cache) override;
+
+    //Only reads the event data cache and the element holder.
+    bool IsReentrant() const override { return true; }
     
   private:
     
     std::vector<art::Ptr<recob::SpacePoint> > FindTrackSpacePoints(std::vector<art::Ptr<recob::SpacePoint> >& spacePoints,
-								   TVector3& showerStartPosition,TVector3& showerDirection);
+								   TVector3& showerStartPosition,TVector3& showerDirection,
+								   float maxProjectionDist);
     
     
     //Fcl paramters
@@ -60,12 +66,12 @@ namespace ShowerRecoTools{
     
     art::InputTag fPFParticleModuleLabel;
     
-    std::string fInitialTrackLengthInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackLengthInputLabel;
     std::string fShowerEnergyInputLabel;
-    std::string fShowerStartPositionInputLabel;
-    std::string fInitialTrackHitsOuputLabel;
-    std::string fInitialTrackSpacePointsOutputLabel;
-    std::string fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackHitsOuputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackSpacePointsOutputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionInputLabel;
   };
 
 
@@ -88,15 +94,22 @@ namespace ShowerRecoTools{
   {
   }
 
+  void Shower3DTrackHitFinder::RequestEventData(reco::shower::ShowerEventDataCache& cache){
+    cache.RequestFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
+    cache.RequestFindOneP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
+  }
+
   int Shower3DTrackHitFinder::CalculateElement(const art::Ptr<recob::PFParticle>& pfparticle,
 					       art::Event& Event, 
 					       reco::shower::ShowerElementHolder& ShowerEleHolder){
     
 
-    //If we want to use a dynamic length value on a second iteraction get theta value now
+    //If we want to use a dynamic length value on a second iteraction get theta value now.
+    //Kept local as the tool can run for several PFParticles at once.
+    float maxProjectionDist = fMaxProjectionDist;
     if(fAllowDyanmicLength){
       if(ShowerEleHolder.CheckElement(fInitialTrackLengthInputLabel)){
-        ShowerEleHolder.GetElement(fInitialTrackLengthInputLabel,fMaxProjectionDist);
+        ShowerEleHolder.GetElement(fInitialTrackLengthInputLabel,maxProjectionDist);
       }
     }
 
@@ -116,29 +129,15 @@ namespace ShowerRecoTools{
     TVector3 ShowerDirection     = {-999,-999,-999};
     ShowerEleHolder.GetElement(fShowerDirectionInputLabel,ShowerDirection);
 
-    // Get the assocated pfParicle Handle
-    art::Handle<std::vector<recob::PFParticle> > pfpHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, pfpHandle)){
-      throw cet::exception("Shower3DTrackHitFinder") << "Could not get the pandora pf particles. Something is not cofingured correctly Please give the correct pandoa module label. Stopping";
-      return 1;
-    }
-
     // Get the spacepoint - PFParticle assn
-    art::FindManyP<recob::SpacePoint> fmspp(pfpHandle, Event, fPFParticleModuleLabel);
+    const art::FindManyP<recob::SpacePoint>& fmspp = IShowerTool::GetEventDataCache().GetFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
     if (!fmspp.isValid()){
       throw cet::exception("Shower3DTrackHitFinder") << "Trying to get the spacepoint and failed. Something is not configured correctly. Stopping ";
       return 1;
     }
 
-    // Get the spacepoints
-    art::Handle<std::vector<recob::SpacePoint> > spHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, spHandle)){
-      throw cet::exception("Shower3DTrackHitFinder") << "Could not configure the spacepoint handle. Something is configured incorrectly. Stopping";
-      return 1;
-    }
-
     // Get the hits associated with the space points
-    art::FindOneP<recob::Hit> fohsp(spHandle, Event, fPFParticleModuleLabel);
+    const art::FindOneP<recob::Hit>& fohsp = IShowerTool::GetEventDataCache().GetFindOneP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
     if(!fohsp.isValid()){
       throw cet::exception("Shower3DTrackHitFinder") << "Spacepoint and hit association not valid. Stopping.";
       return 1;
@@ -158,7 +157,7 @@ namespace ShowerRecoTools{
 
     // Get only the space points from the track
     std::vector<art::Ptr<recob::SpacePoint> > trackSpacePoints;
-    trackSpacePoints = FindTrackSpacePoints(spacePoints,ShowerStartPosition,ShowerDirection);
+    trackSpacePoints = FindTrackSpacePoints(spacePoints,ShowerStartPosition,ShowerDirection,maxProjectionDist);
 
     // Get the hits associated to the space points and seperate them by planes
     std::vector<art::Ptr<recob::Hit> > trackHits;
@@ -175,7 +174,8 @@ namespace ShowerRecoTools{
 
   std::vector<art::Ptr<recob::SpacePoint> > Shower3DTrackHitFinder::FindTrackSpacePoints(std::vector<art::Ptr<recob::SpacePoint> >& spacePoints, 
 											 TVector3& showerStartPosition,
-											 TVector3& showerDirection){
+											 TVector3& showerDirection,
+											 float maxProjectionDist){
 
     // Make a vector to hold the output space points
     std::vector<art::Ptr<recob::SpacePoint> > trackSpacePoints;
@@ -189,11 +189,11 @@ namespace ShowerRecoTools{
           showerStartPosition, showerDirection, proj);
 
       if (fForwardHitsOnly){
-        if (proj>0 && proj<fMaxProjectionDist && TMath::Abs(perp)<fMaxPerpendicularDist){
+        if (proj>0 && proj<maxProjectionDist && TMath::Abs(perp)<fMaxPerpendicularDist){
           trackSpacePoints.push_back(spacePoint);
         }
       } else {
-        if (TMath::Abs(proj)<fMaxProjectionDist && TMath::Abs(perp)<fMaxPerpendicularDist){
+        if (TMath::Abs(proj)<maxProjectionDist && TMath::Abs(perp)<fMaxPerpendicularDist){
           trackSpacePoints.push_back(spacePoint);
         }
       }
@@ -35,6 +35,9 @@ namespace ShowerRecoTools {
           reco::shower::ShowerElementHolder& ShowerEleHolder
           ) override;
 
+      //Does nothing, so it can run for several PFParticles at once.
+      bool IsReentrant() const override { return true; }
+
     private:
 
       // Function to initialise the producer i.e produces<std::vector<recob::Vertex> >();
@@ -45,6 +45,11 @@ namespace ShowerRecoTools {
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerElementHolder
 			 ) override;
+
+    //Only reads the event data cache and the element holder.
+    bool IsReentrant() const override { return true; }
+
+    void RequestEventData(reco::shower::ShowerEventDataCache& cache) override;
   private:
     
     double CalculateEnergy(std::vector<art::Ptr<recob::Hit> >& hits, geo::View_t& view);
@@ -65,7 +70,7 @@ namespace ShowerRecoTools {
     
     art::InputTag fPFParticleModuleLabel;
 
-    std::string   fShowerEnergyOutputLabel;
+    reco::shower::ShowerElementSlot   fShowerEnergyOutputLabel;
 
     //Services
     detinfo::DetectorProperties const* detprop = nullptr;
@@ -97,6 +102,11 @@ namespace ShowerRecoTools {
   {
   }
 
+  void ShowerLinearEnergy::RequestEventData(reco::shower::ShowerEventDataCache& cache){
+    cache.RequestFindManyP<recob::Cluster,recob::PFParticle>(fPFParticleModuleLabel);
+    cache.RequestFindManyP<recob::Hit,recob::Cluster>(fPFParticleModuleLabel);
+  }
+
 
 
   int ShowerLinearEnergy::CalculateElement(const art::Ptr<recob::PFParticle>& pfparticle,
@@ -108,26 +118,14 @@ namespace ShowerRecoTools {
     std::vector<double> ShowerLinearEnergy;
     unsigned int numPlanes = fGeom->Nplanes();
 
-    // Get the assocated pfParicle vertex PFParticles
-    art::Handle<std::vector<recob::PFParticle> > pfpHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, pfpHandle)){
-      throw cet::exception("ShowerLinearEnergy") << "Could not get the pandora pf particles. Something is not cofingured coreectly Please give the correct pandoa module label. Stopping";
-      return 1;
-    }
-
     std::map<geo::View_t, std::vector<art::Ptr<recob::Hit> > > view_hits;
 
     //Get the clusters
-    art::Handle<std::vector<recob::Cluster> > clusHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, clusHandle)){
-      throw cet::exception("ShowerLinearEnergy") << "Could not get the pandora clusters. Something is not cofingured coreectly Please give the correct pandoa module label. Stopping";
-      return 1;
-    }
-    art::FindManyP<recob::Cluster> fmc(pfpHandle, Event, fPFParticleModuleLabel);
+    const art::FindManyP<recob::Cluster>& fmc = IShowerTool::GetEventDataCache().GetFindManyP<recob::Cluster,recob::PFParticle>(fPFParticleModuleLabel);
     std::vector<art::Ptr<recob::Cluster> > clusters = fmc.at(pfparticle.key());
 
     //Get the hit association
-    art::FindManyP<recob::Hit> fmhc(clusHandle, Event, fPFParticleModuleLabel);
+    const art::FindManyP<recob::Hit>& fmhc = IShowerTool::GetEventDataCache().GetFindManyP<recob::Hit,recob::Cluster>(fPFParticleModuleLabel);
 
     //Loop over the clusters in the plane and get the hits
     for(auto const& cluster: clusters){
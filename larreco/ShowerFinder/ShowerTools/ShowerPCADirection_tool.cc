@@ -49,12 +49,17 @@ namespace ShowerRecoTools {
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
+
+    //Only reads the event data cache and the element holder.
+    bool IsReentrant() const override { return true; }
+
+    void RequestEventData(reco::shower::ShowerEventDataCache& cache) override;
     
   private:
     
     // Define standard art tool interface
     TVector3 ShowerPCAVector(std::vector<art::Ptr<recob::SpacePoint> >& spacePoints_pfp, 
-			     art::FindManyP<recob::Hit>& fmh, 
+			     const art::FindManyP<recob::Hit>& fmh, 
 			     TVector3& ShowerCentre);
    
     double  RMSShowerGradient(std::vector<art::Ptr<recob::SpacePoint> >& sps, 
@@ -71,9 +76,9 @@ namespace ShowerRecoTools {
                              //PCA vector is decided as (Shower Centre - Shower Start Position). 
     bool fChargeWeighted;    //Should the PCA axis be charge weighted.
 
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionOutputLabel; 
-    std::string fShowerCentreOutputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionOutputLabel; 
+    reco::shower::ShowerElementSlot fShowerCentreOutputLabel;
 
   };
   
@@ -94,30 +99,25 @@ namespace ShowerRecoTools {
   {
   }
 
+  void ShowerPCADirection::RequestEventData(reco::shower::ShowerEventDataCache& cache){
+    cache.RequestFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
+    cache.RequestFindManyP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
+  }
+
   int ShowerPCADirection::CalculateElement(const art::Ptr<recob::PFParticle>& pfparticle,
 					   art::Event& Event,
 					   reco::shower::ShowerElementHolder& ShowerEleHolder){
 
-    // Get the assocated pfParicle vertex PFParticles
-    art::Handle<std::vector<recob::PFParticle> > pfpHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, pfpHandle)){
-      throw cet::exception("ShowerPCADirection") << "Could not get the pandora pf particles. Something is not cofingured coreectly Please give the correct pandoa module label. Stopping";
-      return 1;
-    }
-    art::FindManyP<recob::SpacePoint> fmspp(pfpHandle, Event, fPFParticleModuleLabel);
+    // Get the assocated pfParicle spacepoints
+    const art::FindManyP<recob::SpacePoint>& fmspp = IShowerTool::GetEventDataCache().GetFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
 
     if (!fmspp.isValid()){
       throw cet::exception("ShowerPCADirection") << "Trying to get the spacepoint and failed. Something is not configured correctly. Stopping ";
       return 1;
     }
 
-    //Get the spacepoints handle and the hit assoication
-    art::Handle<std::vector<recob::SpacePoint> > spHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, spHandle)){
-      throw cet::exception("ShowerPCADirection") << "Could not configure the spacepoint handle. Something is configured incorrectly. Stopping";
-      return 1;
-    }
-    art::FindManyP<recob::Hit> fmh(spHandle, Event, fPFParticleModuleLabel);
+    //Get the spacepoint hit assoication
+    const art::FindManyP<recob::Hit>& fmh = IShowerTool::GetEventDataCache().GetFindManyP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
     if(!fmh.isValid()){
       throw cet::exception("ShowerPCADirection") << "Spacepoint and hit association not valid. Stopping.";
       return 1;
@@ -240,7 +240,7 @@ namespace ShowerRecoTools {
   }
 
   //Function to calculate the shower direction using a charge weight 3D PCA calculation.
-  TVector3 ShowerPCADirection::ShowerPCAVector(std::vector<art::Ptr<recob::SpacePoint> >& sps, art::FindManyP<recob::Hit>& fmh, TVector3& ShowerCentre){
+  TVector3 ShowerPCADirection::ShowerPCAVector(std::vector<art::Ptr<recob::SpacePoint> >& sps, const art::FindManyP<recob::Hit>& fmh, TVector3& ShowerCentre){
 
     //Initialise the the PCA.
     TPrincipal *pca = new TPrincipal(3,"");
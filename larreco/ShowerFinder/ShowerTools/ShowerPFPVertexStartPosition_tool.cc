@@ -48,14 +48,19 @@ namespace ShowerRecoTools{
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
+
+    //Only reads the event data cache and the element holder.
+    bool IsReentrant() const override { return true; }
+
+    void RequestEventData(reco::shower::ShowerEventDataCache& cache) override;
     
     
     private:
     
     //fcl parameters
     art::InputTag fPFParticleModuleLabel; 
-    std::string   fShowerStartPositionOutputLabel; 
-    std::string   fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot   fShowerStartPositionOutputLabel; 
+    reco::shower::ShowerElementSlot   fShowerDirectionInputLabel;
   };
 
 
@@ -71,39 +76,33 @@ namespace ShowerRecoTools{
   {
   }
 
+  void ShowerPFPVertexStartPosition::RequestEventData(reco::shower::ShowerEventDataCache& cache){
+    cache.RequestHandle<recob::Vertex>(fPFParticleModuleLabel);
+    cache.RequestFindManyP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
+    cache.RequestFindManyP<recob::Vertex,recob::PFParticle>(fPFParticleModuleLabel);
+    cache.RequestFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
+  }
+
   int ShowerPFPVertexStartPosition::CalculateElement(const art::Ptr<recob::PFParticle>& pfparticle,
 					    art::Event& Event, 
 					    reco::shower::ShowerElementHolder& ShowerEleHolder){
 
     //Get the vertices.
-    art::Handle<std::vector<recob::Vertex> > vtxHandle;
-    std::vector<art::Ptr<recob::Vertex> > vertices;
-    if (Event.getByLabel(fPFParticleModuleLabel, vtxHandle))
-      art::fill_ptr_vector(vertices, vtxHandle);
-    else {
+    const reco::shower::ShowerEventDataCache& eventData = IShowerTool::GetEventDataCache();
+    if (!eventData.GetHandle<recob::Vertex>(fPFParticleModuleLabel).isValid()){
       throw cet::exception("ShowerPFPVertexStartPosition") << "Could not get the pandora vertices. Something is not configured correctly. Please give the correct pandora module label. Stopping";
       return 1;
     }
     
-    //Get the spacepoints handle and the hit assoication
-    art::Handle<std::vector<recob::SpacePoint> > spHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, spHandle)){
-      throw cet::exception("ShowerPFPVertexStartPosition") << "Could not configure the spacepoint handle. Something is configured incorrectly. Stopping";
-      return 1;
-    }
-    art::FindManyP<recob::Hit> fmh(spHandle, Event, fPFParticleModuleLabel);
+    //Get the spacepoint hit assoication
+    const art::FindManyP<recob::Hit>& fmh = eventData.GetFindManyP<recob::Hit,recob::SpacePoint>(fPFParticleModuleLabel);
     if(!fmh.isValid()){
       throw cet::exception("ShowerPFPVertexStartPosition") << "Spacepoint and hit association not valid. Stopping.";
       return 1;
     }
 
     // Get the assocated pfParicle vertex PFParticles
-    art::Handle<std::vector<recob::PFParticle> > pfpHandle;
-    if (!Event.getByLabel(fPFParticleModuleLabel, pfpHandle)){
-      throw cet::exception("ShowerPFPVertexStartPosition") << "Could not get the pandora pf particles. Something is not cofingured coreectly Please give the correct pandoa module label. Stopping";
-      return 1;
-    }
-    art::FindManyP<recob::Vertex> fmv(pfpHandle, Event, fPFParticleModuleLabel);
+    const art::FindManyP<recob::Vertex>& fmv = eventData.GetFindManyP<recob::Vertex,recob::PFParticle>(fPFParticleModuleLabel);
     if(!fmv.isValid()){
       throw cet::exception("ShowerPFPVertexStartPosition") << "Vertex and PF particle association is somehow not valid. Stopping";
       return 1;
@@ -138,7 +137,7 @@ namespace ShowerRecoTools{
       TVector3 ShowerDirection = {-999, -999, -999};
       ShowerEleHolder.GetElement(fShowerDirectionInputLabel,ShowerDirection);
 
-      art::FindManyP<recob::SpacePoint> fmspp(pfpHandle, Event, fPFParticleModuleLabel);
+      const art::FindManyP<recob::SpacePoint>& fmspp = eventData.GetFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
 
       if (!fmspp.isValid()){
         throw cet::exception("ShowerPFPVertexStartPosition") << "Trying to get the spacepoints and failed. Something is not configured correctly. Stopping ";
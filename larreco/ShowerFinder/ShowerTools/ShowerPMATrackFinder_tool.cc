@@ -63,11 +63,11 @@ namespace ShowerRecoTools{
 
     //fcl paramters
     float fMinTrajectoryPoints; //Minimum number of trajectory points returned from the fit to decide the track is good.
-    std::string fInitialTrackLengthOutputLabel;
-    std::string fInitialTrackOutputLabel;
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionInputLabel;
-    std::string fInitialTrackHitsInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackLengthOutputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackOutputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackHitsInputLabel;
   };
 
 
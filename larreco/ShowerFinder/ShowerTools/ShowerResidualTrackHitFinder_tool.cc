@@ -127,10 +127,10 @@ namespace ShowerRecoTools {
       float         fTrackMaxAdjacentSPDistance;
       bool          fRunTest;
       bool          fMakeTrackSeed;
-      std::string   fShowerStartPositionInputLabel;
-      std::string   fShowerDirectionInputLabel;
-      std::string   fInitialTrackHitsOutputLabel;
-      std::string   fInitialTrackSpacePointsOutputLabel;
+      reco::shower::ShowerElementSlot   fShowerStartPositionInputLabel;
+      reco::shower::ShowerElementSlot   fShowerDirectionInputLabel;
+      reco::shower::ShowerElementSlot   fInitialTrackHitsOutputLabel;
+      reco::shower::ShowerElementSlot   fInitialTrackSpacePointsOutputLabel;
   };
 
 
@@ -51,6 +51,9 @@ namespace ShowerRecoTools{
 			 art::Event& Event, 
 			 reco::shower::ShowerElementHolder& ShowerEleHolder) override;
 
+    //The dEdx calibration may not be reentrant (see CalorimetryAlg).
+    bool IsReentrant() const override { return fCalorimetryAlg.IsReentrant(); }
+
   private:
 
     //Servcies and Algorithms
@@ -74,12 +77,12 @@ namespace ShowerRecoTools{
     bool fCutStartPosition; //Remove hits using MinDistCutOff from the vertex as well. 
     art::InputTag fPFParticleModuleLabel;
     
-    std::string fShowerStartPositionInputLabel;
-    std::string fInitialTrackSpacePointsInputLabel;
-    std::string fInitialTrackInputLabel;
-    std::string fShowerdEdxOuputLabel;
-    std::string fShowerBestPlaneOutputLabel;
-    std::string fShowerdEdxVecOuputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackSpacePointsInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackInputLabel;
+    reco::shower::ShowerElementSlot fShowerdEdxOuputLabel;
+    reco::shower::ShowerElementSlot fShowerBestPlaneOutputLabel;
+    reco::shower::ShowerElementSlot fShowerdEdxVecOuputLabel;
   };
 
 
@@ -43,6 +43,9 @@ namespace ShowerRecoTools {
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
 
+    //Only reads the element holder.
+    bool IsReentrant() const override { return true; }
+
   private:
 
     //fcl
@@ -59,9 +62,9 @@ namespace ShowerRecoTools {
                                 //use the angle between the the points themselves
     float fAngleCut;
     
-    std::string fInitialTrackInputLabel;
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionOuputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackInputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionOuputLabel;
   };
 
 
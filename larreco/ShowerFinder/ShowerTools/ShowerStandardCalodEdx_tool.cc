@@ -43,6 +43,9 @@ namespace ShowerRecoTools{
 			 art::Event& Event,
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
+
+    //The dEdx calibration may not be reentrant (see CalorimetryAlg).
+    bool IsReentrant() const override { return fCalorimetryAlg.IsReentrant(); }
     
   private:
     
@@ -54,11 +57,11 @@ namespace ShowerRecoTools{
     double fdEdxTrackLength; //Max length from a hit can be to the start point in cm.
     bool   fMaxHitPlane;     //Set the best planes as the one with the most hits
     bool   fMissFirstPoint;  //Do not use any hits from the first wire.
-    std::string fShowerStartPositionInputLabel;
-    std::string fInitialTrackHitsInputLabel;
-    std::string fShowerDirectionInputLabel;
-    std::string fShowerdEdxOutputLabel;
-    std::string fShowerBestPlaneOutputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackHitsInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionInputLabel;
+    reco::shower::ShowerElementSlot fShowerdEdxOutputLabel;
+    reco::shower::ShowerElementSlot fShowerBestPlaneOutputLabel;
   };
 
 
@@ -46,6 +46,9 @@ namespace ShowerRecoTools {
 			 reco::shower::ShowerElementHolder& ShowerEleHolder
 			 ) override;
 
+    //Only reads the element holder.
+    bool IsReentrant() const override { return true; }
+
   private:
 
     //fcl
@@ -57,9 +60,9 @@ namespace ShowerRecoTools {
                             //((Position of traj point + 1) - (Position of traj point).
     int  fTrajPoint;        //Trajectory point to get the direction from.   
 
-    std::string fInitialTrackInputLabel;
-    std::string fShowerStartPositionInputLabel;
-    std::string fShowerDirectionOutputLabel;
+    reco::shower::ShowerElementSlot fInitialTrackInputLabel;
+    reco::shower::ShowerElementSlot fShowerStartPositionInputLabel;
+    reco::shower::ShowerElementSlot fShowerDirectionOutputLabel;
   };
 
 
@@ -91,13 +94,15 @@ namespace ShowerRecoTools {
     recob::Track InitialTrack;
     ShowerEleHolder.GetElement(fInitialTrackInputLabel,InitialTrack);
 
-    if((int)InitialTrack.NumberTrajectoryPoints()-1 < fTrajPoint){
+    //Kept local so a short track does not change the point used for the next showers.
+    int trajPoint = fTrajPoint;
+    if((int)InitialTrack.NumberTrajectoryPoints()-1 < trajPoint){
       mf::LogError("ShowerTrackTrajectoryPointDirection") << "Less that fTrajPoint trajectory points, bailing."<< std::endl;
-      fTrajPoint = InitialTrack.NumberTrajectoryPoints()-1;
+      trajPoint = InitialTrack.NumberTrajectoryPoints()-1;
     }
 
     //ignore bogus info.
-    auto flags = InitialTrack.FlagsAtPoint(fTrajPoint);
+    auto flags = InitialTrack.FlagsAtPoint(trajPoint);
     if(flags.isSet(recob::TrajectoryPointFlagTraits::NoPoint))
     {
       mf::LogError("ShowerTrackTrajectoryPointDirection") << "Bogus trajectory point bailing."<< std::endl;
@@ -124,12 +129,12 @@ namespace ShowerRecoTools {
         StartPosition = InitialTrack.Start();
       }
       //Get the specific trajectory point and look and and the direction from the start position
-      geo::Point_t  TrajPosition = InitialTrack.LocationAtPoint(fTrajPoint);
+      geo::Point_t  TrajPosition = InitialTrack.LocationAtPoint(trajPoint);
       Direction_vec  = (TrajPosition - StartPosition).Unit();
     }
     else{
       //Use the direction of the trajection at tat point;
-      Direction_vec = InitialTrack.DirectionAtPoint(fTrajPoint);
+      Direction_vec = InitialTrack.DirectionAtPoint(trajPoint);
     }
 
     TVector3 Direction = {Direction_vec.X(), Direction_vec.Y(),Direction_vec.Z()};
@@ -22,6 +22,7 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "canvas/Persistency/Common/Ptr.h"
 #include "canvas/Persistency/Common/FindManyP.h"
+#include "cetlib/cpu_timer.h"
 
 //LArSoft includes
 #include "lardata/Utilities/AssociationUtil.h"
@@ -32,12 +33,16 @@
 #include "lardataobj/RecoBase/Cluster.h"
 #include "larreco/ShowerFinder/ShowerTools/IShowerTool.h"
 #include "larreco/ShowerFinder/ShowerProduedPtrsHolder.hh"
+#include "larreco/ShowerFinder/ShowerEventDataCache.hh"
+#include "larreco/ShowerFinder/ShowerPFParticleLoop.hh"
 #include "larreco/RecoAlg/ShowerElementHolder.hh"
 
 //Root Includes
 #include "TVector3.h"
 
 //C++ Includes 
+#include <iomanip>
+#include <mutex>
 #include <vector>
 
 namespace reco {
@@ -57,6 +62,20 @@ private:
 
   void produce(art::Event& evt);
 
+  void endJob();
+
+  //Runs the tools (twice if fSecondInteration is set) on the PFParticle. Returns the error of the last pass.
+  int RunShowerTools(const art::Ptr<recob::PFParticle>& pfp, art::Event& evt, reco::shower::ShowerElementHolder& selement_holder);
+
+  //Runs tool i and times it if fTimeTools is set.
+  int RunShowerTool(unsigned int i, const art::Ptr<recob::PFParticle>& pfp, art::Event& evt, reco::shower::ShowerElementHolder& selement_holder, int iteration);
+
+  //Makes the shower and its associations from the elements the tools calculated for the PFParticle. The holder is
+  //only cleared if the shower is made.
+  void MakeShower(const art::Ptr<recob::PFParticle>& pfp, int err, art::Event& evt, reco::shower::ShowerElementHolder& selement_holder,
+                  int& shower_iter, const art::FindManyP<recob::Cluster>& fmcp, const art::FindManyP<recob::SpacePoint>& fmspp,
+                  const art::FindManyP<recob::Hit>& fmh);
+
   //This function returns the art::Ptr to the data object InstanceName. In the background it uses the PtrMaker which requires the element index of 
   //the unique ptr (iter). 
   template <class T >
@@ -68,22 +87,33 @@ private:
   bool          fSecondInteration;
   bool          fAllowPartialShowers;
   bool          fVerbose; 
+  bool          fTimeTools;
+  bool          fConcurrentPFParticles;
 
   //tool tags which calculate the characteristics of the shower 
-  std::string fShowerStartPositionLabel;
-  std::string fShowerDirectionLabel;
-  std::string fShowerEnergyLabel;
-  std::string fShowerLengthLabel;
-  std::string fShowerdEdxLabel;
-  std::string fShowerBestPlaneLabel;
+  reco::shower::ShowerElementSlot fShowerStartPositionLabel;
+  reco::shower::ShowerElementSlot fShowerDirectionLabel;
+  reco::shower::ShowerElementSlot fShowerEnergyLabel;
+  reco::shower::ShowerElementSlot fShowerLengthLabel;
+  reco::shower::ShowerElementSlot fShowerdEdxLabel;
+  reco::shower::ShowerElementSlot fShowerBestPlaneLabel;
 
   //fcl tools
   std::vector<std::unique_ptr<ShowerRecoTools::IShowerTool> > fShowerTools;
   std::vector<std::string>                                    fShowerToolNames;
 
+  //Time spent in each tool and number of calls, filled if fTimeTools is set
+  std::vector<double>                                         fShowerToolRealTime;
+  std::vector<double>                                         fShowerToolCPUTime;
+  std::vector<unsigned int>                                   fShowerToolCalls;
+  std::mutex                                                  fShowerToolTimerMutex;
+
   //map to the unique ptrs to
   reco::shower::ShowerProduedPtrsHolder uniqueproducerPtrs;
 
+  //Handles and associations read once per event for the module and the tools
+  reco::shower::ShowerEventDataCache fEventDataCache;
+
 };
 
 //This function returns the art::Ptr to the data object InstanceName. In the background it uses the PtrMaker which requires the element index of 
@@ -141,6 +171,12 @@ reco::shower::TRACS::TRACS(fhicl::ParameterSet const& pset) :
     fShowerTools[i]->InitialiseProducers();
   }
 
+  //Ask the tools for the event data they read.
+  for(auto const& fShowerTool: fShowerTools){
+    fShowerTool->RequestEventData(fEventDataCache);
+    fShowerTool->InitialiseEventDataCache(fEventDataCache);
+  }
+
   //Initialise the other paramters.
   fPFParticleModuleLabel      = pset.get<art::InputTag>("PFParticleModuleLabel","pandora");
   fShowerStartPositionLabel = pset.get<std::string  >("ShowerStartPositionLabel");
@@ -152,6 +188,30 @@ reco::shower::TRACS::TRACS(fhicl::ParameterSet const& pset) :
   fSecondInteration           = pset.get<bool         >("SecondInteration",false);
   fAllowPartialShowers        = pset.get<bool         >("AllowPartialShowers",false);
   fVerbose                    = pset.get<bool         >("Verbose",false);
+  fTimeTools                  = pset.get<bool         >("TimeTools",false);
+  fConcurrentPFParticles      = pset.get<bool         >("ConcurrentPFParticles",false);
+
+  //The tools are shared by the PFParticles calculated at once so each must say it can be.
+  if(fConcurrentPFParticles){
+    for(unsigned int i=0; i<fShowerTools.size(); ++i){
+      if(!fShowerTools[i]->IsReentrant()){
+        throw cet::exception("TRACS") << "ConcurrentPFParticles is set but the tool " << fShowerToolNames[i] << " is not reentrant. Stopping." << std::endl;
+      }
+      if(fShowerTools[i]->EventDisplayEnabled()){
+        throw cet::exception("TRACS") << "ConcurrentPFParticles is set but the tool " << fShowerToolNames[i] << " runs the event display, which writes to the TFileService and is not thread safe. Stopping." << std::endl;
+      }
+    }
+  }
+
+  fShowerToolRealTime.resize(fShowerTools.size(),0);
+  fShowerToolCPUTime.resize(fShowerTools.size(),0);
+  fShowerToolCalls.resize(fShowerTools.size(),0);
+
+  //The module's own associations.
+  fEventDataCache.RequestHandle<recob::Cluster>(fPFParticleModuleLabel);
+  fEventDataCache.RequestFindManyP<recob::Hit,recob::Cluster>(fPFParticleModuleLabel);
+  fEventDataCache.RequestFindManyP<recob::Cluster,recob::PFParticle>(fPFParticleModuleLabel);
+  fEventDataCache.RequestFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
 
   produces<std::vector<recob::Shower> >();
   produces<art::Assns<recob::Shower, recob::Hit> >();
@@ -172,7 +232,7 @@ reco::shower::TRACS::TRACS(fhicl::ParameterSet const& pset) :
     
 void reco::shower::TRACS::produce(art::Event& evt) {
 
-  //Ptr makers for the products 
+  //Ptr makers for the products
   uniqueproducerPtrs.SetPtrMakers(evt);
 
   //Get the PFParticles
@@ -184,17 +244,19 @@ void reco::shower::TRACS::produce(art::Event& evt) {
   else {
     throw cet::exception("TRACS") << "pfps not loaded. Maybe you got the module label wrong?" << std::endl;
   }
- 
+
+  //Read the event data for the module and the tools.
+  fEventDataCache.Fill(evt);
+
   //Handle to access the pandora hits assans
-  art::Handle<std::vector<recob::Cluster> > clusterHandle;
-  if (!evt.getByLabel(fPFParticleModuleLabel,clusterHandle)){
+  if (!fEventDataCache.GetHandle<recob::Cluster>(fPFParticleModuleLabel).isValid()){
     throw cet::exception("TRACS") << "pfp clusters are not loaded." << std::endl;
   }
 
-  //Get the assoications to hits, clusters and spacespoints 
-  art::FindManyP<recob::Hit> fmh(clusterHandle, evt, fPFParticleModuleLabel);
-  art::FindManyP<recob::Cluster> fmcp(pfpHandle, evt, fPFParticleModuleLabel);
-  art::FindManyP<recob::SpacePoint> fmspp(pfpHandle, evt, fPFParticleModuleLabel);
+  //Get the assoications to hits, clusters and spacespoints
+  const art::FindManyP<recob::Hit>& fmh = fEventDataCache.GetFindManyP<recob::Hit,recob::Cluster>(fPFParticleModuleLabel);
+  const art::FindManyP<recob::Cluster>& fmcp = fEventDataCache.GetFindManyP<recob::Cluster,recob::PFParticle>(fPFParticleModuleLabel);
+  const art::FindManyP<recob::SpacePoint>& fmspp = fEventDataCache.GetFindManyP<recob::SpacePoint,recob::PFParticle>(fPFParticleModuleLabel);
 
   if(!fmcp.isValid()){
     throw cet::exception("TRACS") << "Find many clusters is not valid." << std::endl;
@@ -206,187 +268,227 @@ void reco::shower::TRACS::produce(art::Event& evt) {
     throw cet::exception("TRACS") << "Find many spacepoints is not valid." << std::endl;
   }
 
-  //Holder to pass to the functions, contains the 6 properties of the shower 
-  // - Start Poistion
-  // - Direction
-  // - Initial Track
-  // - Initial Track Hits
-  // - Energy 
-  // - dEdx 
-  reco::shower::ShowerElementHolder selement_holder;
-
+  //Calculate the shower properties and make the showers.
   int shower_iter = 0;
-  //Loop of the pf particles
-  for(auto const& pfp: pfps){
+  auto runTools = [&](const art::Ptr<recob::PFParticle>& pfp, reco::shower::ShowerElementHolder& selement_holder){
+    return RunShowerTools(pfp,evt,selement_holder);
+  };
+  auto makeShower = [&](const art::Ptr<recob::PFParticle>& pfp, int err,
+                        reco::shower::ShowerElementHolder& selement_holder, int& iter){
+    MakeShower(pfp,err,evt,selement_holder,iter,fmcp,fmspp,fmh);
+  };
+  if(fConcurrentPFParticles){
+    reco::shower::LoopPFParticlesConcurrently(pfps,shower_iter,runTools,makeShower);
+  }
+  else{
+    reco::shower::LoopPFParticles(pfps,shower_iter,runTools,makeShower);
+  }
 
-    //Update the shower iterator
-    selement_holder.SetShowerNumber(shower_iter);
+  //Put everything in the event.
+  uniqueproducerPtrs.MoveAllToEvent(evt);
 
-    //loop only over showers.
-    if(pfp->PdgCode() != 11 && pfp->PdgCode() != 22){continue;}
+  //Reset the ptrs to the data products
+  uniqueproducerPtrs.reset();
 
-    //Calculate the shower properties 
-    //Loop over the shower tools
-    int err = 0;
-    unsigned int i=0;
-    for(auto const& fShowerTool: fShowerTools){
+  //Forget the event data
+  fEventDataCache.Clear();
 
-      //Calculate the metric
-      std::string evd_disp_append = fShowerToolNames[i]+"_iteration"+std::to_string(0) + "_" + this->moduleDescription().moduleLabel();
-      err = fShowerTool->RunShowerTool(pfp,evt,selement_holder,evd_disp_append);
+}
 
-      if(err){
-	mf::LogError("TRACS") << "Error in shower tool: " << fShowerToolNames[i]  << " with code: " << err << std::endl;
-	break;
-      }
-      ++i;
-    }
-    //Should we do a second interaction now we have done a first pass of the calculation
-    i=0;
-    if(fSecondInteration){
-
-      for(auto const& fShowerTool: fShowerTools){
-	//Calculate the metric
-	std::string evd_disp_append = fShowerToolNames[i]+"_iteration"+std::to_string(1) + "_" + this->moduleDescription().moduleLabel();
-	err = fShowerTool->RunShowerTool(pfp,evt,selement_holder,evd_disp_append);
-      
-	if(err){
-	  mf::LogError("TRACS") << "Error in shower tool: " << fShowerToolNames[i]  << " with code: " << err << std::endl;
-	  break;
-	}
-	++i;
-      }
-    }
+int reco::shower::TRACS::RunShowerTools(const art::Ptr<recob::PFParticle>& pfp, art::Event& evt,
+                                        reco::shower::ShowerElementHolder& selement_holder){
 
-    //If we want a full shower and we recieved an error call from a tool return;
+  //Loop over the shower tools
+  int err = 0;
+  for(unsigned int i=0; i<fShowerTools.size(); ++i){
+
+    //Calculate the metric
+    err = RunShowerTool(i,pfp,evt,selement_holder,0);
     if(err){
-      mf::LogError("TRACS") << "Error on tool. Assuming all the shower products and properties were not set and bailing." << std::endl;
-      continue;
+      mf::LogError("TRACS") << "Error in shower tool: " << fShowerToolNames[i]  << " with code: " << err << std::endl;
+      break;
     }
+  }
 
-    //If we are are not allowing partial shower check all the products to make the shower are correctly set
-    if(!fAllowPartialShowers){
-      if(!selement_holder.CheckElement("ShowerStartPosition")){
-	mf::LogError("TRACS") << "The start position is not set in the element holder. bailing" << std::endl;
-	continue;
-      }
-      if(!selement_holder.CheckElement("ShowerDirection")){
-	mf::LogError("TRACS") << "The direction is not set in the element holder. bailing" << std::endl;
-	continue;
-      }
-      if(!selement_holder.CheckElement("ShowerEnergy")){
-	mf::LogError("TRACS") << "The energy is not set in the element holder. bailing" << std::endl;
-	continue;
-      }
-      if(!selement_holder.CheckElement("ShowerdEdx")){
-	mf::LogError("TRACS") << "The dEdx is not set in the element holder. bailing" << std::endl;
-        continue;
-      }
+  //Should we do a second interaction now we have done a first pass of the calculation
+  if(fSecondInteration){
+    for(unsigned int i=0; i<fShowerTools.size(); ++i){
 
-      //Check All of the products that have been asked to be checked.
-      bool elements_are_set = selement_holder.CheckAllElementTags();
-      if(!elements_are_set){
-	mf::LogError("TRACS") << "Not all the elements in the property holder which should be set are not. Bailing. " << std::endl; 
-	continue;
-      }
-      
-      ///Check all the producers 
-      bool producers_are_set = uniqueproducerPtrs.CheckAllProducedElements(selement_holder);
-      if(!producers_are_set){
-	mf::LogError("TRACS") << "Not all the elements in the property holder which are produced are not set. Bailing. " << std::endl; 
-	continue;
+      //Calculate the metric
+      err = RunShowerTool(i,pfp,evt,selement_holder,1);
+      if(err){
+        mf::LogError("TRACS") << "Error in shower tool: " << fShowerToolNames[i]  << " with code: " << err << std::endl;
+        break;
       }
     }
+  }
 
-    //Get the properties 
-    TVector3                           ShowerStartPosition  = {-999,-999,-999};
-    TVector3                           ShowerDirection      = {-999,-999,-999};
-    std::vector<double>                ShowerEnergy         = {-999,-999,-999};
-    std::vector<double>                ShowerdEdx           = {-999,-999,-999};
-
-    int                                BestPlane               = -999;
-    TVector3                           ShowerStartPositionErr  = {-999,-999,-999};
-    TVector3                           ShowerDirectionErr      = {-999,-999,-999};
-    std::vector<double>                ShowerEnergyErr         = {-999,-999,-999};
-    std::vector<double>                ShowerdEdxErr           = {-999,-999,-999};
-    
-    err = 0;
-    if(selement_holder.CheckElement(fShowerStartPositionLabel))    err += selement_holder.GetElementAndError(fShowerStartPositionLabel,ShowerStartPosition,ShowerStartPositionErr);
-    if(selement_holder.CheckElement(fShowerDirectionLabel))        err += selement_holder.GetElementAndError(fShowerDirectionLabel,ShowerDirection,ShowerDirectionErr);
-    if(selement_holder.CheckElement(fShowerEnergyLabel))           err += selement_holder.GetElementAndError(fShowerEnergyLabel,ShowerEnergy,ShowerEnergyErr);
-    if(selement_holder.CheckElement(fShowerdEdxLabel))             err += selement_holder.GetElementAndError(fShowerdEdxLabel,ShowerdEdx,ShowerdEdxErr  );
-    if(selement_holder.CheckElement(fShowerBestPlaneLabel))        err += selement_holder.GetElement(fShowerBestPlaneLabel,BestPlane);
+  return err;
+}
 
-    if(err){
-      throw cet::exception("TRACS")  << "Error in TRACS Module. A Check on a shower property failed " << std::endl;
-    }
+int reco::shower::TRACS::RunShowerTool(unsigned int i, const art::Ptr<recob::PFParticle>& pfp, art::Event& evt,
+                                       reco::shower::ShowerElementHolder& selement_holder, int iteration){
 
-    if(fVerbose){
-      //Check the shower
-      std::cout<<"Shower Vertex: X:"<<ShowerStartPosition.X()<<" Y: "<<ShowerStartPosition.Y()<<" Z: "<<ShowerStartPosition.Z()<<std::endl;
-      std::cout<<"Shower Direction: X:"<<ShowerDirection.X()<<" Y: "<<ShowerDirection.Y()<<" Z: "<<ShowerDirection.Z()<<std::endl;
-      std::cout<<"Shower dEdx: size: "<<ShowerdEdx.size()<<" Plane 0: "<<ShowerdEdx.at(0)<<" Plane 1: "<<ShowerdEdx.at(1)<<" Plane 2: "<<ShowerdEdx.at(2)<<std::endl;
-      std::cout<<"Shower Energy: size: "<<ShowerEnergy.size()<<" Plane 0: "<<ShowerEnergy.at(0)<<" Plane 1: "<<ShowerEnergy.at(1)<<" Plane 2: "<<ShowerEnergy.at(2)<<std::endl;
-      std::cout<<"Shower Best Plane: "<<BestPlane<<std::endl;
+  std::string evd_disp_append = fShowerToolNames[i]+"_iteration"+std::to_string(iteration) + "_" + this->moduleDescription().moduleLabel();
+  if(!fTimeTools){
+    return fShowerTools[i]->RunShowerTool(pfp,evt,selement_holder,evd_disp_append);
+  }
 
-      //Print what has been created in the shower
-      selement_holder.PrintElements();
-    }
+  cet::cpu_timer timer;
+  timer.start();
+  int err = fShowerTools[i]->RunShowerTool(pfp,evt,selement_holder,evd_disp_append);
+  timer.stop();
 
-    //Make the shower 
-    recob::Shower shower = recob::Shower(ShowerDirection, ShowerDirectionErr,ShowerStartPosition, ShowerDirectionErr,ShowerEnergy,ShowerEnergyErr,ShowerdEdx, ShowerdEdxErr, BestPlane, -999);
-    selement_holder.SetElement(shower,"shower");
-    ++shower_iter;
-    art::Ptr<recob::Shower> ShowerPtr = this->GetProducedElementPtr<recob::Shower>("shower",selement_holder);
-
-    //Associate the pfparticle 
-    uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::PFParticle>>(ShowerPtr,pfp,"pfShowerAssociationsbase");
-        
-    //Get the associated hits,clusters and spacepoints
-    std::vector<art::Ptr<recob::Cluster> >    showerClusters    = fmcp.at(pfp.key());
-    std::vector<art::Ptr<recob::SpacePoint> > showerSpacePoints = fmspp.at(pfp.key());
-
-    //Add the hits for each "cluster"
-    for(auto const& cluster: showerClusters){
-
-      //Associate the clusters 
-      std::vector<art::Ptr<recob::Hit> > ClusterHits = fmh.at(cluster.key());
-      uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::Cluster>>(ShowerPtr,cluster,"clusterAssociationsbase");
-          
-      //Associate the hits
-      for(auto const& hit: ClusterHits){
-	uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::Hit>>(ShowerPtr, hit,"hitAssociationsbase");
-      }
+  std::lock_guard<std::mutex> lock(fShowerToolTimerMutex);
+  fShowerToolRealTime[i] += timer.accumulated_real_time();
+  fShowerToolCPUTime[i]  += timer.accumulated_cpu_time();
+  ++fShowerToolCalls[i];
+  return err;
+}
+
+void reco::shower::TRACS::MakeShower(const art::Ptr<recob::PFParticle>& pfp, int err, art::Event& evt,
+                                     reco::shower::ShowerElementHolder& selement_holder, int& shower_iter,
+                                     const art::FindManyP<recob::Cluster>& fmcp, const art::FindManyP<recob::SpacePoint>& fmspp,
+                                     const art::FindManyP<recob::Hit>& fmh){
+
+  //If we want a full shower and we recieved an error call from a tool return;
+  if(err){
+    mf::LogError("TRACS") << "Error on tool. Assuming all the shower products and properties were not set and bailing." << std::endl;
+    return;
+  }
+
+  //If we are are not allowing partial shower check all the products to make the shower are correctly set
+  if(!fAllowPartialShowers){
+    if(!selement_holder.CheckElement(fShowerStartPositionLabel)){
+      mf::LogError("TRACS") << "The start position is not set in the element holder. bailing" << std::endl;
+      return;
+    }
+    if(!selement_holder.CheckElement(fShowerDirectionLabel)){
+      mf::LogError("TRACS") << "The direction is not set in the element holder. bailing" << std::endl;
+      return;
+    }
+    if(!selement_holder.CheckElement(fShowerEnergyLabel)){
+      mf::LogError("TRACS") << "The energy is not set in the element holder. bailing" << std::endl;
+      return;
+    }
+    if(!selement_holder.CheckElement(fShowerdEdxLabel)){
+      mf::LogError("TRACS") << "The dEdx is not set in the element holder. bailing" << std::endl;
+      return;
     }
 
-    //Associate the spacepoints
-    for(auto const& sp: showerSpacePoints){
-      uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::SpacePoint>>(ShowerPtr,sp,"spShowerAssociationsbase");
+    //Check All of the products that have been asked to be checked.
+    bool elements_are_set = selement_holder.CheckAllElementTags();
+    if(!elements_are_set){
+      mf::LogError("TRACS") << "Not all the elements in the property holder which should be set are not. Bailing. " << std::endl;
+      return;
     }
 
-    //Loop over the tool data products and add them.
-    uniqueproducerPtrs.AddDataProducts(selement_holder);
-		
-    //AddAssociations
-    int assn_err = 0;
-    for(auto const& fShowerTool: fShowerTools){
-      assn_err += fShowerTool->AddAssociations(evt,selement_holder);
+    ///Check all the producers
+    bool producers_are_set = uniqueproducerPtrs.CheckAllProducedElements(selement_holder);
+    if(!producers_are_set){
+      mf::LogError("TRACS") << "Not all the elements in the property holder which are produced are not set. Bailing. " << std::endl;
+      return;
     }
-    if(!fAllowPartialShowers && assn_err > 0){
-      mf::LogError("TRACS") << "A association failed and you are not allowing partial showers. The event will not be added to the event " << std::endl; 
-      continue;
+  }
+
+  //Get the properties
+  TVector3                           ShowerStartPosition  = {-999,-999,-999};
+  TVector3                           ShowerDirection      = {-999,-999,-999};
+  std::vector<double>                ShowerEnergy         = {-999,-999,-999};
+  std::vector<double>                ShowerdEdx           = {-999,-999,-999};
+
+  int                                BestPlane               = -999;
+  TVector3                           ShowerStartPositionErr  = {-999,-999,-999};
+  TVector3                           ShowerDirectionErr      = {-999,-999,-999};
+  std::vector<double>                ShowerEnergyErr         = {-999,-999,-999};
+  std::vector<double>                ShowerdEdxErr           = {-999,-999,-999};
+
+  err = 0;
+  if(selement_holder.CheckElement(fShowerStartPositionLabel))    err += selement_holder.GetElementAndError(fShowerStartPositionLabel,ShowerStartPosition,ShowerStartPositionErr);
+  if(selement_holder.CheckElement(fShowerDirectionLabel))        err += selement_holder.GetElementAndError(fShowerDirectionLabel,ShowerDirection,ShowerDirectionErr);
+  if(selement_holder.CheckElement(fShowerEnergyLabel))           err += selement_holder.GetElementAndError(fShowerEnergyLabel,ShowerEnergy,ShowerEnergyErr);
+  if(selement_holder.CheckElement(fShowerdEdxLabel))             err += selement_holder.GetElementAndError(fShowerdEdxLabel,ShowerdEdx,ShowerdEdxErr  );
+  if(selement_holder.CheckElement(fShowerBestPlaneLabel))        err += selement_holder.GetElement(fShowerBestPlaneLabel,BestPlane);
+
+  if(err){
+    throw cet::exception("TRACS")  << "Error in TRACS Module. A Check on a shower property failed " << std::endl;
+  }
+
+  if(fVerbose){
+    //Check the shower
+    std::cout<<"Shower Vertex: X:"<<ShowerStartPosition.X()<<" Y: "<<ShowerStartPosition.Y()<<" Z: "<<ShowerStartPosition.Z()<<std::endl;
+    std::cout<<"Shower Direction: X:"<<ShowerDirection.X()<<" Y: "<<ShowerDirection.Y()<<" Z: "<<ShowerDirection.Z()<<std::endl;
+    std::cout<<"Shower dEdx: size: "<<ShowerdEdx.size()<<" Plane 0: "<<ShowerdEdx.at(0)<<" Plane 1: "<<ShowerdEdx.at(1)<<" Plane 2: "<<ShowerdEdx.at(2)<<std::endl;
+    std::cout<<"Shower Energy: size: "<<ShowerEnergy.size()<<" Plane 0: "<<ShowerEnergy.at(0)<<" Plane 1: "<<ShowerEnergy.at(1)<<" Plane 2: "<<ShowerEnergy.at(2)<<std::endl;
+    std::cout<<"Shower Best Plane: "<<BestPlane<<std::endl;
+
+    //Print what has been created in the shower
+    selement_holder.PrintElements();
+  }
+
+  //Make the shower
+  recob::Shower shower = recob::Shower(ShowerDirection, ShowerDirectionErr,ShowerStartPosition, ShowerDirectionErr,ShowerEnergy,ShowerEnergyErr,ShowerdEdx, ShowerdEdxErr, BestPlane, -999);
+  selement_holder.SetElement(shower,"shower");
+  ++shower_iter;
+  art::Ptr<recob::Shower> ShowerPtr = this->GetProducedElementPtr<recob::Shower>("shower",selement_holder);
+
+  //Associate the pfparticle
+  uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::PFParticle>>(ShowerPtr,pfp,"pfShowerAssociationsbase");
+
+  //Get the associated hits,clusters and spacepoints
+  std::vector<art::Ptr<recob::Cluster> >    showerClusters    = fmcp.at(pfp.key());
+  std::vector<art::Ptr<recob::SpacePoint> > showerSpacePoints = fmspp.at(pfp.key());
+
+  //Add the hits for each "cluster"
+  for(auto const& cluster: showerClusters){
+
+    //Associate the clusters
+    std::vector<art::Ptr<recob::Hit> > ClusterHits = fmh.at(cluster.key());
+    uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::Cluster>>(ShowerPtr,cluster,"clusterAssociationsbase");
+
+    //Associate the hits
+    for(auto const& hit: ClusterHits){
+      uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::Hit>>(ShowerPtr, hit,"hitAssociationsbase");
     }
+  }
 
-    //Reset the showerproperty holder.
-    selement_holder.ClearAll();
+  //Associate the spacepoints
+  for(auto const& sp: showerSpacePoints){
+    uniqueproducerPtrs.AddSingle<art::Assns<recob::Shower, recob::SpacePoint>>(ShowerPtr,sp,"spShowerAssociationsbase");
   }
-  
-  //Put everything in the event.
-  uniqueproducerPtrs.MoveAllToEvent(evt);
 
-  //Reset the ptrs to the data products
-  uniqueproducerPtrs.reset();
+  //Loop over the tool data products and add them.
+  uniqueproducerPtrs.AddDataProducts(selement_holder);
+
+  //AddAssociations
+  int assn_err = 0;
+  for(auto const& fShowerTool: fShowerTools){
+    assn_err += fShowerTool->AddAssociations(evt,selement_holder);
+  }
+  if(!fAllowPartialShowers && assn_err > 0){
+    mf::LogError("TRACS") << "A association failed and you are not allowing partial showers. The event will not be added to the event " << std::endl;
+    return;
+  }
 
+  //Reset the showerproperty holder.
+  selement_holder.ClearAll();
+}
+
+void reco::shower::TRACS::endJob() {
+
+  if(!fTimeTools) return;
+
+  //Report the time spent in each tool
+  mf::LogInfo log("TRACS");
+  log << "Time spent in the shower tools:" << "\n"
+      << std::left << std::setw(50) << "Tool" << std::right << std::setw(10) << "Calls"
+      << std::setw(14) << "Real [s]" << std::setw(14) << "CPU [s]" << std::setw(16) << "Real/call [ms]";
+  for(unsigned int i=0; i<fShowerTools.size(); ++i){
+    double realTime = fShowerToolRealTime[i];
+    log << "\n" << std::left << std::setw(50) << fShowerToolNames[i] << std::right << std::setw(10) << fShowerToolCalls[i]
+        << std::setw(14) << realTime << std::setw(14) << fShowerToolCPUTime[i]
+        << std::setw(16) << (fShowerToolCalls[i] ? 1000.*realTime/fShowerToolCalls[i] : 0.);
+  }
 }
 
 DEFINE_ART_MODULE(reco::shower::TRACS)
@@ -2,9 +2,12 @@
 
 #include <algorithm>
 #include <cstdlib>
-#include <set>
 #include <string>
 #include <iostream>
+#include <unordered_map>
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
 template<class T> T sqr(T x){return x*x;}
 
@@ -58,15 +61,6 @@ CollectionWireHit::CollectionWireHit(int chan, double q,
   for(SpaceCharge* sc: cross) sc->AddCharge(p);
 }
 
-// ---------------------------------------------------------------------------
-CollectionWireHit::~CollectionWireHit()
-{
-  // Each SpaceCharge can only be in one collection wire, so we own them. But
-  // not SpaceCharge does not clean up its induction wires since they're
-  // shared.
-  for(SpaceCharge* sc: fCrossings) delete sc;
-}
-
 // ---------------------------------------------------------------------------
 double Metric(double q, double p)
 {
@@ -84,10 +78,11 @@ double Metric(const std::vector<SpaceCharge*>& scs, double alpha)
 {
   double ret = 0;
 
-  std::set<InductionWireHit*> iwires;
+  std::vector<const InductionWireHit*> iwires;
+  iwires.reserve(2*scs.size());
   for(const SpaceCharge* sc: scs){
-    if(sc->fWire1) iwires.insert(sc->fWire1);
-    if(sc->fWire2) iwires.insert(sc->fWire2);
+    if(sc->fWire1) iwires.push_back(sc->fWire1);
+    if(sc->fWire2) iwires.push_back(sc->fWire2);
 
     if(alpha != 0){
       ret -= alpha*sqr(sc->fPred);
@@ -97,6 +92,11 @@ double Metric(const std::vector<SpaceCharge*>& scs, double alpha)
     }
   }
 
+  // Each induction wire counts once. Sort by address (as std::set did) so the
+  // sum is always made in the same order
+  std::sort(iwires.begin(), iwires.end());
+  iwires.erase(std::unique(iwires.begin(), iwires.end()), iwires.end());
+
   for(const InductionWireHit* iwire: iwires){
     ret += Metric(iwire->fCharge, iwire->fPred);
   }
@@ -328,3 +328,73 @@ void Iterate(const std::vector<CollectionWireHit*>& cwires,
 
   for(SpaceCharge* sc: orphanSCs) Iterate(sc, alpha);
 }
+
+// ---------------------------------------------------------------------------
+std::vector<std::vector<CollectionWireHit*>>
+ColourWires(const std::vector<CollectionWireHit*>& cwires)
+{
+  std::vector<std::vector<CollectionWireHit*>> colours;
+
+  // Updating a wire writes to its own SpaceCharges, the neighbour potential of
+  // their neighbours and the prediction of their induction wires. Reads are
+  // from the same objects. Any of these in common makes two wires conflict.
+  std::unordered_map<const void*, std::vector<unsigned int>> usedBy;
+
+  std::vector<const void*> touched;
+  std::vector<bool> forbidden;
+
+  // Greedy colouring, visiting the wires in the same order as Iterate() so
+  // that each colour keeps the same "random" ordering
+  unsigned int cwireIdx = 0;
+  if(!cwires.empty()){
+    do{
+      CollectionWireHit* cwire = cwires[cwireIdx];
+
+      touched.clear();
+      for(const SpaceCharge* sc: cwire->fCrossings){
+        touched.push_back(sc);
+        if(sc->fWire1) touched.push_back(sc->fWire1);
+        if(sc->fWire2) touched.push_back(sc->fWire2);
+        for(const Neighbour& nei: sc->fNeighbours) touched.push_back(nei.fSC);
+      }
+      std::sort(touched.begin(), touched.end());
+      touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+      forbidden.assign(colours.size(), false);
+      for(const void* obj: touched){
+        auto it = usedBy.find(obj);
+        if(it == usedBy.end()) continue;
+        for(unsigned int c: it->second) forbidden[c] = true;
+      }
+
+      const unsigned int colour = std::find(forbidden.begin(), forbidden.end(), false) - forbidden.begin();
+      if(colour == colours.size()) colours.emplace_back();
+
+      colours[colour].push_back(cwire);
+      for(const void* obj: touched) usedBy[obj].push_back(colour);
+
+      const unsigned int prime = 1299827;
+      cwireIdx = (cwireIdx+prime)%cwires.size();
+    } while(cwireIdx != 0);
+  }
+
+  return colours;
+}
+
+// ---------------------------------------------------------------------------
+void Iterate(const std::vector<std::vector<CollectionWireHit*>>& colours,
+             const std::vector<SpaceCharge*>& orphanSCs,
+             double alpha)
+{
+  // Wires of the same colour touch disjoint objects, so the result does not
+  // depend on how the work is split between threads
+  for(const std::vector<CollectionWireHit*>& cwires: colours){
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, cwires.size()),
+                      [&cwires, alpha](const tbb::blocked_range<size_t>& r){
+                        for(size_t i = r.begin(); i != r.end(); ++i) Iterate(cwires[i], alpha);
+                      });
+  }
+
+  // Orphans can share induction wires, do them serially
+  for(SpaceCharge* sc: orphanSCs) Iterate(sc, alpha);
+}
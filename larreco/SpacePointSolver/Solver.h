@@ -59,11 +59,12 @@ public:
   double fNeiPotential; ///< Neighbour-induced potential
 };
 
+/// The SpaceCharges are not owned by the wire. They are expected to live in a
+/// contiguous pool (std::vector<SpaceCharge>) owned by the caller.
 class CollectionWireHit: public WireHit
 {
 public:
   CollectionWireHit(int chan, double q, const std::vector<SpaceCharge*>& cross);
-  ~CollectionWireHit();
 
   //protected:
   int fChannel;
@@ -87,4 +88,15 @@ void Iterate(const std::vector<CollectionWireHit*>& cwires,
              const std::vector<SpaceCharge*>& orphanSCs,
              double alpha);
 
+/// Split the collection wires into groups ("colours") such that no two wires
+/// in a group share a SpaceCharge, a neighbour of one, or an induction
+/// wire. The updates of all the wires in one group are then independent.
+std::vector<std::vector<CollectionWireHit*>>
+ColourWires(const std::vector<CollectionWireHit*>& cwires);
+
+/// As above, but the wires within each colour are updated concurrently
+void Iterate(const std::vector<std::vector<CollectionWireHit*>>& colours,
+             const std::vector<SpaceCharge*>& orphanSCs,
+             double alpha);
+
 #endif
@@ -64,13 +64,17 @@ private:
   typedef std::map<const WireHit*, const recob::Hit*> HitMap_t;
 
   void BuildSystem(const std::vector<HitTriplet>& triplets,
+                   std::vector<SpaceCharge>& scPool,
                    std::vector<CollectionWireHit*>& cwires,
                    std::vector<InductionWireHit*>& iwires,
                    std::vector<SpaceCharge*>& orphanSCs,
                    bool incNei,
                    HitMap_t& hitmap) const;
 
+  /// If \a colours is not empty the wires are updated concurrently, colour
+  /// by colour, see ColourWires()
   void Minimize(const std::vector<CollectionWireHit*>& cwires,
+                const std::vector<std::vector<CollectionWireHit*>>& colours,
                 const std::vector<SpaceCharge*>& orphanSCs,
                 double alpha,
                 int maxiterations);
@@ -104,6 +108,9 @@ private:
   int fMaxIterationsNoReg;
   int fMaxIterationsReg;
 
+  double fConvergence; ///< Stop when the metric changes by less than this fraction
+  bool fParallel;      ///< Update independent collection wires concurrently
+
   double fXHitOffset;
 
   const detinfo::DetectorProperties* detprop;
@@ -125,6 +132,8 @@ SpacePointSolver::SpacePointSolver(const fhicl::ParameterSet& pset) :
     fDistThreshDrift(pset.get<double>("WireIntersectThresholdDriftDir")),
     fMaxIterationsNoReg(pset.get<int>("MaxIterationsNoReg")),
     fMaxIterationsReg(pset.get<int>("MaxIterationsReg")),
+    fConvergence(pset.get<double>("ConvergenceTolerance", 1e-3)),
+    fParallel(pset.get<bool>("ParallelIterate", false)),
     fXHitOffset(pset.get<double>("XHitOffset"))
 {
   recob::ChargedSpacePointCollectionCreator::produces(producesCollector(), "pre");
@@ -245,6 +254,7 @@ AddNeighbours(const std::vector<SpaceCharge*>& spaceCharges) const
 // ---------------------------------------------------------------------------
 void SpacePointSolver::
 BuildSystem(const std::vector<HitTriplet>& triplets,
+            std::vector<SpaceCharge>& scPool,
             std::vector<CollectionWireHit*>& cwires,
             std::vector<InductionWireHit*>& iwires,
             std::vector<SpaceCharge*>& orphanSCs,
@@ -273,14 +283,20 @@ BuildSystem(const std::vector<HitTriplet>& triplets,
 
   std::set<InductionWireHit*> satisfiedInduction;
 
+  // All the SpaceCharges live in one block. Reserving up front guarantees the
+  // pointers handed out below stay valid.
+  scPool.clear();
+  scPool.reserve(triplets.size());
+
   for(const HitTriplet& trip: triplets){
     // Don't have a cwire object yet, set it later
-    SpaceCharge* sc = new SpaceCharge(trip.pt.x,
-                                      trip.pt.y,
-                                      trip.pt.z,
-                                      0,
-                                      inductionMap[trip.u],
-                                      inductionMap[trip.v]);
+    scPool.emplace_back(trip.pt.x,
+                        trip.pt.y,
+                        trip.pt.z,
+                        nullptr,
+                        inductionMap[trip.u],
+                        inductionMap[trip.v]);
+    SpaceCharge* sc = &scPool.back();
 
     if(trip.u && trip.v){
       collectionMap[trip.x].push_back(sc);
@@ -303,10 +319,7 @@ BuildSystem(const std::vector<HitTriplet>& triplets,
       // If there are no full triplets try the triplets with one bad channel
       scs = collectionMapBad[hit];
     }
-    else{
-      // If there were good triplets, delete the bad hit ones
-      for(SpaceCharge* sc: collectionMapBad[hit]) delete sc;
-    }
+    // Otherwise the bad hit ones are simply left unused in the pool
     // Still no space points, don't bother making a wire
     if(scs.empty()) continue;
 
@@ -327,9 +340,6 @@ BuildSystem(const std::vector<HitTriplet>& triplets,
        satisfiedInduction.count(sc->fWire2) == 0){
       orphanSCs.push_back(sc);
     }
-    else{
-      delete sc;
-    }
   }
   spaceCharges.insert(spaceCharges.end(), orphanSCs.begin(), orphanSCs.end());
 
@@ -411,6 +421,7 @@ FillSystemToSpacePointsAndAssns(const std::vector<art::Ptr<recob::Hit>>& hitlist
 
 // ---------------------------------------------------------------------------
 void SpacePointSolver::Minimize(const std::vector<CollectionWireHit*>& cwires,
+                                const std::vector<std::vector<CollectionWireHit*>>& colours,
                                 const std::vector<SpaceCharge*>& orphanSCs,
                                 double alpha,
                                 int maxiterations)
@@ -418,14 +429,17 @@ void SpacePointSolver::Minimize(const std::vector<CollectionWireHit*>& cwires,
   double prevMetric = Metric(cwires, alpha);
   std::cout << "Begin: " << prevMetric << std::endl;
   for(int i = 0; i < maxiterations; ++i){
-    Iterate(cwires, orphanSCs, alpha);
+    if(colours.empty())
+      Iterate(cwires, orphanSCs, alpha);
+    else
+      Iterate(colours, orphanSCs, alpha);
     const double metric = Metric(cwires, alpha);
     std::cout << i << " " << metric << std::endl;
     if(metric > prevMetric){
       std::cout << "Warning: metric increased" << std::endl;
       return;
     }
-    if(fabs(metric-prevMetric) < 1e-3*fabs(prevMetric)) return;
+    if(fabs(metric-prevMetric) < fConvergence*fabs(prevMetric)) return;
     prevMetric = metric;
   }
 }
@@ -485,6 +499,8 @@ void SpacePointSolver::produce(art::Event& evt)
   std::vector<InductionWireHit*> iwires;
   // Nodes with a bad collection wire that we otherwise can't address
   std::vector<SpaceCharge*> orphanSCs;
+  // Storage for all the SpaceCharges
+  std::vector<SpaceCharge> scPool;
 
   HitMap_t hitmap;
   if(is2view){
@@ -493,7 +509,7 @@ void SpacePointSolver::produce(art::Event& evt)
                      xbadchans, ubadchans, {},
                      fDistThresh, fDistThreshDrift, fXHitOffset);
     BuildSystem(tf.TripletsTwoView(),
-                cwires, iwires, orphanSCs,
+                scPool, cwires, iwires, orphanSCs,
                 fAlpha != 0, hitmap);
   }
   else{
@@ -502,7 +518,7 @@ void SpacePointSolver::produce(art::Event& evt)
                      xbadchans, ubadchans, vbadchans,
                      fDistThresh, fDistThreshDrift, fXHitOffset);
     BuildSystem(tf.Triplets(),
-                cwires, iwires, orphanSCs,
+                scPool, cwires, iwires, orphanSCs,
                 fAlpha != 0, hitmap);
   }
 
@@ -510,14 +526,20 @@ void SpacePointSolver::produce(art::Event& evt)
   spcol_pre.put();
 
   if(fFit){
+    std::vector<std::vector<CollectionWireHit*>> colours;
+    if(fParallel){
+      colours = ColourWires(cwires);
+      std::cout << cwires.size() << " collection wires in " << colours.size() << " independent sets" << std::endl;
+    }
+
     std::cout << "Iterating with no regularization..." << std::endl;
-    Minimize(cwires, orphanSCs, 0, fMaxIterationsNoReg);
+    Minimize(cwires, colours, orphanSCs, 0, fMaxIterationsNoReg);
 
     FillSystemToSpacePoints(cwires, orphanSCs, spcol_noreg);
     spcol_noreg.put();
 
     std::cout << "Now with regularization..." << std::endl;
-    Minimize(cwires, orphanSCs, fAlpha, fMaxIterationsReg);
+    Minimize(cwires, colours, orphanSCs, fAlpha, fMaxIterationsReg);
 
     FillSystemToSpacePointsAndAssns(hitlist, cwires, orphanSCs, hitmap, spcol, *assns);
     spcol.put();
@@ -526,7 +548,6 @@ void SpacePointSolver::produce(art::Event& evt)
 
   for(InductionWireHit* i: iwires) delete i;
   for(CollectionWireHit* c: cwires) delete c;
-  for(SpaceCharge* s: orphanSCs) delete s;
 }
 
 } // end namespace reco3d
@@ -33,6 +33,9 @@
 #include "lardata/RecoObjects/TrackStatePropagator.h"
 #include "lardataobj/MCBase/MCTrack.h"
 
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <chrono>
 #include <memory>
 
 namespace trkf {
@@ -144,6 +147,11 @@ namespace trkf {
         Name("keepInputTrajectoryPoints"),
         Comment("Option to keep positions and directions from input trajectory/track. The fit will provide only covariance matrices, chi2, ndof, particle Id and absolute momentum. It may also modify the trajectory point flags. In order to avoid inconsistencies, it has to be used with the following fitter options all set to false: sortHitsByPlane, sortOutputHitsMinLength, skipNegProp.")
       };
+      fhicl::Atom<bool> fitInParallel {
+        Name("fitInParallel"),
+        Comment("Option to fit all the input tracks of the event at once with TrackKalmanFitter::fitTracks (parallel per-track fitting on TBB workers). The output is the same as in the serial fit. Not used when the input is from PFParticles."),
+        false
+      };
     };
 
     struct Config {
@@ -468,32 +476,62 @@ void trkf::KalmanFilterFinalTrackFitter::produce(art::Event & e)
       trackId = std::make_unique<art::FindManyP<anab::ParticleID>>(inputTracks, e, pidInputTag);
     }
 
-    for (unsigned int iTrack = 0; iTrack < inputTracks->size(); ++iTrack) {
+    const unsigned int nTracks = inputTracks->size();
+    std::vector<TrackKalmanFitter::TrackFitInput> fitInputs(nTracks);
+    std::vector<TrackKalmanFitter::TrackFitOutput> fitOutputs(nTracks);
+    std::vector<recob::Track> fittedTracks(nTracks);
+    std::vector<std::vector<art::Ptr<recob::Hit> > > fittedHits(nTracks);
+    std::vector<trkmkr::OptionalOutputs> fittedOptionals(nTracks);
+    for (unsigned int iTrack = 0; iTrack < nTracks; ++iTrack) {
 
       const recob::Track& track = inputTracks->at(iTrack);
       art::Ptr<recob::Track> ptrack(inputTracks, iTrack);
-      const int pId = setPId(iTrack, trackId);
-      const double mom = setMomValue(ptrack, trackCalo, pMC, pId);
-      const bool flipDir = setDirFlip(track, mcdir);
+      auto& in = fitInputs[iTrack];
+      in.traj = &track.Trajectory();
+      in.tkID = track.ID();
+      in.covVtx = track.VertexCovarianceLocal5D();
+      in.covEnd = track.EndCovarianceLocal5D();
+      in.pdgid = setPId(iTrack, trackId);
+      in.pval = setMomValue(ptrack, trackCalo, pMC, in.pdgid);
+      in.flipDirection = setDirFlip(track, mcdir);
 
       //this is not computationally optimal, but at least preserves the order unlike FindManyP
-      std::vector<art::Ptr<recob::Hit> > inHits;
       for (auto it = tkHitsAssn.begin(); it!=tkHitsAssn.end(); ++it) {
-	if (it->first == ptrack) inHits.push_back(it->second);
-	else if (inHits.size()>0) break;
+	if (it->first == ptrack) in.hits.push_back(it->second);
+	else if (in.hits.size()>0) break;
+      }
+
+      if (p_().options().produceTrackFitHitInfo()) fittedOptionals[iTrack].initTrackFitInfos();
+      fitOutputs[iTrack] = {false, &fittedTracks[iTrack], &fittedHits[iTrack], &fittedOptionals[iTrack]};
+    }
+
+    auto const fitStart = std::chrono::steady_clock::now();
+    if (p_().options().fitInParallel()) {
+      kalmanFitter.fitTracks(fitInputs, fitOutputs);
+    } else {
+      for (unsigned int iTrack = 0; iTrack < nTracks; ++iTrack) {
+	auto const& in = fitInputs[iTrack];
+	auto& out = fitOutputs[iTrack];
+	out.fitok = kalmanFitter.fitTrack(*in.traj, in.tkID, in.covVtx, in.covEnd, in.hits, in.pval, in.pdgid, in.flipDirection,
+					  *out.track, *out.hits, *out.optionals);
       }
+    }
+    std::chrono::duration<double> const fitTime = std::chrono::steady_clock::now() - fitStart;
+    mf::LogDebug("KalmanFilterFinalTrackFitter") << "Fit " << nTracks << " tracks in " << fitTime.count()*1000. << " ms ("
+						 << (fitTime.count()>0. ? nTracks/fitTime.count() : 0.) << " tracks/s)";
+
+    for (unsigned int iTrack = 0; iTrack < nTracks; ++iTrack) {
+
+      const recob::Track& track = inputTracks->at(iTrack);
+      auto& out = fitOutputs[iTrack];
+      if (!out.fitok) continue;
 
-      recob::Track outTrack;
-      std::vector<art::Ptr<recob::Hit> > outHits;
-      trkmkr::OptionalOutputs optionals;
-      if (p_().options().produceTrackFitHitInfo()) optionals.initTrackFitInfos();
-      bool fitok = kalmanFitter.fitTrack(track.Trajectory(),track.ID(),
-					  track.VertexCovarianceLocal5D(),track.EndCovarianceLocal5D(),
-					  inHits, mom, pId, flipDir, outTrack, outHits, optionals);
-      if (!fitok) continue;
+      recob::Track& outTrack = *out.track;
+      std::vector<art::Ptr<recob::Hit> >& outHits = *out.hits;
+      trkmkr::OptionalOutputs& optionals = *out.optionals;
 
       if (p_().options().keepInputTrajectoryPoints()) {
-	restoreInputPoints(track.Trajectory().Trajectory(),inHits,outTrack,outHits);
+	restoreInputPoints(track.Trajectory().Trajectory(),fitInputs[iTrack].hits,outTrack,outHits);
       }
 
       outputTracks->emplace_back(std::move(outTrack));
@@ -26,8 +26,32 @@
 
 #include "lardataobj/MCBase/MCTrack.h"
 
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <chrono>
 #include <memory>
 
+namespace {
+
+  /// hits associated to each of nTrajs trajectories, in the order of the association; only the first run of consecutive entries of a trajectory is kept
+  template <typename T>
+  std::vector<std::vector<art::Ptr<recob::Hit> > > hitsPerTrajectory(const art::Assns<T, recob::Hit>& assn, const unsigned int nTrajs) {
+    std::vector<std::vector<art::Ptr<recob::Hit> > > result(nTrajs);
+    std::vector<bool> done(nTrajs, false);
+    size_t last = nTrajs;
+    for (auto it = assn.begin(); it!=assn.end(); ++it) {
+      const size_t key = it->first.key();
+      if (key!=last) {
+	if (last<nTrajs) done[last] = true;
+	last = key;
+      }
+      if (key<nTrajs && !done[key]) result[key].push_back(it->second);
+    }
+    return result;
+  }
+
+}
+
 namespace trkf {
 
   class KalmanFilterTrajectoryFitter : public art::EDProducer {
@@ -101,6 +125,11 @@ namespace trkf {
         Name("keepInputTrajectoryPoints"),
         Comment("Option to keep positions and directions from input trajectory. The fit will provide only covariance matrices, chi2, ndof, particle Id and absolute momentum. It may also modify the trajectory point flags. In order to avoid inconsistencies, it has to be used with the following fitter options all set to false: sortHitsByPlane, sortOutputHitsMinLength, skipNegProp.")
       };
+      fhicl::Atom<bool> fitInParallel {
+        Name("fitInParallel"),
+        Comment("Option to fit all the trajectories of the event at once with TrackKalmanFitter::fitTracks (parallel per-track fitting on TBB workers). The output is the same as in the serial fit."),
+        false
+      };
     };
 
     struct Config {
@@ -263,39 +292,59 @@ void trkf::KalmanFilterTrajectoryFitter::produce(art::Event & e)
     nTrajs = trajectoryVec->size();
   }
 
+  //convert the input to TrackTrajectories first, so that they stay alive for the whole fit
+  std::vector<recob::TrackTrajectory> convertedTrajs;
+  if (!isTT) {
+    convertedTrajs.reserve(nTrajs);
+    for (auto const& traj : *trajectoryVec) convertedTrajs.emplace_back(traj, std::vector<recob::TrajectoryPointFlags>());
+  }
+  //hits of each trajectory in a single pass, preserving the order unlike FindManyP
+  auto trajHits = (isTT ? hitsPerTrajectory(*trackTrajectoryHitsAssn, nTrajs) : hitsPerTrajectory(*trajectoryHitsAssn, nTrajs));
+
+  std::vector<TrackKalmanFitter::TrackFitInput> fitInputs(nTrajs);
+  std::vector<TrackKalmanFitter::TrackFitOutput> fitOutputs(nTrajs);
+  std::vector<recob::Track> fittedTracks(nTrajs);
+  std::vector<std::vector<art::Ptr<recob::Hit> > > fittedHits(nTrajs);
+  std::vector<trkmkr::OptionalOutputs> fittedOptionals(nTrajs);
   for (unsigned int iTraj = 0; iTraj < nTrajs; ++iTraj) {
+    auto& in = fitInputs[iTraj];
+    in.traj = (isTT ? &trackTrajectoryVec->at(iTraj) : &convertedTrajs[iTraj]);
+    in.tkID = iTraj;
+    in.hits = std::move(trajHits[iTraj]);
+    in.pdgid = setPId();
+    in.pval = setMomValue(in.traj, pMC, in.pdgid);
+    in.flipDirection = setDirFlip(in.traj, mcdir);
+    if (p_().options().produceTrackFitHitInfo()) fittedOptionals[iTraj].initTrackFitInfos();
+    fitOutputs[iTraj] = {false, &fittedTracks[iTraj], &fittedHits[iTraj], &fittedOptionals[iTraj]};
+  }
 
-    const recob::TrackTrajectory& inTraj = (isTT ? trackTrajectoryVec->at(iTraj) : recob::TrackTrajectory(trajectoryVec->at(iTraj), std::vector<recob::TrajectoryPointFlags>()) );
-    //const std::vector<recob::TrajectoryPointFlags>& inFlags = (isTT ? trackTrajectoryVec->at(iTraj).Flags() : std::vector<recob::TrajectoryPointFlags>());
-    //this is not computationally optimal, but at least preserves the order unlike FindManyP
-    std::vector<art::Ptr<recob::Hit> > inHits;
-    if (isTT) {
-      for (auto it = trackTrajectoryHitsAssn->begin(); it!=trackTrajectoryHitsAssn->end(); ++it) {
-	if (it->first.key() == iTraj) inHits.push_back(it->second);
-	else if (inHits.size()>0) break;
-      }
-    } else {
-      for (auto it = trajectoryHitsAssn->begin(); it!=trajectoryHitsAssn->end(); ++it) {
-	if (it->first.key() == iTraj) inHits.push_back(it->second);
-	else if (inHits.size()>0) break;
-      }
+  auto const fitStart = std::chrono::steady_clock::now();
+  if (p_().options().fitInParallel()) {
+    kalmanFitter.fitTracks(fitInputs, fitOutputs);
+  } else {
+    for (unsigned int iTraj = 0; iTraj < nTrajs; ++iTraj) {
+      auto const& in = fitInputs[iTraj];
+      auto& out = fitOutputs[iTraj];
+      out.fitok = kalmanFitter.fitTrack(*in.traj, in.tkID, in.covVtx, in.covEnd, in.hits, in.pval, in.pdgid, in.flipDirection,
+					*out.track, *out.hits, *out.optionals);
     }
-    const int pId = setPId();
-    const double mom = setMomValue(&inTraj, pMC, pId);
-    const bool flipDir = setDirFlip(&inTraj, mcdir);
-
-    recob::Track outTrack;
-    std::vector<art::Ptr<recob::Hit> > outHits;
-    trkmkr::OptionalOutputs optionals;
-    if (p_().options().produceTrackFitHitInfo()) optionals.initTrackFitInfos();
-    bool fitok = kalmanFitter.fitTrack(inTraj,iTraj,
-					SMatrixSym55(),SMatrixSym55(),
-					inHits,//inFlags,
-					mom, pId, flipDir, outTrack, outHits, optionals);
-    if (!fitok) continue;
+  }
+  std::chrono::duration<double> const fitTime = std::chrono::steady_clock::now() - fitStart;
+  mf::LogDebug("KalmanFilterTrajectoryFitter") << "Fit " << nTrajs << " trajectories in " << fitTime.count()*1000. << " ms ("
+					       << (fitTime.count()>0. ? nTrajs/fitTime.count() : 0.) << " tracks/s)";
+
+  for (unsigned int iTraj = 0; iTraj < nTrajs; ++iTraj) {
+
+    auto const& in = fitInputs[iTraj];
+    auto& out = fitOutputs[iTraj];
+    if (!out.fitok) continue;
+
+    recob::Track& outTrack = *out.track;
+    std::vector<art::Ptr<recob::Hit> >& outHits = *out.hits;
+    trkmkr::OptionalOutputs& optionals = *out.optionals;
 
     if (p_().options().keepInputTrajectoryPoints()) {
-      restoreInputPoints(inTraj,inHits,outTrack,outHits);
+      restoreInputPoints(*in.traj,in.hits,outTrack,outHits);
     }
 
     outputTracks->emplace_back(std::move(outTrack));
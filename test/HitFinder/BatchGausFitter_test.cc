@@ -0,0 +1,244 @@
+/**
+ * @file   BatchGausFitter_test.cc
+ * @brief  Test and benchmark of hit::BatchGausFitter
+ * @see    BatchGausFitter.h
+ *
+ * Synthetic pulse trains of one to three Gaussians plus noise are fit with
+ * the batched fitter, with a ROOT TH1F/TF1 fit set up as in the
+ * PeakFitterGaussian tool and with the MarqFitAlg fit used by the
+ * PeakFitterMrqdt tool. The fitted peaks are compared and the fit rate of
+ * each method is printed in hits per second.
+ */
+
+// C/C++ standard libraries
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( BatchGausFitter_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/HitFinder/BatchGausFitter.h"
+#include "lardata/Utilities/MarqFitAlg.h"
+
+// ROOT libraries
+#include "TF1.h"
+#include "TH1.h"
+#include "TH1F.h"
+
+namespace {
+
+  struct PulseTrain {
+    std::vector<float> signal;
+    std::vector<float> truth;    ///< (amplitude, mean, sigma) of each Gaussian
+    std::vector<float> seed;     ///< starting values, as a candidate hit finder would give
+  };
+
+  std::vector<PulseTrain> makePulseTrains(std::size_t nTrains)
+  {
+    std::mt19937                          engine(12345);
+    std::normal_distribution<float>       noise(0., 1.);
+    std::uniform_real_distribution<float> flat(0., 1.);
+
+    std::vector<PulseTrain> trains(nTrains);
+
+    for(std::size_t idx = 0; idx < nTrains; idx++)
+    {
+      PulseTrain&       train = trains[idx];
+      std::size_t const nGaus = 1 + idx % 3;
+
+      train.signal.assign(20 + 15 * nGaus, 0.);
+
+      for(std::size_t gaus = 0; gaus < nGaus; gaus++)
+      {
+        float const amp   = 20. + 60. * flat(engine);
+        float const mean  = 8. + 15. * gaus + 3. * flat(engine);
+        float const sigma = 1.5 + 2. * flat(engine);
+
+        train.truth.insert(train.truth.end(), {amp, mean, sigma});
+        train.seed.insert(train.seed.end(), {amp * (0.8f + 0.4f * flat(engine)), mean + flat(engine) - 0.5f, sigma * (0.8f + 0.4f * flat(engine))});
+
+        for(std::size_t tick = 0; tick < train.signal.size(); tick++)
+        {
+          float const z = (tick + 0.5 - mean) / sigma;
+          train.signal[tick] += amp * std::exp(-0.5 * z * z);
+        }
+      }
+
+      for(auto& value : train.signal) value += noise(engine);
+    }
+
+    return trains;
+  }
+
+  // parameter limits as in the PeakFitterGaussian tool with its default configuration
+  void fillLimits(float amp, float mean, float sigma, float roiSize, float* low, float* high)
+  {
+    low[0]  = 0.1 * amp;                             high[0] = 2. * amp;
+    low[1]  = std::max(mean - 2. * sigma, 0.);       high[1] = std::min(mean + 2. * sigma, double(roiSize));
+    low[2]  = std::max(0.5, 0.1 * sigma);            high[2] = 3. * sigma;
+  }
+
+  double hitsPerSecond(std::size_t nHits, std::chrono::steady_clock::time_point start)
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return nHits / elapsed.count();
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(BatchFitAgainstReferenceFitters)
+{
+  std::vector<PulseTrain> const trains = makePulseTrains(3000);
+
+  std::size_t nHits(0);
+
+  for(const auto& train : trains) nHits += train.truth.size() / 3;
+
+  // --- batched fitter
+  std::vector<hit::BatchGausFitter::Problem>  problems(trains.size());
+  std::vector<hit::BatchGausFitter::Solution> solutions;
+
+  for(std::size_t idx = 0; idx < trains.size(); idx++)
+  {
+    const PulseTrain&              train   = trains[idx];
+    hit::BatchGausFitter::Problem& problem = problems[idx];
+
+    problem.signal = train.signal.data();
+    problem.nTicks = train.signal.size();
+    problem.params = train.seed;
+    problem.params.push_back(0.);
+    problem.lowLimits.resize(problem.params.size(), 0.);
+    problem.highLimits.resize(problem.params.size(), 0.);
+
+    for(std::size_t par = 0; par < train.seed.size(); par += 3)
+      fillLimits(train.seed[par], train.seed[par+1], train.seed[par+2], problem.nTicks, &problem.lowLimits[par], &problem.highLimits[par]);
+  }
+
+  auto batchStart = std::chrono::steady_clock::now();
+
+  hit::BatchGausFitter().Fit(problems, solutions);
+
+  double const batchRate = hitsPerSecond(nHits, batchStart);
+
+  // --- ROOT fit as done by PeakFitterGaussian
+  TH1::AddDirectory(kFALSE);
+
+  std::vector<std::vector<double>> rootParams(trains.size());
+
+  auto rootStart = std::chrono::steady_clock::now();
+
+  for(std::size_t idx = 0; idx < trains.size(); idx++)
+  {
+    const PulseTrain& train   = trains[idx];
+    int const         roiSize = train.signal.size();
+    std::size_t const nGaus   = train.seed.size() / 3;
+
+    TH1F histogram("BatchGausFitterTest", "", roiSize, 0., roiSize);
+
+    histogram.Sumw2();
+
+    for(int tick = 0; tick < roiSize; tick++) histogram.SetBinContent(tick + 1, train.signal[tick]);
+
+    std::string formula;
+
+    for(std::size_t gaus = 0; gaus < nGaus; gaus++) formula += "gaus(" + std::to_string(3 * gaus) + ") + ";
+    formula += "[" + std::to_string(3 * nGaus) + "]";
+
+    TF1 Gaus("BatchGausFitterTestFunc", formula.c_str(), 0., roiSize);
+
+    Gaus.FixParameter(3 * nGaus, 0.);
+
+    for(std::size_t par = 0; par < train.seed.size(); par += 3)
+    {
+      float low[3], high[3];
+
+      fillLimits(train.seed[par], train.seed[par+1], train.seed[par+2], roiSize, low, high);
+
+      for(std::size_t k = 0; k < 3; k++)
+      {
+        Gaus.SetParameter(par + k, train.seed[par + k]);
+        Gaus.SetParLimits(par + k, low[k], high[k]);
+      }
+    }
+
+    if (histogram.Fit(&Gaus, "QNWB", "", 0., roiSize) == 0)
+      for(std::size_t par = 0; par < train.seed.size(); par++) rootParams[idx].push_back(Gaus.GetParameter(par));
+  }
+
+  double const rootRate = hitsPerSecond(nHits, rootStart);
+
+  // --- MarqFitAlg as done by PeakFitterMrqdt
+  gshf::MarqFitAlg marqFitAlg;
+
+  auto mrqdtStart = std::chrono::steady_clock::now();
+
+  for(const auto& train : trains)
+  {
+    int const          roiSize = train.signal.size();
+    int const          nParams = train.seed.size();
+    std::vector<float> y(train.signal);
+    std::vector<float> p(nParams), low(nParams), high(nParams);
+
+    for(int par = 0; par < nParams; par += 3)
+    {
+      fillLimits(train.seed[par], train.seed[par+1] - 0.5, train.seed[par+2], roiSize, &low[par], &high[par]);
+
+      p[par]   = train.seed[par];
+      p[par+1] = train.seed[par+1] - 0.5;
+      p[par+2] = train.seed[par+2];
+    }
+
+    float lambda(-1.), chiSqr(0.), dchiSqr(0.);
+
+    for(int trial = 0; trial <= 100; trial++)
+    {
+      if (marqFitAlg.mrqdtfit(lambda, &p[0], &low[0], &high[0], &y[0], nParams, roiSize, chiSqr, dchiSqr)) break;
+      if (std::abs(dchiSqr) < 1.e-3) break;
+    }
+  }
+
+  double const mrqdtRate = hitsPerSecond(nHits, mrqdtStart);
+
+  std::cout << "Fit rate for " << nHits << " hits in " << trains.size() << " pulse trains:"
+            << "\n  BatchGausFitter:    " << batchRate << " hits/s"
+            << "\n  PeakFitterGaussian: " << rootRate  << " hits/s"
+            << "\n  PeakFitterMrqdt:    " << mrqdtRate << " hits/s" << std::endl;
+
+  // --- compare the batched fit with the truth and with the ROOT fit
+  std::size_t nCompared(0);
+
+  for(std::size_t idx = 0; idx < trains.size(); idx++)
+  {
+    const hit::BatchGausFitter::Solution& solution = solutions[idx];
+
+    BOOST_CHECK(solution.valid);
+
+    if (!solution.valid) continue;
+
+    BOOST_CHECK_EQUAL(solution.NDF, int(trains[idx].signal.size() - trains[idx].seed.size()));
+
+    for(std::size_t par = 0; par < trains[idx].truth.size(); par += 3)
+    {
+      // noise is 1 ADC, peaks are at least 20 ADC high
+      BOOST_CHECK_SMALL(solution.params[par + 1] - trains[idx].truth[par + 1], 0.5f);
+
+      if (rootParams[idx].empty()) continue;
+
+      BOOST_CHECK_SMALL(solution.params[par]     - rootParams[idx][par],     float(0.02 * rootParams[idx][par]));
+      BOOST_CHECK_SMALL(solution.params[par + 1] - rootParams[idx][par + 1], 0.02f);
+      BOOST_CHECK_SMALL(solution.params[par + 2] - rootParams[idx][par + 2], float(0.02 * rootParams[idx][par + 2]));
+      nCompared++;
+    }
+  }
+
+  BOOST_CHECK_GT(nCompared, nHits / 2);
+
+} // BOOST_AUTO_TEST_CASE(BatchFitAgainstReferenceFitters)
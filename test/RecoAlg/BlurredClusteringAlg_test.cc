@@ -0,0 +1,364 @@
+/**
+ * @file   BlurredClusteringAlg_test.cc
+ * @brief  Test of the blur and the clustering of cluster::BlurredClusteringAlg
+ * @see    BlurredClusteringAlg.h
+ *
+ * On a fixed sample of hits with tracks, a shower, isolated noise hits, wide
+ * hits and dead wires, the separable GaussianBlur(), serial and concurrent, is
+ * compared with the 2D splat of each hit with its kernel, and FindClusters(),
+ * which skips the seeds on islands smaller than the minimum cluster size, with
+ * the loop growing a cluster from every seed.
+ */
+
+// C/C++ standard libraries
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( BlurredClusteringAlg_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/BlurredClusteringAlg.h"
+#include "lardataobj/RecoBase/Hit.h"
+
+// framework libraries
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+#include "cetlib/pow.h"
+#include "fhiclcpp/ParameterSet.h"
+
+
+namespace cluster {
+
+  class BlurredClusteringAlgTest {
+  public:
+    explicit BlurredClusteringAlgTest(fhicl::ParameterSet const& pset)
+      : alg(pset, nullptr, nullptr, nullptr)
+    {}
+
+    /// Fills the image and the hit containers like ConvertRecobHitsToVector(), with the wire
+    /// number as global wire and the dead wires given
+    std::vector<std::vector<double>> ConvertHits(std::vector<art::Ptr<recob::Hit>> const& hits,
+                                                 std::vector<int> const& deadWires)
+    {
+      int lowerTick = 100000, upperTick{}, lowerWire = 100000, upperWire{};
+      for (auto const& hit : hits) {
+        int const wire = hit->WireID().Wire;
+        if (hit->PeakTime() < lowerTick) lowerTick = hit->PeakTime();
+        if (hit->PeakTime() > upperTick) upperTick = hit->PeakTime();
+        if (wire < lowerWire) lowerWire = wire;
+        if (wire > upperWire) upperWire = wire;
+      }
+      alg.fLowerTick = lowerTick-20;
+      alg.fUpperTick = upperTick+20;
+      alg.fLowerWire = lowerWire-20;
+      alg.fUpperWire = upperWire+20;
+
+      alg.fNTicks = alg.fUpperTick-alg.fLowerTick;
+      alg.fHits.clear();
+      alg.fHitBins.clear();
+      alg.fHitIndex.assign((alg.fUpperWire-alg.fLowerWire)*alg.fNTicks, -1);
+
+      std::vector<std::vector<double>> image(alg.fUpperWire-alg.fLowerWire, std::vector<double>(alg.fNTicks));
+      for (auto const& hit : hits) {
+        int const wire = hit->WireID().Wire;
+        auto const tick = static_cast<int>(hit->PeakTime());
+        float const charge = hit->Integral();
+        if (charge > image.at(wire-alg.fLowerWire).at(tick-alg.fLowerTick)) {
+          image.at(wire-alg.fLowerWire).at(tick-alg.fLowerTick) = charge;
+          int const bin = (wire-alg.fLowerWire)*alg.fNTicks + (tick-alg.fLowerTick);
+          if (alg.fHitIndex[bin] < 0) {
+            alg.fHitIndex[bin] = alg.fHits.size();
+            alg.fHits.push_back(hit);
+            alg.fHitBins.push_back(bin);
+          }
+          else alg.fHits[alg.fHitIndex[bin]] = hit;
+        }
+      }
+
+      alg.fDeadWires.assign(alg.fUpperWire-alg.fLowerWire, false);
+      for (int const wire : deadWires) {
+        if (wire >= alg.fLowerWire and wire < alg.fUpperWire)
+          alg.fDeadWires[wire-alg.fLowerWire] = true;
+      }
+      return image;
+    }
+
+    std::vector<std::vector<double>> GaussianBlur(std::vector<std::vector<double>> const& image) const
+    {
+      return alg.GaussianBlur(image);
+    }
+
+    /// Blur splatting each hit with its 2D kernel
+    std::vector<std::vector<double>> SplatBlur(std::vector<std::vector<double>> const& image) const
+    {
+      auto const [blur_wire, blur_tick, sigma_wire, sigma_tick] = alg.FindBlurringParameters();
+
+      int width = 2 * blur_wire + 1;
+      int height = 2 * blur_tick + 1;
+      int nbinsx = image.size();
+      int nbinsy = image.at(0).size();
+
+      std::vector<std::vector<double>> copy(nbinsx, std::vector<double>(nbinsy, 0));
+      for (int x = 0; x < nbinsx; ++x) {
+        for (int y = 0; y < nbinsy; ++y) {
+
+          if (image[x][y] == 0)
+            continue;
+
+          auto const& hit = alg.fHits[alg.fHitIndex[x*alg.fNTicks + y]];
+          int tick_scale = std::sqrt(cet::square(hit->RMS()) + cet::square(sigma_tick)) / (double)sigma_tick;
+          tick_scale = std::max(std::min(tick_scale, alg.fMaxTickWidthBlur), 1);
+          auto const& correct_kernel = alg.fAllKernels[sigma_wire][sigma_tick*tick_scale];
+
+          auto const [lower_bin_dead, upper_bin_dead] = alg.DeadWireCount(x, width);
+          auto dead_wires_passed{lower_bin_dead};
+
+          for (int blurx = -(width/2+lower_bin_dead); blurx < (width+1)/2+upper_bin_dead; ++blurx) {
+            if (x + blurx < 0) continue;
+            for (int blury = -height/2*tick_scale; blury < ((((height+1)/2)-1)*tick_scale)+1; ++blury) {
+              if (blurx < 0 and alg.fDeadWires[x+blurx])
+                dead_wires_passed -= 1;
+
+              double const weight = correct_kernel[alg.fKernelWidth * (alg.fKernelHeight / 2 + blury) + (alg.fKernelWidth / 2 + (blurx - dead_wires_passed))];
+              if (x + blurx >= 0 and x + blurx < nbinsx and y + blury >= 0 and y + blury < nbinsy)
+                copy[x+blurx][y+blury] += weight * image[x][y];
+
+              if (blurx > 0 and alg.fDeadWires[x+blurx])
+                dead_wires_passed += 1;
+            }
+          }
+        }
+      }
+      return copy;
+    }
+
+    std::vector<std::vector<int>> FindClusters(std::vector<std::vector<double>> const& blurred) const
+    {
+      std::vector<std::vector<int>> allcluster;
+      alg.FindClusters(blurred, allcluster);
+      return allcluster;
+    }
+
+    /// Clustering growing a cluster from every seed, until no bin is added
+    std::vector<std::vector<int>> FindClustersFromAllSeeds(std::vector<std::vector<double>> const& blurred) const
+    {
+      int const nbinsx = blurred.size();
+      int const nbinsy = blurred.at(0).size();
+      auto const charge = [&](int bin) { return blurred[bin % nbinsx][bin / nbinsx]; };
+
+      std::vector<std::vector<int>> allcluster;
+      std::vector<bool> used(nbinsx * nbinsy);
+      std::vector<std::pair<double, int>> values;
+      for (int xbin = 0; xbin < nbinsx; ++xbin) {
+        for (int ybin = 0; ybin < nbinsy; ++ybin) {
+          int const bin = alg.ConvertWireTickToBin(blurred, xbin, ybin);
+          values.emplace_back(charge(bin), bin);
+        }
+      }
+      std::sort(values.rbegin(), values.rend());
+
+      for (auto const& [blurred_binval, bin] : values) {
+        if (blurred_binval < alg.fMinSeed)
+          break;
+
+        std::vector<int> cluster;
+        std::vector<double> times;
+        if (used[bin])
+          continue;
+        used[bin] = true;
+        cluster.push_back(bin);
+        if (double const time = alg.GetTimeOfBin(blurred, bin); time > 0)
+          times.push_back(time);
+
+        while (true) {
+          bool added_cluster{false};
+          for (unsigned int clusBin = 0; clusBin < cluster.size(); ++clusBin) {
+            int const binx = cluster[clusBin] % nbinsx;
+            int const biny = ((cluster[clusBin] - binx) / nbinsx) % nbinsy;
+            for (int x = binx - alg.fClusterWireDistance; x <= binx + alg.fClusterWireDistance; x++) {
+              if (x >= nbinsx or x < 0) continue;
+              for (int y = biny - alg.fClusterTickDistance; y <= biny + alg.fClusterTickDistance; y++) {
+                if (y >= nbinsy or y < 0) continue;
+                if (x == binx and y == biny) continue;
+                auto const bin = alg.ConvertWireTickToBin(blurred, x, y);
+                if (used[bin])
+                  continue;
+                double const time = alg.GetTimeOfBin(blurred, bin);
+                if (time > 0 && times.size() > 0 && ! alg.PassesTimeCut(times, time))
+                  continue;
+                if (charge(bin) > alg.fChargeThreshold) {
+                  used[bin] = true;
+                  cluster.push_back(bin);
+                  added_cluster = true;
+                  if (time > 0)
+                    times.push_back(time);
+                }
+              }
+            }
+          }
+          if (!added_cluster)
+            break;
+        }
+
+        if (cluster.size() < alg.fMinSize) {
+          for (auto const bin : cluster) used[bin] = false;
+          continue;
+        }
+
+        // Fill in holes in the cluster
+        for (unsigned int clusBin = 0; clusBin < cluster.size(); clusBin++) {
+          for (int x = -1; x <= 1; ++x) {
+            for (int y = -1; y <= 1; ++y) {
+              if (x == 0 && y == 0) continue;
+              int neighbouringBin = cluster[clusBin] + x + (y * nbinsx);
+              if (neighbouringBin < nbinsx || neighbouringBin % nbinsx == 0 || neighbouringBin % nbinsx == nbinsx - 1 || neighbouringBin >= nbinsx * (nbinsy - 1))
+                continue;
+              double const time = alg.GetTimeOfBin(blurred, neighbouringBin);
+              if (!used[neighbouringBin] && (alg.NumNeighbours(nbinsx, used, neighbouringBin) > alg.fNeighboursThreshold) && alg.PassesTimeCut(times, time)) {
+                used[neighbouringBin] = true;
+                cluster.push_back(neighbouringBin);
+                if (time > 0)
+                  times.push_back(time);
+              }
+            }
+          }
+        }
+
+        // Remove peninsulas
+        while (true) {
+          bool removed_cluster{false};
+          for (int clusBin = cluster.size() - 1; clusBin >= 0; clusBin--) {
+            auto const bin = cluster[clusBin];
+            if (bin < nbinsx || bin % nbinsx == 0 || bin % nbinsx == nbinsx - 1 || bin >= nbinsx * (nbinsy - 1)) continue;
+            if (alg.NumNeighbours(nbinsx, used, bin) < alg.fMinNeighbours) {
+              used[bin] = false;
+              removed_cluster = true;
+              cluster.erase(cluster.begin() + clusBin);
+            }
+          }
+          if (!removed_cluster)
+            break;
+        }
+
+        if (cluster.size() < alg.fMinSize) {
+          for (auto const bin : cluster) used[bin] = false;
+          continue;
+        }
+        allcluster.push_back(cluster);
+      }
+      return allcluster;
+    }
+
+  private:
+    cluster::BlurredClusteringAlg alg;
+  };
+
+} // namespace cluster
+
+
+namespace {
+
+  fhicl::ParameterSet makeConfig(int minSize, bool concurrentBlur = false)
+  {
+    // standard_blurredclusteralg, with a time threshold which the shower hits can fail
+    fhicl::ParameterSet pset;
+    pset.put("BlurWire",            6);
+    pset.put("BlurTick",            12);
+    pset.put("SigmaWire",           4.);
+    pset.put("SigmaTick",           6.);
+    pset.put("ClusterWireDistance", 2);
+    pset.put("ClusterTickDistance", 2);
+    pset.put("MaxTickWidthBlur",    10);
+    pset.put("NeighboursThreshold", 0u);
+    pset.put("MinNeighbours",       0u);
+    pset.put("MinSize",             static_cast<unsigned int>(minSize));
+    pset.put("MinSeed",             0.1);
+    pset.put("TimeThreshold",       40.);
+    pset.put("ChargeThreshold",     0.07);
+    pset.put("ConcurrentBlur",      concurrentBlur);
+    return pset;
+  }
+
+  recob::Hit makeHit(unsigned int wire, float peakTime, float rms, float integral)
+  {
+    return recob::Hit(wire, peakTime - 3 * rms, peakTime + 3 * rms, peakTime, 1., rms,
+                      integral / (2.5066 * rms), 1., integral, integral, 1., 1, 0, 1., 1,
+                      geo::kW, geo::kCollection, geo::WireID(0, 0, 2, wire));
+  }
+
+  /// Two tracks, a shower, wide hits and isolated noise hits
+  std::vector<recob::Hit> makeHitSample()
+  {
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> flat(0., 1.);
+    std::vector<recob::Hit> hits;
+
+    for (unsigned int wire = 300; wire < 700; ++wire)
+      hits.push_back(makeHit(wire, 2000. + 0.8 * (wire - 300.), 3. + 2. * flat(rng), 100. + 50. * flat(rng)));
+    for (unsigned int wire = 420; wire < 520; ++wire)
+      hits.push_back(makeHit(wire, 3500. - 6. * (wire - 420.), 8. + 60. * flat(rng), 80. + 40. * flat(rng)));
+    for (int i = 0; i < 600; ++i) {
+      double const r = 60. * flat(rng), phi = 6.2832 * flat(rng);
+      hits.push_back(makeHit(560 + r * std::cos(phi), 2800. + 4. * r * std::sin(phi), 4. + 10. * flat(rng), 20. + 200. * flat(rng)));
+    }
+    for (int i = 0; i < 150; ++i)
+      hits.push_back(makeHit(280 + 460 * flat(rng), 1900. + 1800. * flat(rng), 2. + 4. * flat(rng), 5. + 30. * flat(rng)));
+
+    return hits;
+  }
+
+  std::vector<art::Ptr<recob::Hit>> makePtrs(std::vector<recob::Hit> const& hits)
+  {
+    std::vector<art::Ptr<recob::Hit>> ptrs;
+    for (std::size_t i = 0; i < hits.size(); ++i)
+      ptrs.emplace_back(art::ProductID(), &hits[i], i);
+    return ptrs;
+  }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(SeparableAgainstSplatBlur)
+{
+  std::vector<recob::Hit> const hits = makeHitSample();
+  std::vector<int> const deadWires{350, 351, 352, 480, 575, 640};
+
+  for (bool const concurrent : {false, true}) {
+    cluster::BlurredClusteringAlgTest test(makeConfig(2, concurrent));
+    auto const image = test.ConvertHits(makePtrs(hits), deadWires);
+
+    auto const blurred = test.GaussianBlur(image);
+    auto const splat = test.SplatBlur(image);
+
+    BOOST_REQUIRE_EQUAL(blurred.size(), splat.size());
+    for (std::size_t x = 0; x < blurred.size(); ++x) {
+      BOOST_REQUIRE_EQUAL(blurred[x].size(), splat[x].size());
+      for (std::size_t y = 0; y < blurred[x].size(); ++y)
+        BOOST_CHECK_CLOSE(blurred[x][y], splat[x][y], 1e-10);
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(SkippedSeedsAgainstAllSeeds)
+{
+  std::vector<recob::Hit> const hits = makeHitSample();
+  std::vector<int> const deadWires{350, 351, 352, 480, 575, 640};
+
+  for (int const minSize : {2, 8, 30}) {
+    cluster::BlurredClusteringAlgTest test(makeConfig(minSize));
+    auto const image = test.ConvertHits(makePtrs(hits), deadWires);
+    auto const blurred = test.GaussianBlur(image);
+
+    auto const clusters = test.FindClusters(blurred);
+    BOOST_CHECK(!clusters.empty());
+
+    // on the same image, and from the blur splatting each hit
+    BOOST_CHECK(clusters == test.FindClustersFromAllSeeds(blurred));
+    BOOST_CHECK(clusters == test.FindClustersFromAllSeeds(test.SplatBlur(image)));
+  }
+}
@@ -0,0 +1,158 @@
+/**
+ * @file   DBScan3DAlg_test.cc
+ * @brief  Test and scaling benchmark for cluster::DBScan3DAlg
+ * @see    DBScan3DAlg.h
+ *
+ * The cell indexed clustering is compared with a straightforward full scan
+ * implementation of the same DBSCAN (the original algorithm) on small
+ * random samples, then timed on samples from 10^3 to 10^6 points.
+ */
+
+// C/C++ standard libraries
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( DBScan3DAlg_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/DBScan3DAlg.h"
+
+// framework libraries
+#include "fhiclcpp/ParameterSet.h"
+
+
+namespace {
+
+  fhicl::ParameterSet makeConfig(double epsilon, unsigned int minpts, double badchannelweight)
+  {
+    fhicl::ParameterSet pset;
+    pset.put("epsilon", epsilon);
+    pset.put("minpts", minpts);
+    pset.put("badchannelweight", badchannelweight);
+    pset.put("neighbors", 10u);
+    return pset;
+  }
+
+  /// DBSCAN with the full scan for neighbours, as the algorithm was originally written
+  std::vector<int> fullScanDBScan(const std::vector<std::array<double,3>>& xyz,
+                                  const std::vector<unsigned int>& nbad,
+                                  double epsilon, unsigned int minpts, double weight)
+  {
+    double const epsilon2 = epsilon * epsilon;
+
+    auto dist = [&](size_t a, size_t b){
+      float const dx = xyz[a][0] - xyz[b][0];
+      float const dy = xyz[a][1] - xyz[b][1];
+      float const dz = xyz[a][2] - xyz[b][2];
+      float const d = dx*dx + dy*dy + dz*dz - std::pow((nbad[a] + nbad[b]) * weight, 2);
+      return std::max(d, 0.f);
+    };
+
+    auto neighbours = [&](size_t index){
+      std::vector<unsigned int> result;
+      for (size_t i = 0; i < xyz.size(); ++i)
+        if (i != index && !(dist(index, i) > epsilon2)) result.push_back(i);
+      return result;
+    };
+
+    std::vector<int> ids(xyz.size(), UNCLASSIFIED);
+    int cluster_id = 0;
+    for (size_t i = 0; i < xyz.size(); ++i) {
+      if (ids[i] != UNCLASSIFIED) continue;
+      std::vector<unsigned int> seeds = neighbours(i);
+      if (seeds.size() < minpts) { ids[i] = NOISE; continue; }
+      ids[i] = cluster_id;
+      for (auto seed : seeds) ids[seed] = cluster_id;
+      for (size_t s = 0; s < seeds.size(); ++s) {
+        std::vector<unsigned int> const spread = neighbours(seeds[s]);
+        if (spread.size() < minpts) continue;
+        for (auto n : spread) {
+          if (ids[n] == UNCLASSIFIED) seeds.push_back(n);
+          if (ids[n] == UNCLASSIFIED || ids[n] == NOISE) ids[n] = cluster_id;
+        }
+      }
+      ++cluster_id;
+    }
+    return ids;
+  }
+
+  /// Random track-like segments plus uniform noise in a box of side size
+  void makePoints(size_t npoints, double size, std::mt19937& engine,
+                  std::vector<std::array<double,3>>& xyz, std::vector<unsigned int>& nbad)
+  {
+    std::uniform_real_distribution<double> flat(0., 1.);
+    xyz.clear();
+    nbad.clear();
+    while (xyz.size() < npoints) {
+      if (flat(engine) < 0.2) {
+        xyz.push_back({size * flat(engine), size * flat(engine), size * flat(engine)});
+        nbad.push_back(engine() % 3);
+        continue;
+      }
+      std::array<double,3> start{size * flat(engine), size * flat(engine), size * flat(engine)};
+      std::array<double,3> dir{flat(engine) - 0.5, flat(engine) - 0.5, flat(engine) - 0.5};
+      for (size_t step = 0; step < 50 && xyz.size() < npoints; ++step) {
+        xyz.push_back({start[0] + step * dir[0], start[1] + step * dir[1], start[2] + step * dir[2]});
+        nbad.push_back(engine() % 3);
+      }
+    }
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(SameClustersAsFullScan)
+{
+  std::mt19937 engine(2020);
+
+  for (double weight : {0., 0.2}) {
+    for (unsigned int minpts : {2u, 4u}) {
+      cluster::DBScan3DAlg alg(makeConfig(1.5, minpts, weight));
+
+      for (size_t npoints : {500, 3000}) {
+        std::vector<std::array<double,3>> xyz;
+        std::vector<unsigned int> nbad;
+        std::vector<int> ids;
+
+        makePoints(npoints, 100., engine, xyz, nbad);
+        alg.dbscan(xyz, nbad, ids);
+
+        std::vector<int> const expected = fullScanDBScan(xyz, nbad, 1.5, minpts, weight);
+
+        BOOST_CHECK(ids == expected);
+      }
+    }
+  }
+} // BOOST_AUTO_TEST_CASE(SameClustersAsFullScan)
+
+
+BOOST_AUTO_TEST_CASE(ScalingBenchmark)
+{
+  std::mt19937 engine(1234);
+  cluster::DBScan3DAlg alg(makeConfig(1.5, 2, 0.));
+
+  for (size_t npoints = 1000; npoints <= 1000000; npoints *= 10) {
+    std::vector<std::array<double,3>> xyz;
+    std::vector<unsigned int> nbad;
+    std::vector<int> ids;
+
+    // keep the density of points constant
+    makePoints(npoints, 10. * std::cbrt(double(npoints)), engine, xyz, nbad);
+
+    auto start = std::chrono::steady_clock::now();
+    alg.dbscan(xyz, nbad, ids);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "DBScan3DAlg: " << npoints << " points clustered in " << elapsed.count() << " ms ("
+              << (*std::max_element(ids.begin(), ids.end()) + 1) << " clusters)" << std::endl;
+
+    BOOST_CHECK_EQUAL(ids.size(), npoints);
+  }
+} // BOOST_AUTO_TEST_CASE(ScalingBenchmark)
@@ -0,0 +1,188 @@
+/**
+ * @file   DBScanAlg_test.cc
+ * @brief  Test and benchmark of the wire indexed method of cluster::DBScanAlg
+ * @see    DBScanAlg.h
+ *
+ * The clusters of Method 3, which computes the similarities on demand from a
+ * wire index, are compared with a full scan DBSCAN built on the public
+ * getSimilarity(), getSimilarity2() and getWidthFactor() on samples with bad
+ * wires. Then the run time and peak resident memory of Method 3 and of the
+ * similarity matrices of Method 0 are printed for growing samples.
+ */
+
+// C/C++ standard libraries
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <sys/resource.h>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( DBScanAlg_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/DBScanAlg.h"
+
+// framework libraries
+#include "fhiclcpp/ParameterSet.h"
+
+
+namespace {
+
+  constexpr double kWirePitch = 0.3;  // cm
+
+  fhicl::ParameterSet makeConfig(unsigned int method, unsigned int minPts)
+  {
+    fhicl::ParameterSet pset;
+    pset.put("eps",    1.0);
+    pset.put("epstwo", 1.5);
+    pset.put("minPts", minPts);
+    pset.put("Method", method);
+    pset.put("Metric", 3);
+    return pset;
+  }
+
+  /// DBSCAN as run_dbscan_cluster() does it, with a full scan for neighbours
+  std::vector<unsigned int> fullScanDBScan(cluster::DBScanAlg& alg, double eps, double eps2,
+                                           unsigned int minPts)
+  {
+    unsigned int const noCluster    = UINT_MAX;
+    unsigned int const noiseCluster = UINT_MAX - 1;
+    std::vector<std::vector<double>> const& ps = alg.fps;
+
+    auto regionQuery = [&](unsigned int point){
+      std::set<unsigned int> result;
+      for (unsigned int j = 0; j < ps.size(); ++j) {
+        double const sim  = alg.getSimilarity(ps[point], ps[j]);
+        double const sim2 = alg.getSimilarity2(ps[point], ps[j]);
+        double const wf   = alg.getWidthFactor(ps[point], ps[j]);
+        if ((sim/(eps*eps)) + (sim2/(eps2*eps2*wf)) <= 1) result.insert(j);
+      }
+      return result;
+    };
+
+    std::vector<unsigned int> ids(ps.size(), noCluster);
+    unsigned int cid = 0;
+    for (unsigned int pid = 0; pid < ps.size(); ++pid) {
+      if (ids[pid] != noCluster) continue;
+      std::set<unsigned int> seeds = regionQuery(pid);
+      if (seeds.size() < minPts) { ids[pid] = noiseCluster; continue; }
+      for (auto seed : seeds) ids[seed] = cid;
+      ids[pid] = cid;
+      seeds.erase(pid);
+      while (!seeds.empty()) {
+        unsigned int const current = *seeds.begin();
+        std::set<unsigned int> const result = regionQuery(current);
+        if (result.size() >= minPts) {
+          for (auto r : result) {
+            if (ids[r] == noCluster) seeds.insert(r);
+            if (ids[r] == noCluster || ids[r] == noiseCluster) ids[r] = cid;
+          }
+        }
+        seeds.erase(current);
+      }
+      ++cid;
+    }
+    return ids;
+  }
+
+  /// Track-like hits and noise on nWires wires, crossing short runs of bad wires
+  void makeHits(std::size_t nHits, unsigned int nWires, std::mt19937& engine,
+                std::vector<std::vector<double>>& points, std::set<uint32_t>& badChannels)
+  {
+    std::uniform_real_distribution<double> flat(0., 1.);
+
+    points.clear();
+    badChannels.clear();
+    for (unsigned int wire = 0; wire < nWires; ++wire) {
+      if (flat(engine) > 0.02) continue;
+      for (unsigned int bad = wire; bad < wire + 1 + 3 * flat(engine) && bad < nWires; ++bad)
+        badChannels.insert(bad);
+    }
+
+    // bad wires have no hits
+    while (points.size() < nHits) {
+      if (flat(engine) < 0.2) {
+        unsigned int const wire = nWires * flat(engine);
+        if (badChannels.count(wire)) continue;
+        points.push_back({wire * kWirePitch, 0.1 * nWires * flat(engine), 0.2 + 0.3 * flat(engine)});
+        continue;
+      }
+      unsigned int const wire0 = nWires * flat(engine);
+      double const time0 = 0.1 * nWires * flat(engine);
+      double const slope = 4. * (flat(engine) - 0.5);
+      for (unsigned int wire = wire0; wire < wire0 + 40 && wire < nWires && points.size() < nHits; ++wire) {
+        if (badChannels.count(wire)) continue;
+        points.push_back({wire * kWirePitch, time0 + slope * kWirePitch * (wire - wire0),
+                          0.2 + 0.3 * flat(engine)});
+      }
+    }
+  }
+
+  long peakRSSkB()
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(SameClustersAsFullScan)
+{
+  std::mt19937 engine(3141);
+
+  for (unsigned int minPts : {2u, 4u}) {
+    cluster::DBScanAlg alg(makeConfig(3, minPts));
+
+    for (std::size_t nHits : {500, 2000}) {
+      std::vector<std::vector<double>> points;
+      std::set<uint32_t> badChannels;
+
+      makeHits(nHits, 400, engine, points, badChannels);
+      alg.InitScan(points, badChannels, std::vector<double>(3, kWirePitch));
+      alg.run_cluster();
+
+      std::vector<unsigned int> const expected = fullScanDBScan(alg, 1.0, 1.5, minPts);
+
+      BOOST_CHECK(alg.fpointId_to_clusterId == expected);
+    }
+  }
+} // BOOST_AUTO_TEST_CASE(SameClustersAsFullScan)
+
+
+BOOST_AUTO_TEST_CASE(MemoryAndTimeBenchmark)
+{
+  std::mt19937 engine(2718);
+
+  // the similarity matrices first only up to a few thousand hits: the peak
+  // resident memory never goes down, so the wire index is measured first
+  for (unsigned int method : {3u, 0u}) {
+    cluster::DBScanAlg alg(makeConfig(method, 2));
+
+    for (std::size_t nHits = 500; nHits <= (method == 0? 2000: 128000); nHits *= 4) {
+      std::vector<std::vector<double>> points;
+      std::set<uint32_t> badChannels;
+
+      // keep the density of hits constant
+      makeHits(nHits, nHits / 4, engine, points, badChannels);
+
+      auto start = std::chrono::steady_clock::now();
+      alg.InitScan(points, badChannels, std::vector<double>(3, kWirePitch));
+      alg.run_cluster();
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+      std::cout << "DBScanAlg Method " << method << ": " << nHits << " hits clustered in "
+                << elapsed.count() << " ms (" << alg.fclusters.size() << " clusters), peak RSS "
+                << peakRSSkB() / 1024 << " MB" << std::endl;
+
+      BOOST_CHECK_EQUAL(alg.fpointId_to_clusterId.size(), nHits);
+    }
+  }
+} // BOOST_AUTO_TEST_CASE(MemoryAndTimeBenchmark)
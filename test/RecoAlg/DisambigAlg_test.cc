@@ -0,0 +1,74 @@
+/**
+ * @file   DisambigAlg_test.cc
+ * @brief  Test of the grouping of hits by channel and peak time in apa::DisambigAlg
+ * @see    DisambigAlg.h
+ *
+ * DisambigAlg keeps the disambiguation state of hits with the same channel and
+ * peak time in one entry, indexed by hit. The entries of a synthetic hit set
+ * must group the hits as the (channel, peak time) keys of the maps used before.
+ */
+
+// C/C++ standard libraries
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( DisambigAlg_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/DisambigAlg.h"
+
+
+namespace {
+
+  /// Entries of the hits as the (channel, peak time) map keys gave them
+  std::vector<size_t> chanTimeKeyIndex(std::vector<raw::ChannelID_t> const& channels, std::vector<float> const& peakTimes)
+  {
+    std::map<std::pair<double,double>, size_t> firstHit;
+    std::vector<size_t>                        index(channels.size());
+
+    for(size_t h = 0; h < channels.size(); h++)
+    {
+      if (channels[h] == raw::InvalidChannelID) index[h] = h;
+      else index[h] = firstHit.emplace(std::make_pair(channels[h]*1., peakTimes[h]*1.), h).first->second;
+    }
+
+    return index;
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(ChanTimeIndexAgainstChanTimeKeys)
+{
+  std::mt19937 engine(35);
+
+  std::vector<raw::ChannelID_t> channels;
+  std::vector<float>            peakTimes;
+
+  // few channels and peak times, so that many hits share both; some hits are not UV hits
+  for(size_t h = 0; h < 20000; h++)
+  {
+    channels.push_back(engine() % 10 == 0 ? raw::InvalidChannelID : raw::ChannelID_t(engine() % 300));
+    peakTimes.push_back(0.5 * (engine() % 40));
+  }
+
+  std::vector<size_t> const index = apa::DisambigAlg::ChanTimeIndex(channels, peakTimes);
+  std::vector<size_t> const keys  = chanTimeKeyIndex(channels, peakTimes);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(index.begin(), index.end(), keys.begin(), keys.end());
+
+  size_t nShared(0);
+  for(size_t h = 0; h < index.size(); h++) if (index[h] != h) nShared++;
+  BOOST_CHECK_GT(nShared, 0U);
+
+} // BOOST_AUTO_TEST_CASE(ChanTimeIndexAgainstChanTimeKeys)
+
+
+BOOST_AUTO_TEST_CASE(ChanTimeIndexWithoutHits)
+{
+  BOOST_CHECK(apa::DisambigAlg::ChanTimeIndex({}, {}).empty());
+} // BOOST_AUTO_TEST_CASE(ChanTimeIndexWithoutHits)
@@ -0,0 +1,157 @@
+/**
+ * @file   HoughTransform_test.cc
+ * @brief  Test and benchmark of the accumulators of cluster::HoughTransform
+ * @see    HoughBaseAlg.h
+ *
+ * Hits along random straight lines plus uniform noise are added to a
+ * HoughTransform using HoughDenseAccumulator and to one using the maps of
+ * HoughTransformCounters. The maximum returned for each added point, the
+ * global maximum and the counters must be the same, also after cells are
+ * cleared and points are subtracted as HoughBaseAlg::Transform does.
+ * The rate of added points is printed for both.
+ */
+
+// C/C++ standard libraries
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( HoughTransform_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/HoughBaseAlg.h"
+
+
+namespace {
+
+  constexpr unsigned int kNWires       = 2400;
+  constexpr unsigned int kNTicks       = 6400;
+  constexpr float        kRhoRes       = 5.;
+  constexpr unsigned int kNAngleCells  = 10800;
+
+  std::vector<std::pair<int, int>> makePoints(std::size_t nLines, std::size_t nNoise)
+  {
+    std::mt19937                          engine(2468);
+    std::uniform_real_distribution<float> flat(0., 1.);
+
+    std::vector<std::pair<int, int>> points;
+
+    for(std::size_t line = 0; line < nLines; line++)
+    {
+      int const   wire0 = kNWires * 0.8 * flat(engine);
+      float const tick0 = kNTicks * flat(engine);
+      float const slope = 20. * (flat(engine) - 0.5);
+
+      for(int wire = wire0; wire < wire0 + int(kNWires / 10); wire++)
+      {
+        int const tick = tick0 + slope * (wire - wire0);
+
+        if (tick >= 0 && tick < int(kNTicks)) points.emplace_back(wire, tick);
+      }
+    }
+
+    for(std::size_t noise = 0; noise < nNoise; noise++)
+      points.emplace_back(kNWires * flat(engine), kNTicks * flat(engine));
+
+    std::shuffle(points.begin(), points.end(), engine);
+
+    return points;
+  }
+
+  double pointsPerSecond(std::size_t nPoints, std::chrono::steady_clock::time_point start)
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return nPoints / elapsed.count();
+  }
+
+  void checkSameMax(cluster::HoughTransform const& dense, cluster::HoughTransform const& sparse)
+  {
+    int denseRow(0), denseCol(0), sparseRow(0), sparseCol(0);
+
+    BOOST_CHECK_EQUAL(dense.GetMax(denseRow, denseCol), sparse.GetMax(sparseRow, sparseCol));
+    BOOST_CHECK_EQUAL(denseRow, sparseRow);
+    BOOST_CHECK_EQUAL(denseCol, sparseCol);
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(DenseAgainstCounterMaps)
+{
+  std::vector<std::pair<int, int>> const points = makePoints(50, 5000);
+
+  cluster::HoughTransform dense, sparse;
+
+  dense.Init(kNWires, kNTicks, kRhoRes, kNAngleCells, true);
+  sparse.Init(kNWires, kNTicks, kRhoRes, kNAngleCells, false);
+
+  // --- add all the points
+  std::vector<std::array<int, 3>> denseMax, sparseMax;
+
+  denseMax.reserve(points.size());
+  sparseMax.reserve(points.size());
+
+  auto denseStart = std::chrono::steady_clock::now();
+
+  for(auto const& point : points) denseMax.push_back(dense.AddPointReturnMax(point.first, point.second));
+
+  double const denseRate = pointsPerSecond(points.size(), denseStart);
+
+  auto sparseStart = std::chrono::steady_clock::now();
+
+  for(auto const& point : points) sparseMax.push_back(sparse.AddPointReturnMax(point.first, point.second));
+
+  double const sparseRate = pointsPerSecond(points.size(), sparseStart);
+
+  std::cout << "Hough transform of " << points.size() << " points with " << kNAngleCells << " angles:"
+            << "\n  HoughDenseAccumulator:  " << denseRate  << " points/s"
+            << "\n  HoughTransformCounters: " << sparseRate << " points/s" << std::endl;
+
+  for(std::size_t idx = 0; idx < points.size(); idx++)
+  {
+    BOOST_CHECK_EQUAL(denseMax[idx][0], sparseMax[idx][0]);
+    BOOST_CHECK_EQUAL(denseMax[idx][1], sparseMax[idx][1]);
+    BOOST_CHECK_EQUAL(denseMax[idx][2], sparseMax[idx][2]);
+  }
+
+  checkSameMax(dense, sparse);
+
+  // --- clear around the maximum and subtract some points, as after a line is found
+  for(std::size_t iteration = 0; iteration < 5; iteration++)
+  {
+    int row(0), col(0);
+
+    sparse.GetMax(row, col);
+
+    for(int y = row - 2; y <= row + 2; y++)
+    {
+      for(int x = col - 2; x <= col + 2; x++)
+      {
+        if (y < 1 || y >= int(kNAngleCells)) continue;
+        dense.SetCell(y, x, 0);
+        sparse.SetCell(y, x, 0);
+      }
+    }
+
+    for(std::size_t idx = iteration; idx < points.size(); idx += 13)
+    {
+      dense.SubtractPoint(points[idx].first, points[idx].second);
+      sparse.SubtractPoint(points[idx].first, points[idx].second);
+    }
+
+    checkSameMax(dense, sparse);
+
+    for(int y = row - 10; y <= row + 10; y++)
+    {
+      if (y < 0 || y >= int(kNAngleCells)) continue;
+      for(int x = col - 50; x <= col + 50; x++) BOOST_CHECK_EQUAL(dense.GetCell(y, x), sparse.GetCell(y, x));
+    }
+  }
+
+} // BOOST_AUTO_TEST_CASE(DenseAgainstCounterMaps)
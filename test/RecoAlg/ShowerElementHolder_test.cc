@@ -0,0 +1,139 @@
+/**
+ * @file   ShowerElementHolder_test.cc
+ * @brief  Test and benchmark of the element access of reco::shower::ShowerElementHolder
+ * @see    ShowerElementHolder.hh
+ *
+ * Elements set through a ShowerElementSlot must be the ones read through their
+ * name and the other way around, keep their type checks, and survive ClearAll()
+ * unset. Looking a name up by string does not register it, only setting it does.
+ * The get/set throughput by name and by slot is printed for a set of
+ * elements like the one a TRACS tool chain fills for each PFParticle.
+ */
+
+// C/C++ standard libraries
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( ShowerElementHolder_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/ShowerElementHolder.hh"
+
+
+BOOST_AUTO_TEST_CASE(SlotAgainstName)
+{
+  reco::shower::ShowerElementSlot const direction("ShowerDirection");
+  reco::shower::ShowerElementSlot const hits("InitialTrackHits");
+
+  reco::shower::ShowerElementHolder holder;
+
+  std::vector<double> dir{0., 0.6, 0.8}, dirErr{0.1, 0.1, 0.1};
+  holder.SetElement(dir, dirErr, direction);
+  std::vector<int> trackHits{3, 1, 4, 1, 5};
+  holder.SetElement(trackHits, "InitialTrackHits", true);
+
+  std::vector<double> readDir, readDirErr;
+  BOOST_CHECK_EQUAL(holder.GetElementAndError("ShowerDirection", readDir, readDirErr), 0);
+  BOOST_CHECK(readDir == dir);
+  BOOST_CHECK(readDirErr == dirErr);
+
+  std::vector<int> readHits;
+  BOOST_CHECK_EQUAL(holder.GetElement(hits, readHits), 0);
+  BOOST_CHECK(readHits == trackHits);
+  BOOST_CHECK(holder.CheckElementTag(hits));
+
+  // the type is still checked
+  int wrongType;
+  BOOST_CHECK_THROW(holder.GetElement(direction, wrongType), cet::exception);
+  BOOST_CHECK_THROW(holder.GetElement("NotAnElement", wrongType), cet::exception);
+
+  // ClearAll() unsets the elements but keeps them for the next shower
+  holder.ClearAll();
+  BOOST_CHECK(!holder.CheckElement(direction));
+  BOOST_CHECK(!holder.CheckElement("InitialTrackHits"));
+  BOOST_CHECK(!holder.CheckAllElementTags());
+
+  holder.SetElement(trackHits, hits, false);
+  BOOST_CHECK(holder.CheckElement("InitialTrackHits"));
+  BOOST_CHECK(holder.CheckAllElementTags());
+} // BOOST_AUTO_TEST_CASE(SlotAgainstName)
+
+
+BOOST_AUTO_TEST_CASE(LookUpDoesNotRegister)
+{
+  reco::shower::ShowerElementRegistry const& registry = reco::shower::ShowerElementRegistry::Instance();
+  reco::shower::ShowerElementHolder holder;
+
+  std::string const name = "NeverSetShowerElement";
+  std::size_t const nRegistered = registry.Size();
+
+  double value = 0.;
+  BOOST_CHECK(!holder.CheckElement(name));
+  BOOST_CHECK(!holder.CheckElementTag(name));
+  BOOST_CHECK_THROW(holder.GetElement(name, value), cet::exception);
+  holder.ClearElement(name);
+  holder.SetElementTag(name, true);
+  BOOST_CHECK_EQUAL(registry.Size(), nRegistered);
+
+  holder.SetElement(value, name);
+  BOOST_CHECK_EQUAL(registry.Size(), nRegistered + 1);
+  BOOST_CHECK(holder.CheckElement(name));
+} // BOOST_AUTO_TEST_CASE(LookUpDoesNotRegister)
+
+
+BOOST_AUTO_TEST_CASE(GetSetThroughput)
+{
+  unsigned int const nElements = 12;
+  unsigned int const nShowers  = 20000;
+
+  std::vector<std::string> names;
+  std::vector<reco::shower::ShowerElementSlot> slots;
+  for (unsigned int i = 0; i < nElements; ++i) {
+    names.push_back("BenchmarkShowerElement" + std::to_string(i));
+    slots.emplace_back(names.back());
+  }
+
+  reco::shower::ShowerElementHolder nameHolder, slotHolder;
+
+  auto const start = std::chrono::steady_clock::now();
+  double nameSum = 0.;
+  for (unsigned int shower = 0; shower < nShowers; ++shower) {
+    for (unsigned int i = 0; i < nElements; ++i) {
+      double value = shower + i, error = 0.;
+      nameHolder.SetElement(value, error, names[i]);
+    }
+    for (unsigned int i = 0; i < nElements; ++i) {
+      double value = 0.;
+      if (nameHolder.CheckElement(names[i])) nameHolder.GetElement(names[i], value);
+      nameSum += value;
+    }
+    nameHolder.ClearAll();
+  }
+  auto const middle = std::chrono::steady_clock::now();
+  double slotSum = 0.;
+  for (unsigned int shower = 0; shower < nShowers; ++shower) {
+    for (unsigned int i = 0; i < nElements; ++i) {
+      double value = shower + i, error = 0.;
+      slotHolder.SetElement(value, error, slots[i]);
+    }
+    for (unsigned int i = 0; i < nElements; ++i) {
+      double value = 0.;
+      if (slotHolder.CheckElement(slots[i])) slotHolder.GetElement(slots[i], value);
+      slotSum += value;
+    }
+    slotHolder.ClearAll();
+  }
+  auto const end = std::chrono::steady_clock::now();
+
+  BOOST_CHECK_EQUAL(nameSum, slotSum);
+
+  double const nCalls = 3. * nElements * nShowers;
+  std::cout << "ShowerElementHolder set/check/get time per call:"
+            << "\n  by name: " << std::chrono::duration<double, std::nano>(middle - start).count() / nCalls << " ns"
+            << "\n  by slot: " << std::chrono::duration<double, std::nano>(end - middle).count() / nCalls << " ns"
+            << std::endl;
+} // BOOST_AUTO_TEST_CASE(GetSetThroughput)
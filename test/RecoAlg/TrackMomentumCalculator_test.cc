@@ -0,0 +1,280 @@
+/**
+ * @file   TrackMomentumCalculator_test.cc
+ * @brief  Test of the range table and of the batch calls of trkf::TrackMomentumCalculator
+ * @see    TrackMomentumCalculator.h
+ *
+ * The muon momentum from range must reproduce the CSDA table at its points,
+ * as the TSpline3 it replaces did, and grow with the range in between.
+ * Between the table points and past its ends it must follow a TSpline3 built
+ * from the same table.
+ * The batch versions of the multiple scattering momenta must give the same
+ * values as one call per track on a sample of scattered muon tracks.
+ * The likelihood scan over all the test momenta must give the likelihoods of
+ * one my_mcs_llhd call per momentum, and GetMomentumMultiScatterLLHD the
+ * momentum of the best of those, as it did before the scan.
+ */
+
+// C/C++ standard libraries
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( TrackMomentumCalculator_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/TrackMomentumCalculator.h"
+#include "lardataobj/RecoBase/Track.h"
+#include "lardataobj/RecoBase/TrackTrajectory.h"
+
+// framework libraries
+#include "canvas/Persistency/Common/Ptr.h"
+
+// ROOT libraries
+#include "TGraph.h"
+#include "TSpline.h"
+
+
+namespace {
+
+  constexpr std::array<float, 29> kRangeGramPerCm{{
+    9.833E-1, 1.786E0, 3.321E0, 6.598E0, 1.058E1, 3.084E1, 4.250E1, 6.732E1,
+    1.063E2,  1.725E2, 2.385E2, 4.934E2, 6.163E2, 8.552E2, 1.202E3, 1.758E3,
+    2.297E3,  4.359E3, 5.354E3, 7.298E3, 1.013E4, 1.469E4, 1.910E4, 3.558E4,
+    4.326E4,  5.768E4, 7.734E4, 1.060E5, 1.307E5}};
+  constexpr std::array<float, 29> kKEMeV{{
+    10,    14,    20,    30,    40,     80,     100,    140,    200,   300,
+    400,   800,   1000,  1400,  2000,   3000,   4000,   8000,   10000, 14000,
+    20000, 30000, 40000, 80000, 100000, 140000, 200000, 300000, 400000}};
+  constexpr double kMuonMass = 105.7; // MeV
+
+  /// Muon track of the given length starting along z, with gaussian kinks every cm
+  recob::Track makeTrack(double length, double kinkRMS, std::mt19937& engine, int id)
+  {
+    std::normal_distribution<double> gaus(0., kinkRMS);
+
+    std::vector<recob::tracking::Point_t>  positions;
+    std::vector<recob::tracking::Vector_t> momenta;
+
+    recob::tracking::Point_t  pos(0., 0., 0.);
+    recob::tracking::Vector_t dir(0., 0., 1.);
+    for (double s = 0.; s <= length; s += 1.) {
+      positions.push_back(pos);
+      momenta.push_back(dir);
+      dir = recob::tracking::Vector_t(dir.X() + gaus(engine), dir.Y() + gaus(engine), dir.Z()).Unit();
+      pos += dir;
+    }
+
+    std::vector<recob::TrajectoryPointFlags> flags(positions.size());
+    recob::TrackTrajectory traj(std::move(positions), std::move(momenta), std::move(flags), false);
+    return recob::Track(traj, 13, -1., -1, recob::tracking::SMatrixSym55(), recob::tracking::SMatrixSym55(), id);
+  }
+
+} // namespace
+
+
+namespace trkf {
+
+  class TrackMomentumCalculatorTest {
+
+  public:
+    struct DeltaThetaInputs {
+      std::vector<float> dEi, dEj, dthij, ind;
+    };
+
+    /// Inputs of the likelihood as GetMomentumMultiScatterLLHD builds them; false if it gives up before
+    bool deltaThetaInputs(art::Ptr<recob::Track> const& trk, DeltaThetaInputs& inputs)
+    {
+      std::vector<float> recoX, recoY, recoZ;
+      for (std::size_t i = 0; i < trk->NumberTrajectoryPoints(); ++i) {
+        auto const& pos = trk->LocationAtPoint(i);
+        recoX.push_back(pos.X());
+        recoY.push_back(pos.Y());
+        recoZ.push_back(pos.Z());
+      }
+      if (recoX.size() < 2 || !tmc.plotRecoTracks_(recoX, recoY, recoZ)) return false;
+
+      auto const segments = tmc.getSegTracks_(recoX, recoY, recoZ, 10.);
+      if (!segments.has_value() || segments->x.size() < 2) return false;
+
+      double const recoL = segments->L.back();
+      if (recoL < tmc.minLength || recoL > tmc.maxLength) return false;
+
+      return tmc.getDeltaThetaij_(inputs.dEi, inputs.dEj, inputs.dthij, inputs.ind, *segments, 10.) == 0;
+    }
+
+    double llhd(DeltaThetaInputs const& in, double p, double res) const
+    { return tmc.my_mcs_llhd(in.dEi, in.dEj, in.dthij, in.ind, p, res); }
+
+    std::vector<double> llhdScan(DeltaThetaInputs const& in, std::vector<double> const& p_tests, double res) const
+    {
+      std::vector<double> results;
+      tmc.my_mcs_llhd_scan(in.dEi, in.dEj, in.dthij, in.ind, p_tests, res, results);
+      return results;
+    }
+
+    TrackMomentumCalculator tmc;
+  };
+
+} // namespace trkf
+
+
+namespace {
+
+  /// The test momenta of GetMomentumMultiScatterLLHD
+  std::vector<double> llhdTestMomenta()
+  {
+    std::vector<double> p_tests;
+    for (int k = 0; k <= 750; ++k) p_tests.push_back(0.001 + k * 0.01);
+    return p_tests;
+  }
+
+  /// The momentum GetMomentumMultiScatterLLHD returned before the scan: one my_mcs_llhd call per test momentum
+  double perMomentumLLHDFit(trkf::TrackMomentumCalculatorTest const& tester,
+                            trkf::TrackMomentumCalculatorTest::DeltaThetaInputs const& inputs)
+  {
+    double logL = 1e+16;
+    double bf = -666.0;
+    for (int k = 0; k <= 750; ++k) {
+      double const p_test = 0.001 + k * 0.01;
+      double const fv = tester.llhd(inputs, p_test, 2.0);
+      if (fv < logL) {
+        bf = p_test;
+        logL = fv;
+      }
+    }
+    return bf;
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(MuonRangeTable)
+{
+  trkf::TrackMomentumCalculator tmc;
+
+  double previous = 0.;
+  for (std::size_t i = 0; i < kRangeGramPerCm.size(); ++i) {
+    float const range = kRangeGramPerCm[i] / 1.396;
+    double const ke = kKEMeV[i];
+
+    BOOST_CHECK_CLOSE(tmc.GetTrackMomentum(range, 13), std::sqrt(ke * ke + 2 * kMuonMass * ke) / 1000., 1e-6);
+
+    // and in between the table points
+    if (i == 0) continue;
+    float const prevRange = kRangeGramPerCm[i - 1] / 1.396;
+    for (int step = 1; step <= 10; ++step) {
+      double const p = tmc.GetTrackMomentum(prevRange + step * (range - prevRange) / 10., 13);
+      BOOST_CHECK_GT(p, previous);
+      previous = p;
+    }
+  }
+
+  BOOST_CHECK_EQUAL(tmc.GetTrackMomentum(-1., 13), -1.);
+} // BOOST_AUTO_TEST_CASE(MuonRangeTable)
+
+
+BOOST_AUTO_TEST_CASE(MuonRangeAgainstTSpline3)
+{
+  // the spline the range table used to be read with
+  std::array<float, 29> range;
+  for (std::size_t i = 0; i < range.size(); ++i) {
+    range[i] = kRangeGramPerCm[i];
+    range[i] /= 1.396;
+  }
+  TGraph const KEvsR{29, range.data(), kKEMeV.data()};
+  TSpline3 const KEvsR_spline3{"KEvsRS", &KEvsR};
+
+  trkf::TrackMomentumCalculator tmc;
+  auto const check = [&](double r) {
+    double const ke = KEvsR_spline3.Eval(r);
+    BOOST_CHECK_CLOSE(tmc.GetTrackMomentum(r, 13), std::sqrt(ke * ke + 2 * kMuonMass * ke) / 1000., 1e-6);
+  };
+
+  for (std::size_t i = 1; i < range.size(); ++i) {
+    for (int step = 1; step < 8; ++step)
+      check(range[i - 1] + step * (range[i] - range[i - 1]) / 8.);
+  }
+
+  // extrapolated with the first and the last interval
+  check(0.5 * range.front());
+  check(1.2 * range.back());
+} // BOOST_AUTO_TEST_CASE(MuonRangeAgainstTSpline3)
+
+
+BOOST_AUTO_TEST_CASE(BatchAgainstSingleTracks)
+{
+  std::mt19937 engine(97531);
+  std::uniform_real_distribution<double> flat(0., 1.);
+
+  std::vector<std::unique_ptr<recob::Track>> tracks;
+  std::vector<art::Ptr<recob::Track>> trackPtrs;
+  for (int id = 0; id < 20; ++id) {
+    tracks.push_back(std::make_unique<recob::Track>(makeTrack(150. + 600. * flat(engine), 0.002 + 0.01 * flat(engine), engine, id)));
+    trackPtrs.emplace_back(tracks.back().get(), id);
+  }
+
+  trkf::TrackMomentumCalculator batchTmc, singleTmc;
+
+  std::vector<double> const llhd = batchTmc.GetMomentumMultiScatterLLHD(trackPtrs);
+  std::vector<double> const chi2 = batchTmc.GetMomentumMultiScatterChi2(trackPtrs);
+
+  BOOST_REQUIRE_EQUAL(llhd.size(), trackPtrs.size());
+  BOOST_REQUIRE_EQUAL(chi2.size(), trackPtrs.size());
+
+  for (std::size_t i = 0; i < trackPtrs.size(); ++i) {
+    BOOST_CHECK_EQUAL(llhd[i], singleTmc.GetMomentumMultiScatterLLHD(trackPtrs[i]));
+    BOOST_CHECK_EQUAL(chi2[i], singleTmc.GetMomentumMultiScatterChi2(trackPtrs[i]));
+  }
+} // BOOST_AUTO_TEST_CASE(BatchAgainstSingleTracks)
+
+
+BOOST_AUTO_TEST_CASE(LLHDScanAgainstPerMomentum)
+{
+  // fixed reference sample of segment pairs: energy lost up to each segment of the pair (GeV),
+  // kink angles (mrad) and the flags of the pairs used; the momenta cover the ones at which
+  // the particle stops between the two segments, where the angle is penalised
+  trkf::TrackMomentumCalculatorTest::DeltaThetaInputs inputs;
+  for (int i = 0; i < 60; ++i) {
+    inputs.dEi.push_back(0.0213 * i);
+    inputs.dEj.push_back(0.0213 * (i + 1));
+    inputs.dthij.push_back(40. * std::sin(0.7 * i + 0.3) * std::exp(-0.02 * i));
+    inputs.ind.push_back((i % 9 == 4) ? 0. : 1.);
+  }
+
+  trkf::TrackMomentumCalculatorTest tester;
+  std::vector<double> const p_tests = llhdTestMomenta();
+
+  for (double const res : {2.0, 0.5}) {
+    std::vector<double> const scan = tester.llhdScan(inputs, p_tests, res);
+    BOOST_REQUIRE_EQUAL(scan.size(), p_tests.size());
+    for (std::size_t k = 0; k < p_tests.size(); ++k)
+      BOOST_CHECK_CLOSE(scan[k], tester.llhd(inputs, p_tests[k], res), 1e-10);
+  }
+} // BOOST_AUTO_TEST_CASE(LLHDScanAgainstPerMomentum)
+
+
+BOOST_AUTO_TEST_CASE(LLHDFitAgainstPerMomentum)
+{
+  std::mt19937 engine(24680);
+  std::uniform_real_distribution<double> flat(0., 1.);
+
+  trkf::TrackMomentumCalculatorTest tester;
+
+  int nFitted = 0;
+  for (int id = 0; id < 20; ++id) {
+    recob::Track const track = makeTrack(150. + 600. * flat(engine), 0.002 + 0.01 * flat(engine), engine, id);
+    art::Ptr<recob::Track> const trackPtr(&track, id);
+
+    trkf::TrackMomentumCalculatorTest::DeltaThetaInputs inputs;
+    if (!tester.deltaThetaInputs(trackPtr, inputs)) continue;
+    ++nFitted;
+
+    trkf::TrackMomentumCalculator tmc;
+    BOOST_CHECK_EQUAL(tmc.GetMomentumMultiScatterLLHD(trackPtr), perMomentumLLHDFit(tester, inputs));
+  }
+  BOOST_CHECK_GT(nFitted, 0);
+} // BOOST_AUTO_TEST_CASE(LLHDFitAgainstPerMomentum)
@@ -0,0 +1,114 @@
+/**
+ * @file   TrajectoryMCSFitter_test.cc
+ * @brief  Test and benchmark of the golden-section search of trkf::TrajectoryMCSFitter
+ * @see    TrajectoryMCSFitter.h
+ *
+ * Scattering angles between segments are drawn from the modified Highland
+ * formula for muons of known momentum, with the energy loss along the track.
+ * The momentum from the golden-section search must be the one of the full
+ * likelihood scan within the scan step, for forward and backward fits.
+ * The likelihood evaluations per track are printed for both.
+ */
+
+// C/C++ standard libraries
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( TrajectoryMCSFitter_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/TrajectoryMCSFitter.h"
+
+
+namespace {
+
+  constexpr int    kPid       = 13;
+  constexpr double kSegLen    = 14.;   // cm
+  constexpr double kPStep     = 0.01;  // GeV
+  constexpr double kAngResol  = 3.0;   // mrad
+
+  trkf::TrajectoryMCSFitter makeFitter(bool goldenSearch)
+  {
+    return trkf::TrajectoryMCSFitter(kPid, 3, kSegLen, 2, 10, 0, 0.01, 7.5, kPStep, kAngResol, goldenSearch);
+  }
+
+  /// Segment radiation lengths, angles and cumulative lengths of a muon with momentum p crossing up to maxSegs segments
+  void makeTrack(trkf::TrajectoryMCSFitter const& fitter, double p, unsigned int maxSegs, std::mt19937& engine,
+                 std::vector<float>& segRadLengths, std::vector<float>& dtheta,
+                 std::vector<float>& cumLenFwd, std::vector<float>& cumLenBwd)
+  {
+    std::normal_distribution<double> gaus(0., 1.);
+
+    double const m = fitter.mass(kPid);
+    double const Etot = std::sqrt(p * p + m * m);
+
+    // the muon must not stop before the end of the track
+    unsigned int nSegs = maxSegs;
+    while (nSegs > 3 && fitter.GetE(Etot, nSegs * kSegLen, m) < m + 0.05) --nSegs;
+
+    segRadLengths.assign(nSegs, kSegLen / 14.);
+    dtheta.clear();
+    cumLenFwd.clear();
+    cumLenBwd.clear();
+
+    for (unsigned int i = 0; i + 1 < nSegs; ++i) {
+      cumLenFwd.push_back(i * kSegLen);
+      cumLenBwd.push_back((nSegs - i - 2) * kSegLen);
+
+      double const Eij = fitter.GetE(Etot, cumLenFwd.back(), m);
+      double const pij = std::sqrt(std::max(Eij * Eij - m * m, 1e-6));
+      double const beta = pij / std::sqrt(pij * pij + m * m);
+      double const tH0 = (fitter.MomentumDependentConstant(pij) / (pij * beta)) * (1.0 + 0.038 * std::log(segRadLengths[i]))
+                         * std::sqrt(segRadLengths[i]);
+      double const rms = std::sqrt(2.0 * (tH0 * tH0 + kAngResol * kAngResol));
+      dtheta.push_back(std::abs(rms * gaus(engine)));
+    }
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(SearchAgainstScan)
+{
+  std::mt19937 engine(1357);
+  std::uniform_real_distribution<double> flat(0., 1.);
+
+  trkf::TrajectoryMCSFitter const scanFitter = makeFitter(false);
+  trkf::TrajectoryMCSFitter const searchFitter = makeFitter(true);
+
+  unsigned int const nTracks = 200;
+  long scanEvals(0), searchEvals(0);
+
+  for (unsigned int track = 0; track < nTracks; ++track) {
+    double const p = 0.3 + 3.7 * flat(engine);
+    unsigned int const nSegs = 5 + 55 * flat(engine);
+
+    std::vector<float> segRadLengths, dtheta, cumLenFwd, cumLenBwd;
+    makeTrack(scanFitter, p, nSegs, engine, segRadLengths, dtheta, cumLenFwd, cumLenBwd);
+
+    for (bool fwd : {true, false}) {
+      std::vector<float>& cumLen = (fwd ? cumLenFwd : cumLenBwd);
+
+      auto const scan = scanFitter.doLikelihoodScan(dtheta, segRadLengths, cumLen, fwd, true, kPid);
+      auto const search = searchFitter.doLikelihoodScan(dtheta, segRadLengths, cumLen, fwd, true, kPid);
+
+      BOOST_CHECK_SMALL(search.p - scan.p, kPStep * 1.001);
+      BOOST_CHECK_LE(search.logL, scan.logL + 1e-3);
+      // the curvature gives a symmetric uncertainty, the scan the wider side: only check both are there
+      if (scan.pUnc > 0.) BOOST_CHECK_GT(search.pUnc, 0.);
+
+      scanEvals += scan.nEvals;
+      searchEvals += search.nEvals;
+    }
+  }
+
+  std::cout << "TrajectoryMCSFitter likelihood evaluations per track (fwd+bwd):"
+            << "\n  scan:                  " << double(scanEvals) / nTracks
+            << "\n  golden-section search: " << double(searchEvals) / nTracks << std::endl;
+
+  BOOST_CHECK_LT(searchEvals, scanEvals / 5);
+} // BOOST_AUTO_TEST_CASE(SearchAgainstScan)
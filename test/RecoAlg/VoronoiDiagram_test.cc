@@ -6,10 +6,7 @@
  *
  * Usage:
  *
- *     TBD....
- *     geometry_icarus_test  [ConfigurationFile [GeometryTestParameterSet]]
- *
- * By default, `GeometryTestParameterSet` is set to `"physics.analyzers.geotest"`.
+ *     VoronoiDiagram_test
  *
  */
 
@@ -22,11 +19,157 @@
 // utility libraries
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
+// C/C++ standard libraries
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
 //------------------------------------------------------------------------------
 //---  The test environment
 //---
 
+namespace {
+
+  /// Uniform number in [0, 1) taken directly from the engine, so that the points do not depend on the standard library
+  double flat(std::mt19937& engine) {return engine() / 4294967296.;}
+
+  /// Random points in the plane, either uniform or along a line, sorted as VoronoiPathFinder does it
+  dcel2d::PointList makePoints(std::mt19937& engine, std::vector<reco::ClusterHit3D>& hits, size_t nPoints, bool trackLike)
+  {
+    dcel2d::PointList pointList;
+
+    hits.resize(std::max(hits.size(), nPoints));
+
+    for(size_t idx = 0; idx < nPoints; idx++)
+    {
+      double x = trackLike ? 100. * flat(engine)               : 50. * flat(engine);
+      double y = trackLike ? 0.3 * x + 4. * (flat(engine) - 0.5) : 50. * flat(engine);
+
+      pointList.emplace_back(dcel2d::Point(x, y, &hits[idx]));
+    }
+
+    pointList.sort([](const auto& left, const auto& right){return (std::abs(std::get<0>(left) - std::get<0>(right)) > std::numeric_limits<float>::epsilon()) ? std::get<0>(left) < std::get<0>(right) : std::get<1>(left) < std::get<1>(right);});
 
+    return pointList;
+  }
+
+  /// Text summary of a diagram: the face sites, the vertices, the half edge links and the convex hull
+  std::string summarize(const dcel2d::HalfEdgeList&     halfEdgeList,
+                        const dcel2d::VertexList&       vertexList,
+                        const dcel2d::FaceList&         faceList,
+                        const voronoi2d::VoronoiDiagram& voronoiDiagram)
+  {
+    std::map<const void*, int> indexMap;
+
+    int index(0);
+    for(const auto& halfEdge : halfEdgeList) indexMap[&halfEdge] = index++;
+    index = 0;
+    for(const auto& vertex : vertexList) indexMap[&vertex] = index++;
+    index = 0;
+    for(const auto& face : faceList) indexMap[&face] = index++;
+
+    auto toIndex = [&indexMap](const void* ptr){return ptr ? (indexMap.count(ptr) ? indexMap[ptr] : -2) : -1;};
+
+    std::ostringstream summary;
+
+    for(const auto& face : faceList)
+      summary << "F " << face.getCoords()[0] << " " << face.getCoords()[1] << " " << face.onConvexHull() << " " << toIndex(face.getHalfEdge()) << "\n";
+    for(const auto& vertex : vertexList)
+      summary << "V " << vertex.getCoords()[0] << " " << vertex.getCoords()[1] << " " << toIndex(vertex.getHalfEdge()) << "\n";
+    for(const auto& halfEdge : halfEdgeList)
+      summary << "H " << toIndex(halfEdge.getTargetVertex()) << " " << toIndex(halfEdge.getFace()) << " " << toIndex(halfEdge.getTwinHalfEdge())
+              << " " << toIndex(halfEdge.getNextHalfEdge()) << " " << toIndex(halfEdge.getLastHalfEdge()) << "\n";
+    for(const auto& point : voronoiDiagram.getConvexHull())
+      summary << "C " << std::get<0>(point) << " " << std::get<1>(point) << "\n";
+
+    return summary.str();
+  }
+
+  /// Builds the diagram of the points and returns its summary; the build time is added to buildTime
+  std::string buildDiagram(const dcel2d::PointList& pointList, voronoi2d::VoronoiArena* arena, double& buildTime)
+  {
+    dcel2d::HalfEdgeList halfEdgeList;
+    dcel2d::VertexList   vertexList;
+    dcel2d::FaceList     faceList;
+
+    // The diagram code is chatty, keep it out of the test output
+    std::ostringstream sink;
+    std::streambuf*    coutBuffer = std::cout.rdbuf(sink.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<voronoi2d::VoronoiDiagram> voronoiDiagram = arena
+      ? std::make_unique<voronoi2d::VoronoiDiagram>(halfEdgeList, vertexList, faceList, *arena)
+      : std::make_unique<voronoi2d::VoronoiDiagram>(halfEdgeList, vertexList, faceList);
+
+    voronoiDiagram->buildVoronoiDiagram(pointList);
+
+    buildTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout.rdbuf(coutBuffer);
+
+    return summarize(halfEdgeList, vertexList, faceList, *voronoiDiagram);
+  }
+
+  /// Number of lines of the summary of the given kind ('F', 'V', 'H' or 'C')
+  size_t countLines(const std::string& summary, char kind)
+  {
+    size_t count(summary.front() == kind ? 1 : 0);
+
+    for(size_t pos = summary.find('\n'); pos + 1 < summary.size(); pos = summary.find('\n', pos + 1))
+      if (summary[pos + 1] == kind) count++;
+
+    return count;
+  }
+
+  /// 64 bit FNV-1a hash of the summary
+  std::uint64_t hashSummary(const std::string& summary)
+  {
+    std::uint64_t hash(14695981039346656037ULL);
+
+    for(unsigned char c : summary) hash = (hash ^ c) * 1099511628211ULL;
+
+    return hash;
+  }
+
+  /// A diagram built with the VoronoiDiagram code that allocated the beach line and the events one at a time
+  struct ReferenceDiagram
+  {
+    size_t        nPoints;
+    bool          trackLike;
+    size_t        nFaces;
+    size_t        nVertices;
+    size_t        nHalfEdges;
+    size_t        nHullPoints;
+    std::uint64_t summaryHash;
+  };
+
+  /// The points of entry idx are made by makePoints() with the engine seeded with kReferenceSeed + idx.
+  /// The references were made on x86-64 without fused multiply-add, which moves nearby vertices.
+  constexpr unsigned int kReferenceSeed = 20180215;
+
+  const std::vector<ReferenceDiagram> referenceDiagrams = {
+    {    5, false,     5,     2,     18,   4, 0x47e6b1fd993c4ae3ULL},
+    {    5, true,      5,     2,     14,   6, 0xc75db1e4d60c1a02ULL},
+    {   12, false,    12,    12,     56,   6, 0x53d3f3a03c672505ULL},
+    {   12, true,     12,     5,     54,   7, 0xa44d6e725c19d01eULL},
+    {   60, false,    60,    94,    336,  10, 0xb449eda9afadbeadULL},
+    {   60, true,     60,    50,    330,  13, 0x1ef8569efd532531ULL},
+    {  250, false,   250,   449,   1472,  12, 0x8b163c20ea761129ULL},
+    {  250, true,    250,   353,   1464,  16, 0x286d870bad590b4dULL},
+    { 1000, false,  1000,  1890,   5956,  20, 0xbd0617ea6c9790ceULL},
+    { 1000, true,   1000,  1701,   5960,  18, 0x104cc09b48044eeaULL},
+    { 4000, false,  4000,  7776,  23946,  25, 0x2b1da53d51b76b4dULL},
+    { 4000, true,   4000,  7401,  23954,  21, 0xf86ee6688652fabbULL}
+  };
+
+} // namespace
 
 //------------------------------------------------------------------------------
 //---  The tests
@@ -37,76 +180,75 @@
  * @param argc number of arguments in argv
  * @param argv arguments to the function
  * @return number of detected errors (0 on success)
- * @throw cet::exception most of error situations throw
- *
- * The arguments in argv are:
- * 0. name of the executable ("Geometry_test")
- * 1. path to the FHiCL configuration file
- * 2. FHiCL path to the configuration of the geometry test
- *    (default: physics.analysers.geotest)
- * 3. FHiCL path to the configuration of the geometry
- *    (default: services.Geometry)
  *
+ * The diagrams of fixed sets of points must match the references made with
+ * the code that allocated the beach line and the events one at a time.
+ * Then diagrams are built for a sequence of "clusters" of random points, once
+ * with a diagram owning its construction arena and once with a single arena
+ * reused from cluster to cluster as VoronoiPathFinder does. Both must give the
+ * same diagrams. The construction time per 10^4 points is printed for both.
  */
 //------------------------------------------------------------------------------
 int main(int argc, char const** argv)
 {
     int nErrors(0);
-/*
-    // This test program needs work before being released into the wild...
-    // In the meantime, comment out the guts here.
 
-    // Build a test point list
-    dcel2d::PointList pointList;
+    std::mt19937                    engine(20180215);
+    std::vector<reco::ClusterHit3D> hits;
+    voronoi2d::VoronoiArena         arena;
 
-    // Loop through hits and do projection to plane
-//    for(const auto& hit3D : clusterParameters.getHitPairListPtr())
-//    {
-//        Eigen::Vector3f pcaToHitVec(hit3D->getPosition()[0] - pcaCenter(0),
-//                                    hit3D->getPosition()[1] - pcaCenter(1),
-//                                    hit3D->getPosition()[2] - pcaCenter(2));
-//        Eigen::Vector3f pcaToHit = rotationMatrix * pcaToHitVec;
-//
-//        pointList.emplace_back(dcel2d::Point(pcaToHit(0),pcaToHit(1),hit3D));
-//    }
-
-    // Make a dummy 3D hit
-    reco::ClusterHit3D clusterHit3D;
-
-//    pointList.emplace_back(dcel2d::Point(-10.,  0., &clusterHit3D));
-//    pointList.emplace_back(dcel2d::Point(  0., -5., &clusterHit3D));
-//    pointList.emplace_back(dcel2d::Point(  0.,  5., &clusterHit3D));
-//    pointList.emplace_back(dcel2d::Point( 10.,  0., &clusterHit3D));
-
-    pointList.emplace_back(dcel2d::Point(-10.,  0., &clusterHit3D));
-    pointList.emplace_back(dcel2d::Point( -5.,  0., &clusterHit3D));
-    pointList.emplace_back(dcel2d::Point(  0.,  0., &clusterHit3D));
-    pointList.emplace_back(dcel2d::Point(  5.,  0., &clusterHit3D));
-    pointList.emplace_back(dcel2d::Point( 10.,  0., &clusterHit3D));
-
-    // Sort the point vec by decreasing x, then increase y
-    pointList.sort([](const auto& left, const auto& right){return (std::abs(std::get<0>(left) - std::get<0>(right)) > std::numeric_limits<float>::epsilon()) ? std::get<0>(left) < std::get<0>(right) : std::get<1>(left) < std::get<1>(right);});
+    double ownArenaTime(0.);
+    double sharedArenaTime(0.);
+    size_t nPoints(0);
+
+    for(size_t idx = 0; idx < referenceDiagrams.size(); idx++)
+    {
+        const ReferenceDiagram& reference = referenceDiagrams[idx];
+
+        std::mt19937      referenceEngine(kReferenceSeed + idx);
+        dcel2d::PointList pointList = makePoints(referenceEngine, hits, reference.nPoints, reference.trackLike);
+        std::string       diagram   = buildDiagram(pointList, &arena, sharedArenaTime);
+
+        if (countLines(diagram, 'F') != reference.nFaces    || countLines(diagram, 'V') != reference.nVertices   ||
+            countLines(diagram, 'H') != reference.nHalfEdges || countLines(diagram, 'C') != reference.nHullPoints ||
+            hashSummary(diagram) != reference.summaryHash)
+        {
+            mf::LogError("VoronoiDiagram_test") << "Diagram of reference " << idx << " (" << reference.nPoints << " points) differs from the reference: "
+                                                << countLines(diagram, 'F') << " faces, " << countLines(diagram, 'V') << " vertices, "
+                                                << countLines(diagram, 'H') << " half edges, " << countLines(diagram, 'C') << " hull points";
+            nErrors++;
+        }
+    }
 
-    // Get some useful containers
-    dcel2d::FaceList          faceList;            // Keeps track of "faces" from Voronoi Diagram
-    dcel2d::VertexList        vertexList;          // Keeps track of "vertices" from Voronoi Diagram
-    dcel2d::HalfEdgeList      halfEdgeList;        // Keeps track of "halfedges" from Voronoi Diagram
+    sharedArenaTime = 0.;
 
-    // Set up the voronoi diagram builder
-    voronoi2d::VoronoiDiagram voronoiDiagram(halfEdgeList,vertexList,faceList);
+    for(int cluster = 0; cluster < 200; cluster++)
+    {
+        // Mostly small clusters with an occasional large one
+        size_t            clusterSize = 5 + engine() % (cluster % 20 == 0 ? 5000 : 400);
+        dcel2d::PointList pointList   = makePoints(engine, hits, clusterSize, cluster % 2);
+
+        std::string ownArenaDiagram    = buildDiagram(pointList, nullptr, ownArenaTime);
+        std::string sharedArenaDiagram = buildDiagram(pointList, &arena,  sharedArenaTime);
+
+        if (ownArenaDiagram != sharedArenaDiagram)
+        {
+            mf::LogError("VoronoiDiagram_test") << "Diagram of cluster " << cluster << " (" << clusterSize << " points) depends on the arena";
+            nErrors++;
+        }
 
-    // And make the diagram
-    voronoiDiagram.buildVoronoiDiagram(pointList);
+        nPoints += clusterSize;
+    }
 
-    // Recover the voronoi diagram vertex list and the container to store them in
-//    dcel2d::VertexList& vertexList = clusterParameters.getVertexList();
+    std::cout << "VoronoiDiagram construction time per 10^4 points (" << nPoints << " points):"
+              << "\n  arena per diagram:   " << 1.e4 * ownArenaTime / nPoints << " ms"
+              << "\n  arena reused:        " << 1.e4 * sharedArenaTime / nPoints << " ms" << std::endl;
 
     // 4. And finally we cross fingers.
     if (nErrors > 0)
     {
         mf::LogError("VoronoiDiagram_test") << nErrors << " errors detected!";
     }
-*/
+
     return nErrors;
 } // main()
-
@@ -0,0 +1,189 @@
+/**
+ * @file   kdTree_test.cc
+ * @brief  Test and benchmark of the flat version of lar_cluster3d::kdTree
+ * @see    kdTree.h
+ *
+ * Space points along random straight tracks are given wire numbers in three
+ * planes and a peak time, then the neighbourhood of every point is found with
+ * the node based tree, with single queries of the flat tree and with the
+ * batch query of the flat tree. All three must give the same neighbours in
+ * the same order; the query rate of each is printed.
+ */
+
+// C/C++ standard libraries
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( kdTree_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/RecoAlg/Cluster3DAlgs/Cluster3D.h"
+#include "larreco/RecoAlg/Cluster3DAlgs/kdTree.h"
+
+// framework libraries
+#include "fhiclcpp/ParameterSet.h"
+
+
+namespace {
+
+  constexpr float kWirePitch = 0.3;   // cm
+  constexpr float kTickSize  = 0.05;  // cm per tick
+
+  reco::HitPairList makeHits(std::size_t nTracks, std::size_t nHitsPerTrack)
+  {
+    std::mt19937                          engine(4321);
+    std::uniform_real_distribution<float> flat(0., 1.);
+    std::normal_distribution<float>       smear(0., 0.1);
+
+    reco::HitPairList hitPairList;
+
+    float const cos60 = 0.5;
+    float const sin60 = std::sqrt(3.) / 2.;
+
+    for(std::size_t track = 0; track < nTracks; track++)
+    {
+      Eigen::Vector3f start(100. * flat(engine), 100. * flat(engine) - 50., 100. * flat(engine));
+      Eigen::Vector3f dir(flat(engine) - 0.5, flat(engine) - 0.5, flat(engine) - 0.5);
+
+      dir.normalize();
+
+      for(std::size_t idx = 0; idx < nHitsPerTrack; idx++)
+      {
+        Eigen::Vector3f position = start + 0.25 * idx * dir;
+
+        for(std::size_t coord = 0; coord < 3; coord++) position[coord] += smear(engine);
+
+        std::vector<geo::WireID> wireIDVec(3);
+
+        wireIDVec[0].Wire = std::lround(( position[2] * cos60 + position[1] * sin60) / kWirePitch + 1000.);
+        wireIDVec[1].Wire = std::lround(( position[2] * cos60 - position[1] * sin60) / kWirePitch + 1000.);
+        wireIDVec[2].Wire = std::lround(  position[2] / kWirePitch);
+
+        for(std::size_t plane = 0; plane < 3; plane++) wireIDVec[plane].Plane = plane;
+
+        float const peakTime = position[0] / kTickSize;
+
+        hitPairList.emplace_back(hitPairList.size(), 0, position, 1., peakTime, 0., 2., 1., 1., 0., 0., 0.,
+                                 reco::ClusterHit2DVec(3, nullptr), std::vector<float>(3, 0.), wireIDVec);
+      }
+    }
+
+    return hitPairList;
+  }
+
+  double queriesPerSecond(std::size_t nQueries, std::chrono::steady_clock::time_point start)
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return nQueries / elapsed.count();
+  }
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(FlatTreeAgainstNodeTree)
+{
+  reco::HitPairList const hitPairList = makeHits(200, 500);
+
+  fhicl::ParameterSet pset;
+
+  pset.put("EnableMonitoring",  true);
+  pset.put("PairSigmaPeakTime", 3.);
+  pset.put("RefLeafBestDist",   1.99 * kWirePitch);
+  pset.put("MaxWireDeltas",     3);
+
+  lar_cluster3d::kdTree kdTree(pset);
+
+  // --- node based tree, one query per hit
+  lar_cluster3d::kdTree::KdTreeNodeList kdTreeNodeContainer;
+  lar_cluster3d::kdTree::KdTreeNode     topNode = kdTree.BuildKdTree(hitPairList, kdTreeNodeContainer);
+
+  std::vector<lar_cluster3d::kdTree::CandPairList> nodeResults;
+
+  nodeResults.reserve(hitPairList.size());
+
+  auto nodeStart = std::chrono::steady_clock::now();
+
+  for(const auto& hit : hitPairList)
+  {
+    float bestDist(std::numeric_limits<float>::max());
+
+    nodeResults.emplace_back();
+    kdTree.FindNearestNeighbors(&hit, topNode, nodeResults.back(), bestDist);
+  }
+
+  double const nodeRate = queriesPerSecond(hitPairList.size(), nodeStart);
+
+  // --- flat tree, one query per hit
+  lar_cluster3d::kdTree::FlatKdTree flatKdTree = kdTree.BuildFlatKdTree(hitPairList);
+
+  BOOST_CHECK_EQUAL(flatKdTree.numLeaves(), hitPairList.size());
+
+  std::vector<lar_cluster3d::kdTree::NeighborBuffer> flatResults(hitPairList.size());
+
+  auto flatStart = std::chrono::steady_clock::now();
+
+  std::size_t hitIdx(0);
+
+  for(const auto& hit : hitPairList)
+  {
+    float bestDist(std::numeric_limits<float>::max());
+
+    kdTree.FindNearestNeighbors(&hit, flatKdTree, flatResults[hitIdx++], bestDist);
+  }
+
+  double const flatRate = queriesPerSecond(hitPairList.size(), flatStart);
+
+  // --- flat tree, all queries at once
+  lar_cluster3d::kdTree::NeighborPool neighborPool;
+
+  auto batchStart = std::chrono::steady_clock::now();
+
+  kdTree.FindAllNearestNeighbors(flatKdTree, neighborPool, std::numeric_limits<float>::max());
+
+  double const batchRate = queriesPerSecond(hitPairList.size(), batchStart);
+
+  std::cout << "Neighbor queries for " << hitPairList.size() << " hits:"
+            << "\n  node tree:          " << nodeRate  << " queries/s"
+            << "\n  flat tree:          " << flatRate  << " queries/s"
+            << "\n  flat tree (batch):  " << batchRate << " queries/s" << std::endl;
+
+  // --- the three must agree exactly
+  std::size_t nNeighbors(0);
+
+  hitIdx = 0;
+
+  for(const auto& hit : hitPairList)
+  {
+    const lar_cluster3d::kdTree::CandPairList&   nodeList  = nodeResults[hitIdx];
+    const lar_cluster3d::kdTree::NeighborBuffer& flatList  = flatResults[hitIdx++];
+    size_t const                                 leaf      = flatKdTree.leafOfInput[hitIdx - 1];
+
+    BOOST_CHECK(flatKdTree.hits[leaf] == &hit);
+    BOOST_REQUIRE_EQUAL(flatList.size(),          nodeList.size());
+    BOOST_REQUIRE_EQUAL(neighborPool.size(leaf), nodeList.size());
+
+    auto flatItr = flatList.begin();
+    auto poolItr = neighborPool.begin(leaf);
+
+    for(const auto& candPair : nodeList)
+    {
+      BOOST_CHECK_EQUAL(flatItr->first,  candPair.first);
+      BOOST_CHECK(flatItr->second == candPair.second);
+      BOOST_CHECK_EQUAL(poolItr->first,  candPair.first);
+      BOOST_CHECK(flatKdTree.hits[poolItr->second] == candPair.second);
+      flatItr++;
+      poolItr++;
+    }
+
+    nNeighbors += nodeList.size();
+  }
+
+  BOOST_CHECK_GT(nNeighbors, hitPairList.size());
+
+} // BOOST_AUTO_TEST_CASE(FlatTreeAgainstNodeTree)
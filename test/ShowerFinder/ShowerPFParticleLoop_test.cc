@@ -0,0 +1,138 @@
+/**
+ * @file   ShowerPFParticleLoop_test.cc
+ * @brief  Test of the serial and concurrent TRACS PFParticle loops
+ * @see    ShowerPFParticleLoop.hh
+ *
+ * A chain of reentrant tools is run over a fixed sample of PFParticles with
+ * reco::shower::LoopPFParticles() and LoopPFParticlesConcurrently(). The tools
+ * set every element they read for each PFParticle, like the TRACS tools do, so
+ * the showers made must be the same and in the same order, including the
+ * PFParticles a tool fails on and the ones which are not showers.
+ */
+
+// C/C++ standard libraries
+#include <cmath>
+#include <string>
+#include <vector>
+
+// boost test libraries
+#define BOOST_TEST_MODULE ( ShowerPFParticleLoop_test )
+#include "cetlib/quiet_unit_test.hpp"
+
+// LArSoft libraries
+#include "larreco/ShowerFinder/ShowerPFParticleLoop.hh"
+#include "larreco/RecoAlg/ShowerElementHolder.hh"
+
+
+namespace {
+
+  struct TestPFParticle {
+    int pdg;
+    int id;
+    std::vector<double> points; // positions along the shower axis
+    int PdgCode() const { return pdg; }
+  };
+
+  struct TestShower {
+    int id;
+    int number;
+    double start;
+    double direction;
+    double energy;
+    double dEdx;
+    bool operator==(TestShower const& other) const
+    {
+      return id == other.id && number == other.number && start == other.start &&
+        direction == other.direction && energy == other.energy && dEdx == other.dEdx;
+    }
+  };
+
+  reco::shower::ShowerElementSlot const startSlot("ShowerStartPosition");
+  reco::shower::ShowerElementSlot const directionSlot("ShowerDirection");
+  reco::shower::ShowerElementSlot const energySlot("ShowerEnergy");
+  reco::shower::ShowerElementSlot const dEdxSlot("ShowerdEdx");
+
+  // The tools of the chain, run in order until one fails.
+  int RunTools(TestPFParticle const* pfp, reco::shower::ShowerElementHolder& holder)
+  {
+    if (pfp->points.empty()) return 1;
+    double start = pfp->points.front();
+    holder.SetElement(start, startSlot);
+
+    holder.GetElement(startSlot, start);
+    double direction = (pfp->points.back() - start) >= 0. ? 1. : -1.;
+    holder.SetElement(direction, directionSlot);
+
+    double energy = 0.;
+    for (double point: pfp->points) energy += std::abs(point - start);
+    holder.SetElement(energy, energySlot);
+
+    if (pfp->points.size() < 3) return 2;
+    double dEdx = std::abs(pfp->points[2] - pfp->points[0]) / 2.;
+    holder.SetElement(dEdx, dEdxSlot);
+    return 0;
+  }
+
+  std::vector<TestPFParticle> MakeSample()
+  {
+    std::vector<TestPFParticle> sample;
+    for (int i = 0; i < 500; ++i) {
+      TestPFParticle pfp;
+      pfp.id = i;
+      pfp.pdg = (i % 7 == 0) ? 13 : ((i % 2 == 0) ? 11 : 22);
+      unsigned int const nPoints = (i % 11 == 0) ? 0 : ((i % 13 == 0) ? 2 : 3 + i % 17);
+      for (unsigned int j = 0; j < nPoints; ++j)
+        pfp.points.push_back(std::sin(0.37 * i + 1.3 * j) * (10. + j));
+      sample.push_back(pfp);
+    }
+    return sample;
+  }
+
+  template <bool Concurrent>
+  std::vector<TestShower> MakeShowers(std::vector<TestPFParticle const*> const& pfps, int& shower_iter)
+  {
+    std::vector<TestShower> showers;
+    auto makeShower = [&](TestPFParticle const* pfp, int err,
+                          reco::shower::ShowerElementHolder& holder, int& iter) {
+      if (err) return;
+      TestShower shower;
+      shower.id = pfp->id;
+      shower.number = holder.GetShowerNumber();
+      holder.GetElement(startSlot, shower.start);
+      holder.GetElement(directionSlot, shower.direction);
+      holder.GetElement(energySlot, shower.energy);
+      holder.GetElement(dEdxSlot, shower.dEdx);
+      showers.push_back(shower);
+      ++iter;
+    };
+    if (Concurrent)
+      reco::shower::LoopPFParticlesConcurrently(pfps, shower_iter, RunTools, makeShower);
+    else
+      reco::shower::LoopPFParticles(pfps, shower_iter, RunTools, makeShower);
+    return showers;
+  }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(ConcurrentAgainstSerial)
+{
+  std::vector<TestPFParticle> const sample = MakeSample();
+  std::vector<TestPFParticle const*> pfps;
+  for (auto const& pfp: sample) pfps.push_back(&pfp);
+
+  int serialIter = 0;
+  std::vector<TestShower> const serial = MakeShowers<false>(pfps, serialIter);
+  BOOST_CHECK(!serial.empty());
+  BOOST_CHECK_EQUAL(serialIter, static_cast<int>(serial.size()));
+
+  // run a few times, the tasks are scheduled differently each time
+  for (int run = 0; run < 5; ++run) {
+    int concurrentIter = 0;
+    std::vector<TestShower> const concurrent = MakeShowers<true>(pfps, concurrentIter);
+    BOOST_CHECK_EQUAL(concurrentIter, serialIter);
+    BOOST_REQUIRE_EQUAL(concurrent.size(), serial.size());
+    for (std::size_t i = 0; i < serial.size(); ++i)
+      BOOST_CHECK_MESSAGE(concurrent[i] == serial[i], "shower " << i << " from PFParticle " << serial[i].id);
+  }
+}